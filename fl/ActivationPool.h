@@ -0,0 +1,54 @@
+// ActivationPool.h
+//
+// Purpose: Reusable Activated terms for the fuzzy outputs of a compiled engine.
+// Detail: Accumulated::addTerm(term, degree, activation) allocates a new Activated for every fired rule and
+// Accumulated::clear() deletes them again, so every process() churns the heap. The pool instead takes the
+// Activated terms back out of a fuzzy output before each evaluation and hands them out again for the next
+// one. A term belongs to the fuzzy output while it is in it (so Accumulated::clear() and the destructor of
+// the engine still delete it) and to the pool otherwise, so nothing is ever owned twice. Once the pool holds
+// as many terms as there are conclusions, evaluation performs no heap allocations.
+
+#ifndef FL_ACTIVATIONPOOL_H
+#define FL_ACTIVATIONPOOL_H
+
+#include "fl/fuzzylite.h"
+
+#include <vector>
+
+namespace fl {
+    class Accumulated;
+    class Activated;
+    class Term;
+    class TNorm;
+
+    class ActivationPool {
+    protected:
+        std::vector<Activated*> _available;
+
+    public:
+        explicit ActivationPool(int size = 0);
+        virtual ~ActivationPool();
+
+        /**
+         * Allocates terms until the pool holds at least size of them, and room to take back that many.
+         */
+        virtual void reserve(int size);
+        /**
+         * Moves the activated terms of the fuzzy output into the pool, leaving it empty.
+         */
+        virtual void recycle(Accumulated* fuzzyOutput);
+        /**
+         * Same as Accumulated::addTerm(term, degree, activation), but with a term from the pool.
+         */
+        virtual void activate(Accumulated* fuzzyOutput, const Term* term, scalar degree,
+                const TNorm* activation);
+
+        virtual int numberOfAvailable() const;
+        virtual void clear();
+
+    private:
+        FL_DISABLE_COPY(ActivationPool)
+    };
+
+}
+#endif /* FL_ACTIVATIONPOOL_H */
@@ -0,0 +1,438 @@
+// CompiledEngine.h
+//
+// Purpose: Opt-in "compiled" evaluation mode for a configured fl::Engine.
+// Detail: compile() lowers every enabled RuleBlock into flat, contiguous arrays: one slot per distinct
+// (variable, term, hedges) proposition, a postfix instruction array for the antecedents, and the rule
+// weights and conclusions. process() then evaluates them in tight loops, instead of recursing through the
+// Proposition/Operator tree with virtual norm calls at every node. The plan keeps pointers into the engine,
+// so compile() again after changing it. The plan is read-only once compiled: the evaluation methods below
+// take the state they work on as arguments, so that EvaluationContext can run the same plan from many
+// threads at once.
+
+#ifndef FL_COMPILEDENGINE_H
+#define FL_COMPILEDENGINE_H
+
+#include "fl/fuzzylite.h"
+
+#include "fl/ActivationPool.h"
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/defuzzifier/SampledArea.h"
+#include "fl/term/MembershipKernel.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fl {
+    class Engine;
+    class Variable;
+    class Term;
+    class Hedge;
+    class Norm;
+    class TNorm;
+    class SNorm;
+    class Expression;
+    class Rule;
+    class Accumulated;
+    class AccumulatedKernel;
+    class Defuzzifier;
+
+    class CompiledEngine {
+    public:
+
+        enum NormCode {
+            CUSTOM, MINIMUM, MAXIMUM, ALGEBRAIC_PRODUCT, ALGEBRAIC_SUM,
+            BOUNDED_DIFFERENCE, BOUNDED_SUM
+        };
+
+        /**
+         * The pair of norms of a block for which the rule loop is specialized, with the norms inlined, or
+         * GENERIC for any other, which switches over NormCode and falls back to the virtual Norm::compute().
+         */
+        enum NormPair {
+            GENERIC, MINIMUM_MAXIMUM, ALGEBRAIC_PRODUCT_SUM, BOUNDED_DIFFERENCE_SUM
+        };
+
+        /**
+         * The integral of a stock defuzzifier, of an Exact one or of PrefixSumBisector, or NOT_INTEGRAL for
+         * any other defuzzifier.
+         */
+        enum IntegralCode {
+            NOT_INTEGRAL, CENTROID, BISECTOR, MEAN_OF_MAXIMUM, SMALLEST_OF_MAXIMUM, LARGEST_OF_MAXIMUM
+        };
+
+        /**
+         * How the integral of an output is computed: from samples at the resolution of the defuzzifier, in
+         * closed form from the pieces of a PiecewiseLinear, as the Exact defuzzifiers do, when it applies, or
+         * from the prefix sums of a SampledArea, as PrefixSumBisector does.
+         */
+        enum IntegralForm {
+            SAMPLED, PIECEWISE_LINEAR, PREFIX_SUM
+        };
+
+        enum OpCode {
+            LOAD_SLOT, LOAD_OUTPUT, CONJUNCTION, DISJUNCTION
+        };
+
+        struct Instruction {
+            OpCode code;
+            int operand;
+        };
+
+        /**
+         * A distinct proposition "variable is [hedges] term" shared by every rule that mentions it.
+         * Hedges are stored in the order they are applied, that is, reversed from the rule text. Inputs
+         * outside [supportStart, supportEnd] skip the membership function and take outsideSupport, which
+         * is the hedged value of zero.
+         */
+        struct Slot {
+            const Variable* variable;
+            int variableIndex;
+            const Term* term;
+            int firstHedge, numberOfHedges;
+            bool constant;
+            scalar supportStart, supportEnd;
+            scalar outsideSupport;
+        };
+
+        /**
+         * The row of the term in the matrix of Linear coefficients, or -1 if its output is not a LinearOutput.
+         * Its hedges are those of the enabled conclusions before it in the rule followed by its own, because
+         * Consequent::modify() hedges the activation degree in place, so in fuzzylite 5.0 the hedges of a
+         * conclusion also apply to the conclusions after it.
+         */
+        struct Conclusion {
+            int outputIndex;
+            int row;
+            const Term* term;
+            int firstHedge, numberOfHedges;
+        };
+
+        /**
+         * The slots in [firstRequired, firstRequired + numberOfRequired) of requiredSlots() are those that
+         * make the antecedent zero when any of them is zero, so the rule cannot fire unless all are non-zero.
+         */
+        struct CompiledRule {
+            int firstInstruction, numberOfInstructions;
+            int firstConclusion, numberOfConclusions;
+            int firstRequired, numberOfRequired;
+            scalar weight;
+        };
+
+        struct CompiledBlock {
+            NormCode conjunctionCode, disjunctionCode;
+            NormPair normPair;
+            const TNorm* conjunction;
+            const SNorm* disjunction;
+            const TNorm* activation;
+            int firstRule, numberOfRules;
+        };
+
+        /**
+         * A Takagi-Sugeno output whose conclusions are all Linear terms, defuzzified by WeightedAverage or
+         * WeightedSum. Its terms are rows [firstRow, firstRow + numberOfRows) of a dense matrix of their
+         * coefficients, one column per input variable plus the constant, sorted by the address of their terms
+         * as the defuzzifiers group them for accumulation, so it is defuzzified against the input values read
+         * once instead of a virtual Linear::membership() per activated term.
+         */
+        struct LinearOutput {
+            int outputIndex;
+            bool average;
+            const SNorm* accumulation;
+            NormCode accumulationCode;
+            int firstRow, numberOfRows;
+        };
+
+    protected:
+        Engine* _engine;
+        scalar _macheps;
+        std::vector<Slot> _slots;
+        std::vector<MembershipKernel> _kernels;
+        std::vector<int> _inputSlots;
+        std::vector<int> _inputSlotOffsets;
+        std::vector<const Hedge*> _hedges;
+        std::vector<Instruction> _instructions;
+        std::vector<Conclusion> _conclusions;
+        std::vector<CompiledRule> _rules;
+        std::vector<CompiledBlock> _blocks;
+        std::vector<int> _requiredSlots;
+        std::vector<int> _ruleIndexStart, _ruleIndex;
+        std::vector<int> _unindexedRules;
+        std::vector<Accumulated*> _fuzzyOutputs;
+        std::vector<int> _numberOfConclusions;
+        std::vector<LinearOutput> _linearOutputs;
+        std::vector<int> _linearOutputIndex;
+        std::vector<const Term*> _linearTerms;
+        std::vector<scalar> _linearCoefficients;
+        std::vector<std::pair<const Term*, int> > _linearRowTable;
+        int _linearColumns;
+        std::vector<IntegralCode> _integralCodes;
+        std::vector<IntegralForm> _integralForms;
+        std::vector<PiecewiseLinear> _piecewiseLinears;
+        std::vector<SampledArea> _sampledAreas;
+
+        ActivationPool _pool;
+        std::vector<scalar> _slotValues;
+        std::vector<scalar> _stack;
+        std::vector<int> _activeRules;
+        std::vector<scalar> _inputValues;
+        std::vector<scalar> _linearDegrees;
+        AccumulatedKernel* _fuzzyOutputKernel;
+
+        bool _memoized, _memoizable, _memoValid;
+        scalar _inputTolerance;
+        std::vector<scalar> _lastInputValues;
+        std::vector<bool> _lastInputEnabled;
+        std::vector<scalar> _lastOutputValues;
+
+        bool _batchable;
+        std::vector<scalar> _batchSlotValues;
+        std::vector<scalar> _batchStack;
+        std::vector<scalar> _batchDegrees;
+        bool _linearBatchable;
+        std::vector<scalar> _batchLinearValues, _batchAccumulated;
+        std::vector<scalar> _batchSums, _batchWeights, _batchFired;
+        std::vector<bool> _batchLinearRows;
+
+        virtual int compileSlot(const Variable* variable, const Term* term,
+                const std::vector<Hedge*>& hedges);
+        virtual int compileExpression(const Expression* node, const Rule* rule,
+                const CompiledBlock& block, int depth);
+        virtual void compileRuleIndex();
+        virtual void compileLinearOutputs();
+        virtual void compileIntegralOutputs();
+
+        /**
+         * Same as OutputVariable::defuzzify() of the output variable.
+         */
+        virtual void defuzzify(int outputIndex);
+
+        template <typename Conjunction, typename Disjunction>
+        scalar evaluateWith(const Conjunction& conjunction, const Disjunction& disjunction,
+                const CompiledRule& rule, const scalar* slotValues, scalar* stack,
+                const std::vector<Accumulated*>& fuzzyOutputs) const;
+        template <typename Conjunction, typename Disjunction>
+        int fireWith(const Conjunction& conjunction, const Disjunction& disjunction,
+                const CompiledBlock& block, const int* activeRules, int active, int numberOfActiveRules,
+                const scalar* slotValues, scalar* stack,
+                const std::vector<Accumulated*>& fuzzyOutputs, ActivationPool& pool) const;
+
+        virtual void fuzzifyBatch(const Slot& slot, const MembershipKernel& kernel,
+                const scalar* x, scalar* result, int size) const;
+        virtual void evaluateBatch(const CompiledRule& rule, const CompiledBlock& block,
+                scalar* degrees, int size);
+        /**
+         * Defuzzifies the output for the samples [start, start + size) from the rule degrees of the chunk,
+         * updating the output variable as OutputVariable::defuzzify() would one sample after another. The
+         * active rules, in ascending order, are those that fire for any of the samples.
+         */
+        virtual void processLinearBatch(const LinearOutput& output, const int* activeRules,
+                int numberOfActiveRules, int firings, const std::vector<const scalar*>& inputs,
+                int start, int size, scalar* outputValues);
+        /**
+         * Weighted sums of the output for each sample of the chunk, from the rows of the rules that fire
+         * for that sample, for chunks where few rules fire per sample.
+         */
+        virtual void processLinearSamples(const LinearOutput& output, const int* activeRules,
+                int numberOfActiveRules, const std::vector<const scalar*>& inputs, int start, int size);
+        /**
+         * Weighted sums of the output for each sample of the chunk, from the product of the matrix of the
+         * active rows with the inputs of the whole chunk.
+         */
+        virtual void processLinearChunk(const LinearOutput& output, const int* activeRules,
+                int numberOfActiveRules, const std::vector<const scalar*>& inputs, int start, int size);
+
+    public:
+        static const int BatchSize = 64;
+
+        explicit CompiledEngine(Engine* engine = fl::null);
+        virtual ~CompiledEngine();
+
+        /**
+         * Lowers the rule blocks of the engine into the plan. It also indexes the rules by the input slots
+         * that their antecedents require to be non-zero (see activeRules()), and sizes the ActivationPool
+         * from the conclusions of the rules, so that steady-state evaluation does not allocate.
+         */
+        virtual void compile(Engine* engine);
+        virtual void compile();
+        virtual bool isCompiled() const;
+        virtual void clear();
+
+        /**
+         * Same as Engine::process(). The slots of the inputs are fuzzified first, and then only the rules that
+         * activeRules() finds can fire are evaluated, which with overlapping partitions is a small fraction of
+         * a large rule base. Fired rules activate their conclusions with Activated terms from the pool.
+         */
+        virtual void process();
+
+        /**
+         * Whether process() skips the work for inputs that did not change (true by default): only the slots
+         * of input variables that moved by more than the input tolerance are fuzzified again, and when no
+         * input moved, and the output values are still the ones it computed, the rules and defuzzifiers are
+         * skipped and the previous outputs kept. The plan is not memoizable when the input terms read other
+         * values of the engine (Linear or Function), in which case process() always evaluates everything.
+         */
+        virtual void setMemoized(bool memoized);
+        virtual bool isMemoized() const;
+        virtual bool isMemoizable() const;
+        /**
+         * Inputs that moved by at most the tolerance count as unchanged (0.0 by default, that is, only
+         * equal values, which keeps the outputs exact).
+         */
+        virtual void setInputTolerance(scalar tolerance);
+        virtual scalar getInputTolerance() const;
+        /**
+         * Makes the next process() evaluate everything, as needed after calling Engine::process() in between.
+         */
+        virtual void invalidate();
+
+        /**
+         * Evaluates size samples at once. inputs holds one array per input variable and outputs one
+         * array per output variable (or null to skip it), in the order they are registered in the
+         * engine. Samples are processed in order, so the engine is left in the state of the last one.
+         * Each stage of the plan runs across a chunk of BatchSize samples at a time, so the inner loops are
+         * flat and vectorizable. When every output is a LinearOutput, a chunk multiplies the matrix of
+         * coefficients by its inputs and reduces the weighted sums across samples.
+         */
+        virtual void processBatch(const std::vector<const scalar*>& inputs,
+                const std::vector<scalar*>& outputs, int size);
+        virtual bool isBatchable() const;
+
+        virtual Engine* getEngine() const;
+
+        virtual int numberOfSlots() const;
+        virtual int numberOfInstructions() const;
+        virtual int numberOfRules() const;
+        /**
+         * Number of conclusions on the output variable, that is, the most terms its fuzzy output can hold.
+         */
+        virtual int numberOfConclusions(int outputIndex) const;
+
+        virtual const std::vector<Slot>& slots() const;
+        virtual const std::vector<int>& inputSlots() const;
+        /**
+         * The slots of input variable i are inputSlots()[inputSlotOffsets()[i]] up to (excluding)
+         * inputSlots()[inputSlotOffsets()[i + 1]].
+         */
+        virtual const std::vector<int>& inputSlotOffsets() const;
+        virtual const std::vector<CompiledRule>& rules() const;
+        virtual const std::vector<CompiledBlock>& blocks() const;
+        virtual const std::vector<int>& requiredSlots() const;
+        virtual const std::vector<Instruction>& instructions() const;
+        virtual const std::vector<Conclusion>& conclusions() const;
+        /**
+         * The hedges of the slots and conclusions, each in the order they are applied.
+         */
+        virtual const std::vector<const Hedge*>& hedges() const;
+        virtual const std::vector<scalar>& constantSlotValues() const;
+        virtual const std::vector<LinearOutput>& linearOutputs() const;
+        /**
+         * Index in linearOutputs() of the output variable, or -1 if it is defuzzified by its defuzzifier.
+         */
+        virtual int linearOutputIndex(int outputIndex) const;
+        virtual const std::vector<const Term*>& linearTerms() const;
+        /**
+         * Row-major matrix with a row per linear term: its coefficient of each input variable and then its
+         * constant, which is zero for terms without one.
+         */
+        virtual const std::vector<scalar>& linearCoefficients() const;
+        /**
+         * Most rows of a single LinearOutput, which is the scratch space defuzzifyLinear() needs.
+         */
+        virtual int maximumLinearRows() const;
+        virtual IntegralCode integralOutputCode(int outputIndex) const;
+        virtual IntegralForm integralOutputForm(int outputIndex) const;
+        /**
+         * The samples of the fuzzy output of an output of the PREFIX_SUM form, as the last process() took
+         * them to find its bisector, so that its centroid, for instance, costs no further pass over the
+         * membership function. It is empty for outputs of other forms.
+         */
+        virtual const SampledArea& sampledOutput(int outputIndex) const;
+        virtual int stackSize() const;
+        virtual scalar getMacheps() const;
+
+        /**
+         * Membership of x in the term of an input slot, or the constant value of the slot, with its hedges
+         * applied.
+         */
+        virtual scalar fuzzify(const Slot& slot, scalar x) const;
+        /**
+         * Activation degree of the term of an output slot in the given fuzzy output, with its hedges applied.
+         */
+        virtual scalar fuzzify(const Slot& slot, const Accumulated* fuzzyOutput) const;
+        virtual scalar applyHedges(int firstHedge, int numberOfHedges, scalar x) const;
+        /**
+         * Writes to rules, in ascending order, the indices of the rules whose required slots are all
+         * non-zero in the given slot values, and returns how many there are. Rules that are left out
+         * would have an activation degree of zero (or NaN), so they would not fire anyway. The array must
+         * have room for numberOfRules() indices.
+         */
+        virtual int activeRules(const scalar* slotValues, int* rules) const;
+        /**
+         * Degree of the antecedent of the rule (without its weight) from the given slot values, using
+         * the stack as scratch space and the fuzzy outputs for propositions on output variables.
+         */
+        virtual scalar evaluate(const CompiledRule& rule, const CompiledBlock& block,
+                const scalar* slotValues, scalar* stack,
+                const std::vector<Accumulated*>& fuzzyOutputs) const;
+        /**
+         * Evaluates the rules of the block among activeRules[active, numberOfActiveRules), activating the
+         * conclusions of those that fire, and returns the position of the first rule past the block. The rule
+         * loop is instantiated for the NormPair of the block.
+         */
+        virtual int fire(const CompiledBlock& block, const int* activeRules, int active, int numberOfActiveRules,
+                const scalar* slotValues, scalar* stack,
+                const std::vector<Accumulated*>& fuzzyOutputs, ActivationPool& pool) const;
+        /**
+         * Activates the conclusions of the rule in the given fuzzy outputs with terms from the pool.
+         */
+        virtual void activate(const CompiledRule& rule, const CompiledBlock& block, scalar degree,
+                const std::vector<Accumulated*>& fuzzyOutputs, ActivationPool& pool) const;
+        /**
+         * Row of the term in the matrix of Linear coefficients, or -1 if it is not a term of a LinearOutput.
+         */
+        virtual int linearRow(const Term* term) const;
+        /**
+         * Same as Linear::membership() of the term in the row, with the given values of the input variables.
+         */
+        virtual scalar linearValue(int row, const scalar* inputValues) const;
+        /**
+         * Same as WeightedAverage::defuzzify() or WeightedSum::defuzzify() of the fuzzy output, with the
+         * given values of the input variables and rowDegrees as scratch space for maximumLinearRows() values.
+         */
+        virtual scalar defuzzifyLinear(const LinearOutput& output, const Accumulated* fuzzyOutput,
+                const scalar* inputValues, scalar* rowDegrees) const;
+        /**
+         * Same as the integral defuzzifier of the output variable on its fuzzy output, given as a kernel set
+         * to it, which is a flat snapshot of the fuzzy output sampled instead of the virtual membership
+         * functions of the Accumulated, Activated and norms, with piecewiseLinear as the storage of its pieces for the PIECEWISE_LINEAR form and
+         * sampledArea that of its samples for the PREFIX_SUM form. The output must have an
+         * integralOutputCode() other than NOT_INTEGRAL.
+         */
+        virtual scalar defuzzifyIntegral(int outputIndex, const AccumulatedKernel& fuzzyOutput,
+                PiecewiseLinear& piecewiseLinear, SampledArea& sampledArea) const;
+
+        virtual std::string toString() const;
+
+        /**
+         * Whether value is within tolerance of last, counting NaN as equal to NaN.
+         */
+        static bool isUnchanged(scalar value, scalar last, scalar tolerance);
+        static NormCode normCode(const Norm* norm);
+        static IntegralCode integralCode(const Defuzzifier* defuzzifier);
+        /**
+         * The integral of the stock defuzzifiers and also of the Exact ones and PrefixSumBisector, with the
+         * form it is computed in.
+         */
+        static IntegralCode integralCode(const Defuzzifier* defuzzifier, IntegralForm& form);
+        static NormPair normPair(NormCode conjunctionCode, NormCode disjunctionCode);
+        static scalar compute(NormCode code, const Norm* norm, scalar a, scalar b);
+        static std::size_t linearHash(const Term* term);
+        static void compute(NormCode code, const Norm* norm, scalar* a, const scalar* b, int size);
+
+    private:
+        FL_DISABLE_COPY(CompiledEngine)
+    };
+
+}
+#endif /* FL_COMPILEDENGINE_H */
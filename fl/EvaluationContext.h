@@ -0,0 +1,95 @@
+// EvaluationContext.h
+//
+// Purpose: Per-thread evaluation state for a compiled fl::Engine.
+// Detail: An Engine keeps its input values, fuzzy outputs and output values inside the variables of the
+// model, so it can only be evaluated by one thread at a time. An EvaluationContext holds its own copy of
+// that mutable state and runs the read-only plan of a CompiledEngine against it, so any number of threads
+// can share one configured engine, each with its own context, without locks or Engine::clone(). Linear and
+// Function terms read their variables from the context instead of the engine, and CompiledFunction terms
+// run their instructions on a stack of the context.
+
+#ifndef FL_EVALUATIONCONTEXT_H
+#define FL_EVALUATIONCONTEXT_H
+
+#include "fl/fuzzylite.h"
+
+#include "fl/ActivationPool.h"
+#include "fl/CompiledEngine.h"
+#include "fl/term/AccumulatedKernel.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fl {
+    class Accumulated;
+    class Term;
+
+    class EvaluationContext {
+    protected:
+        const CompiledEngine* _model;
+        std::vector<scalar> _inputValues;
+        std::vector<scalar> _outputValues, _previousOutputValues;
+        std::vector<scalar> _lastInputValues;
+        std::vector<bool> _lastInputEnabled;
+        bool _evaluated;
+        std::vector<Accumulated*> _fuzzyOutputs;
+        ActivationPool _pool;
+        std::vector<bool> _engineDependentOutputs;
+        std::vector<bool> _engineDependentSlots;
+
+        std::vector<scalar> _slotValues;
+        std::vector<scalar> _stack;
+        std::vector<int> _activeRules;
+        std::map<std::string, scalar> _functionVariables;
+        std::vector<scalar> _functionStack;
+        std::vector<scalar> _linearDegrees;
+        AccumulatedKernel _fuzzyOutputKernel;
+        std::vector<PiecewiseLinear> _piecewiseLinears;
+        std::vector<SampledArea> _sampledAreas;
+
+        virtual scalar membership(const Term* term, scalar x);
+        virtual scalar defuzzify(int outputIndex);
+        virtual scalar defuzzifyWeighted(int outputIndex);
+
+    public:
+        explicit EvaluationContext(const CompiledEngine* model);
+        virtual ~EvaluationContext();
+
+        virtual const CompiledEngine* getModel() const;
+
+        virtual void setInputValue(int inputIndex, scalar value);
+        virtual void setInputValue(const std::string& name, scalar value);
+        virtual scalar getInputValue(int inputIndex) const;
+
+        virtual scalar getOutputValue(int outputIndex) const;
+        virtual scalar getOutputValue(const std::string& name) const;
+        virtual scalar getPreviousOutputValue(int outputIndex) const;
+        virtual const Accumulated* fuzzyOutput(int outputIndex) const;
+        /**
+         * Same as CompiledEngine::sampledOutput(), for the last process() of this context.
+         */
+        virtual const SampledArea& sampledOutput(int outputIndex) const;
+
+        virtual int numberOfInputs() const;
+        virtual int numberOfOutputs() const;
+
+        /**
+         * Same as Engine::process(), but reading and writing only the state of this context. Follows the
+         * memoization settings of the model, so inputs that did not change are not fuzzified again.
+         */
+        virtual void process();
+        virtual void restart();
+
+        /**
+         * Copies the output values of this context into the output variables of the engine, for code
+         * that reads them from there after processing.
+         */
+        virtual void writeOutputValues();
+
+    private:
+        FL_DISABLE_COPY(EvaluationContext)
+    };
+
+}
+#endif /* FL_EVALUATIONCONTEXT_H */
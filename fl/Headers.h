@@ -27,17 +27,33 @@
 
 #include "fl/fuzzylite.h"
 
+#include "fl/ActivationPool.h"
+#include "fl/CompiledEngine.h"
 #include "fl/Console.h"
 #include "fl/Engine.h"
+#include "fl/EvaluationContext.h"
 #include "fl/Exception.h"
+#include "fl/LookupEngine.h"
+#include "fl/TypedEngine.h"
+#include "fl/TypedKernel.h"
 
+#include "fl/defuzzifier/AdaptiveArea.h"
+#include "fl/defuzzifier/AdaptiveDefuzzifier.h"
 #include "fl/defuzzifier/Bisector.h"
 #include "fl/defuzzifier/Centroid.h"
 #include "fl/defuzzifier/Defuzzifier.h"
+#include "fl/defuzzifier/ExactBisector.h"
+#include "fl/defuzzifier/ExactCentroid.h"
+#include "fl/defuzzifier/ExactLargestOfMaximum.h"
+#include "fl/defuzzifier/ExactMeanOfMaximum.h"
+#include "fl/defuzzifier/ExactSmallestOfMaximum.h"
 #include "fl/defuzzifier/IntegralDefuzzifier.h"
 #include "fl/defuzzifier/SmallestOfMaximum.h"
 #include "fl/defuzzifier/LargestOfMaximum.h"
 #include "fl/defuzzifier/MeanOfMaximum.h"
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/defuzzifier/PrefixSumBisector.h"
+#include "fl/defuzzifier/SampledArea.h"
 #include "fl/defuzzifier/WeightedAverage.h"
 #include "fl/defuzzifier/WeightedDefuzzifier.h"
 #include "fl/defuzzifier/WeightedSum.h"
@@ -52,15 +68,22 @@
 #include "fl/factory/TNormFactory.h"
 #include "fl/factory/TermFactory.h"
 
+#include "fl/imex/CachedImporter.h"
 #include "fl/imex/CppExporter.h"
+#include "fl/imex/EngineCache.h"
 #include "fl/imex/FclImporter.h"
 #include "fl/imex/FclExporter.h"
+#include "fl/imex/FlbExporter.h"
+#include "fl/imex/FlbImage.h"
+#include "fl/imex/FlbImporter.h"
 #include "fl/imex/FisImporter.h"
 #include "fl/imex/FisExporter.h"
 #include "fl/imex/FldExporter.h"
 #include "fl/imex/FllImporter.h"
 #include "fl/imex/FllExporter.h"
 #include "fl/imex/JavaExporter.h"
+#include "fl/imex/KernelExporter.h"
+#include "fl/imex/StreamingFldExporter.h"
 
 #include "fl/hedge/Any.h"
 #include "fl/hedge/Extremely.h"
@@ -97,10 +120,13 @@
 #include "fl/rule/Consequent.h"
 #include "fl/rule/Rule.h"
 #include "fl/rule/RuleBlock.h"
+#include "fl/rule/RuleLoader.h"
 #include "fl/rule/Expression.h"
 
 #include "fl/term/Accumulated.h"
+#include "fl/term/AccumulatedKernel.h"
 #include "fl/term/Bell.h"
+#include "fl/term/CompiledFunction.h"
 #include "fl/term/Concave.h"
 #include "fl/term/Constant.h"
 #include "fl/term/Cosine.h"
@@ -109,6 +135,7 @@
 #include "fl/term/Gaussian.h"
 #include "fl/term/GaussianProduct.h"
 #include "fl/term/Linear.h"
+#include "fl/term/MembershipKernel.h"
 #include "fl/term/PiShape.h"
 #include "fl/term/Ramp.h"
 #include "fl/term/Rectangle.h"
@@ -116,6 +143,7 @@
 #include "fl/term/Sigmoid.h"
 #include "fl/term/SigmoidDifference.h"
 #include "fl/term/SigmoidProduct.h"
+#include "fl/term/SortedDiscrete.h"
 #include "fl/term/Spike.h"
 #include "fl/term/Term.h"
 #include "fl/term/Activated.h"
@@ -125,6 +153,7 @@
 
 #include "fl/variable/InputVariable.h"
 #include "fl/variable/OutputVariable.h"
+#include "fl/variable/TermIndex.h"
 #include "fl/variable/Variable.h"
 
 
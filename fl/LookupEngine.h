@@ -0,0 +1,89 @@
+// LookupEngine.h
+//
+// Purpose: Precomputed control-surface surrogate for a configured fl::Engine with few inputs.
+// Detail: bake() evaluates the engine once on a regular grid spanning the range of every input variable
+// and stores the outputs in a dense table. process() then replaces the full inference with a multilinear
+// interpolation between the 2^n grid points around the current inputs, which costs the same no matter how
+// many rules or how fine a defuzzifier the engine has. The error of the surrogate is measured against the
+// engine at the centre of every grid cell, where interpolation is least accurate.
+
+#ifndef FL_LOOKUPENGINE_H
+#define FL_LOOKUPENGINE_H
+
+#include "fl/fuzzylite.h"
+
+#include <string>
+#include <vector>
+
+namespace fl {
+    class Engine;
+
+    class LookupEngine {
+    public:
+        static const int MaximumNumberOfInputs = 4;
+
+    protected:
+        Engine* _engine;
+        std::vector<int> _resolution;
+        std::vector<scalar> _minimum, _step;
+        std::vector<int> _cells, _stride;
+        std::vector<scalar> _table;
+        std::vector<scalar> _maximumError, _meanError;
+        std::vector<scalar> _inputs, _outputs;
+
+        virtual void evaluateGrid(const std::vector<int>& resolution, scalar offset,
+                std::vector<scalar>& inputs, std::vector<scalar>& outputs);
+
+    public:
+        explicit LookupEngine(Engine* engine = fl::null, int resolution = 33);
+        virtual ~LookupEngine();
+
+        virtual void setResolution(int resolution);
+        virtual void setResolution(const std::vector<int>& resolution);
+        virtual const std::vector<int>& getResolution() const;
+
+        /**
+         * Evaluates the engine on the grid. Every input variable must have a finite range whose maximum
+         * is greater than its minimum.
+         */
+        virtual void bake(Engine* engine);
+        virtual void bake();
+        virtual bool isBaked() const;
+        virtual void clear();
+
+        /**
+         * Interpolates the table at the given inputs, one value per input variable, and writes one value
+         * per output variable, in the order they are registered in the engine. Inputs outside the range
+         * of their variable are clamped to it, and NaN inputs give NaN outputs.
+         */
+        virtual void lookup(const scalar* inputs, scalar* outputs) const;
+
+        /**
+         * Drop-in replacement for Engine::process(): reads the input values of the engine and sets the
+         * output values of its output variables, leaving their fuzzy outputs untouched.
+         */
+        virtual void process();
+
+        /**
+         * Compares the table against the engine at the centres of the grid cells, or at a grid of the
+         * given number of points per input placed halfway between the points of a regular grid. A point
+         * where only one of them is NaN, such as near the edge of an output with a NaN default value,
+         * counts as an infinite error.
+         */
+        virtual void measureError();
+        virtual void measureError(int resolution);
+        virtual void measureError(const std::vector<int>& resolution);
+        virtual scalar getMaximumError(int outputIndex) const;
+        virtual scalar getMeanError(int outputIndex) const;
+
+        virtual Engine* getEngine() const;
+        virtual int numberOfPoints() const;
+
+        virtual std::string toString() const;
+
+    private:
+        FL_DISABLE_COPY(LookupEngine)
+    };
+
+}
+#endif /* FL_LOOKUPENGINE_H */
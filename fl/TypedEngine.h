@@ -0,0 +1,216 @@
+// TypedEngine.h
+//
+// Purpose: Compiled evaluation of an fl::Engine in float or double, independently of fl::scalar.
+// Detail: fuzzylite fixes the precision of every value at compile time with FL_USE_FLOAT, so one program
+// cannot run float engines, which fit twice the values per SIMD register and per cache line, next to double
+// ones. A TypedEngine<T> converts the plan of a CompiledEngine into values of type T: the parameters of the
+// terms, the rule weights and the coefficients of Linear terms, with the membership functions, the norms,
+// the rules and the defuzzifiers evaluated in T by TypedKernel<T>, the same code CompiledEngine evaluates in
+// scalar. FloatEngine and DoubleEngine are both compiled into the library, so any number of either can be
+// used side by side, each from one configured engine.
+// The inputs and outputs live in the TypedEngine, so the engine itself is never written. Terms of classes
+// other than those MembershipKernel recognizes, custom norms and hedges are evaluated by the engine in
+// scalar and converted, so the engine must outlive its typed engines, and compile() again after changing it.
+// CompiledFunction terms of the engine are evaluated on the values of the typed engine converted to scalar,
+// while compile() throws for plain Function terms of the engine, which read the values of the engine itself.
+// Outputs are defuzzified by Centroid, Bisector, MeanOfMaximum, SmallestOfMaximum or LargestOfMaximum
+// (including their subclasses, sampled at their resolution), or by WeightedAverage or WeightedSum on Constant,
+// Linear and CompiledFunction terms. compile() throws for any other defuzzifier.
+
+#ifndef FL_TYPEDENGINE_H
+#define FL_TYPEDENGINE_H
+
+#include "fl/fuzzylite.h"
+
+#include "fl/CompiledEngine.h"
+#include "fl/TypedKernel.h"
+#include "fl/term/MembershipKernel.h"
+
+#include <string>
+#include <vector>
+
+namespace fl {
+    class CompiledFunction;
+    class Engine;
+    class Variable;
+    class OutputVariable;
+    class Term;
+    class Hedge;
+    class TNorm;
+    class SNorm;
+
+    template <typename T>
+    class TypedEngine {
+    public:
+
+        /**
+         * A term converted to T. Linear terms of the engine are rows of the matrix of coefficients,
+         * CompiledFunction terms of the engine are its function, and other terms of unknown shape are
+         * evaluated by their membership function in scalar. The term is zero outside [supportStart,
+         * supportEnd], which is unbounded for shapes without a known support.
+         */
+        struct TypedTerm {
+            const Term* term;
+            const CompiledFunction* function;
+            MembershipKernel::Shape shape;
+            T height;
+            T parameters[4];
+            T supportStart, supportEnd;
+            int linearRow, linearInputs;
+        };
+
+        struct TypedSlot {
+            const Variable* variable;
+            int variableIndex;
+            bool input, enabled, constant;
+            int term;
+            int firstHedge, numberOfHedges;
+            T supportStart, supportEnd;
+            T outsideSupport, constantValue;
+        };
+
+        struct TypedRule {
+            int firstInstruction, numberOfInstructions;
+            int firstConclusion, numberOfConclusions;
+            int firstRequired, numberOfRequired;
+            T weight;
+        };
+
+        struct TypedBlock {
+            CompiledEngine::NormCode conjunctionCode, disjunctionCode, activationCode;
+            const TNorm* conjunction;
+            const SNorm* disjunction;
+            const TNorm* activation;
+            int firstRule, numberOfRules;
+        };
+
+        struct TypedConclusion {
+            int outputIndex;
+            int term;
+            int firstHedge, numberOfHedges;
+            int block;
+        };
+
+        /**
+         * The settings of an output variable and of its defuzzifier, read at compile().
+         */
+        struct TypedOutput {
+            const OutputVariable* variable;
+            bool enabled;
+            CompiledEngine::IntegralCode integral;
+            bool weighted, average;
+            int resolution;
+            T minimum, maximum, defaultValue;
+            bool lockPreviousValue, lockValueInRange;
+            CompiledEngine::NormCode accumulationCode;
+            const SNorm* accumulation;
+        };
+
+        /**
+         * A conclusion activated in a fuzzy output, as an Activated term is in an Accumulated.
+         */
+        struct TypedActivation {
+            int term;
+            T degree;
+            int block;
+        };
+
+    protected:
+        typedef TypedKernel<T> Kernel;
+
+        const Engine* _engine;
+        T _macheps;
+        std::vector<TypedTerm> _terms;
+        std::vector<T> _linearCoefficients;
+        int _linearColumns;
+        std::vector<TypedSlot> _slots;
+        std::vector<const Hedge*> _hedges;
+        std::vector<CompiledEngine::Instruction> _instructions;
+        std::vector<TypedConclusion> _conclusions;
+        std::vector<TypedRule> _rules;
+        std::vector<TypedBlock> _blocks;
+        std::vector<int> _requiredSlots;
+        std::vector<TypedOutput> _outputs;
+
+        std::vector<T> _inputValues;
+        std::vector<T> _outputValues, _previousOutputValues;
+        std::vector<std::vector<TypedActivation> > _fuzzyOutputs;
+        std::vector<T> _slotValues;
+        std::vector<T> _stack;
+        std::vector<T> _x, _y, _values, _degreeValues;
+        std::vector<int> _groupIndex, _groupTerms;
+        std::vector<T> _groupDegrees;
+        mutable std::vector<scalar> _functionInputs, _functionOutputs, _functionStack;
+
+        virtual int compileTerm(const Term* term);
+        virtual void compileOutput(int outputIndex, const std::vector<int>& conclusionTerms);
+
+        virtual T evaluate(const TypedRule& rule, const TypedBlock& block);
+        virtual T activationDegree(const TypedSlot& slot) const;
+        virtual T applyHedges(int firstHedge, int numberOfHedges, T x) const;
+        virtual T defuzzify(int outputIndex);
+        virtual T defuzzifyIntegral(int outputIndex);
+        virtual T defuzzifyWeighted(int outputIndex);
+        /**
+         * The samples [first, last) of the fuzzy output, sampled at minimum + (i + 0.5) * dx, that are not
+         * outside the support of the term.
+         */
+        virtual void supportSamples(const TypedTerm& term, T minimum, T dx, int resolution,
+                int& first, int& last) const;
+
+    public:
+        explicit TypedEngine(const CompiledEngine* model = fl::null);
+        virtual ~TypedEngine();
+
+        /**
+         * Converts the plan of the compiled engine, which can be discarded afterwards.
+         */
+        virtual void compile(const CompiledEngine* model);
+        /**
+         * Compiles the engine and converts its plan.
+         */
+        virtual void compile(Engine* engine);
+        virtual bool isCompiled() const;
+
+        virtual void setInputValue(int inputIndex, T value);
+        virtual T getInputValue(int inputIndex) const;
+        virtual T getOutputValue(int outputIndex) const;
+        virtual T getPreviousOutputValue(int outputIndex) const;
+
+        virtual int numberOfInputs() const;
+        virtual int numberOfOutputs() const;
+        virtual int numberOfTerms() const;
+
+        /**
+         * Same as Engine::process() on the converted engine, in T.
+         */
+        virtual void process();
+        /**
+         * Evaluates size samples, from one array per input and into one array per output (or null to skip
+         * it), in order, so the typed engine is left in the state of the last one.
+         */
+        virtual void processBatch(const std::vector<const T*>& inputs,
+                const std::vector<T*>& outputs, int size);
+        /**
+         * Clears the output values and the previous ones.
+         */
+        virtual void restart();
+
+        virtual const Engine* getEngine() const;
+        virtual const std::vector<TypedTerm>& terms() const;
+
+        /**
+         * Same as term->membership(x), in T.
+         */
+        virtual T membership(const TypedTerm& term, T x) const;
+        virtual void membership(const TypedTerm& term, const T* x, T* y, int size) const;
+
+    private:
+        FL_DISABLE_COPY(TypedEngine)
+    };
+
+    typedef TypedEngine<float> FloatEngine;
+    typedef TypedEngine<double> DoubleEngine;
+
+}
+#endif /* FL_TYPEDENGINE_H */
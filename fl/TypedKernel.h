@@ -0,0 +1,234 @@
+// TypedKernel.h
+//
+// Purpose: The membership functions, norms and integral defuzzifiers of the compiled engines, in float or double.
+// Detail: CompiledEngine, AccumulatedKernel and MembershipKernel evaluate in fl::scalar and TypedEngine in any
+// T, and all of them evaluate through TypedKernel<scalar> or TypedKernel<T>, so each formula is written once.
+// The membership functions are those of fuzzylite 5.0 and the comparisons those of fl::Operation, within the
+// macheps given, so TypedKernel<scalar> returns exactly what the terms and norms do. The comparisons and the
+// norms are defined here to be inlined into the rule loops; the rest is instantiated for float and double in
+// TypedKernel.cpp.
+
+#ifndef FL_TYPEDKERNEL_H
+#define FL_TYPEDKERNEL_H
+
+#include "fl/fuzzylite.h"
+
+#include "fl/CompiledEngine.h"
+#include "fl/term/MembershipKernel.h"
+
+#include <cmath>
+#include <limits>
+
+namespace fl {
+    class Norm;
+
+    template <typename T>
+    class TypedKernel {
+    public:
+
+        static bool isEq(T a, T b, T macheps) {
+            return a == b or std::fabs(a - b) < macheps or (a != a and b != b);
+        }
+
+        static bool isLt(T a, T b, T macheps) {
+            return not isEq(a, b, macheps) and a < b;
+        }
+
+        static bool isLE(T a, T b, T macheps) {
+            return isEq(a, b, macheps) or a < b;
+        }
+
+        static bool isGt(T a, T b, T macheps) {
+            return not isEq(a, b, macheps) and a > b;
+        }
+
+        static bool isGE(T a, T b, T macheps) {
+            return isEq(a, b, macheps) or a > b;
+        }
+
+        static bool isFinite(T x) {
+            return x == x and std::fabs(x) != std::numeric_limits<T>::infinity();
+        }
+
+        /**
+         * The stock norms. NaN operands are handled as in Op::min and Op::max, which ignore them.
+         */
+        static T minimum(T a, T b) {
+            if (a != a) return b;
+            if (b != b) return a;
+            return a < b ? a : b;
+        }
+
+        static T maximum(T a, T b) {
+            if (a != a) return b;
+            if (b != b) return a;
+            return a > b ? a : b;
+        }
+
+        static T algebraicProduct(T a, T b) {
+            return a * b;
+        }
+
+        static T algebraicSum(T a, T b) {
+            return a + b - (a * b);
+        }
+
+        static T boundedDifference(T a, T b) {
+            const T x = a + b - T(1);
+            return x > T(0) ? x : T(0);
+        }
+
+        static T boundedSum(T a, T b) {
+            const T x = a + b;
+            return x < T(1) ? x : T(1);
+        }
+
+        /**
+         * Same as norm->compute(a, b), for the norm of the given code.
+         */
+        static T compute(CompiledEngine::NormCode code, const Norm* norm, T a, T b);
+        /**
+         * Sets a[k] = norm->compute(a[k], b[k]) for k in [0, size).
+         */
+        static void compute(CompiledEngine::NormCode code, const Norm* norm, T* a, const T* b, int size);
+
+        /**
+         * Same as the membership function of the term of the given shape, height and parameters at x. The
+         * shape must not be MembershipKernel::UNKNOWN.
+         */
+        static T membership(MembershipKernel::Shape shape, const T* parameters, T height, T x, T macheps);
+        /**
+         * Sets y[i] to the membership function at x[i] for i in [0, size), with one loop per shape.
+         */
+        static void membership(MembershipKernel::Shape shape, const T* parameters, T height,
+                const T* x, T* y, int size, T macheps);
+
+        /**
+         * The sums of Centroid::defuzzify(), over the samples in ascending order.
+         */
+        struct CentroidSum {
+            T area, xcentroid;
+
+            CentroidSum() : area(T(0)), xcentroid(T(0)) {
+            }
+
+            void add(const T* x, const T* y, int size) {
+                for (int i = 0; i < size; ++i) {
+                    xcentroid += y[i] * x[i];
+                    area += y[i];
+                }
+            }
+
+            T value() const {
+                return xcentroid / area;
+            }
+        };
+
+        /**
+         * The walk of Bisector::defuzzify(), which adds the next sample of the side with the smaller area.
+         */
+        struct BisectorWalk {
+            T leftArea, rightArea, xLeft, xRight, macheps;
+
+            BisectorWalk(T minimum, T maximum, T macheps) : leftArea(T(0)), rightArea(T(0)),
+            xLeft(minimum), xRight(maximum), macheps(macheps) {
+            }
+
+            bool fromLeft() const {
+                return isLE(leftArea, rightArea, macheps);
+            }
+
+            void addLeft(T x, T y) {
+                xLeft = x;
+                leftArea += y;
+            }
+
+            void addRight(T x, T y) {
+                xRight = x;
+                rightArea += y;
+            }
+
+            T value() const {
+                return (leftArea * xRight + rightArea * xLeft) / (leftArea + rightArea);
+            }
+        };
+
+        /**
+         * The searches of MeanOfMaximum, SmallestOfMaximum and LargestOfMaximum, over the samples in
+         * ascending order. Each search uses only its own method.
+         */
+        struct MaximumSearch {
+            T ymax, xsmallest, xlargest, macheps;
+            bool samePlateau;
+
+            MaximumSearch(T minimum, T maximum, T macheps) : ymax(T(-1)), xsmallest(minimum), xlargest(maximum),
+            macheps(macheps), samePlateau(false) {
+            }
+
+            void mean(const T* x, const T* y, int size) {
+                for (int i = 0; i < size; ++i) {
+                    if (isGt(y[i], ymax, macheps)) {
+                        ymax = y[i];
+                        xsmallest = x[i];
+                        xlargest = x[i];
+                        samePlateau = true;
+                    } else if (isEq(y[i], ymax, macheps) and samePlateau) {
+                        xlargest = x[i];
+                    } else if (isLt(y[i], ymax, macheps)) {
+                        samePlateau = false;
+                    }
+                }
+            }
+
+            void smallest(const T* x, const T* y, int size) {
+                for (int i = 0; i < size; ++i) {
+                    if (isGt(y[i], ymax, macheps)) {
+                        xsmallest = x[i];
+                        ymax = y[i];
+                    }
+                }
+            }
+
+            void largest(const T* x, const T* y, int size) {
+                for (int i = 0; i < size; ++i) {
+                    if (isGE(y[i], ymax, macheps)) {
+                        ymax = y[i];
+                        xlargest = x[i];
+                    }
+                }
+            }
+
+            T meanValue() const {
+                return (xlargest + xsmallest) / T(2);
+            }
+        };
+
+    protected:
+        static T triangle(const T* p, T h, T x, T macheps);
+        static T trapezoid(const T* p, T h, T x, T macheps);
+        static T rectangle(const T* p, T h, T x, T macheps);
+        static T ramp(const T* p, T h, T x, T macheps);
+        static T sShape(const T* p, T h, T x, T macheps);
+        static T zShape(const T* p, T h, T x, T macheps);
+        static T piShape(const T* p, T h, T x, T macheps);
+        static T concave(const T* p, T h, T x, T macheps);
+        static T constant(const T* p, T h, T x, T macheps);
+        static T gaussian(const T* p, T h, T x, T macheps);
+        static T gaussianProduct(const T* p, T h, T x, T macheps);
+        static T bell(const T* p, T h, T x, T macheps);
+        static T sigmoid(const T* p, T h, T x, T macheps);
+        static T sigmoidDifference(const T* p, T h, T x, T macheps);
+        static T sigmoidProduct(const T* p, T h, T x, T macheps);
+        static T spike(const T* p, T h, T x, T macheps);
+        static T cosine(const T* p, T h, T x, T macheps);
+
+        template <T(*shape)(const T*, T, T, T)>
+        static void loop(const T* p, T h, const T* x, T* y, int size, T macheps) {
+            for (int i = 0; i < size; ++i) {
+                y[i] = shape(p, h, x[i], macheps);
+            }
+        }
+    };
+
+}
+#endif /* FL_TYPEDKERNEL_H */
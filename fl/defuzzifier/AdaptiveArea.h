@@ -0,0 +1,64 @@
+// AdaptiveArea.h
+//
+// Purpose: Piecewise-linear approximation of a fuzzy output from samples placed where they are needed.
+// Detail: Sampling the fuzzy output at a fixed resolution spends as many samples on flat regions as on narrow
+// terms. build() samples it first at the vertices, peaks and support ends of the terms of the output and at a
+// few evenly spaced points, and then repeatedly splits the cell whose midpoint deviates most from the chord
+// between its ends, until every deviation, weighted by the fraction of the range that the cell spans, is
+// within the tolerance or the evaluations run out. The pieces between consecutive samples are then integrated
+// and searched in closed form as a PiecewiseLinear. refineMaximum() adds samples around the maximum, whose
+// extent matters to the maximum-based defuzzifiers more than its area does.
+
+#ifndef FL_ADAPTIVEAREA_H
+#define FL_ADAPTIVEAREA_H
+
+#include "fl/defuzzifier/PiecewiseLinear.h"
+
+#include <vector>
+
+namespace fl {
+    class Term;
+
+    class AdaptiveArea : public PiecewiseLinear {
+    protected:
+        int _evaluations;
+        scalar _minimum, _maximum;
+        std::vector<scalar> _x, _y;
+
+        virtual void addBreakpoints(const Term* term, scalar minimum, scalar maximum,
+                std::vector<scalar>& breakpoints) const;
+        virtual void buildPieces();
+
+    public:
+        AdaptiveArea();
+        virtual ~AdaptiveArea() FL_IOVERRIDE;
+
+        /**
+         * The number of evenly spaced cells the range is split into before refining.
+         */
+        static int initialCells();
+
+        /**
+         * Samples the term between minimum and maximum, calling its membership function at most
+         * maximumEvaluations times (and at least three), returning false (and leaving no pieces) when the
+         * range is not finite. Terms with more breakpoints than the evaluations allow are sampled at an
+         * evenly spread subset of them.
+         */
+        virtual bool build(const Term* term, scalar minimum, scalar maximum,
+                scalar tolerance, int maximumEvaluations);
+        /**
+         * Splits the cells where the samples reach or leave the highest value until they are narrower
+         * than the tolerance times the range, so that the ends of the plateau at the maximum are located
+         * as precisely as the maximum-based defuzzifiers need.
+         */
+        virtual void refineMaximum(const Term* term, scalar tolerance, int maximumEvaluations);
+        virtual void clear() FL_IOVERRIDE;
+
+        /**
+         * The number of times the membership function was evaluated by the last build().
+         */
+        virtual int evaluations() const;
+    };
+
+}
+#endif /* FL_ADAPTIVEAREA_H */
@@ -0,0 +1,61 @@
+// AdaptiveDefuzzifier.h
+//
+// Purpose: Integral defuzzifier that samples the fuzzy output adaptively instead of at a fixed resolution.
+// Detail: The fuzzy output is approximated by an AdaptiveArea within the tolerance, with at most resolution
+// evaluations of its membership function, so narrow terms get samples around their vertices and flat regions
+// get few. The method selects what is computed from the approximation: the centroid, the bisector, or the
+// mean, smallest or largest of the maximum, as the defuzzifiers of the same names do from regular samples.
+
+#ifndef FL_ADAPTIVEDEFUZZIFIER_H
+#define FL_ADAPTIVEDEFUZZIFIER_H
+
+#include "fl/defuzzifier/IntegralDefuzzifier.h"
+
+namespace fl {
+
+    class AdaptiveDefuzzifier : public IntegralDefuzzifier {
+    public:
+
+        enum Method {
+            CENTROID, BISECTOR, MEAN_OF_MAXIMUM, SMALLEST_OF_MAXIMUM, LARGEST_OF_MAXIMUM
+        };
+
+    protected:
+        Method _method;
+        scalar _tolerance;
+
+    public:
+        explicit AdaptiveDefuzzifier(Method method = CENTROID,
+                scalar tolerance = defaultTolerance(), int resolution = defaultResolution());
+        virtual ~AdaptiveDefuzzifier() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(AdaptiveDefuzzifier)
+
+        static scalar defaultTolerance();
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum) const FL_IOVERRIDE;
+        /**
+         * Same as defuzzify(), setting evaluations to the number of times the membership function of the
+         * term was evaluated.
+         */
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum, int* evaluations) const;
+
+        virtual void setMethod(Method method);
+        virtual Method getMethod() const;
+
+        /**
+         * The deviation from linear allowed at the midpoint of every cell, weighted by the fraction of the
+         * range that the cell spans.
+         */
+        virtual void setTolerance(scalar tolerance);
+        virtual scalar getTolerance() const;
+
+        virtual AdaptiveDefuzzifier* clone() const FL_IOVERRIDE;
+
+        static Defuzzifier* constructor();
+    };
+
+}
+#endif /* FL_ADAPTIVEDEFUZZIFIER_H */
@@ -0,0 +1,37 @@
+// ExactBisector.h
+//
+// Purpose: Bisector defuzzifier that splits piecewise-linear fuzzy outputs in closed form.
+// Detail: For the outputs PiecewiseLinear accepts, the bisector is the point where the area to its left
+// reaches half of the total, found by solving the quadratic area of the piece where that happens. Other
+// outputs are handled by the sampled Bisector.
+
+#ifndef FL_EXACTBISECTOR_H
+#define FL_EXACTBISECTOR_H
+
+#include "fl/defuzzifier/Bisector.h"
+
+namespace fl {
+    class PiecewiseLinear;
+
+    class ExactBisector : public Bisector {
+    public:
+        explicit ExactBisector(int resolution = defaultResolution());
+        virtual ~ExactBisector() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(ExactBisector)
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum) const FL_IOVERRIDE;
+        /**
+         * Same as defuzzify(term, minimum, maximum), building the pieces into the given PiecewiseLinear,
+         * whose buffers are reused from one call to the next.
+         */
+        virtual scalar defuzzify(const Term* term, scalar minimum, scalar maximum,
+                PiecewiseLinear& piecewiseLinear) const;
+        virtual ExactBisector* clone() const FL_IOVERRIDE;
+
+        static Defuzzifier* constructor();
+    };
+
+}
+#endif /* FL_EXACTBISECTOR_H */
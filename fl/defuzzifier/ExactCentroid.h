@@ -0,0 +1,37 @@
+// ExactCentroid.h
+//
+// Purpose: Centroid defuzzifier that integrates piecewise-linear fuzzy outputs in closed form.
+// Detail: When PiecewiseLinear applies to the fuzzy output (Triangle, Trapezoid, Rectangle and Ramp terms
+// with Minimum or AlgebraicProduct activation and Maximum accumulation), the centroid is computed exactly
+// from the breakpoints of the output. Otherwise it falls back to the sampled Centroid at its resolution.
+
+#ifndef FL_EXACTCENTROID_H
+#define FL_EXACTCENTROID_H
+
+#include "fl/defuzzifier/Centroid.h"
+
+namespace fl {
+    class PiecewiseLinear;
+
+    class ExactCentroid : public Centroid {
+    public:
+        explicit ExactCentroid(int resolution = defaultResolution());
+        virtual ~ExactCentroid() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(ExactCentroid)
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum) const FL_IOVERRIDE;
+        /**
+         * Same as defuzzify(term, minimum, maximum), building the pieces into the given PiecewiseLinear,
+         * whose buffers are reused from one call to the next.
+         */
+        virtual scalar defuzzify(const Term* term, scalar minimum, scalar maximum,
+                PiecewiseLinear& piecewiseLinear) const;
+        virtual ExactCentroid* clone() const FL_IOVERRIDE;
+
+        static Defuzzifier* constructor();
+    };
+
+}
+#endif /* FL_EXACTCENTROID_H */
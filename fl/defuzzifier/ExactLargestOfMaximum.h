@@ -0,0 +1,37 @@
+// ExactLargestOfMaximum.h
+//
+// Purpose: Largest of maximum defuzzifier that finds the maximum of piecewise-linear fuzzy outputs in closed form.
+// Detail: For the outputs PiecewiseLinear accepts, the last point where the highest value is reached is a
+// vertex or clipping point of the pieces, so it is exact instead of depending on the resolution. Other
+// outputs are handled by the sampled LargestOfMaximum.
+
+#ifndef FL_EXACTLARGESTOFMAXIMUM_H
+#define FL_EXACTLARGESTOFMAXIMUM_H
+
+#include "fl/defuzzifier/LargestOfMaximum.h"
+
+namespace fl {
+    class PiecewiseLinear;
+
+    class ExactLargestOfMaximum : public LargestOfMaximum {
+    public:
+        explicit ExactLargestOfMaximum(int resolution = defaultResolution());
+        virtual ~ExactLargestOfMaximum() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(ExactLargestOfMaximum)
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum) const FL_IOVERRIDE;
+        /**
+         * Same as defuzzify(term, minimum, maximum), building the pieces into the given PiecewiseLinear,
+         * whose buffers are reused from one call to the next.
+         */
+        virtual scalar defuzzify(const Term* term, scalar minimum, scalar maximum,
+                PiecewiseLinear& piecewiseLinear) const;
+        virtual ExactLargestOfMaximum* clone() const FL_IOVERRIDE;
+
+        static Defuzzifier* constructor();
+    };
+
+}
+#endif /* FL_EXACTLARGESTOFMAXIMUM_H */
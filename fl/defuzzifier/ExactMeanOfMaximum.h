@@ -0,0 +1,38 @@
+// ExactMeanOfMaximum.h
+//
+// Purpose: Mean of maximum defuzzifier that finds the plateau of piecewise-linear fuzzy outputs in closed form.
+// Detail: For the outputs PiecewiseLinear accepts, the highest value is reached at a vertex of the pieces, and
+// the first plateau at that value starts and ends at the vertices or clipping points found by build(), so its
+// middle is exact instead of depending on the resolution. Other outputs are handled by the sampled
+// MeanOfMaximum.
+
+#ifndef FL_EXACTMEANOFMAXIMUM_H
+#define FL_EXACTMEANOFMAXIMUM_H
+
+#include "fl/defuzzifier/MeanOfMaximum.h"
+
+namespace fl {
+    class PiecewiseLinear;
+
+    class ExactMeanOfMaximum : public MeanOfMaximum {
+    public:
+        explicit ExactMeanOfMaximum(int resolution = defaultResolution());
+        virtual ~ExactMeanOfMaximum() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(ExactMeanOfMaximum)
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum) const FL_IOVERRIDE;
+        /**
+         * Same as defuzzify(term, minimum, maximum), building the pieces into the given PiecewiseLinear,
+         * whose buffers are reused from one call to the next.
+         */
+        virtual scalar defuzzify(const Term* term, scalar minimum, scalar maximum,
+                PiecewiseLinear& piecewiseLinear) const;
+        virtual ExactMeanOfMaximum* clone() const FL_IOVERRIDE;
+
+        static Defuzzifier* constructor();
+    };
+
+}
+#endif /* FL_EXACTMEANOFMAXIMUM_H */
@@ -0,0 +1,37 @@
+// ExactSmallestOfMaximum.h
+//
+// Purpose: Smallest of maximum defuzzifier that finds the maximum of piecewise-linear fuzzy outputs in closed form.
+// Detail: For the outputs PiecewiseLinear accepts, the first point where the highest value is reached is a
+// vertex or clipping point of the pieces, so it is exact instead of depending on the resolution. Other
+// outputs are handled by the sampled SmallestOfMaximum.
+
+#ifndef FL_EXACTSMALLESTOFMAXIMUM_H
+#define FL_EXACTSMALLESTOFMAXIMUM_H
+
+#include "fl/defuzzifier/SmallestOfMaximum.h"
+
+namespace fl {
+    class PiecewiseLinear;
+
+    class ExactSmallestOfMaximum : public SmallestOfMaximum {
+    public:
+        explicit ExactSmallestOfMaximum(int resolution = defaultResolution());
+        virtual ~ExactSmallestOfMaximum() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(ExactSmallestOfMaximum)
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum) const FL_IOVERRIDE;
+        /**
+         * Same as defuzzify(term, minimum, maximum), building the pieces into the given PiecewiseLinear,
+         * whose buffers are reused from one call to the next.
+         */
+        virtual scalar defuzzify(const Term* term, scalar minimum, scalar maximum,
+                PiecewiseLinear& piecewiseLinear) const;
+        virtual ExactSmallestOfMaximum* clone() const FL_IOVERRIDE;
+
+        static Defuzzifier* constructor();
+    };
+
+}
+#endif /* FL_EXACTSMALLESTOFMAXIMUM_H */
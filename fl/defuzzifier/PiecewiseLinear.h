@@ -0,0 +1,109 @@
+// PiecewiseLinear.h
+//
+// Purpose: Exact piecewise-linear form of a fuzzy output, for defuzzifiers that integrate it analytically.
+// Detail: When every activated term of an Accumulated is a Triangle, Trapezoid, Rectangle or Ramp, the
+// activation is Minimum (clipping) or AlgebraicProduct (scaling) and the accumulation is Maximum, the
+// membership function of the fuzzy output is piecewise linear. build() splits the range at the vertices of
+// the terms and at the points where they are clipped, and then follows the upper envelope of the activated
+// terms within each interval, so the pieces describe the membership function exactly and their area and
+// moments can be integrated in closed form instead of sampled.
+
+#ifndef FL_PIECEWISELINEAR_H
+#define FL_PIECEWISELINEAR_H
+
+#include "fl/fuzzylite.h"
+
+#include <vector>
+
+namespace fl {
+    class Term;
+
+    class PiecewiseLinear {
+    public:
+
+        /**
+         * The membership function on [start, end] is value + slope * (x - start).
+         */
+        struct Piece {
+            scalar start, end;
+            scalar value, slope;
+        };
+
+        /**
+         * The membership function of a piecewise-linear term as the polyline through its vertices, scaled
+         * by its height and extended by a constant value on either side.
+         */
+        struct Polyline {
+            scalar x[4], y[4];
+            int size;
+            scalar left, right;
+
+            /**
+             * Reads the vertices of the term, returning false when it is not piecewise linear or its
+             * height is not finite.
+             */
+            bool set(const Term* term);
+            void add(scalar vertex, scalar value);
+            //An empty polyline is zero everywhere, so its support is empty
+            scalar supportStart() const;
+            scalar supportEnd() const;
+            /**
+             * The line of the polyline through the segment that contains the point, as its value at the
+             * origin and its slope.
+             */
+            void line(scalar point, scalar origin, scalar& value, scalar& slope) const;
+        };
+
+    protected:
+        std::vector<Piece> _pieces;
+        std::vector<Polyline> _polylines;
+        std::vector<scalar> _degrees;
+        std::vector<bool> _clipped;
+        std::vector<scalar> _breakpoints, _values, _slopes;
+
+        virtual void addEnvelope(scalar start, scalar end,
+                const std::vector<scalar>& values, const std::vector<scalar>& slopes);
+
+    public:
+        PiecewiseLinear();
+        virtual ~PiecewiseLinear();
+
+        /**
+         * Whether the term is one of the shapes whose membership function is piecewise linear.
+         */
+        static bool isPiecewiseLinear(const Term* term);
+        /**
+         * Whether the term is an Accumulated whose membership function is piecewise linear.
+         */
+        static bool isApplicable(const Term* term);
+
+        /**
+         * Builds the pieces of the fuzzy output between minimum and maximum, returning false (and leaving
+         * no pieces) when it is not applicable or the range is not finite. A PiecewiseLinear kept across
+         * calls reuses its storage, so it no longer allocates once it has seen the largest fuzzy output.
+         */
+        virtual bool build(const Term* term, scalar minimum, scalar maximum);
+        virtual void clear();
+
+        virtual const std::vector<Piece>& pieces() const;
+        virtual bool isEmpty() const;
+
+        virtual scalar area() const;
+        virtual scalar centroid() const;
+        virtual scalar bisector() const;
+        /**
+         * The first and last points where the membership function reaches its highest value, taken as
+         * equal within fuzzylite::macheps(), and the middle of the first plateau at that value, as the
+         * maximum-based defuzzifiers scan for it.
+         */
+        virtual scalar smallestOfMaximum() const;
+        virtual scalar largestOfMaximum() const;
+        virtual scalar meanOfMaximum() const;
+        virtual scalar highestValue() const;
+
+        static scalar area(const Piece& piece);
+        static scalar moment(const Piece& piece);
+    };
+
+}
+#endif /* FL_PIECEWISELINEAR_H */
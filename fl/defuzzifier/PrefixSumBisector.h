@@ -0,0 +1,36 @@
+// PrefixSumBisector.h
+//
+// Purpose: Bisector defuzzifier that samples the fuzzy output once and searches its cumulative area.
+// Detail: The bisector is found from a SampledArea, by binary search over the prefix sums of the samples
+// and linear interpolation within the cell where the cumulative area reaches half, instead of growing the
+// areas on either side towards each other. It costs one Centroid pass over the membership function. The
+// compiled engines keep the SampledArea of each output across calls and expose it as sampledOutput().
+
+#ifndef FL_PREFIXSUMBISECTOR_H
+#define FL_PREFIXSUMBISECTOR_H
+
+#include "fl/defuzzifier/Bisector.h"
+
+namespace fl {
+    class SampledArea;
+
+    class PrefixSumBisector : public Bisector {
+    public:
+        explicit PrefixSumBisector(int resolution = defaultResolution());
+        virtual ~PrefixSumBisector() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(PrefixSumBisector)
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual scalar defuzzify(const Term* term,
+                scalar minimum, scalar maximum) const FL_IOVERRIDE;
+        /**
+         * The bisector of a fuzzy output already sampled, for instance to compute its centroid as well.
+         */
+        virtual scalar defuzzify(const SampledArea& samples) const;
+        virtual PrefixSumBisector* clone() const FL_IOVERRIDE;
+
+        static Defuzzifier* constructor();
+    };
+
+}
+#endif /* FL_PREFIXSUMBISECTOR_H */
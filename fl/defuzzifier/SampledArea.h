@@ -0,0 +1,66 @@
+// SampledArea.h
+//
+// Purpose: Fuzzy output sampled once at the resolution of an integral defuzzifier, with its cumulative area.
+// Detail: Centroid and Bisector each sample the membership function of the fuzzy output at the midpoints of
+// resolution cells. build() samples it once into a buffer, through an AccumulatedKernel, and accumulates the
+// prefix sums of the samples, from which the centroid is the same sum that Centroid computes and the bisector
+// is found by a binary search for the cell where the cumulative area reaches half of the total, interpolated
+// linearly within that cell. A SampledArea built once can answer both, so comparing the two defuzzifiers on
+// the same output costs a single pass over the membership function.
+
+#ifndef FL_SAMPLEDAREA_H
+#define FL_SAMPLEDAREA_H
+
+#include "fl/fuzzylite.h"
+
+#include <vector>
+
+namespace fl {
+    class AccumulatedKernel;
+    class Term;
+
+    class SampledArea {
+    protected:
+        scalar _minimum, _maximum, _step;
+        std::vector<scalar> _samples;
+        std::vector<scalar> _cumulative;
+
+    public:
+        SampledArea();
+        virtual ~SampledArea();
+
+        /**
+         * Samples the term at minimum + (i + 0.5) * (maximum - minimum) / resolution for i in
+         * [0, resolution), returning false (and leaving no samples) when the range is not finite.
+         */
+        virtual bool build(const Term* term, scalar minimum, scalar maximum, int resolution);
+        /**
+         * Same as build(term, minimum, maximum, resolution), sampling the term through a kernel already set
+         * to it. A SampledArea kept across calls reuses its storage.
+         */
+        virtual bool build(const AccumulatedKernel& term, scalar minimum, scalar maximum, int resolution);
+        virtual void clear();
+
+        virtual const std::vector<scalar>& samples() const;
+        /**
+         * The sum of the samples before each cell, with the total at the end, so cumulative()[i] * step is
+         * the area to the left of minimum + i * step.
+         */
+        virtual const std::vector<scalar>& cumulative() const;
+        virtual scalar step() const;
+        virtual bool isEmpty() const;
+
+        virtual scalar area() const;
+        /**
+         * Same as Centroid::defuzzify() at the resolution of the samples.
+         */
+        virtual scalar centroid() const;
+        /**
+         * The leftmost point where the area to its left reaches half of the total, taking the membership
+         * function as constant within each cell. The samples must not be negative.
+         */
+        virtual scalar bisector() const;
+    };
+
+}
+#endif /* FL_SAMPLEDAREA_H */
@@ -0,0 +1,60 @@
+// CachedImporter.h
+//
+// Purpose: Importer that imports each model once through another importer, and afterwards from an
+// fl::EngineCache.
+// Detail: Importing a model from text tokenizes and parses every variable, term and rule, and configures the
+// engine, which every process pays again on start even when the model has not changed. A CachedImporter
+// hashes the text together with the name of its importer and looks the hash up in the cache, where it
+// names the fingerprint of the engine the text imported to; the engine is then imported from the binary
+// image stored under that fingerprint, which FlbImporter maps and builds without parsing. On a miss, the
+// text is imported by the importer as usual, and the image of the engine is stored with the hash of the
+// text pointing to it, so texts that differ only in layout share one image. Engines that do not come back
+// unchanged from their image are not cached, and are imported from the text every time. A cache that cannot
+// be read or written leaves the import unaffected, and the reason is logged through FL_LOG.
+
+#ifndef FL_CACHEDIMPORTER_H
+#define FL_CACHEDIMPORTER_H
+
+#include "fl/imex/Importer.h"
+
+#include "fl/imex/EngineCache.h"
+
+#include <string>
+
+namespace fl {
+
+    class CachedImporter : public Importer {
+    protected:
+        Importer* _importer;
+        EngineCache _cache;
+
+    public:
+        /**
+         * Takes ownership of the importer.
+         */
+        explicit CachedImporter(Importer* importer = fl::null, const EngineCache& cache = EngineCache());
+        CachedImporter(const CachedImporter& other);
+        CachedImporter& operator=(const CachedImporter& other);
+        virtual ~CachedImporter() FL_IOVERRIDE;
+        FL_DEFAULT_MOVE(CachedImporter)
+
+        virtual std::string name() const FL_IOVERRIDE;
+
+        virtual void setImporter(Importer* importer);
+        virtual Importer* getImporter() const;
+
+        virtual void setCache(const EngineCache& cache);
+        virtual const EngineCache& getCache() const;
+
+        virtual Engine* fromString(const std::string& text) const FL_IOVERRIDE;
+
+        /**
+         * The key of the artifact that holds the fingerprint of the engine imported from the text.
+         */
+        virtual std::string sourceKey(const std::string& text) const;
+
+        virtual CachedImporter* clone() const FL_IOVERRIDE;
+    };
+
+}
+#endif /* FL_CACHEDIMPORTER_H */
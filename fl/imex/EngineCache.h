@@ -0,0 +1,111 @@
+// EngineCache.h
+//
+// Purpose: On-disk cache of artifacts built from engines, addressed by the fingerprint of the engine.
+// Detail: The fingerprint of an engine is a hash of everything that defines its behaviour, taken from the
+// object graph rather than from the text it was imported from: its variables with their ranges, flags and
+// terms, the class and exact parameters of every term, the rules of every rule block with their weights, the
+// norms of the rule blocks and the defuzzifier and accumulation of every output variable. Engines that
+// evaluate alike have the same fingerprint whatever importer built them, and it is the same on every run.
+// The cache is a directory holding one file per artifact, named by its key, such as the binary image (FLB)
+// of an engine under "<fingerprint>.flb", which is imported back by mapping the file without parsing. An
+// index file keeps the size of every artifact and the order in which they were last used; whenever the
+// artifacts exceed the capacity of the cache, the least recently used ones are removed. Artifacts are written
+// to a temporary file and renamed into place, so a process never reads an artifact that is half written, and
+// processes that share the directory at most lose an update of the order of use of each other. The cache
+// keeps nothing in memory but its directory and capacity.
+
+#ifndef FL_ENGINECACHE_H
+#define FL_ENGINECACHE_H
+
+#include "fl/fuzzylite.h"
+
+#include <cstddef>
+#include <string>
+
+namespace fl {
+    class Engine;
+
+    class EngineCache {
+    protected:
+        std::string _directory;
+        std::size_t _capacity;
+
+    public:
+        /**
+         * The number of bytes of artifacts kept by default (64 MB).
+         */
+        static const std::size_t DefaultCapacity;
+
+        explicit EngineCache(const std::string& directory = "", std::size_t capacity = DefaultCapacity);
+        virtual ~EngineCache();
+        FL_DEFAULT_COPY_AND_MOVE(EngineCache)
+
+        /**
+         * The directory of the artifacts, which is created on the first store if it does not exist.
+         */
+        virtual void setDirectory(const std::string& directory);
+        virtual std::string getDirectory() const;
+
+        virtual void setCapacity(std::size_t capacity);
+        virtual std::size_t getCapacity() const;
+
+        /**
+         * The fingerprint of the engine, as 16 hexadecimal digits.
+         */
+        static std::string fingerprint(const Engine* engine);
+        /**
+         * The 64-bit FNV-1a hash of the bytes, as 16 hexadecimal digits.
+         */
+        static std::string hash(const std::string& bytes);
+
+        /**
+         * Stores the binary image of the engine under "<fingerprint>.flb", unless it is there already, and
+         * returns the fingerprint. The image is imported back before it is stored, and an engine whose image
+         * does not import back with the same fingerprint, such as one with a term of a class that is not
+         * registered, throws an fl::Exception and is not stored. If a key is given, the fingerprint is stored
+         * under it as well, provided the image and the key fit in the cache together, so that storing the
+         * key never evicts the image it names.
+         */
+        virtual std::string storeEngine(const Engine* engine, const std::string& key = "") const;
+        /**
+         * Imports the engine from its binary image, or returns fl::null if the cache does not hold it. An image
+         * that is not valid is removed and counts as missing; a valid image that cannot be imported throws
+         * the fl::Exception of FlbImporter and stays in the cache.
+         */
+        virtual Engine* loadEngine(const std::string& fingerprint) const;
+
+        /**
+         * Stores the artifact under the key, which must be made of letters, digits, '.', '-' and '_', and
+         * removes the least recently used artifacts until the cache is within its capacity. Returns false,
+         * storing nothing, if the artifact alone exceeds the capacity.
+         */
+        virtual bool store(const std::string& key, const std::string& artifact) const;
+        /**
+         * Reads the artifact stored under the key into the given string, marking it as the most recently used.
+         * Returns false if the cache does not hold it.
+         */
+        virtual bool load(const std::string& key, std::string& artifact) const;
+        /**
+         * Marks the artifact stored under the key as the most recently used, and returns whether the cache
+         * holds it.
+         */
+        virtual bool touch(const std::string& key) const;
+        virtual void remove(const std::string& key) const;
+        virtual void clear() const;
+
+        virtual int numberOfArtifacts() const;
+        /**
+         * The number of bytes of all the artifacts in the cache.
+         */
+        virtual std::size_t size() const;
+        virtual std::string path(const std::string& key) const;
+
+    protected:
+        /**
+         * Replaces the file at the path with the bytes, through a temporary file renamed into place.
+         */
+        virtual void write(const std::string& path, const std::string& bytes) const;
+    };
+
+}
+#endif /* FL_ENGINECACHE_H */
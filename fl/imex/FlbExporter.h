@@ -0,0 +1,33 @@
+// FlbExporter.h
+//
+// Purpose: Exports an fl::Engine as a binary image (FLB) that fl::FlbImporter reads back without parsing.
+// Detail: The image lays out the engine as described in FlbImage.h: interned names, the parameters of the
+// terms as flat scalars, and rules with their variables, terms and hedges already resolved to indices. The
+// string returned by toString() holds the raw bytes of the image, which toFile() writes in binary mode.
+// Defuzzifiers and norms are stored by class name, with the resolution of integral defuzzifiers, the type
+// of weighted ones and the method and tolerance of an AdaptiveDefuzzifier; other settings of custom
+// defuzzifiers are not stored.
+
+#ifndef FL_FLBEXPORTER_H
+#define FL_FLBEXPORTER_H
+
+#include "fl/imex/Exporter.h"
+
+namespace fl {
+
+    class FlbExporter : public Exporter {
+    public:
+        FlbExporter();
+        virtual ~FlbExporter() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(FlbExporter)
+
+        virtual std::string name() const FL_IOVERRIDE;
+
+        virtual std::string toString(const Engine* engine) const FL_IOVERRIDE;
+        virtual void toFile(const std::string& path, const Engine* engine) const FL_IOVERRIDE;
+
+        virtual FlbExporter* clone() const FL_IOVERRIDE;
+    };
+
+}
+#endif /* FL_FLBEXPORTER_H */
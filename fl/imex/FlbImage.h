@@ -0,0 +1,182 @@
+// FlbImage.h
+//
+// Purpose: Layout of the binary engine format written by fl::FlbExporter and read by fl::FlbImporter.
+// Detail: An image is a header followed by sections of fixed-size records, each section aligned to 8 bytes and
+// located by its offset from the start of the image, so an image is position-independent and its records are
+// read where they lie, straight from a memory-mapped file. Names and texts are interned once in the strings
+// section and referred to by index. Variables are stored inputs first, each with the range of its terms; the
+// parameters of the terms are flat arrays of scalars; rules refer to their variables, terms and hedges by
+// index, with antecedents in postfix order, so they are rebuilt without parsing a single rule.
+// Images hold the native byte order and scalar size of the writer, which the reader checks before anything
+// else, as it checks that every offset, count and index stays within the image.
+
+#ifndef FL_FLBIMAGE_H
+#define FL_FLBIMAGE_H
+
+#include "fl/fuzzylite.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace fl {
+
+    class FlbImage {
+    public:
+        /**
+         * Offsets, counts and indices, all 32-bit.
+         */
+        typedef unsigned int Index;
+        /**
+         * The index of a missing string, term or defuzzifier setting.
+         */
+        static const Index None;
+        static const Index Version;
+        static const Index ByteOrder;
+
+        enum Flag {
+            ENABLED = 1, LOADED = 2, LOCK_PREVIOUS_VALUE = 4, LOCK_VALUE_IN_RANGE = 8
+        };
+
+        /**
+         * SHAPE terms are the stock terms MembershipKernel reads, with its shape code and parameters;
+         * DISCRETE terms hold their (x, y) pairs, LINEAR terms their coefficients and FUNCTION terms their
+         * formula. Terms of any other class hold the text of their parameters.
+         */
+        enum TermKind {
+            SHAPE, DISCRETE, LINEAR, FUNCTION, TEXT
+        };
+
+        enum NodeCode {
+            PROPOSITION, CONJUNCTION, DISJUNCTION
+        };
+
+        struct Section {
+            Index offset, count;
+        };
+
+        struct Header {
+            char magic[4];
+            Index version, byteOrder, scalarSize;
+            Index size;
+            Index name;
+            Index numberOfInputs;
+            Index reserved;
+            Section strings, characters, variables, terms, scalars, ruleBlocks, rules, nodes, hedges;
+        };
+
+        /**
+         * A string as its offset in the characters section, which holds it null-terminated.
+         */
+        struct StringRecord {
+            Index offset, length;
+        };
+
+        /**
+         * An input or output variable. The defuzzifier and the accumulation of output variables are class
+         * names, with the resolution of integral defuzzifiers, the type of weighted ones and the method and
+         * tolerance of adaptive ones, or None (NaN for the tolerance).
+         */
+        struct VariableRecord {
+            scalar minimum, maximum, defaultValue, tolerance;
+            Index name, flags;
+            Index firstTerm, numberOfTerms;
+            Index defuzzifier, resolution, type;
+            Index accumulation;
+        };
+
+        /**
+         * A term and the range of its parameters in the scalars section. The text is the formula of FUNCTION
+         * terms and the parameters of TEXT terms.
+         */
+        struct TermRecord {
+            scalar height;
+            Index name, className, kind, shape, flags;
+            Index firstScalar, numberOfScalars;
+            Index text;
+        };
+
+        struct RuleBlockRecord {
+            Index name, flags;
+            Index conjunction, disjunction, activation;
+            Index firstRule, numberOfRules;
+            Index reserved;
+        };
+
+        /**
+         * A rule, with the nodes of its antecedent in postfix order followed by its conclusions. Rules that
+         * were not loaded hold only their text.
+         */
+        struct RuleRecord {
+            scalar weight;
+            Index text, antecedent, consequent, flags;
+            Index firstNode, numberOfNodes, numberOfConclusions;
+            Index reserved;
+        };
+
+        /**
+         * A proposition on the variable at the given index, inputs first, and on the term at the given index
+         * of the variable (None for "any"), with its hedges as names in the hedges section; or an operator on
+         * the two expressions before it.
+         */
+        struct NodeRecord {
+            Index code, variable, term;
+            Index firstHedge, numberOfHedges;
+        };
+
+    protected:
+        const char* _data;
+        std::size_t _size;
+        std::vector<double> _copy;
+        bool _mapped;
+
+    public:
+        FlbImage();
+        virtual ~FlbImage();
+
+        /**
+         * Maps the file into memory, read only, until the image is closed or destroyed.
+         */
+        virtual void map(const std::string& path);
+        /**
+         * Reads the bytes in place if they are aligned to 8 bytes, or else from a copy, so the bytes must
+         * outlive the image unless they were copied.
+         */
+        virtual void view(const char* data, std::size_t size);
+        virtual void close();
+        virtual bool isMapped() const;
+
+        virtual const char* data() const;
+        virtual std::size_t size() const;
+
+        /**
+         * Throws an fl::Exception unless the image is one this build can read and all its references are
+         * within bounds.
+         */
+        virtual void check() const;
+
+        virtual const Header& header() const;
+        virtual const char* string(Index index) const;
+        virtual const VariableRecord* variables() const;
+        virtual const TermRecord* terms() const;
+        virtual const scalar* scalars() const;
+        virtual const RuleBlockRecord* ruleBlocks() const;
+        virtual const RuleRecord* rules() const;
+        virtual const NodeRecord* nodes() const;
+        virtual const Index* hedges() const;
+
+        /**
+         * The class name of the stock term of the given MembershipKernel shape, or an empty string.
+         */
+        static std::string shapeClassName(int shape);
+        /**
+         * The number of parameters of the stock term of the given MembershipKernel shape.
+         */
+        static int shapeParameters(int shape);
+
+    private:
+        FL_DISABLE_COPY(FlbImage)
+    };
+
+}
+#endif /* FL_FLBIMAGE_H */
@@ -0,0 +1,71 @@
+// FlbImporter.h
+//
+// Purpose: Imports an fl::Engine from a binary image (FLB) written by fl::FlbExporter.
+// Detail: fromFile() maps the image into memory and builds the engine straight from its records: terms are
+// constructed from their flat parameters, and rules from their resolved propositions, with no tokenizing,
+// no lookup of names and no parsing other than the formulas of Function terms. The defuzzifiers and terms of
+// this library that the FactoryManager does not know, such as ExactCentroid or SortedDiscrete, are
+// constructed by the importer; norms, hedges and the terms and defuzzifiers of any other class are
+// constructed through the FactoryManager, so custom classes must be registered there. The image is checked
+// before anything is built, and an image that is not valid throws an fl::Exception without building
+// anything.
+
+#ifndef FL_FLBIMPORTER_H
+#define FL_FLBIMPORTER_H
+
+#include "fl/imex/Importer.h"
+
+#include "fl/imex/FlbImage.h"
+
+#include <vector>
+
+namespace fl {
+    class Variable;
+    class Term;
+    class Rule;
+    class Proposition;
+    class Defuzzifier;
+
+    class FlbImporter : public Importer {
+    public:
+        FlbImporter();
+        virtual ~FlbImporter() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(FlbImporter)
+
+        virtual std::string name() const FL_IOVERRIDE;
+
+        /**
+         * Imports the image held in the bytes of the string.
+         */
+        virtual Engine* fromString(const std::string& image) const FL_IOVERRIDE;
+        /**
+         * Maps the file into memory and imports the image, unmapping it afterwards.
+         */
+        virtual Engine* fromFile(const std::string& path) const FL_IOVERRIDE;
+        virtual Engine* fromImage(const FlbImage& image) const;
+
+        virtual FlbImporter* clone() const FL_IOVERRIDE;
+
+    protected:
+        /**
+         * Constructs the defuzzifier of the class, or returns fl::null if it is neither one of this library
+         * nor registered in the FactoryManager.
+         */
+        virtual Defuzzifier* constructDefuzzifier(const std::string& className) const;
+        /**
+         * Constructs the term of the class, or returns fl::null if it is neither one of this library nor
+         * registered in the FactoryManager.
+         */
+        virtual Term* constructTerm(const std::string& className) const;
+        virtual Term* buildTerm(const FlbImage& image, const FlbImage::TermRecord& record,
+                const Engine* engine) const;
+        virtual Defuzzifier* buildDefuzzifier(const FlbImage& image,
+                const FlbImage::VariableRecord& record) const;
+        virtual Rule* buildRule(const FlbImage& image, const FlbImage::RuleRecord& record,
+                const std::vector<Variable*>& variables) const;
+        virtual Proposition* buildProposition(const FlbImage& image, const FlbImage::NodeRecord& record,
+                const std::vector<Variable*>& variables, Rule* rule) const;
+    };
+
+}
+#endif /* FL_FLBIMPORTER_H */
@@ -0,0 +1,83 @@
+// KernelExporter.h
+//
+// Purpose: Exporter of an engine as a standalone C++ function specialized to it.
+// Detail: CppExporter writes the code that builds the engine through the fuzzylite API, so the exported
+// engine evaluates exactly as slowly as the interpreter. A KernelExporter instead writes one function that
+// evaluates the engine from its compiled plan (CompiledEngine), with every parameter a literal: each
+// distinct proposition is the inlined membership function of its term with its hedges, each rule is
+// unrolled into the norms of its block on those propositions, and each output is defuzzified in place, by
+// the weighted sums of Takagi-Sugeno outputs or by a loop over the fixed resolution of the integral
+// defuzzifiers of Mamdani outputs, which samples the activated terms of the output unrolled. The code
+// depends only on <cmath> and <limits>, allocates nothing, and performs the operations of the compiled
+// plan in the same order, so its outputs equal those of Engine::process() up to rounding. For each output
+// variable there is also a function of the input values that returns it, as in
+// "double CarSteering(double CarPosition, double CarVelocity)".
+// The code ends with a test harness: a function that evaluates the engine at samples of the input space
+// whose outputs were computed with Engine::process() at export time, and counts the outputs that differ from
+// them by more than a tolerance.
+// Engines must be made of stock terms, hedges, norms and defuzzifiers; output variables that lock their
+// previous value, Tsukamoto outputs and rules on output variables have no standalone form and are rejected.
+// Of the subclasses of the integral defuzzifiers, the Exact* family is integrated in closed form over the
+// pieces of the fuzzy output and PrefixSumBisector from the prefix sums of its samples; other subclasses may
+// defuzzify otherwise and are rejected.
+
+#ifndef FL_KERNELEXPORTER_H
+#define FL_KERNELEXPORTER_H
+
+#include "fl/imex/Exporter.h"
+
+#include "fl/CompiledEngine.h"
+
+#include <set>
+#include <string>
+
+namespace fl {
+    class Engine;
+    class Hedge;
+    class MembershipKernel;
+
+    class KernelExporter : public Exporter {
+    protected:
+        int _checkSamples;
+
+    public:
+        KernelExporter();
+        virtual ~KernelExporter() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(KernelExporter)
+
+        virtual std::string name() const FL_IOVERRIDE;
+
+        /**
+         * The number of samples of the input space in the test harness (100 by default), or 0 to leave the
+         * harness out. The samples are a grid, as FldExporter::toString(engine, checkSamples) samples it.
+         */
+        virtual void setCheckSamples(int checkSamples);
+        virtual int getCheckSamples() const;
+
+        //WARNING: The engine will be const_casted in order to be compiled and to process the samples!
+        virtual std::string toString(const Engine* engine) const FL_IOVERRIDE;
+
+        /**
+         * The name as a C++ identifier.
+         */
+        virtual std::string identifier(const std::string& name) const;
+        /**
+         * The value as a double literal, exact to the last bit.
+         */
+        virtual std::string literal(scalar value) const;
+        /**
+         * The call that evaluates the membership function of the kernel on the expression x. The helper
+         * functions that calls like this need are added to the functions, which are written before the
+         * engine.
+         */
+        virtual std::string membership(const MembershipKernel& kernel, const std::string& x,
+                std::set<std::string>& functions) const;
+        virtual std::string hedge(const Hedge* hedge, const std::string& x, std::set<std::string>& functions) const;
+        virtual std::string norm(CompiledEngine::NormCode code, const std::string& a, const std::string& b,
+                std::set<std::string>& functions) const;
+
+        virtual KernelExporter* clone() const FL_IOVERRIDE;
+    };
+
+}
+#endif /* FL_KERNELEXPORTER_H */
@@ -0,0 +1,143 @@
+// StreamingFldExporter.h
+//
+// Purpose: FldExporter that evaluates datasets and grids of any size in bounded memory, in parallel, keeping
+// the rows in order.
+// Detail: FldExporter::write() reads the dataset line by line through std::getline(), parses each line into
+// a new vector of scalars through a std::istringstream per value, evaluates it on the engine and formats the
+// results through std::ostream, all on a single thread. A StreamingFldExporter reads the dataset in chunks
+// of a fixed number of bytes, parses the numbers of each line in place without allocating, and evaluates
+// the lines of a chunk in blocks spread across threads (OpenMP), each thread with its own EvaluationContext
+// on one CompiledEngine of the engine, so the engine itself is never written. Every block formats its rows
+// into its own buffer, and the buffers are written in the order of the lines, so the output is exactly
+// what FldExporter writes for the same lines: one row per line, and an empty row for each line that is
+// empty or a comment. Memory holds one chunk of input and its rows of output, whatever the size of the
+// dataset. Engines with an output variable that locks its previous value depend on the order of the rows,
+// so they are evaluated on a single thread. Evaluation starts from a restarted engine.
+// The grid of FldExporter::write(engine, writer, maximumNumberOfResults) is swept the same way: its points are
+// numbered in the order Op::increment() visits them, and each block decodes the values of its own range of
+// points, so the sweep is split across threads with the rows written in the same order. Rows can also be
+// written as binary scalars, which skips formatting and parsing of large surfaces altogether.
+
+#ifndef FL_STREAMINGFLDEXPORTER_H
+#define FL_STREAMINGFLDEXPORTER_H
+
+#include "fl/imex/FldExporter.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace fl {
+    class Engine;
+    class EvaluationContext;
+
+    class StreamingFldExporter : public FldExporter {
+    protected:
+        std::size_t _chunkSize;
+        int _linesPerBlock;
+        int _numberOfThreads;
+        bool _exportBinary;
+
+    public:
+        /**
+         * The number of bytes of input read per chunk by default (4 MB).
+         */
+        static const std::size_t DefaultChunkSize;
+
+        explicit StreamingFldExporter(const std::string& separator = " ");
+        virtual ~StreamingFldExporter() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(StreamingFldExporter)
+
+        virtual std::string name() const FL_IOVERRIDE;
+
+        /**
+         * The number of bytes of input read at once. Chunks grow only to fit a line longer than them.
+         */
+        virtual void setChunkSize(std::size_t chunkSize);
+        virtual std::size_t getChunkSize() const;
+
+        /**
+         * The number of lines a thread evaluates at a time (512 by default).
+         */
+        virtual void setLinesPerBlock(int linesPerBlock);
+        virtual int getLinesPerBlock() const;
+
+        /**
+         * The number of threads to evaluate with, or 0 (by default) for as many as OpenMP provides. Builds
+         * without OpenMP evaluate on a single thread.
+         */
+        virtual void setNumberOfThreads(int numberOfThreads);
+        virtual int getNumberOfThreads() const;
+
+        /**
+         * Writes each row as its values in native scalars, inputs first, without separators, line breaks or
+         * header, so empty lines and comments write nothing.
+         */
+        virtual void setExportBinary(bool exportBinary);
+        virtual bool exportsBinary() const;
+
+        using FldExporter::toString;
+        using FldExporter::toFile;
+        virtual std::string toString(Engine* engine, int maximumNumberOfResults) const FL_IOVERRIDE;
+        virtual std::string toString(Engine* engine, const std::string& inputData) const FL_IOVERRIDE;
+        virtual void toFile(const std::string& path, Engine* engine, int maximumNumberOfResults) const FL_IOVERRIDE;
+        virtual void toFile(const std::string& path, Engine* engine, const std::string& inputData) const FL_IOVERRIDE;
+
+        /**
+         * Evaluates the dataset read from the reader into the file, one chunk at a time.
+         */
+        virtual void toFile(const std::string& path, Engine* engine, std::istream& reader) const;
+
+        /**
+         * Evaluates the dataset read from the reader, one chunk at a time, and writes the rows in order. Returns
+         * the number of lines read.
+         */
+        virtual long stream(Engine* engine, std::istream& reader, std::ostream& writer) const;
+        /**
+         * Evaluates the size bytes of data, which must be followed by a null character, and writes the rows
+         * in order. Returns the number of lines read.
+         */
+        virtual long stream(Engine* engine, const char* data, std::size_t size, std::ostream& writer) const;
+        /**
+         * Evaluates the grid of FldExporter::write(engine, writer, maximumNumberOfResults), a few blocks of
+         * points at a time, and writes the rows in the same order. Returns the number of points.
+         */
+        virtual long sweep(Engine* engine, int maximumNumberOfResults, std::ostream& writer) const;
+
+        virtual StreamingFldExporter* clone() const FL_IOVERRIDE;
+
+    protected:
+        /**
+         * Evaluates the lines of [start, end), the first of which is the line after firstLine, with the
+         * contexts (one per thread), and writes their rows in order. The rows of each block are formatted into
+         * one string of blocks, which is reused from chunk to chunk. Returns the number of lines.
+         */
+        virtual long writeLines(const std::vector<EvaluationContext*>& contexts, const char* start,
+                const char* end, long firstLine, std::vector<std::string>& blocks, std::ostream& writer) const;
+        /**
+         * Evaluates the points [firstPoint, firstPoint + numberOfPoints) of the grid with the given resolution,
+         * as writeLines() evaluates lines.
+         */
+        virtual void writePoints(const std::vector<EvaluationContext*>& contexts, long firstPoint,
+                long numberOfPoints, int resolution, std::vector<std::string>& blocks, std::ostream& writer) const;
+        /**
+         * Evaluates the line [start, end) with the context and appends its row to the output, or an empty
+         * row for an empty line or a comment.
+         */
+        virtual void writeLine(EvaluationContext* context, const char* start, const char* end,
+                std::string& output) const;
+        /**
+         * Processes the input values of the context and appends its row to the output.
+         */
+        virtual void writeRow(EvaluationContext* context, std::string& output) const;
+
+    public:
+        /**
+         * Appends the value as Op::str() formats it, without a stream.
+         */
+        static void appendValue(scalar value, std::string& output);
+    };
+
+}
+#endif /* FL_STREAMINGFLDEXPORTER_H */
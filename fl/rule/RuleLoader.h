@@ -0,0 +1,136 @@
+// RuleLoader.h
+//
+// Purpose: Bulk loader of rules, for rule bases too large to parse one Rule::parse() at a time.
+// Detail: Rule::parse() splits the text into strings and looks up every variable, term and hedge by a linear
+// scan of the engine and its variables. A RuleLoader interns the names of the variables of an engine, of their
+// terms and of the available hedges into hash tables once, and then reads each rule in a single pass over its
+// characters, building the same expression trees that Rule::load() would without copying any token. A whole
+// rule block is loaded in one call, and rules that fail to parse are skipped and recorded as errors instead of
+// throwing, so the cost of loading grows linearly with the number of rules.
+
+#ifndef FL_RULELOADER_H
+#define FL_RULELOADER_H
+
+#include "fl/fuzzylite.h"
+
+#include <string>
+#include <vector>
+
+namespace fl {
+    class Engine;
+    class Expression;
+    class Hedge;
+    class Proposition;
+    class Rule;
+    class RuleBlock;
+    class Variable;
+
+    class RuleLoader {
+    public:
+
+        struct Error {
+            int line;
+            std::string rule;
+            std::string message;
+        };
+
+        /**
+         * Open-addressing hash table from names to indices, looked up by the characters of a token.
+         */
+        class NameTable {
+        protected:
+            std::vector<std::string> _names;
+            std::vector<int> _values;
+            std::vector<int> _slots;
+
+            virtual void rehash(std::size_t numberOfSlots);
+
+        public:
+            NameTable();
+            virtual ~NameTable();
+
+            static std::size_t hash(const char* name, std::size_t length);
+
+            /**
+             * Adds the name unless it is already in the table, so the first value added for a name wins as
+             * in the lookups by name of fuzzylite.
+             */
+            virtual void add(const std::string& name, int value);
+            /**
+             * The value of the name, or -1 if it is not in the table.
+             */
+            virtual int find(const char* name, std::size_t length) const;
+            virtual int size() const;
+            virtual void clear();
+        };
+
+    protected:
+
+        struct Token {
+            std::size_t start, end;
+        };
+
+        const Engine* _engine;
+        std::vector<Variable*> _variables;
+        NameTable _inputVariables, _outputVariables;
+        std::vector<NameTable> _terms;
+        std::vector<std::string> _hedgeNames;
+        NameTable _hedges;
+        std::vector<Error> _errors;
+
+        //State of the rule being parsed
+        const std::string* _text;
+        std::vector<Token> _tokens;
+        std::size_t _position;
+        std::string _message;
+        std::vector<Hedge*> _ruleHedges;
+        std::vector<int> _usedHedges;
+
+        virtual void tokenize(const std::string& text, std::size_t start, std::size_t end);
+        virtual bool accept(const char* keyword);
+        virtual std::string current() const;
+        virtual bool fail(const std::string& message);
+
+        virtual Expression* parseDisjunction(Rule* rule);
+        virtual Expression* parseConjunction(Rule* rule);
+        virtual Expression* parsePrimary(Rule* rule);
+        virtual Proposition* parseProposition(Rule* rule, bool conclusion);
+        virtual Hedge* hedge(Rule* rule, int hedgeIndex);
+
+    public:
+        explicit RuleLoader(const Engine* engine = fl::null);
+        virtual ~RuleLoader();
+
+        /**
+         * Interns the names of the variables of the engine, of their terms and of the hedges available in
+         * the HedgeFactory. Build again after adding or renaming any of them.
+         */
+        virtual void build(const Engine* engine);
+        virtual void build();
+        virtual const Engine* getEngine() const;
+
+        /**
+         * Parses a rule equivalent to Rule::parse(rule, engine), or returns fl::null and records an error
+         * under the given line number if it is not valid.
+         */
+        virtual Rule* parse(const std::string& rule, int line = 0);
+
+        /**
+         * Adds to the rule block the rules in the text, one per line, skipping blank lines, comments starting
+         * with # and the "rule:" prefix of the FuzzyLite Language. Returns the number of rules added.
+         * The rules are loaded already, so the rule block must not be loaded again with loadRules() or
+         * reloadRules(), which would parse them once more with Rule::load().
+         */
+        virtual int load(RuleBlock* ruleBlock, const std::string& rules);
+        virtual int load(RuleBlock* ruleBlock, const std::vector<std::string>& rules);
+
+        virtual const std::vector<Error>& errors() const;
+        virtual int numberOfErrors() const;
+        virtual void clearErrors();
+
+    private:
+        FL_DISABLE_COPY(RuleLoader)
+    };
+
+}
+#endif /* FL_RULELOADER_H */
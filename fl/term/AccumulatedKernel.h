@@ -0,0 +1,105 @@
+// AccumulatedKernel.h
+//
+// Purpose: Flattened snapshot of a fuzzy output, evaluated over an array of values in a single call.
+// Detail: Accumulated::membership() walks a vector of pointers to Activated terms and, for each of them,
+// calls the membership function of the activated term, the activation norm and then the accumulation norm,
+// all virtually, for every single value. An AccumulatedKernel reads the fuzzy output once into parallel
+// arrays: a MembershipKernel per activated term (its shape code and parameters), the degrees, and the codes
+// of the activation norms, next to the code of the accumulation norm. Evaluating it over an array of values
+// then takes one pass per term over a block of values that stays in cache: the kernel of the term, then the
+// activation and the accumulation as flat loops over the block. It returns exactly what calling
+// Accumulated::membership() value by value does, and the integral defuzzifiers below sample it at the same
+// points, in the same order, as Centroid, Bisector and the maximum-based defuzzifiers, so they return exactly
+// what those do. Terms other than an Accumulated are evaluated through a single MembershipKernel, so any
+// term can be sampled through one. The snapshot must be set again after the fuzzy output changes.
+
+#ifndef FL_ACCUMULATEDKERNEL_H
+#define FL_ACCUMULATEDKERNEL_H
+
+#include "fl/fuzzylite.h"
+
+#include "fl/CompiledEngine.h"
+#include "fl/term/MembershipKernel.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace fl {
+    class Term;
+    class TNorm;
+    class SNorm;
+
+    class AccumulatedKernel {
+    protected:
+        const Term* _term;
+        bool _accumulated, _complete;
+        const SNorm* _accumulation;
+        CompiledEngine::NormCode _accumulationCode;
+        std::vector<MembershipKernel> _kernels;
+        std::vector<scalar> _degrees;
+        std::vector<const TNorm*> _activations;
+        std::vector<CompiledEngine::NormCode> _activationCodes;
+        mutable std::vector<scalar> _values, _degreeValues;
+        mutable std::vector<scalar> _x, _y, _rightX, _rightY;
+
+        /**
+         * Samples the cells [first, first + size) at origin + (i + 0.5) * step, or at origin - (i + 0.5) * step
+         * when counted from the right, into the scratch arrays x and y.
+         */
+        virtual void sample(scalar origin, scalar step, bool fromRight, int first, int size,
+                scalar* x, scalar* y) const;
+
+    public:
+        /**
+         * The number of values evaluated per pass over the terms.
+         */
+        static const int BlockSize = 256;
+
+        explicit AccumulatedKernel(const Term* term = fl::null);
+        virtual ~AccumulatedKernel();
+
+        /**
+         * Reads the activated terms, degrees and norms of the fuzzy output (or the class and parameters of
+         * any other term), reusing the arrays of the previous snapshot.
+         */
+        virtual void set(const Term* term);
+        virtual const Term* getTerm() const;
+        /**
+         * Whether the term is an Accumulated, flattened term by term, rather than a single kernel.
+         */
+        virtual bool isAccumulated() const;
+        virtual int numberOfTerms() const;
+
+        /**
+         * Same as term->membership(x).
+         */
+        virtual scalar membership(scalar x) const;
+        /**
+         * Sets y[i] = term->membership(x[i]) for i in [0, size).
+         */
+        virtual void membership(const scalar* x, scalar* y, std::size_t size) const;
+
+        /**
+         * Same as Centroid::defuzzify() of the term at the given resolution.
+         */
+        virtual scalar centroid(scalar minimum, scalar maximum, int resolution) const;
+        /**
+         * Same as Bisector::defuzzify() of the term at the given resolution.
+         */
+        virtual scalar bisector(scalar minimum, scalar maximum, int resolution) const;
+        /**
+         * Same as MeanOfMaximum::defuzzify() of the term at the given resolution.
+         */
+        virtual scalar meanOfMaximum(scalar minimum, scalar maximum, int resolution) const;
+        /**
+         * Same as SmallestOfMaximum::defuzzify() of the term at the given resolution.
+         */
+        virtual scalar smallestOfMaximum(scalar minimum, scalar maximum, int resolution) const;
+        /**
+         * Same as LargestOfMaximum::defuzzify() of the term at the given resolution.
+         */
+        virtual scalar largestOfMaximum(scalar minimum, scalar maximum, int resolution) const;
+    };
+
+}
+#endif /* FL_ACCUMULATEDKERNEL_H */
@@ -0,0 +1,101 @@
+// CompiledFunction.h
+//
+// Purpose: Function term that evaluates its formula from flat postfix bytecode.
+// Detail: Function::membership() copies the values of every variable of the engine into a map by name and
+// then walks the tree of the formula recursively, looking each variable up in that map and calling each
+// operator through a function pointer. A CompiledFunction parses the formula as Function does, and then at
+// load() time lowers the tree into a postfix instruction array: subtrees without variables are folded into
+// constants, the variables of the engine and x are resolved to their indices, and addition, subtraction,
+// multiplication, division and negation are performed inline. Evaluation then runs the instructions over a
+// small stack without looking anything up by name and without allocating. The variables of the engine are
+// resolved once, so load() again after adding, removing or renaming them.
+
+#ifndef FL_COMPILEDFUNCTION_H
+#define FL_COMPILEDFUNCTION_H
+
+#include "fl/term/Function.h"
+
+#include <string>
+#include <vector>
+
+namespace fl {
+
+    class CompiledFunction : public Function {
+    public:
+
+        enum OpCode {
+            CONSTANT, LOAD_X, LOAD_INPUT, LOAD_OUTPUT, LOAD_VARIABLE,
+            NEGATE, ADD, SUBTRACT, MULTIPLY, DIVIDE, UNARY, BINARY
+        };
+
+        /**
+         * Binary instructions compute binary(a, b) with b on top of the stack and a below it, where a is
+         * the right operand of the node, as Node::evaluate() does.
+         */
+        struct Instruction {
+            OpCode code;
+            int operand;
+            scalar value;
+            Unary unary;
+            Binary binary;
+        };
+
+    protected:
+        std::vector<Instruction> _instructions;
+        std::vector<std::string> _variableNames;
+        std::vector<int> _inputs, _outputs;
+        int _stackSize;
+        mutable std::vector<scalar> _inputValues, _outputValues, _stack;
+
+        virtual bool compile(const Node* node, int& depth);
+        virtual void emit(OpCode code, int operand = 0, scalar value = 0.0,
+                Unary unary = fl::null, Binary binary = fl::null);
+
+    public:
+        explicit CompiledFunction(const std::string& name = "",
+                const std::string& formula = "", const Engine* engine = fl::null);
+        virtual ~CompiledFunction() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(CompiledFunction)
+
+        static CompiledFunction* create(const std::string& name,
+                const std::string& formula,
+                const Engine* engine = fl::null); // throw (fl::Exception);
+
+        virtual std::string className() const FL_IOVERRIDE;
+
+        /**
+         * Reads the current values of the variables of the engine that the formula uses, without the map
+         * of variables, which is only read for names that are not variables of the engine.
+         */
+        virtual scalar membership(scalar x) const FL_IOVERRIDE;
+
+        /**
+         * Evaluates the formula with the given values of the input and output variables, indexed as in
+         * the engine, and a stack of at least stackSize() values. Does not modify the function, so it can
+         * be called from many threads at once, each with its own stack.
+         */
+        virtual scalar evaluate(scalar x, const scalar* inputValues, const scalar* outputValues,
+                scalar* stack) const;
+
+        virtual void setEngine(const Engine* engine) FL_IOVERRIDE;
+
+        virtual void unload() FL_IOVERRIDE;
+        virtual void load(const std::string& formula, const Engine* engine) FL_IOVERRIDE; // throw (fl::Exception);
+        using Function::load;
+
+        /**
+         * Lowers the tree of the loaded formula into instructions, which load() does already.
+         */
+        virtual void compile(); // throw (fl::Exception);
+        virtual bool isCompiled() const;
+
+        virtual const std::vector<Instruction>& instructions() const;
+        virtual int stackSize() const;
+
+        virtual CompiledFunction* clone() const FL_IOVERRIDE;
+
+        static Term* constructor();
+    };
+
+}
+#endif /* FL_COMPILEDFUNCTION_H */
@@ -0,0 +1,75 @@
+// MembershipKernel.h
+//
+// Purpose: Membership function of a term evaluated over an array of values in a single call.
+// Detail: Term::membership() is a virtual call per value, so loops over many values (integration, plotting,
+// batch inference) can neither be inlined nor vectorized. A MembershipKernel reads the parameters of a
+// fuzzylite term once and then evaluates its shape over a whole array: with SSE2, or AVX when compiled for
+// it, for the shapes made of comparisons and arithmetic, and with the loops of TypedKernel<scalar>, without
+// virtual calls, for the shapes built on exp, pow and cos, which the compiler can vectorize with its vector
+// math library, and for the values past the last full SIMD register. The kernels perform the same operations
+// in the same order as the terms, so they return exactly what calling membership() value by value does. Terms
+// of other classes are evaluated by their own membership function, value by value.
+
+#ifndef FL_MEMBERSHIPKERNEL_H
+#define FL_MEMBERSHIPKERNEL_H
+
+#include "fl/fuzzylite.h"
+
+#include <cstddef>
+
+namespace fl {
+    class Term;
+
+    class MembershipKernel {
+    public:
+
+        enum Shape {
+            UNKNOWN, TRIANGLE, TRAPEZOID, RECTANGLE, RAMP, SSHAPE, ZSHAPE, PISHAPE, CONCAVE, CONSTANT,
+            GAUSSIAN, GAUSSIAN_PRODUCT, BELL, SIGMOID, SIGMOID_DIFFERENCE, SIGMOID_PRODUCT, SPIKE, COSINE
+        };
+
+    protected:
+        const Term* _term;
+        Shape _shape;
+        scalar _height;
+        scalar _parameters[4];
+
+        virtual std::size_t vectorized(const scalar* x, scalar* y, std::size_t size) const;
+        virtual void sequential(const scalar* x, scalar* y, std::size_t size) const;
+
+    public:
+        explicit MembershipKernel(const Term* term = fl::null);
+        virtual ~MembershipKernel();
+
+        /**
+         * Reads the class and parameters of the term, which must be set again after any of them changes.
+         */
+        virtual void set(const Term* term);
+        virtual const Term* getTerm() const;
+        virtual Shape getShape() const;
+        virtual scalar getHeight() const;
+        /**
+         * The parameters of the shape in the order the term declares them, zero past those it has.
+         */
+        virtual const scalar* getParameters() const;
+
+        /**
+         * Whether the membership function of the term is evaluated with SIMD instructions.
+         */
+        virtual bool isVectorized() const;
+
+        /**
+         * Sets y[i] = term->membership(x[i]) for i in [0, size).
+         */
+        virtual void membership(const scalar* x, scalar* y, std::size_t size) const;
+
+        static void membership(const Term* term, const scalar* x, scalar* y, std::size_t size);
+
+        /**
+         * The number of values evaluated per SIMD instruction, or 1 if none are compiled in.
+         */
+        static int vectorWidth();
+    };
+
+}
+#endif /* FL_MEMBERSHIPKERNEL_H */
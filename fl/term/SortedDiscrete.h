@@ -0,0 +1,60 @@
+// SortedDiscrete.h
+//
+// Purpose: Discrete term whose membership function costs O(log n), or O(1) on uniformly spaced points.
+// Detail: Discrete::membership() scans its points from the start on every call, so sampled membership
+// functions with thousands of points cost thousands of comparisons per value. A SortedDiscrete keeps its
+// points sorted by x and finds the two points around a value by binary search. When the x values are
+// uniformly spaced, which is detected whenever the points change or can be stated with setGrid(), the
+// index is computed from the value directly and only checked against its neighbours. On sorted points it
+// returns exactly what Discrete::membership() does.
+
+#ifndef FL_SORTEDDISCRETE_H
+#define FL_SORTEDDISCRETE_H
+
+#include "fl/term/Discrete.h"
+
+namespace fl {
+
+    class SortedDiscrete : public Discrete {
+    protected:
+        bool _uniform;
+        scalar _start, _inverseStep;
+
+        /**
+         * The index of the first point whose x is not less than the value, which must lie strictly
+         * between the first and the last points.
+         */
+        virtual std::size_t locate(scalar x) const;
+
+    public:
+        explicit SortedDiscrete(const std::string& name = "",
+                const std::vector<Pair>& xy = std::vector<Pair>(),
+                scalar height = 1.0);
+        virtual ~SortedDiscrete() FL_IOVERRIDE;
+        FL_DEFAULT_COPY_AND_MOVE(SortedDiscrete)
+
+        virtual std::string className() const FL_IOVERRIDE;
+        virtual void configure(const std::string& parameters) FL_IOVERRIDE;
+
+        virtual scalar membership(scalar x) const FL_IOVERRIDE;
+
+        virtual void setXY(const std::vector<Pair>& pairs) FL_IOVERRIDE;
+        /**
+         * Sets the points (start + i * step, y[i]), which are sorted and uniformly spaced by construction.
+         */
+        virtual void setGrid(scalar start, scalar step, const std::vector<scalar>& y);
+
+        /**
+         * Sorts the points by x and detects whether they are uniformly spaced. Call it after changing
+         * the points through xy().
+         */
+        virtual void sort();
+        virtual bool isUniform() const;
+
+        virtual SortedDiscrete* clone() const FL_IOVERRIDE;
+
+        static Term* constructor();
+    };
+
+}
+#endif /* FL_SORTEDDISCRETE_H */
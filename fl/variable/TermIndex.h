@@ -0,0 +1,31 @@
+// TermIndex.h
+//
+// Purpose: Support intervals of terms, outside of which their membership is zero.
+// Detail: Term only exposes membership(x), so support() recovers from the parameters of each fuzzylite term
+// an interval outside of which its membership is zero: compact for Triangle, Trapezoid, Rectangle, Cosine,
+// PiShape and Discrete terms that start and end at zero, half-open for Ramp, SShape and ZShape, and the whole
+// line for the shapes that never reach zero. The compiled engines and AdaptiveArea skip the membership
+// function outside of it.
+
+#ifndef FL_TERMINDEX_H
+#define FL_TERMINDEX_H
+
+#include "fl/fuzzylite.h"
+
+namespace fl {
+    class Term;
+
+    class TermIndex {
+    public:
+        /**
+         * Sets start and end such that the membership of the term is zero outside [start, end], widened by
+         * fuzzylite::macheps() to match the tolerance of the comparisons in the terms. Terms that may be
+         * non-zero anywhere (or are not recognized) get [-inf, inf], and terms that are zero everywhere
+         * get the empty support [inf, -inf]. A Discrete without points gets [-inf, inf], so that its
+         * membership function is called and throws as Discrete::membership() does.
+         */
+        static void support(const Term* term, scalar& start, scalar& end);
+    };
+
+}
+#endif /* FL_TERMINDEX_H */
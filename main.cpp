@@ -28,6 +28,8 @@
 
 // FuzzyLite Library Engine for Fuzzy Inference System
 fl::Engine* fuzzyLiteEngine;
+// Compiled version of the engine, which skips the work when the car's inputs have not changed since the last frame
+fl::CompiledEngine* compiledEngine;
 
 // FIS Inputs
 
@@ -289,6 +291,12 @@ void SetupFuzzyInferenceSystem()
 	// Conjunction, Disjunction, Activation and Accumulation/Aggregation functions are simple Min/Max functions.
 	fuzzyLiteEngine->configure("Minimum", "Maximum", "Minimum", "Maximum", "Centroid");
 
+	// The steering terms are all triangles, so the centroid can be integrated exactly from their breakpoints instead of sampled.
+	carSteering->setDefuzzifier(new fl::ExactCentroid());
+
+	// Compile the finished engine; its process() also defuzzifies the output.
+	compiledEngine = new fl::CompiledEngine(fuzzyLiteEngine);
+
 
 }
 
@@ -321,11 +329,8 @@ void DoGameLogic()
 		carVelocity->setInputValue(GameCarVelocityRelativeToLine);
 		carPosition->setInputValue(GameCarPositionRelativeToLine);
 
-		// Resolve the FIS
-		fuzzyLiteEngine->process();
-
-		// Retrieve output via defuzzification
-		carSteering->defuzzify();
+		// Resolve the FIS; this also defuzzifies the output, and does nothing new while the car's inputs are unchanged
+		compiledEngine->process();
 
 		// Set game object to use new value
 		GameCarSteering = carSteering->getOutputValue();
@@ -369,11 +374,8 @@ void DoGameLogic()
 		carVelocity->setInputValue(carSpeedValue);
 		carPosition->setInputValue(carPositionValue);
 
-		// Resolve the FIS
-		fuzzyLiteEngine->process();
-
-		// Retrieve output via defuzzification
-		carSteering->defuzzify();
+		// Resolve the FIS and retrieve output via defuzzification
+		compiledEngine->process();
 		carSteeringValue = carSteering->getOutputValue();
 
 		// Display output
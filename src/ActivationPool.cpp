@@ -0,0 +1,60 @@
+// ActivationPool.cpp
+//
+// Purpose: Implementation of fl::ActivationPool.
+
+#include "fl/ActivationPool.h"
+
+#include "fl/term/Accumulated.h"
+#include "fl/term/Activated.h"
+
+namespace fl {
+
+    ActivationPool::ActivationPool(int size) {
+        reserve(size);
+    }
+
+    ActivationPool::~ActivationPool() {
+        clear();
+    }
+
+    void ActivationPool::reserve(int size) {
+        if (size <= 0) return;
+        _available.reserve(size);
+        while ((int) _available.size() < size) {
+            _available.push_back(new Activated);
+        }
+    }
+
+    void ActivationPool::recycle(Accumulated* fuzzyOutput) {
+        std::vector<Activated*>& terms = fuzzyOutput->terms();
+        _available.insert(_available.end(), terms.begin(), terms.end());
+        //Clears the vector only, keeping its capacity, since the terms now belong to the pool
+        terms.clear();
+    }
+
+    void ActivationPool::activate(Accumulated* fuzzyOutput, const Term* term, scalar degree,
+            const TNorm* activation) {
+        if (_available.empty()) {
+            fuzzyOutput->addTerm(term, degree, activation);
+            return;
+        }
+        Activated* activated = _available.back();
+        _available.pop_back();
+        activated->setTerm(term);
+        activated->setDegree(degree);
+        activated->setActivation(activation);
+        fuzzyOutput->addTerm(activated);
+    }
+
+    int ActivationPool::numberOfAvailable() const {
+        return (int) _available.size();
+    }
+
+    void ActivationPool::clear() {
+        for (std::size_t i = 0; i < _available.size(); ++i) {
+            delete _available.at(i);
+        }
+        _available.clear();
+    }
+
+}
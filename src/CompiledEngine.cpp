@@ -0,0 +1,1505 @@
+// CompiledEngine.cpp
+//
+// Purpose: Implementation of fl::CompiledEngine.
+// Detail: The evaluation below mirrors Engine::process() for the stock fuzzylite semantics (rule weight
+// times antecedent degree, rules fire above macheps, hedges applied right to left and compounded across
+// the conclusions of a rule) so the compiled mode is a drop-in replacement for it.
+
+#include "fl/CompiledEngine.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/TypedKernel.h"
+#include "fl/defuzzifier/IntegralDefuzzifier.h"
+#include "fl/defuzzifier/WeightedDefuzzifier.h"
+#include "fl/hedge/Any.h"
+#include "fl/hedge/Hedge.h"
+#include "fl/norm/SNorm.h"
+#include "fl/norm/TNorm.h"
+#include "fl/norm/s/AlgebraicSum.h"
+#include "fl/norm/s/BoundedSum.h"
+#include "fl/norm/s/Maximum.h"
+#include "fl/norm/t/AlgebraicProduct.h"
+#include "fl/norm/t/BoundedDifference.h"
+#include "fl/norm/t/Minimum.h"
+#include "fl/rule/Antecedent.h"
+#include "fl/rule/Consequent.h"
+#include "fl/rule/Expression.h"
+#include "fl/rule/Rule.h"
+#include "fl/rule/RuleBlock.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/AccumulatedKernel.h"
+#include "fl/term/Activated.h"
+#include "fl/term/Function.h"
+#include "fl/term/Linear.h"
+#include "fl/term/Term.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+#include "fl/variable/TermIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <typeinfo>
+
+namespace fl {
+
+    /**
+     * Orders slot indices by the index of their variable.
+     */
+    struct SlotVariableOrder {
+        const std::vector<CompiledEngine::Slot>& slots;
+
+        explicit SlotVariableOrder(const std::vector<CompiledEngine::Slot>& slots) : slots(slots) {
+        }
+
+        bool operator()(int a, int b) const {
+            return slots[a].variableIndex < slots[b].variableIndex;
+        }
+    };
+
+    /**
+     * The norms of the specialized rule loops, inlined into it.
+     */
+    struct MinimumNorm {
+
+        scalar operator()(scalar a, scalar b) const {
+            return TypedKernel<scalar>::minimum(a, b);
+        }
+    };
+
+    struct MaximumNorm {
+
+        scalar operator()(scalar a, scalar b) const {
+            return TypedKernel<scalar>::maximum(a, b);
+        }
+    };
+
+    struct AlgebraicProductNorm {
+
+        scalar operator()(scalar a, scalar b) const {
+            return TypedKernel<scalar>::algebraicProduct(a, b);
+        }
+    };
+
+    struct AlgebraicSumNorm {
+
+        scalar operator()(scalar a, scalar b) const {
+            return TypedKernel<scalar>::algebraicSum(a, b);
+        }
+    };
+
+    struct BoundedDifferenceNorm {
+
+        scalar operator()(scalar a, scalar b) const {
+            return TypedKernel<scalar>::boundedDifference(a, b);
+        }
+    };
+
+    struct BoundedSumNorm {
+
+        scalar operator()(scalar a, scalar b) const {
+            return TypedKernel<scalar>::boundedSum(a, b);
+        }
+    };
+
+    /**
+     * Any norm, through the switch over its code in the generic rule loop.
+     */
+    struct CodedNorm {
+        CompiledEngine::NormCode code;
+        const Norm* norm;
+
+        CodedNorm(CompiledEngine::NormCode code, const Norm* norm) : code(code), norm(norm) {
+        }
+
+        scalar operator()(scalar a, scalar b) const {
+            return CompiledEngine::compute(code, norm, a, b);
+        }
+    };
+
+    CompiledEngine::CompiledEngine(Engine* engine) : _engine(fl::null), _macheps(fuzzylite::macheps()),
+    _linearColumns(0), _fuzzyOutputKernel(new AccumulatedKernel), _memoized(true), _memoizable(false), _memoValid(false), _inputTolerance(0.0),
+    _batchable(false), _linearBatchable(false) {
+        if (engine) compile(engine);
+    }
+
+    CompiledEngine::~CompiledEngine() {
+        delete _fuzzyOutputKernel;
+    }
+
+    void CompiledEngine::clear() {
+        _slots.clear();
+        _kernels.clear();
+        _inputSlots.clear();
+        _inputSlotOffsets.clear();
+        _hedges.clear();
+        _instructions.clear();
+        _conclusions.clear();
+        _rules.clear();
+        _blocks.clear();
+        _requiredSlots.clear();
+        _ruleIndexStart.clear();
+        _ruleIndex.clear();
+        _unindexedRules.clear();
+        _fuzzyOutputs.clear();
+        _numberOfConclusions.clear();
+        _linearOutputs.clear();
+        _linearOutputIndex.clear();
+        _linearTerms.clear();
+        _linearCoefficients.clear();
+        _linearRowTable.clear();
+        _linearColumns = 0;
+        _integralCodes.clear();
+        _integralForms.clear();
+        _piecewiseLinears.clear();
+        _sampledAreas.clear();
+        _slotValues.clear();
+        _stack.clear();
+        _activeRules.clear();
+        _inputValues.clear();
+        _linearDegrees.clear();
+        _lastInputValues.clear();
+        _lastInputEnabled.clear();
+        _lastOutputValues.clear();
+        _memoizable = false;
+        _memoValid = false;
+        _batchable = false;
+        _batchSlotValues.clear();
+        _batchStack.clear();
+        _batchDegrees.clear();
+        _linearBatchable = false;
+        _batchLinearValues.clear();
+        _batchAccumulated.clear();
+        _batchSums.clear();
+        _batchWeights.clear();
+        _batchFired.clear();
+        _batchLinearRows.clear();
+    }
+
+    void CompiledEngine::compile(Engine* engine) {
+        _engine = engine;
+        compile();
+    }
+
+    void CompiledEngine::compile() {
+        clear();
+        if (not _engine) {
+            throw fl::Exception("[compiled engine error] no engine to compile", FL_AT);
+        }
+        std::string status;
+        if (not _engine->isReady(&status)) {
+            throw fl::Exception("[compiled engine error] engine <" + _engine->getName() + "> "
+                    "is not ready to be compiled:\n" + status, FL_AT);
+        }
+        _macheps = fuzzylite::macheps();
+
+        int maximumDepth = 0;
+        for (int b = 0; b < _engine->numberOfRuleBlocks(); ++b) {
+            const RuleBlock* ruleBlock = _engine->getRuleBlock(b);
+            if (not ruleBlock->isEnabled()) continue;
+
+            CompiledBlock block;
+            block.conjunction = ruleBlock->getConjunction();
+            block.disjunction = ruleBlock->getDisjunction();
+            block.activation = ruleBlock->getActivation();
+            block.conjunctionCode = normCode(block.conjunction);
+            block.disjunctionCode = normCode(block.disjunction);
+            block.normPair = normPair(block.conjunctionCode, block.disjunctionCode);
+            block.firstRule = (int) _rules.size();
+
+            for (int r = 0; r < ruleBlock->numberOfRules(); ++r) {
+                const Rule* rule = ruleBlock->getRule(r);
+                if (not rule->isLoaded()) continue;
+
+                CompiledRule compiled;
+                compiled.weight = rule->getWeight();
+                compiled.firstRequired = 0;
+                compiled.numberOfRequired = 0;
+                compiled.firstInstruction = (int) _instructions.size();
+                int depth = compileExpression(rule->getAntecedent()->getExpression(), rule, block, 0);
+                maximumDepth = std::max(maximumDepth, depth);
+                compiled.numberOfInstructions = (int) _instructions.size() - compiled.firstInstruction;
+
+                compiled.firstConclusion = (int) _conclusions.size();
+                const std::vector<Proposition*>& conclusions = rule->getConsequent()->conclusions();
+                //Consequent::modify() hedges the activation degree in place, so each conclusion also
+                //takes the hedges of the enabled conclusions before it
+                std::vector<const Hedge*> consequentHedges;
+                for (std::size_t c = 0; c < conclusions.size(); ++c) {
+                    const Proposition* proposition = conclusions.at(c);
+                    if (not proposition->variable->isEnabled()) continue;
+                    Conclusion conclusion;
+                    conclusion.outputIndex = -1;
+                    conclusion.row = -1;
+                    for (int o = 0; o < _engine->numberOfOutputVariables(); ++o) {
+                        if (_engine->getOutputVariable(o) == proposition->variable) {
+                            conclusion.outputIndex = o;
+                            break;
+                        }
+                    }
+                    if (conclusion.outputIndex < 0) {
+                        throw fl::Exception("[compiled engine error] output variable <"
+                                + proposition->variable->getName() + "> in rule <"
+                                + rule->getText() + "> is not registered in the engine", FL_AT);
+                    }
+                    conclusion.term = proposition->term;
+                    consequentHedges.insert(consequentHedges.end(),
+                            proposition->hedges.rbegin(), proposition->hedges.rend());
+                    conclusion.firstHedge = (int) _hedges.size();
+                    _hedges.insert(_hedges.end(), consequentHedges.begin(), consequentHedges.end());
+                    conclusion.numberOfHedges = (int) consequentHedges.size();
+                    _conclusions.push_back(conclusion);
+                }
+                compiled.numberOfConclusions = (int) _conclusions.size() - compiled.firstConclusion;
+                _rules.push_back(compiled);
+            }
+            block.numberOfRules = (int) _rules.size() - block.firstRule;
+            _blocks.push_back(block);
+        }
+
+        _numberOfConclusions.resize(_engine->numberOfOutputVariables(), 0);
+        for (std::size_t c = 0; c < _conclusions.size(); ++c) {
+            ++_numberOfConclusions.at(_conclusions.at(c).outputIndex);
+        }
+        for (int o = 0; o < _engine->numberOfOutputVariables(); ++o) {
+            _fuzzyOutputs.push_back(_engine->getOutputVariable(o)->fuzzyOutput());
+            _fuzzyOutputs.back()->terms().reserve(_numberOfConclusions.at(o));
+        }
+        _pool.reserve((int) _conclusions.size());
+        _slotValues.resize(_slots.size(), fl::nan);
+        for (std::size_t i = 0; i < _slots.size(); ++i) {
+            if (_slots.at(i).constant) {
+                _slotValues.at(i) = fuzzify(_slots.at(i), fl::nan);
+            }
+        }
+        _stack.resize(std::max(maximumDepth, 1));
+        compileRuleIndex();
+
+        //Groups the input slots by variable, so an input that has not changed can skip all of its slots
+        std::stable_sort(_inputSlots.begin(), _inputSlots.end(), SlotVariableOrder(_slots));
+        _inputSlotOffsets.assign(_engine->numberOfInputVariables() + 1, 0);
+        for (std::size_t i = 0; i < _inputSlots.size(); ++i) {
+            ++_inputSlotOffsets.at(_slots.at(_inputSlots.at(i)).variableIndex + 1);
+        }
+        for (int i = 0; i < _engine->numberOfInputVariables(); ++i) {
+            _inputSlotOffsets.at(i + 1) += _inputSlotOffsets.at(i);
+        }
+
+        //The slots of an input only depend on its value unless its terms read other values of the engine
+        _memoizable = true;
+        for (std::size_t i = 0; i < _inputSlots.size() and _memoizable; ++i) {
+            const Term* term = _slots.at(_inputSlots.at(i)).term;
+            _memoizable = not (dynamic_cast<const Linear*> (term) or dynamic_cast<const Function*> (term));
+        }
+        _lastInputValues.assign(_engine->numberOfInputVariables(), fl::nan);
+        _lastInputEnabled.assign(_engine->numberOfInputVariables(), true);
+        _lastOutputValues.assign(_engine->numberOfOutputVariables(), fl::nan);
+        _memoValid = false;
+
+        //Samples can only be evaluated side by side when no proposition reads engine state that changes
+        //while the rules of a single sample are being activated
+        _batchable = _memoizable;
+        for (std::size_t i = 0; i < _instructions.size() and _batchable; ++i) {
+            _batchable = _instructions.at(i).code != LOAD_OUTPUT;
+        }
+        _batchSlotValues.resize(_slots.size() * BatchSize, fl::nan);
+        _batchStack.resize(_stack.size() * BatchSize, fl::nan);
+        _batchDegrees.resize(std::max((int) _rules.size(), 1) * BatchSize, 0.0);
+
+        compileLinearOutputs();
+        compileIntegralOutputs();
+    }
+
+    void CompiledEngine::compileLinearOutputs() {
+        const int numberOfInputs = _engine->numberOfInputVariables();
+        _linearColumns = numberOfInputs + 1;
+        _linearOutputIndex.assign(_engine->numberOfOutputVariables(), -1);
+        int maximumRows = 0;
+        bool accumulated = false;
+        for (int o = 0; o < _engine->numberOfOutputVariables(); ++o) {
+            const OutputVariable* outputVariable = _engine->getOutputVariable(o);
+            const WeightedDefuzzifier* defuzzifier =
+                    dynamic_cast<const WeightedDefuzzifier*> (outputVariable->getDefuzzifier());
+            if (not defuzzifier or defuzzifier->getType() == WeightedDefuzzifier::Tsukamoto) continue;
+            //Subclasses may defuzzify otherwise, so only the stock defuzzifiers are replaced
+            const std::string className = defuzzifier->className();
+            if (className != "WeightedAverage" and className != "WeightedSum") continue;
+
+            std::vector<const Term*> terms;
+            bool linear = true;
+            for (std::size_t c = 0; c < _conclusions.size() and linear; ++c) {
+                if (_conclusions.at(c).outputIndex != o) continue;
+                const Linear* term = dynamic_cast<const Linear*> (_conclusions.at(c).term);
+                //Linear::membership() skips the inputs it has no coefficients for, even if they are NaN
+                linear = term and term->getEngine() == _engine
+                        and (int) term->coefficients().size() >= numberOfInputs;
+                terms.push_back(term);
+            }
+            if (not linear) continue;
+            std::sort(terms.begin(), terms.end(), std::less<const Term*>());
+            terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+            LinearOutput output;
+            output.outputIndex = o;
+            output.average = (className == "WeightedAverage");
+            output.accumulation = outputVariable->fuzzyOutput()->getAccumulation();
+            output.accumulationCode = normCode(output.accumulation);
+            output.firstRow = (int) _linearTerms.size();
+            output.numberOfRows = (int) terms.size();
+            for (std::size_t t = 0; t < terms.size(); ++t) {
+                const std::vector<scalar>& coefficients =
+                        static_cast<const Linear*> (terms.at(t))->coefficients();
+                _linearTerms.push_back(terms.at(t));
+                _linearCoefficients.insert(_linearCoefficients.end(),
+                        coefficients.begin(), coefficients.begin() + numberOfInputs);
+                _linearCoefficients.push_back((int) coefficients.size() > numberOfInputs
+                        ? coefficients.back() : 0.0);
+            }
+            _linearOutputIndex.at(o) = (int) _linearOutputs.size();
+            _linearOutputs.push_back(output);
+            maximumRows = std::max(maximumRows, output.numberOfRows);
+            accumulated = accumulated or output.accumulation;
+        }
+
+        //Open addressing table from the terms to their rows, at most half full
+        if (not _linearTerms.empty()) {
+            std::size_t size = 2;
+            while (size < 2 * _linearTerms.size()) size *= 2;
+            _linearRowTable.assign(size, std::pair<const Term*, int>((const Term*) fl::null, -1));
+            for (std::size_t r = 0; r < _linearTerms.size(); ++r) {
+                std::size_t i = linearHash(_linearTerms.at(r)) & (size - 1);
+                while (_linearRowTable.at(i).first) i = (i + 1) & (size - 1);
+                _linearRowTable.at(i) = std::pair<const Term*, int>(_linearTerms.at(r), (int) r);
+            }
+        }
+        for (std::size_t c = 0; c < _conclusions.size(); ++c) {
+            Conclusion& conclusion = _conclusions.at(c);
+            if (_linearOutputIndex.at(conclusion.outputIndex) >= 0) {
+                conclusion.row = linearRow(conclusion.term);
+            }
+        }
+
+        _inputValues.assign(std::max(numberOfInputs, 1), fl::nan);
+        _linearDegrees.assign(std::max(maximumRows, 1), -1.0);
+        _linearBatchable = _batchable and not _linearOutputs.empty()
+                and _linearOutputs.size() == _engine->outputVariables().size();
+        if (_linearBatchable) {
+            _batchLinearValues.resize(std::max(maximumRows, 1) * BatchSize, fl::nan);
+            if (accumulated) _batchAccumulated.resize(std::max(maximumRows, 1) * BatchSize, -1.0);
+            _batchSums.resize(BatchSize, 0.0);
+            _batchWeights.resize(BatchSize, 0.0);
+            _batchFired.resize(BatchSize, 0.0);
+            _batchLinearRows.resize(std::max(maximumRows, 1), false);
+        }
+    }
+
+    void CompiledEngine::compileIntegralOutputs() {
+        _integralCodes.assign(_engine->numberOfOutputVariables(), NOT_INTEGRAL);
+        _integralForms.assign(_engine->numberOfOutputVariables(), SAMPLED);
+        _piecewiseLinears.assign(_engine->numberOfOutputVariables(), PiecewiseLinear());
+        _sampledAreas.assign(_engine->numberOfOutputVariables(), SampledArea());
+        for (int o = 0; o < _engine->numberOfOutputVariables(); ++o) {
+            _integralCodes.at(o) = integralCode(_engine->getOutputVariable(o)->getDefuzzifier(),
+                    _integralForms.at(o));
+        }
+    }
+
+    int CompiledEngine::compileSlot(const Variable* variable, const Term* term,
+            const std::vector<Hedge*>& hedges) {
+        for (std::size_t i = 0; i < _slots.size(); ++i) {
+            const Slot& slot = _slots.at(i);
+            if (slot.variable != variable or slot.term != term
+                    or slot.numberOfHedges != (int) hedges.size()) continue;
+            bool sameHedges = true;
+            for (int h = 0; h < slot.numberOfHedges and sameHedges; ++h) {
+                sameHedges = (_hedges.at(slot.firstHedge + h) == hedges.at(hedges.size() - 1 - h));
+            }
+            if (sameHedges) return (int) i;
+        }
+
+        Slot slot;
+        slot.variable = variable;
+        slot.variableIndex = -1;
+        slot.term = term;
+        slot.firstHedge = (int) _hedges.size();
+        _hedges.insert(_hedges.end(), hedges.rbegin(), hedges.rend());
+        slot.numberOfHedges = (int) hedges.size();
+        //"any" does not depend on the inputs, and disabled variables are checked on every evaluation
+        slot.constant = not hedges.empty() and dynamic_cast<const Any*> (hedges.back());
+
+        for (int i = 0; i < _engine->numberOfInputVariables() and slot.variableIndex < 0; ++i) {
+            if (_engine->getInputVariable(i) == variable) slot.variableIndex = i;
+        }
+        bool isInput = slot.variableIndex >= 0;
+        for (int i = 0; i < _engine->numberOfOutputVariables() and slot.variableIndex < 0; ++i) {
+            if (_engine->getOutputVariable(i) == variable) slot.variableIndex = i;
+        }
+        if (slot.variableIndex < 0) {
+            throw fl::Exception("[compiled engine error] variable <" + variable->getName()
+                    + "> is not registered in the engine", FL_AT);
+        }
+        //Outside the support of the term its membership is zero, so the slot takes its hedged zero
+        slot.supportStart = -fl::inf;
+        slot.supportEnd = fl::inf;
+        if (isInput and not slot.constant) {
+            TermIndex::support(term, slot.supportStart, slot.supportEnd);
+            _inputSlots.push_back((int) _slots.size());
+        }
+        slot.outsideSupport = applyHedges(slot.firstHedge, slot.numberOfHedges, 0.0);
+        _slots.push_back(slot);
+        _kernels.push_back(MembershipKernel(term));
+        return (int) _slots.size() - 1;
+    }
+
+    int CompiledEngine::compileExpression(const Expression* node, const Rule* rule,
+            const CompiledBlock& block, int depth) {
+        if (const Proposition* proposition = dynamic_cast<const Proposition*> (node)) {
+            Instruction instruction;
+            instruction.operand = compileSlot(proposition->variable, proposition->term, proposition->hedges);
+            const Slot& slot = _slots.at(instruction.operand);
+            bool isOutput = not slot.constant and
+                    dynamic_cast<const OutputVariable*> (proposition->variable);
+            instruction.code = isOutput ? LOAD_OUTPUT : LOAD_SLOT;
+            _instructions.push_back(instruction);
+            return depth + 1;
+        }
+        if (const Operator* fuzzyOperator = dynamic_cast<const Operator*> (node)) {
+            Instruction instruction;
+            instruction.operand = 0;
+            if (fuzzyOperator->name == Rule::andKeyword()) {
+                if (not block.conjunction) {
+                    throw fl::Exception("[conjunction error] the following rule requires a conjunction operator:\n"
+                            + rule->getText(), FL_AT);
+                }
+                instruction.code = CONJUNCTION;
+            } else if (fuzzyOperator->name == Rule::orKeyword()) {
+                if (not block.disjunction) {
+                    throw fl::Exception("[disjunction error] the following rule requires a disjunction operator:\n"
+                            + rule->getText(), FL_AT);
+                }
+                instruction.code = DISJUNCTION;
+            } else {
+                throw fl::Exception("[syntax error] operator <" + fuzzyOperator->name + "> not recognized", FL_AT);
+            }
+            int leftDepth = compileExpression(fuzzyOperator->left, rule, block, depth);
+            int rightDepth = compileExpression(fuzzyOperator->right, rule, block, depth + 1);
+            _instructions.push_back(instruction);
+            return std::max(leftDepth, rightDepth);
+        }
+        throw fl::Exception("[compiled engine error] unexpected expression in rule <" + rule->getText() + ">", FL_AT);
+    }
+
+    void CompiledEngine::compileRuleIndex() {
+        //Replays the instructions of each rule on a stack of slot sets: a conjunction that is zero when
+        //either operand is zero requires the slots of both, while any other norm with N(0, 0) = 0 only
+        //requires the slots that both operands require
+        std::vector<int> postings(_slots.size(), 0);
+        for (std::size_t r = 0; r < _rules.size(); ++r) {
+            CompiledRule& rule = _rules.at(r);
+            const CompiledBlock* block = fl::null;
+            for (std::size_t b = 0; b < _blocks.size() and not block; ++b) {
+                const CompiledBlock& candidate = _blocks.at(b);
+                if ((int) r < candidate.firstRule + candidate.numberOfRules) block = &candidate;
+            }
+            std::vector<std::vector<int> > sets;
+            for (int i = rule.firstInstruction; i < rule.firstInstruction + rule.numberOfInstructions; ++i) {
+                const Instruction& instruction = _instructions.at(i);
+                if (instruction.code == LOAD_SLOT or instruction.code == LOAD_OUTPUT) {
+                    sets.push_back(std::vector<int>());
+                    if (instruction.code == LOAD_SLOT) sets.back().push_back(instruction.operand);
+                    continue;
+                }
+                std::vector<int> right = sets.back();
+                sets.pop_back();
+                std::vector<int>& left = sets.back();
+                std::vector<int> result;
+                const NormCode code = (instruction.code == CONJUNCTION)
+                        ? block->conjunctionCode : block->disjunctionCode;
+                if (code == MINIMUM or code == ALGEBRAIC_PRODUCT) {
+                    std::set_union(left.begin(), left.end(), right.begin(), right.end(),
+                            std::back_inserter(result));
+                } else if (code != CUSTOM) {
+                    std::set_intersection(left.begin(), left.end(), right.begin(), right.end(),
+                            std::back_inserter(result));
+                }
+                left.swap(result);
+            }
+            rule.firstRequired = (int) _requiredSlots.size();
+            rule.numberOfRequired = sets.empty() ? 0 : (int) sets.back().size();
+            if (not sets.empty()) {
+                _requiredSlots.insert(_requiredSlots.end(), sets.back().begin(), sets.back().end());
+            }
+            for (int q = rule.firstRequired; q < rule.firstRequired + rule.numberOfRequired; ++q) {
+                ++postings.at(_requiredSlots.at(q));
+            }
+        }
+
+        //Each rule is indexed once, under the required slot shared by the fewest rules
+        std::vector<int> keys(_rules.size(), -1);
+        _ruleIndexStart.assign(_slots.size() + 1, 0);
+        for (std::size_t r = 0; r < _rules.size(); ++r) {
+            const CompiledRule& rule = _rules.at(r);
+            for (int q = rule.firstRequired; q < rule.firstRequired + rule.numberOfRequired; ++q) {
+                const int slot = _requiredSlots.at(q);
+                if (keys.at(r) < 0 or postings.at(slot) < postings.at(keys.at(r))) keys.at(r) = slot;
+            }
+            if (keys.at(r) < 0) {
+                _unindexedRules.push_back((int) r);
+            } else {
+                ++_ruleIndexStart.at(keys.at(r) + 1);
+            }
+        }
+        for (std::size_t i = 0; i < _slots.size(); ++i) {
+            _ruleIndexStart.at(i + 1) += _ruleIndexStart.at(i);
+        }
+        _ruleIndex.resize(_ruleIndexStart.back());
+        std::vector<int> position(_ruleIndexStart.begin(), _ruleIndexStart.end() - 1);
+        for (std::size_t r = 0; r < _rules.size(); ++r) {
+            if (keys.at(r) >= 0) _ruleIndex.at(position.at(keys.at(r))++) = (int) r;
+        }
+        _activeRules.resize(std::max((int) _rules.size(), 1));
+    }
+
+    scalar CompiledEngine::fuzzify(const Slot& slot, scalar x) const {
+        if (not slot.variable->isEnabled()) {
+            return 0.0;
+        }
+        if (slot.constant) {
+            //"any" is the last hedge in the text, hence the first one to be applied
+            return applyHedges(slot.firstHedge + 1, slot.numberOfHedges - 1,
+                    _hedges[slot.firstHedge]->hedge(fl::nan));
+        }
+        if (x < slot.supportStart or x > slot.supportEnd) {
+            return slot.outsideSupport;
+        }
+        return applyHedges(slot.firstHedge, slot.numberOfHedges, slot.term->membership(x));
+    }
+
+    scalar CompiledEngine::fuzzify(const Slot& slot, const Accumulated* fuzzyOutput) const {
+        if (not slot.variable->isEnabled()) {
+            return 0.0;
+        }
+        return applyHedges(slot.firstHedge, slot.numberOfHedges, fuzzyOutput->activationDegree(slot.term));
+    }
+
+    scalar CompiledEngine::applyHedges(int firstHedge, int numberOfHedges, scalar x) const {
+        const int lastHedge = firstHedge + numberOfHedges;
+        for (int hedge = firstHedge; hedge < lastHedge; ++hedge) {
+            x = _hedges[hedge]->hedge(x);
+        }
+        return x;
+    }
+
+    int CompiledEngine::activeRules(const scalar* slotValues, int* rules) const {
+        int size = 0;
+        for (std::size_t slot = 0; slot + 1 < _ruleIndexStart.size(); ++slot) {
+            //NaN is not zero, since Op::min and Op::max ignore it
+            if (slotValues[slot] == 0.0) continue;
+            for (int k = _ruleIndexStart[slot]; k < _ruleIndexStart[slot + 1]; ++k) {
+                const CompiledRule& rule = _rules[_ruleIndex[k]];
+                bool active = true;
+                for (int q = rule.firstRequired; q < rule.firstRequired + rule.numberOfRequired and active; ++q) {
+                    active = slotValues[_requiredSlots[q]] != 0.0;
+                }
+                if (active) rules[size++] = _ruleIndex[k];
+            }
+        }
+        std::sort(rules, rules + size);
+
+        //Merges the rules that are always evaluated, which are already sorted, from the back
+        int indexed = size - 1, unindexed = (int) _unindexedRules.size() - 1;
+        size += (int) _unindexedRules.size();
+        for (int position = size - 1; unindexed >= 0; --position) {
+            if (indexed >= 0 and rules[indexed] > _unindexedRules[unindexed]) {
+                rules[position] = rules[indexed--];
+            } else {
+                rules[position] = _unindexedRules[unindexed--];
+            }
+        }
+        return size;
+    }
+
+    template <typename Conjunction, typename Disjunction>
+    scalar CompiledEngine::evaluateWith(const Conjunction& conjunction, const Disjunction& disjunction,
+            const CompiledRule& rule, const scalar* slotValues, scalar* stack,
+            const std::vector<Accumulated*>& fuzzyOutputs) const {
+        int top = -1;
+        const Instruction* instruction = &_instructions[rule.firstInstruction];
+        const Instruction* end = instruction + rule.numberOfInstructions;
+        for (; instruction != end; ++instruction) {
+            switch (instruction->code) {
+                case LOAD_SLOT:
+                    stack[++top] = slotValues[instruction->operand];
+                    break;
+                case LOAD_OUTPUT:
+                {
+                    const Slot& slot = _slots[instruction->operand];
+                    stack[++top] = fuzzify(slot, fuzzyOutputs[slot.variableIndex]);
+                    break;
+                }
+                case CONJUNCTION:
+                    --top;
+                    stack[top] = conjunction(stack[top], stack[top + 1]);
+                    break;
+                case DISJUNCTION:
+                    --top;
+                    stack[top] = disjunction(stack[top], stack[top + 1]);
+                    break;
+            }
+        }
+        return stack[top];
+    }
+
+    scalar CompiledEngine::evaluate(const CompiledRule& rule, const CompiledBlock& block,
+            const scalar* slotValues, scalar* stack,
+            const std::vector<Accumulated*>& fuzzyOutputs) const {
+        return evaluateWith(CodedNorm(block.conjunctionCode, block.conjunction),
+                CodedNorm(block.disjunctionCode, block.disjunction), rule, slotValues, stack, fuzzyOutputs);
+    }
+
+    template <typename Conjunction, typename Disjunction>
+    int CompiledEngine::fireWith(const Conjunction& conjunction, const Disjunction& disjunction,
+            const CompiledBlock& block, const int* activeRules, int active, int numberOfActiveRules,
+            const scalar* slotValues, scalar* stack,
+            const std::vector<Accumulated*>& fuzzyOutputs, ActivationPool& pool) const {
+        const int end = block.firstRule + block.numberOfRules;
+        for (; active < numberOfActiveRules and activeRules[active] < end; ++active) {
+            const CompiledRule& rule = _rules[activeRules[active]];
+            scalar degree = rule.weight * evaluateWith(conjunction, disjunction, rule, slotValues, stack, fuzzyOutputs);
+            //Same as Op::isGt(degree, 0.0), which is false for NaN
+            if (degree >= _macheps) {
+                activate(rule, block, degree, fuzzyOutputs, pool);
+            }
+        }
+        return active;
+    }
+
+    int CompiledEngine::fire(const CompiledBlock& block, const int* activeRules, int active, int numberOfActiveRules,
+            const scalar* slotValues, scalar* stack,
+            const std::vector<Accumulated*>& fuzzyOutputs, ActivationPool& pool) const {
+        switch (block.normPair) {
+            case MINIMUM_MAXIMUM:
+                return fireWith(MinimumNorm(), MaximumNorm(), block, activeRules, active, numberOfActiveRules,
+                        slotValues, stack, fuzzyOutputs, pool);
+            case ALGEBRAIC_PRODUCT_SUM:
+                return fireWith(AlgebraicProductNorm(), AlgebraicSumNorm(), block, activeRules, active,
+                        numberOfActiveRules, slotValues, stack, fuzzyOutputs, pool);
+            case BOUNDED_DIFFERENCE_SUM:
+                return fireWith(BoundedDifferenceNorm(), BoundedSumNorm(), block, activeRules, active,
+                        numberOfActiveRules, slotValues, stack, fuzzyOutputs, pool);
+            default:
+                return fireWith(CodedNorm(block.conjunctionCode, block.conjunction),
+                        CodedNorm(block.disjunctionCode, block.disjunction), block, activeRules, active,
+                        numberOfActiveRules, slotValues, stack, fuzzyOutputs, pool);
+        }
+    }
+
+    void CompiledEngine::activate(const CompiledRule& rule, const CompiledBlock& block, scalar degree,
+            const std::vector<Accumulated*>& fuzzyOutputs, ActivationPool& pool) const {
+        const Conclusion* conclusion = &_conclusions[rule.firstConclusion];
+        const Conclusion* end = conclusion + rule.numberOfConclusions;
+        for (; conclusion != end; ++conclusion) {
+            pool.activate(fuzzyOutputs[conclusion->outputIndex], conclusion->term,
+                    applyHedges(conclusion->firstHedge, conclusion->numberOfHedges, degree),
+                    block.activation);
+        }
+    }
+
+    std::size_t CompiledEngine::linearHash(const Term* term) {
+        //The lowest bits of the address are the same for every term, by alignment
+        return (reinterpret_cast<std::size_t> (term) >> 4) * 2654435761u;
+    }
+
+    int CompiledEngine::linearRow(const Term* term) const {
+        if (_linearRowTable.empty()) return -1;
+        const std::size_t mask = _linearRowTable.size() - 1;
+        for (std::size_t i = linearHash(term) & mask;; i = (i + 1) & mask) {
+            if (_linearRowTable[i].first == term) return _linearRowTable[i].second;
+            if (not _linearRowTable[i].first) return -1;
+        }
+    }
+
+    scalar CompiledEngine::linearValue(int row, const scalar* inputValues) const {
+        //Same order of the sums as Linear::membership()
+        const int numberOfInputs = _linearColumns - 1;
+        const scalar* coefficients = &_linearCoefficients[row * _linearColumns];
+        scalar result = 0.0;
+        for (int i = 0; i < numberOfInputs; ++i) {
+            result += coefficients[i] * inputValues[i];
+        }
+        return result + coefficients[numberOfInputs];
+    }
+
+    scalar CompiledEngine::defuzzifyLinear(const LinearOutput& output, const Accumulated* fuzzyOutput,
+            const scalar* inputValues, scalar* rowDegrees) const {
+        const std::vector<Activated*>& terms = fuzzyOutput->terms();
+        scalar sum = 0.0, weights = 0.0;
+        //With accumulation, the degrees are accumulated per row, and rows without any stay negative
+        if (output.accumulation) std::fill(rowDegrees, rowDegrees + output.numberOfRows, scalar(-1.0));
+        for (std::size_t i = 0; i < terms.size(); ++i) {
+            const Term* term = terms[i]->getTerm();
+            const int row = linearRow(term);
+            if (row < output.firstRow or row >= output.firstRow + output.numberOfRows) {
+                throw fl::Exception("[compiled engine error] term <" + term->getName() + "> "
+                        "is not a conclusion of the compiled output", FL_AT);
+            }
+            const scalar w = terms[i]->getDegree();
+            if (output.accumulation) {
+                scalar& degree = rowDegrees[row - output.firstRow];
+                degree = compute(output.accumulationCode, output.accumulation, degree < 0.0 ? 0.0 : degree, w);
+            } else {
+                sum += w * linearValue(row, inputValues);
+                weights += w;
+            }
+        }
+        if (output.accumulation) {
+            for (int r = 0; r < output.numberOfRows; ++r) {
+                const scalar w = rowDegrees[r];
+                if (w < 0.0) continue;
+                sum += w * linearValue(output.firstRow + r, inputValues);
+                weights += w;
+            }
+        }
+        return output.average ? sum / weights : sum;
+    }
+
+    scalar CompiledEngine::defuzzifyIntegral(int outputIndex, const AccumulatedKernel& fuzzyOutput,
+            PiecewiseLinear& piecewiseLinear, SampledArea& sampledArea) const {
+        const OutputVariable* outputVariable = _engine->getOutputVariable(outputIndex);
+        //The resolution is read on every call, as Engine::process() would see it changed
+        const int resolution = static_cast<const IntegralDefuzzifier*> (
+                outputVariable->getDefuzzifier())->getResolution();
+        const scalar minimum = outputVariable->getMinimum();
+        const scalar maximum = outputVariable->getMaximum();
+        const IntegralCode code = _integralCodes.at(outputIndex);
+        if (_integralForms.at(outputIndex) == PREFIX_SUM) {
+            //Same as PrefixSumBisector
+            if (not sampledArea.build(fuzzyOutput, minimum, maximum, resolution)) return fl::nan;
+            return sampledArea.bisector();
+        }
+        //Same as the Exact defuzzifiers, which sample the fuzzy outputs PiecewiseLinear does not apply to
+        if (_integralForms.at(outputIndex) == PIECEWISE_LINEAR
+                and piecewiseLinear.build(fuzzyOutput.getTerm(), minimum, maximum)) {
+            switch (code) {
+                case CENTROID:
+                    return piecewiseLinear.centroid();
+                case BISECTOR:
+                    return piecewiseLinear.bisector();
+                case MEAN_OF_MAXIMUM:
+                    return piecewiseLinear.meanOfMaximum();
+                case SMALLEST_OF_MAXIMUM:
+                    return piecewiseLinear.smallestOfMaximum();
+                default:
+                    return piecewiseLinear.largestOfMaximum();
+            }
+        }
+        switch (code) {
+            case CENTROID:
+                return fuzzyOutput.centroid(minimum, maximum, resolution);
+            case BISECTOR:
+                return fuzzyOutput.bisector(minimum, maximum, resolution);
+            case MEAN_OF_MAXIMUM:
+                return fuzzyOutput.meanOfMaximum(minimum, maximum, resolution);
+            case SMALLEST_OF_MAXIMUM:
+                return fuzzyOutput.smallestOfMaximum(minimum, maximum, resolution);
+            case LARGEST_OF_MAXIMUM:
+                return fuzzyOutput.largestOfMaximum(minimum, maximum, resolution);
+            default:
+                throw fl::Exception("[compiled engine error] output variable <" + outputVariable->getName()
+                        + "> is not defuzzified by an integral defuzzifier", FL_AT);
+        }
+    }
+
+    void CompiledEngine::process() {
+        if (not isCompiled()) {
+            throw fl::Exception("[compiled engine error] engine has not been compiled", FL_AT);
+        }
+        const std::vector<InputVariable*>& inputVariables = _engine->inputVariables();
+        const std::vector<OutputVariable*>& outputVariables = _engine->outputVariables();
+
+        const bool memoize = _memoized and _memoizable and _memoValid;
+        bool changed = not memoize;
+        for (std::size_t v = 0; v < inputVariables.size(); ++v) {
+            const scalar x = inputVariables[v]->getInputValue();
+            const bool enabled = inputVariables[v]->isEnabled();
+            _inputValues[v] = x;
+            if (memoize and enabled == _lastInputEnabled[v]
+                    and isUnchanged(x, _lastInputValues[v], _inputTolerance)) {
+                continue;
+            }
+            changed = true;
+            _lastInputValues[v] = x;
+            _lastInputEnabled[v] = enabled;
+            for (int i = _inputSlotOffsets[v]; i < _inputSlotOffsets[v + 1]; ++i) {
+                _slotValues[_inputSlots[i]] = fuzzify(_slots[_inputSlots[i]], x);
+            }
+        }
+
+        bool outputsUnchanged = not changed;
+        for (std::size_t i = 0; i < outputVariables.size() and outputsUnchanged; ++i) {
+            outputsUnchanged = isUnchanged(outputVariables[i]->getOutputValue(), _lastOutputValues[i], 0.0);
+        }
+        if (outputsUnchanged) {
+            //The fuzzy outputs are those of the same inputs, so only OutputVariable::defuzzify() moving the
+            //output value into the previous one is left
+            for (std::size_t i = 0; i < outputVariables.size(); ++i) {
+                const scalar outputValue = outputVariables[i]->getOutputValue();
+                if (Op::isFinite(outputValue)) outputVariables[i]->setPreviousOutputValue(outputValue);
+            }
+            return;
+        }
+
+        for (std::size_t i = 0; i < _fuzzyOutputs.size(); ++i) {
+            _pool.recycle(_fuzzyOutputs[i]);
+        }
+
+        //Rules are numbered block after block, so the active ones come out in the order of their blocks
+        const int numberOfActiveRules = activeRules(&_slotValues[0], &_activeRules[0]);
+        int active = 0;
+        for (std::size_t b = 0; b < _blocks.size(); ++b) {
+            active = fire(_blocks[b], &_activeRules[0], active, numberOfActiveRules,
+                    &_slotValues[0], &_stack[0], _fuzzyOutputs, _pool);
+        }
+
+        for (std::size_t i = 0; i < outputVariables.size(); ++i) {
+            defuzzify((int) i);
+            _lastOutputValues[i] = outputVariables[i]->getOutputValue();
+        }
+        _memoValid = true;
+    }
+
+    void CompiledEngine::defuzzify(int outputIndex) {
+        OutputVariable* outputVariable = _engine->getOutputVariable(outputIndex);
+        const int linear = _linearOutputIndex[outputIndex];
+        const IntegralCode integral = _integralCodes[outputIndex];
+        if ((linear >= 0 or integral != NOT_INTEGRAL)
+                and outputVariable->isEnabled() and not _fuzzyOutputs[outputIndex]->isEmpty()) {
+            //Same as OutputVariable::defuzzify() with a non-empty fuzzy output
+            const scalar outputValue = outputVariable->getOutputValue();
+            if (Op::isFinite(outputValue)) outputVariable->setPreviousOutputValue(outputValue);
+            scalar result;
+            if (linear >= 0) {
+                result = defuzzifyLinear(_linearOutputs[linear], _fuzzyOutputs[outputIndex],
+                        &_inputValues[0], &_linearDegrees[0]);
+            } else {
+                _fuzzyOutputKernel->set(_fuzzyOutputs[outputIndex]);
+                result = defuzzifyIntegral(outputIndex, *_fuzzyOutputKernel,
+                        _piecewiseLinears[outputIndex], _sampledAreas[outputIndex]);
+            }
+            if (outputVariable->isLockedOutputValueInRange()) {
+                result = Op::bound(result, outputVariable->getMinimum(), outputVariable->getMaximum());
+            }
+            outputVariable->setOutputValue(result);
+        } else {
+            outputVariable->defuzzify();
+        }
+    }
+
+    bool CompiledEngine::isUnchanged(scalar value, scalar last, scalar tolerance) {
+        return value == last or (Op::isNaN(value) and Op::isNaN(last)) or std::fabs(value - last) <= tolerance;
+    }
+
+    void CompiledEngine::setMemoized(bool memoized) {
+        _memoized = memoized;
+        _memoValid = false;
+    }
+
+    bool CompiledEngine::isMemoized() const {
+        return _memoized;
+    }
+
+    bool CompiledEngine::isMemoizable() const {
+        return _memoizable;
+    }
+
+    void CompiledEngine::setInputTolerance(scalar tolerance) {
+        _inputTolerance = tolerance;
+    }
+
+    scalar CompiledEngine::getInputTolerance() const {
+        return _inputTolerance;
+    }
+
+    void CompiledEngine::invalidate() {
+        _memoValid = false;
+    }
+
+    void CompiledEngine::fuzzifyBatch(const Slot& slot, const MembershipKernel& kernel,
+            const scalar* x, scalar* result, int size) const {
+        if (not slot.variable->isEnabled()) {
+            std::fill(result, result + size, scalar(0.0));
+            return;
+        }
+        const scalar start = slot.supportStart, end = slot.supportEnd;
+        if (kernel.getShape() != MembershipKernel::UNKNOWN) {
+            //Branching on the support would only get in the way of vectorizing the kernel
+            kernel.membership(x, result, size);
+            for (int k = 0; k < size; ++k) {
+                if (x[k] < start or x[k] > end) result[k] = 0.0;
+            }
+        } else {
+            const Term* term = slot.term;
+            for (int k = 0; k < size; ++k) {
+                result[k] = (x[k] < start or x[k] > end) ? 0.0 : term->membership(x[k]);
+            }
+        }
+        const int lastHedge = slot.firstHedge + slot.numberOfHedges;
+        for (int hedge = slot.firstHedge; hedge < lastHedge; ++hedge) {
+            const Hedge* h = _hedges[hedge];
+            for (int k = 0; k < size; ++k) {
+                result[k] = h->hedge(result[k]);
+            }
+        }
+    }
+
+    void CompiledEngine::evaluateBatch(const CompiledRule& rule, const CompiledBlock& block,
+            scalar* degrees, int size) {
+        scalar* stack = &_batchStack[0];
+        int top = -1;
+        const Instruction* instruction = &_instructions[rule.firstInstruction];
+        const Instruction* end = instruction + rule.numberOfInstructions;
+        for (; instruction != end; ++instruction) {
+            switch (instruction->code) {
+                case LOAD_SLOT:
+                {
+                    const scalar* values = &_batchSlotValues[instruction->operand * BatchSize];
+                    ++top;
+                    std::copy(values, values + size, stack + top * BatchSize);
+                    break;
+                }
+                case CONJUNCTION:
+                    --top;
+                    compute(block.conjunctionCode, block.conjunction,
+                            stack + top * BatchSize, stack + (top + 1) * BatchSize, size);
+                    break;
+                case DISJUNCTION:
+                    --top;
+                    compute(block.disjunctionCode, block.disjunction,
+                            stack + top * BatchSize, stack + (top + 1) * BatchSize, size);
+                    break;
+                default:
+                    throw fl::Exception("[compiled engine error] instruction cannot be evaluated in batch", FL_AT);
+            }
+        }
+        const scalar* result = stack + top * BatchSize;
+        const scalar weight = rule.weight;
+        for (int k = 0; k < size; ++k) {
+            degrees[k] = weight * result[k];
+        }
+    }
+
+    void CompiledEngine::processBatch(const std::vector<const scalar*>& inputs,
+            const std::vector<scalar*>& outputs, int size) {
+        if (not isCompiled()) {
+            throw fl::Exception("[compiled engine error] engine has not been compiled", FL_AT);
+        }
+        const std::vector<InputVariable*>& inputVariables = _engine->inputVariables();
+        const std::vector<OutputVariable*>& outputVariables = _engine->outputVariables();
+        if (inputs.size() != inputVariables.size() or outputs.size() != outputVariables.size()) {
+            std::ostringstream ex;
+            ex << "[compiled engine error] expected <" << inputVariables.size() << "> input arrays and <"
+                    << outputVariables.size() << "> output arrays, but got <" << inputs.size()
+                    << "> and <" << outputs.size() << ">";
+            throw fl::Exception(ex.str(), FL_AT);
+        }
+        //Samples overwrite the state of the engine one after another
+        _memoValid = false;
+
+        if (not _batchable) {
+            for (int k = 0; k < size; ++k) {
+                for (std::size_t i = 0; i < inputVariables.size(); ++i) {
+                    inputVariables[i]->setInputValue(inputs[i][k]);
+                }
+                process();
+                for (std::size_t i = 0; i < outputVariables.size(); ++i) {
+                    if (outputs[i]) outputs[i][k] = outputVariables[i]->getOutputValue();
+                }
+            }
+            return;
+        }
+
+        for (std::size_t i = 0; i < _slots.size(); ++i) {
+            if (_slots[i].constant) {
+                std::fill(&_batchSlotValues[i * BatchSize], &_batchSlotValues[i * BatchSize] + BatchSize,
+                        fuzzify(_slots[i], fl::nan));
+            }
+        }
+
+        //Disabled outputs are defuzzified by OutputVariable::defuzzify(), which processLinearBatch() cannot mirror
+        bool linearBatch = _linearBatchable;
+        for (std::size_t i = 0; i < outputVariables.size() and linearBatch; ++i) {
+            linearBatch = outputVariables[i]->isEnabled();
+        }
+
+        for (int start = 0; start < size; start += BatchSize) {
+            const int chunk = (size - start < BatchSize) ? size - start : BatchSize;
+
+            for (std::size_t i = 0; i < _inputSlots.size(); ++i) {
+                const int slot = _inputSlots[i];
+                fuzzifyBatch(_slots[slot], _kernels[slot], inputs[_slots[slot].variableIndex] + start,
+                        &_batchSlotValues[slot * BatchSize], chunk);
+            }
+
+            for (std::size_t b = 0; b < _blocks.size(); ++b) {
+                const CompiledBlock& block = _blocks[b];
+                for (int r = block.firstRule; r < block.firstRule + block.numberOfRules; ++r) {
+                    evaluateBatch(_rules[r], block, &_batchDegrees[r * BatchSize], chunk);
+                }
+            }
+
+            if (linearBatch) {
+                //Rules that fire for none of the samples are left out of the products and the sums
+                int numberOfActiveRules = 0, firings = 0;
+                for (int r = 0; r < (int) _rules.size(); ++r) {
+                    const scalar* degrees = &_batchDegrees[r * BatchSize];
+                    int fires = 0;
+                    for (int k = 0; k < chunk; ++k) {
+                        fires += degrees[k] >= _macheps;
+                    }
+                    if (fires > 0) _activeRules[numberOfActiveRules++] = r;
+                    firings += fires;
+                }
+                for (std::size_t i = 0; i < _linearOutputs.size(); ++i) {
+                    const LinearOutput& output = _linearOutputs[i];
+                    processLinearBatch(output, &_activeRules[0], numberOfActiveRules, firings,
+                            inputs, start, chunk, outputs[output.outputIndex]);
+                }
+                continue;
+            }
+
+            for (int k = 0; k < chunk; ++k) {
+                for (std::size_t i = 0; i < inputVariables.size(); ++i) {
+                    inputVariables[i]->setInputValue(inputs[i][start + k]);
+                    _inputValues[i] = inputs[i][start + k];
+                }
+                for (std::size_t i = 0; i < _fuzzyOutputs.size(); ++i) {
+                    _pool.recycle(_fuzzyOutputs[i]);
+                }
+                for (std::size_t b = 0; b < _blocks.size(); ++b) {
+                    const CompiledBlock& block = _blocks[b];
+                    for (int r = block.firstRule; r < block.firstRule + block.numberOfRules; ++r) {
+                        const scalar degree = _batchDegrees[r * BatchSize + k];
+                        if (degree >= _macheps) {
+                            activate(_rules[r], block, degree, _fuzzyOutputs, _pool);
+                        }
+                    }
+                }
+                for (std::size_t i = 0; i < outputVariables.size(); ++i) {
+                    defuzzify((int) i);
+                    if (outputs[i]) outputs[i][start + k] = outputVariables[i]->getOutputValue();
+                }
+            }
+        }
+
+        if (linearBatch and size > 0) {
+            //Leaves the inputs and fuzzy outputs of the last sample, whose degrees are still in the last chunk
+            const int last = (size - 1) % BatchSize;
+            for (std::size_t i = 0; i < inputVariables.size(); ++i) {
+                inputVariables[i]->setInputValue(inputs[i][size - 1]);
+            }
+            for (std::size_t i = 0; i < _fuzzyOutputs.size(); ++i) {
+                _pool.recycle(_fuzzyOutputs[i]);
+            }
+            for (std::size_t b = 0; b < _blocks.size(); ++b) {
+                const CompiledBlock& block = _blocks[b];
+                for (int r = block.firstRule; r < block.firstRule + block.numberOfRules; ++r) {
+                    const scalar degree = _batchDegrees[r * BatchSize + last];
+                    if (degree >= _macheps) {
+                        activate(_rules[r], block, degree, _fuzzyOutputs, _pool);
+                    }
+                }
+            }
+        }
+    }
+
+    void CompiledEngine::processLinearBatch(const LinearOutput& output, const int* activeRules,
+            int numberOfActiveRules, int firings, const std::vector<const scalar*>& inputs,
+            int start, int size, scalar* outputValues) {
+        scalar* sums = &_batchSums[0];
+        scalar* weights = &_batchWeights[0];
+        scalar* fired = &_batchFired[0];
+        //When few rules fire per sample, as with partitions of triangles, the products of every active row
+        //for every sample are mostly thrown away, so each sample takes the rows of its own rules instead
+        if (firings * 4 < numberOfActiveRules * size) {
+            processLinearSamples(output, activeRules, numberOfActiveRules, inputs, start, size);
+        } else {
+            processLinearChunk(output, activeRules, numberOfActiveRules, inputs, start, size);
+        }
+
+        //Same as OutputVariable::defuzzify() one sample after another
+        OutputVariable* outputVariable = _engine->getOutputVariable(output.outputIndex);
+        const bool lockPrevious = outputVariable->isLockedPreviousOutputValue();
+        const bool lockRange = outputVariable->isLockedOutputValueInRange();
+        const scalar minimum = outputVariable->getMinimum(), maximum = outputVariable->getMaximum();
+        const scalar defaultValue = outputVariable->getDefaultValue();
+        scalar previous = outputVariable->getPreviousOutputValue();
+        scalar value = outputVariable->getOutputValue();
+        for (int k = 0; k < size; ++k) {
+            if (Op::isFinite(value)) previous = value;
+            if (fired[k] > 0.0) value = output.average ? sums[k] / weights[k] : sums[k];
+            else if (lockPrevious and not Op::isNaN(previous)) value = previous;
+            else value = defaultValue;
+            if (lockRange) value = Op::bound(value, minimum, maximum);
+            if (outputValues) outputValues[start + k] = value;
+        }
+        outputVariable->setPreviousOutputValue(previous);
+        outputVariable->setOutputValue(value);
+    }
+
+    void CompiledEngine::processLinearSamples(const LinearOutput& output, const int* activeRules,
+            int numberOfActiveRules, const std::vector<const scalar*>& inputs, int start, int size) {
+        const int numberOfInputs = _linearColumns - 1;
+        scalar* x = &_inputValues[0];
+        scalar* rowDegrees = &_linearDegrees[0];
+        if (output.accumulation) std::fill(rowDegrees, rowDegrees + output.numberOfRows, scalar(-1.0));
+        for (int k = 0; k < size; ++k) {
+            for (int i = 0; i < numberOfInputs; ++i) {
+                x[i] = inputs[i][start + k];
+            }
+            scalar sum = 0.0, weight = 0.0, count = 0.0;
+            for (int i = 0; i < numberOfActiveRules; ++i) {
+                const scalar degree = _batchDegrees[activeRules[i] * BatchSize + k];
+                if (not (degree >= _macheps)) continue;
+                const CompiledRule& rule = _rules[activeRules[i]];
+                for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                    const Conclusion& conclusion = _conclusions[c];
+                    if (conclusion.outputIndex != output.outputIndex) continue;
+                    const scalar w = applyHedges(conclusion.firstHedge, conclusion.numberOfHedges, degree);
+                    if (output.accumulation) {
+                        scalar& accumulated = rowDegrees[conclusion.row - output.firstRow];
+                        accumulated = compute(output.accumulationCode, output.accumulation,
+                                accumulated < 0.0 ? 0.0 : accumulated, w);
+                    } else {
+                        sum += w * linearValue(conclusion.row, x);
+                        weight += w;
+                        count += 1.0;
+                    }
+                }
+            }
+            if (output.accumulation) {
+                for (int r = 0; r < output.numberOfRows; ++r) {
+                    const scalar w = rowDegrees[r];
+                    if (w < 0.0) continue;
+                    sum += w * linearValue(output.firstRow + r, x);
+                    weight += w;
+                    count += 1.0;
+                    rowDegrees[r] = -1.0;
+                }
+            }
+            _batchSums[k] = sum;
+            _batchWeights[k] = weight;
+            _batchFired[k] = count;
+        }
+    }
+
+    void CompiledEngine::processLinearChunk(const LinearOutput& output, const int* activeRules,
+            int numberOfActiveRules, const std::vector<const scalar*>& inputs, int start, int size) {
+        //The rows of the terms that the active rules conclude
+        std::fill(_batchLinearRows.begin(), _batchLinearRows.begin() + output.numberOfRows, false);
+        for (int i = 0; i < numberOfActiveRules; ++i) {
+            const CompiledRule& rule = _rules[activeRules[i]];
+            for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                const Conclusion& conclusion = _conclusions[c];
+                if (conclusion.outputIndex == output.outputIndex) {
+                    _batchLinearRows[conclusion.row - output.firstRow] = true;
+                }
+            }
+        }
+
+        const int numberOfInputs = _linearColumns - 1;
+        //The value of the active rows for every sample, summed in the same order as Linear::membership()
+        scalar* values = &_batchLinearValues[0];
+        for (int r = 0; r < output.numberOfRows; ++r) {
+            if (not _batchLinearRows[r]) continue;
+            const scalar* coefficients = &_linearCoefficients[(output.firstRow + r) * _linearColumns];
+            scalar* z = values + r * BatchSize;
+            std::fill(z, z + size, scalar(0.0));
+            for (int i = 0; i < numberOfInputs; ++i) {
+                const scalar coefficient = coefficients[i];
+                const scalar* x = inputs[i] + start;
+                for (int k = 0; k < size; ++k) {
+                    z[k] += coefficient * x[k];
+                }
+            }
+            const scalar constant = coefficients[numberOfInputs];
+            for (int k = 0; k < size; ++k) {
+                z[k] += constant;
+            }
+        }
+
+        scalar* sums = &_batchSums[0];
+        scalar* weights = &_batchWeights[0];
+        scalar* fired = &_batchFired[0];
+        std::fill(sums, sums + size, scalar(0.0));
+        std::fill(weights, weights + size, scalar(0.0));
+        std::fill(fired, fired + size, scalar(0.0));
+        if (not output.accumulation) {
+            //Conclusions in the order they would be activated, those that do not fire adding zeros
+            for (int i = 0; i < numberOfActiveRules; ++i) {
+                const CompiledRule& rule = _rules[activeRules[i]];
+                const scalar* degrees = &_batchDegrees[activeRules[i] * BatchSize];
+                for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                    const Conclusion& conclusion = _conclusions[c];
+                    if (conclusion.outputIndex != output.outputIndex) continue;
+                    const scalar* z = values + (conclusion.row - output.firstRow) * BatchSize;
+                    if (conclusion.numberOfHedges == 0) {
+                        for (int k = 0; k < size; ++k) {
+                            const bool fires = degrees[k] >= _macheps;
+                            const scalar w = fires ? degrees[k] : 0.0;
+                            sums[k] += fires ? w * z[k] : 0.0;
+                            weights[k] += w;
+                            fired[k] += fires ? 1.0 : 0.0;
+                        }
+                    } else {
+                        for (int k = 0; k < size; ++k) {
+                            if (not (degrees[k] >= _macheps)) continue;
+                            const scalar w = applyHedges(conclusion.firstHedge, conclusion.numberOfHedges, degrees[k]);
+                            sums[k] += w * z[k];
+                            weights[k] += w;
+                            fired[k] += 1.0;
+                        }
+                    }
+                }
+            }
+        } else {
+            //Degrees accumulated per row, and then summed in the order of the rows, as the defuzzifiers do
+            scalar* accumulated = &_batchAccumulated[0];
+            for (int r = 0; r < output.numberOfRows; ++r) {
+                if (not _batchLinearRows[r]) continue;
+                std::fill(accumulated + r * BatchSize, accumulated + r * BatchSize + size, scalar(-1.0));
+            }
+            for (int i = 0; i < numberOfActiveRules; ++i) {
+                const CompiledRule& rule = _rules[activeRules[i]];
+                const scalar* degrees = &_batchDegrees[activeRules[i] * BatchSize];
+                for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                    const Conclusion& conclusion = _conclusions[c];
+                    if (conclusion.outputIndex != output.outputIndex) continue;
+                    scalar* degree = accumulated + (conclusion.row - output.firstRow) * BatchSize;
+                    for (int k = 0; k < size; ++k) {
+                        if (not (degrees[k] >= _macheps)) continue;
+                        const scalar w = applyHedges(conclusion.firstHedge, conclusion.numberOfHedges, degrees[k]);
+                        degree[k] = compute(output.accumulationCode, output.accumulation,
+                                degree[k] < 0.0 ? 0.0 : degree[k], w);
+                    }
+                }
+            }
+            for (int r = 0; r < output.numberOfRows; ++r) {
+                if (not _batchLinearRows[r]) continue;
+                const scalar* degree = accumulated + r * BatchSize;
+                const scalar* z = values + r * BatchSize;
+                for (int k = 0; k < size; ++k) {
+                    const bool fires = degree[k] >= 0.0;
+                    sums[k] += fires ? degree[k] * z[k] : 0.0;
+                    weights[k] += fires ? degree[k] : 0.0;
+                    fired[k] += fires ? 1.0 : 0.0;
+                }
+            }
+        }
+    }
+
+    bool CompiledEngine::isBatchable() const {
+        return _batchable;
+    }
+
+    bool CompiledEngine::isCompiled() const {
+        return _engine and not _stack.empty();
+    }
+
+    Engine* CompiledEngine::getEngine() const {
+        return _engine;
+    }
+
+    int CompiledEngine::numberOfSlots() const {
+        return (int) _slots.size();
+    }
+
+    int CompiledEngine::numberOfInstructions() const {
+        return (int) _instructions.size();
+    }
+
+    int CompiledEngine::numberOfRules() const {
+        return (int) _rules.size();
+    }
+
+    int CompiledEngine::numberOfConclusions(int outputIndex) const {
+        return _numberOfConclusions.at(outputIndex);
+    }
+
+    const std::vector<CompiledEngine::Slot>& CompiledEngine::slots() const {
+        return _slots;
+    }
+
+    const std::vector<int>& CompiledEngine::inputSlots() const {
+        return _inputSlots;
+    }
+
+    const std::vector<int>& CompiledEngine::inputSlotOffsets() const {
+        return _inputSlotOffsets;
+    }
+
+    const std::vector<CompiledEngine::CompiledRule>& CompiledEngine::rules() const {
+        return _rules;
+    }
+
+    const std::vector<CompiledEngine::CompiledBlock>& CompiledEngine::blocks() const {
+        return _blocks;
+    }
+
+    const std::vector<int>& CompiledEngine::requiredSlots() const {
+        return _requiredSlots;
+    }
+
+    const std::vector<CompiledEngine::Instruction>& CompiledEngine::instructions() const {
+        return _instructions;
+    }
+
+    const std::vector<CompiledEngine::Conclusion>& CompiledEngine::conclusions() const {
+        return _conclusions;
+    }
+
+    const std::vector<const Hedge*>& CompiledEngine::hedges() const {
+        return _hedges;
+    }
+
+    const std::vector<scalar>& CompiledEngine::constantSlotValues() const {
+        return _slotValues;
+    }
+
+    const std::vector<CompiledEngine::LinearOutput>& CompiledEngine::linearOutputs() const {
+        return _linearOutputs;
+    }
+
+    int CompiledEngine::linearOutputIndex(int outputIndex) const {
+        return _linearOutputIndex.at(outputIndex);
+    }
+
+    const std::vector<const Term*>& CompiledEngine::linearTerms() const {
+        return _linearTerms;
+    }
+
+    const std::vector<scalar>& CompiledEngine::linearCoefficients() const {
+        return _linearCoefficients;
+    }
+
+    int CompiledEngine::maximumLinearRows() const {
+        return (int) _linearDegrees.size();
+    }
+
+    CompiledEngine::IntegralCode CompiledEngine::integralOutputCode(int outputIndex) const {
+        return _integralCodes.at(outputIndex);
+    }
+
+    CompiledEngine::IntegralForm CompiledEngine::integralOutputForm(int outputIndex) const {
+        return _integralForms.at(outputIndex);
+    }
+
+    const SampledArea& CompiledEngine::sampledOutput(int outputIndex) const {
+        return _sampledAreas.at(outputIndex);
+    }
+
+    int CompiledEngine::stackSize() const {
+        return (int) _stack.size();
+    }
+
+    scalar CompiledEngine::getMacheps() const {
+        return _macheps;
+    }
+
+    std::string CompiledEngine::toString() const {
+        std::ostringstream ss;
+        ss << "CompiledEngine: " << (_engine ? _engine->getName() : "") << "\n";
+        for (std::size_t i = 0; i < _slots.size(); ++i) {
+            const Slot& slot = _slots.at(i);
+            ss << "  slot[" << i << "]: " << slot.variable->getName() << " is ";
+            for (int h = slot.numberOfHedges - 1; h >= 0; --h) {
+                ss << _hedges.at(slot.firstHedge + h)->name();
+                if (h > 0 or slot.term) ss << " ";
+            }
+            if (slot.term) ss << slot.term->getName();
+            ss << "\n";
+        }
+        for (std::size_t r = 0; r < _rules.size(); ++r) {
+            const CompiledRule& rule = _rules.at(r);
+            ss << "  rule[" << r << "]:";
+            for (int i = 0; i < rule.numberOfInstructions; ++i) {
+                const Instruction& instruction = _instructions.at(rule.firstInstruction + i);
+                switch (instruction.code) {
+                    case LOAD_SLOT: ss << " $" << instruction.operand;
+                        break;
+                    case LOAD_OUTPUT: ss << " @" << instruction.operand;
+                        break;
+                    case CONJUNCTION: ss << " " << Rule::andKeyword();
+                        break;
+                    case DISJUNCTION: ss << " " << Rule::orKeyword();
+                        break;
+                }
+            }
+            ss << " -> " << rule.numberOfConclusions << " conclusion(s)";
+            ss << " " << Rule::withKeyword() << " " << Op::str(rule.weight) << "\n";
+        }
+        return ss.str();
+    }
+
+    CompiledEngine::NormCode CompiledEngine::normCode(const Norm* norm) {
+        //Subclasses may compute otherwise, so only the stock classes are matched, by their type rather than
+        //by className(), which returns a new string on every snapshot of a fuzzy output
+        if (not norm) return CUSTOM;
+        const std::type_info& type = typeid (*norm);
+        if (type == typeid (Minimum)) return MINIMUM;
+        if (type == typeid (Maximum)) return MAXIMUM;
+        if (type == typeid (AlgebraicProduct)) return ALGEBRAIC_PRODUCT;
+        if (type == typeid (AlgebraicSum)) return ALGEBRAIC_SUM;
+        if (type == typeid (BoundedDifference)) return BOUNDED_DIFFERENCE;
+        if (type == typeid (BoundedSum)) return BOUNDED_SUM;
+        return CUSTOM;
+    }
+
+    CompiledEngine::IntegralCode CompiledEngine::integralCode(const Defuzzifier* defuzzifier) {
+        //Subclasses may defuzzify otherwise, so only the stock defuzzifiers are replaced
+        if (not defuzzifier) return NOT_INTEGRAL;
+        const std::string name = defuzzifier->className();
+        if (name == "Centroid") return CENTROID;
+        if (name == "Bisector") return BISECTOR;
+        if (name == "MeanOfMaximum") return MEAN_OF_MAXIMUM;
+        if (name == "SmallestOfMaximum") return SMALLEST_OF_MAXIMUM;
+        if (name == "LargestOfMaximum") return LARGEST_OF_MAXIMUM;
+        return NOT_INTEGRAL;
+    }
+
+    CompiledEngine::IntegralCode CompiledEngine::integralCode(const Defuzzifier* defuzzifier, IntegralForm& form) {
+        form = SAMPLED;
+        const IntegralCode code = integralCode(defuzzifier);
+        if (code != NOT_INTEGRAL or not defuzzifier) return code;
+        const std::string name = defuzzifier->className();
+        form = PIECEWISE_LINEAR;
+        if (name == "ExactCentroid") return CENTROID;
+        if (name == "ExactBisector") return BISECTOR;
+        if (name == "ExactMeanOfMaximum") return MEAN_OF_MAXIMUM;
+        if (name == "ExactSmallestOfMaximum") return SMALLEST_OF_MAXIMUM;
+        if (name == "ExactLargestOfMaximum") return LARGEST_OF_MAXIMUM;
+        form = PREFIX_SUM;
+        if (name == "PrefixSumBisector") return BISECTOR;
+        form = SAMPLED;
+        return NOT_INTEGRAL;
+    }
+
+    CompiledEngine::NormPair CompiledEngine::normPair(NormCode conjunctionCode, NormCode disjunctionCode) {
+        if (conjunctionCode == MINIMUM and disjunctionCode == MAXIMUM) return MINIMUM_MAXIMUM;
+        if (conjunctionCode == ALGEBRAIC_PRODUCT and disjunctionCode == ALGEBRAIC_SUM) return ALGEBRAIC_PRODUCT_SUM;
+        if (conjunctionCode == BOUNDED_DIFFERENCE and disjunctionCode == BOUNDED_SUM) return BOUNDED_DIFFERENCE_SUM;
+        return GENERIC;
+    }
+
+    scalar CompiledEngine::compute(NormCode code, const Norm* norm, scalar a, scalar b) {
+        return TypedKernel<scalar>::compute(code, norm, a, b);
+    }
+
+    void CompiledEngine::compute(NormCode code, const Norm* norm, scalar* a, const scalar* b, int size) {
+        TypedKernel<scalar>::compute(code, norm, a, b, size);
+    }
+
+}
@@ -0,0 +1,347 @@
+// EvaluationContext.cpp
+//
+// Purpose: Implementation of fl::EvaluationContext.
+// Detail: Only const methods of the engine, its variables, terms, norms and defuzzifiers are called here.
+// The exceptions are Linear and Function, whose membership reads (and for Function, writes) the state of
+// the engine, so their values are computed from the context instead, including when they are defuzzified
+// by a WeightedDefuzzifier in a Takagi-Sugeno output, or from the matrix of coefficients of the model for
+// its linear outputs. Outputs with a stock integral defuzzifier are sampled through a kernel of the context,
+// those with an Exact one are integrated from pieces of the context, and those with PrefixSumBisector from
+// samples of the context.
+
+#include "fl/EvaluationContext.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/defuzzifier/WeightedDefuzzifier.h"
+#include "fl/defuzzifier/WeightedSum.h"
+#include "fl/norm/SNorm.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Activated.h"
+#include "fl/term/CompiledFunction.h"
+#include "fl/term/Function.h"
+#include "fl/term/Linear.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <algorithm>
+
+namespace fl {
+
+    static bool isEngineDependent(const Term* term) {
+        return dynamic_cast<const Linear*> (term) or dynamic_cast<const Function*> (term);
+    }
+
+    EvaluationContext::EvaluationContext(const CompiledEngine* model) : _model(model), _evaluated(false) {
+        if (not model or not model->isCompiled()) {
+            throw fl::Exception("[evaluation context error] the context needs a compiled engine", FL_AT);
+        }
+        const Engine* engine = model->getEngine();
+        _inputValues.resize(engine->numberOfInputVariables(), fl::nan);
+        _outputValues.resize(engine->numberOfOutputVariables(), fl::nan);
+        _previousOutputValues.resize(engine->numberOfOutputVariables(), fl::nan);
+        _lastInputValues.resize(engine->numberOfInputVariables(), fl::nan);
+        _lastInputEnabled.resize(engine->numberOfInputVariables(), true);
+        _piecewiseLinears.resize(engine->numberOfOutputVariables());
+        _sampledAreas.resize(engine->numberOfOutputVariables());
+
+        for (int i = 0; i < engine->numberOfOutputVariables(); ++i) {
+            const OutputVariable* outputVariable = engine->getOutputVariable(i);
+            const Accumulated* fuzzyOutput = outputVariable->fuzzyOutput();
+            Accumulated* contextOutput = new Accumulated(fuzzyOutput->getName(),
+                    fuzzyOutput->getMinimum(), fuzzyOutput->getMaximum());
+            if (fuzzyOutput->getAccumulation()) {
+                contextOutput->setAccumulation(fuzzyOutput->getAccumulation()->clone());
+            }
+            contextOutput->terms().reserve(model->numberOfConclusions(i));
+            _fuzzyOutputs.push_back(contextOutput);
+
+            bool engineDependent = false;
+            for (int t = 0; t < outputVariable->numberOfTerms() and not engineDependent; ++t) {
+                engineDependent = isEngineDependent(outputVariable->getTerm(t));
+            }
+            if (engineDependent and not dynamic_cast<const WeightedDefuzzifier*> (outputVariable->getDefuzzifier())) {
+                for (std::size_t o = 0; o < _fuzzyOutputs.size(); ++o) delete _fuzzyOutputs.at(o);
+                throw fl::Exception("[evaluation context error] output variable <" + outputVariable->getName()
+                        + "> has terms that depend on the engine and can only be defuzzified "
+                        "in a context by a weighted defuzzifier", FL_AT);
+            }
+            _engineDependentOutputs.push_back(engineDependent);
+        }
+
+        const std::vector<CompiledEngine::Slot>& slots = model->slots();
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            _engineDependentSlots.push_back(slots.at(i).term and isEngineDependent(slots.at(i).term));
+        }
+        int numberOfConclusions = 0;
+        for (int i = 0; i < engine->numberOfOutputVariables(); ++i) {
+            numberOfConclusions += model->numberOfConclusions(i);
+        }
+        _pool.reserve(numberOfConclusions);
+        _slotValues = model->constantSlotValues();
+        _stack.resize(model->stackSize());
+        _activeRules.resize(std::max(model->numberOfRules(), 1));
+        _linearDegrees.resize(model->maximumLinearRows());
+    }
+
+    EvaluationContext::~EvaluationContext() {
+        for (std::size_t i = 0; i < _fuzzyOutputs.size(); ++i) {
+            delete _fuzzyOutputs.at(i);
+        }
+    }
+
+    const CompiledEngine* EvaluationContext::getModel() const {
+        return _model;
+    }
+
+    void EvaluationContext::setInputValue(int inputIndex, scalar value) {
+        _inputValues.at(inputIndex) = value;
+    }
+
+    void EvaluationContext::setInputValue(const std::string& name, scalar value) {
+        const Engine* engine = _model->getEngine();
+        for (int i = 0; i < engine->numberOfInputVariables(); ++i) {
+            if (engine->getInputVariable(i)->getName() == name) {
+                _inputValues.at(i) = value;
+                return;
+            }
+        }
+        throw fl::Exception("[evaluation context error] input variable <" + name + "> not found", FL_AT);
+    }
+
+    scalar EvaluationContext::getInputValue(int inputIndex) const {
+        return _inputValues.at(inputIndex);
+    }
+
+    scalar EvaluationContext::getOutputValue(int outputIndex) const {
+        return _outputValues.at(outputIndex);
+    }
+
+    scalar EvaluationContext::getOutputValue(const std::string& name) const {
+        const Engine* engine = _model->getEngine();
+        for (int i = 0; i < engine->numberOfOutputVariables(); ++i) {
+            if (engine->getOutputVariable(i)->getName() == name) {
+                return _outputValues.at(i);
+            }
+        }
+        throw fl::Exception("[evaluation context error] output variable <" + name + "> not found", FL_AT);
+    }
+
+    scalar EvaluationContext::getPreviousOutputValue(int outputIndex) const {
+        return _previousOutputValues.at(outputIndex);
+    }
+
+    const Accumulated* EvaluationContext::fuzzyOutput(int outputIndex) const {
+        return _fuzzyOutputs.at(outputIndex);
+    }
+
+    const SampledArea& EvaluationContext::sampledOutput(int outputIndex) const {
+        return _sampledAreas.at(outputIndex);
+    }
+
+    int EvaluationContext::numberOfInputs() const {
+        return (int) _inputValues.size();
+    }
+
+    int EvaluationContext::numberOfOutputs() const {
+        return (int) _outputValues.size();
+    }
+
+    scalar EvaluationContext::membership(const Term* term, scalar x) {
+        if (const Linear* linear = dynamic_cast<const Linear*> (term)) {
+            const std::vector<scalar>& coefficients = linear->coefficients();
+            scalar result = 0.0;
+            for (std::size_t i = 0; i < _inputValues.size() and i < coefficients.size(); ++i) {
+                result += coefficients[i] * _inputValues[i];
+            }
+            if (coefficients.size() > _inputValues.size()) {
+                result += coefficients.back();
+            }
+            return result;
+        }
+        const CompiledFunction* compiled = dynamic_cast<const CompiledFunction*> (term);
+        if (compiled and compiled->isCompiled()) {
+            if ((int) _functionStack.size() < compiled->stackSize()) {
+                _functionStack.resize(compiled->stackSize());
+            }
+            const scalar* inputValues = fl::null;
+            if (not _inputValues.empty()) inputValues = &_inputValues[0];
+            const scalar* outputValues = fl::null;
+            if (not _outputValues.empty()) outputValues = &_outputValues[0];
+            return compiled->evaluate(x, inputValues, outputValues, &_functionStack[0]);
+        }
+        if (const Function* function = dynamic_cast<const Function*> (term)) {
+            const Engine* engine = _model->getEngine();
+            for (std::size_t i = 0; i < _inputValues.size(); ++i) {
+                _functionVariables[engine->getInputVariable(i)->getName()] = _inputValues[i];
+            }
+            for (std::size_t i = 0; i < _outputValues.size(); ++i) {
+                _functionVariables[engine->getOutputVariable(i)->getName()] = _outputValues[i];
+            }
+            _functionVariables["x"] = x;
+            return function->evaluate(&_functionVariables);
+        }
+        return term->membership(x);
+    }
+
+    void EvaluationContext::process() {
+        const Engine* engine = _model->getEngine();
+        const std::vector<CompiledEngine::Slot>& slots = _model->slots();
+        const std::vector<int>& inputSlots = _model->inputSlots();
+        const std::vector<int>& inputSlotOffsets = _model->inputSlotOffsets();
+        const bool memoize = _model->isMemoized() and _model->isMemoizable() and _evaluated;
+        bool changed = not memoize;
+        for (std::size_t v = 0; v < _inputValues.size(); ++v) {
+            const scalar x = _inputValues[v];
+            const bool enabled = engine->getInputVariable(v)->isEnabled();
+            if (memoize and enabled == _lastInputEnabled[v]
+                    and CompiledEngine::isUnchanged(x, _lastInputValues[v], _model->getInputTolerance())) {
+                continue;
+            }
+            changed = true;
+            _lastInputValues[v] = x;
+            _lastInputEnabled[v] = enabled;
+            for (int i = inputSlotOffsets[v]; i < inputSlotOffsets[v + 1]; ++i) {
+                const int index = inputSlots[i];
+                const CompiledEngine::Slot& slot = slots[index];
+                if (not _engineDependentSlots[index]) {
+                    _slotValues[index] = _model->fuzzify(slot, x);
+                } else if (slot.variable->isEnabled()) {
+                    _slotValues[index] = _model->applyHedges(slot.firstHedge, slot.numberOfHedges,
+                            membership(slot.term, x));
+                } else {
+                    _slotValues[index] = 0.0;
+                }
+            }
+        }
+        if (not changed) {
+            //Same as OutputVariable::defuzzify() on the fuzzy outputs of the same inputs
+            for (std::size_t i = 0; i < _outputValues.size(); ++i) {
+                if (Op::isFinite(_outputValues[i])) _previousOutputValues[i] = _outputValues[i];
+            }
+            return;
+        }
+
+        for (std::size_t i = 0; i < _fuzzyOutputs.size(); ++i) {
+            _pool.recycle(_fuzzyOutputs[i]);
+        }
+
+        const std::vector<CompiledEngine::CompiledBlock>& blocks = _model->blocks();
+        const int numberOfActiveRules = _model->activeRules(&_slotValues[0], &_activeRules[0]);
+        int active = 0;
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            active = _model->fire(blocks[b], &_activeRules[0], active, numberOfActiveRules,
+                    &_slotValues[0], &_stack[0], _fuzzyOutputs, _pool);
+        }
+
+        //Same as OutputVariable::defuzzify()
+        for (std::size_t i = 0; i < _outputValues.size(); ++i) {
+            const OutputVariable* outputVariable = engine->getOutputVariable(i);
+            if (Op::isFinite(_outputValues[i])) {
+                _previousOutputValues[i] = _outputValues[i];
+            }
+            scalar result;
+            if (outputVariable->isEnabled() and not _fuzzyOutputs[i]->isEmpty()) {
+                if (not outputVariable->getDefuzzifier()) {
+                    throw fl::Exception("[defuzzifier error] defuzzifier needed "
+                            "to defuzzify output variable <" + outputVariable->getName() + ">", FL_AT);
+                }
+                result = defuzzify(i);
+            } else if (outputVariable->isLockedPreviousOutputValue()
+                    and not Op::isNaN(_previousOutputValues[i])) {
+                result = _previousOutputValues[i];
+            } else {
+                result = outputVariable->getDefaultValue();
+            }
+            if (outputVariable->isLockedOutputValueInRange()) {
+                result = Op::bound(result, outputVariable->getMinimum(), outputVariable->getMaximum());
+            }
+            _outputValues[i] = result;
+        }
+        _evaluated = true;
+    }
+
+    scalar EvaluationContext::defuzzify(int outputIndex) {
+        const int linear = _model->linearOutputIndex(outputIndex);
+        if (linear >= 0) {
+            return _model->defuzzifyLinear(_model->linearOutputs()[linear], _fuzzyOutputs[outputIndex],
+                    &_inputValues[0], &_linearDegrees[0]);
+        }
+        if (_engineDependentOutputs[outputIndex]) {
+            return defuzzifyWeighted(outputIndex);
+        }
+        if (_model->integralOutputCode(outputIndex) != CompiledEngine::NOT_INTEGRAL) {
+            _fuzzyOutputKernel.set(_fuzzyOutputs[outputIndex]);
+            return _model->defuzzifyIntegral(outputIndex, _fuzzyOutputKernel,
+                    _piecewiseLinears[outputIndex], _sampledAreas[outputIndex]);
+        }
+        const OutputVariable* outputVariable = _model->getEngine()->getOutputVariable(outputIndex);
+        return outputVariable->getDefuzzifier()->defuzzify(_fuzzyOutputs[outputIndex],
+                outputVariable->getMinimum(), outputVariable->getMaximum());
+    }
+
+    scalar EvaluationContext::defuzzifyWeighted(int outputIndex) {
+        //Same as WeightedAverage::defuzzify() and WeightedSum::defuzzify(), with membership() from the context
+        const OutputVariable* outputVariable = _model->getEngine()->getOutputVariable(outputIndex);
+        const WeightedDefuzzifier* defuzzifier =
+                static_cast<const WeightedDefuzzifier*> (outputVariable->getDefuzzifier());
+        const bool isSum = dynamic_cast<const WeightedSum*> (defuzzifier) != fl::null;
+        const Accumulated* fuzzyOutput = _fuzzyOutputs[outputIndex];
+        const scalar minimum = fuzzyOutput->getMinimum();
+        const scalar maximum = fuzzyOutput->getMaximum();
+
+        std::vector<const Term*> terms;
+        std::vector<scalar> degrees;
+        if (not fuzzyOutput->getAccumulation()) {
+            for (int i = 0; i < fuzzyOutput->numberOfTerms(); ++i) {
+                terms.push_back(fuzzyOutput->getTerm(i)->getTerm());
+                degrees.push_back(fuzzyOutput->getTerm(i)->getDegree());
+            }
+        } else {
+            typedef std::map<const Term*, scalar> TermGroup;
+            TermGroup groups;
+            for (int i = 0; i < fuzzyOutput->numberOfTerms(); ++i) {
+                const Activated* activated = fuzzyOutput->getTerm(i);
+                scalar& degree = groups.insert(TermGroup::value_type(activated->getTerm(), 0.0)).first->second;
+                degree = fuzzyOutput->getAccumulation()->compute(degree, activated->getDegree());
+            }
+            for (TermGroup::const_iterator it = groups.begin(); it != groups.end(); ++it) {
+                terms.push_back(it->first);
+                degrees.push_back(it->second);
+            }
+        }
+
+        WeightedDefuzzifier::Type type = defuzzifier->getType();
+        scalar sum = 0.0, weights = 0.0;
+        for (std::size_t i = 0; i < terms.size(); ++i) {
+            const scalar w = degrees[i];
+            if (type == WeightedDefuzzifier::Automatic) type = defuzzifier->inferType(terms[i]);
+            const scalar z = (type == WeightedDefuzzifier::TakagiSugeno or isEngineDependent(terms[i]))
+                    ? membership(terms[i], w)
+                    : defuzzifier->tsukamoto(terms[i], w, minimum, maximum);
+            sum += w * z;
+            weights += w;
+        }
+        return isSum ? sum : sum / weights;
+    }
+
+    void EvaluationContext::restart() {
+        for (std::size_t i = 0; i < _fuzzyOutputs.size(); ++i) {
+            _pool.recycle(_fuzzyOutputs[i]);
+        }
+        std::fill(_inputValues.begin(), _inputValues.end(), fl::nan);
+        std::fill(_outputValues.begin(), _outputValues.end(), fl::nan);
+        std::fill(_previousOutputValues.begin(), _previousOutputValues.end(), fl::nan);
+        _evaluated = false;
+    }
+
+    void EvaluationContext::writeOutputValues() {
+        Engine* engine = _model->getEngine();
+        for (std::size_t i = 0; i < _outputValues.size(); ++i) {
+            engine->getOutputVariable(i)->setPreviousOutputValue(_previousOutputValues[i]);
+            engine->getOutputVariable(i)->setOutputValue(_outputValues[i]);
+        }
+    }
+
+}
@@ -0,0 +1,321 @@
+// LookupEngine.cpp
+//
+// Purpose: Implementation of fl::LookupEngine.
+// Detail: The grid is evaluated through CompiledEngine::processBatch, and the table stores the outputs of
+// each grid point next to each other so that a lookup reads them from the same cache lines.
+
+#include "fl/LookupEngine.h"
+
+#include "fl/CompiledEngine.h"
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace fl {
+
+    LookupEngine::LookupEngine(Engine* engine, int resolution) : _engine(fl::null) {
+        setResolution(resolution);
+        if (engine) bake(engine);
+    }
+
+    LookupEngine::~LookupEngine() {
+    }
+
+    void LookupEngine::setResolution(int resolution) {
+        setResolution(std::vector<int>(MaximumNumberOfInputs, resolution));
+    }
+
+    void LookupEngine::setResolution(const std::vector<int>& resolution) {
+        for (std::size_t i = 0; i < resolution.size(); ++i) {
+            if (resolution.at(i) < 2) {
+                std::ostringstream ex;
+                ex << "[lookup engine error] resolution must be at least 2 points per input, "
+                        "but got <" << resolution.at(i) << ">";
+                throw fl::Exception(ex.str(), FL_AT);
+            }
+        }
+        _resolution = resolution;
+    }
+
+    const std::vector<int>& LookupEngine::getResolution() const {
+        return _resolution;
+    }
+
+    void LookupEngine::clear() {
+        _minimum.clear();
+        _step.clear();
+        _cells.clear();
+        _stride.clear();
+        _table.clear();
+        _maximumError.clear();
+        _meanError.clear();
+        _inputs.clear();
+        _outputs.clear();
+    }
+
+    void LookupEngine::bake(Engine* engine) {
+        _engine = engine;
+        bake();
+    }
+
+    void LookupEngine::bake() {
+        clear();
+        if (not _engine) {
+            throw fl::Exception("[lookup engine error] no engine to bake", FL_AT);
+        }
+        const int numberOfInputs = _engine->numberOfInputVariables();
+        if (numberOfInputs < 1 or numberOfInputs > MaximumNumberOfInputs) {
+            std::ostringstream ex;
+            ex << "[lookup engine error] engine <" << _engine->getName() << "> has <" << numberOfInputs
+                    << "> input variables, but a lookup table supports between 1 and <"
+                    << MaximumNumberOfInputs << ">";
+            throw fl::Exception(ex.str(), FL_AT);
+        }
+        if ((int) _resolution.size() < numberOfInputs) {
+            std::ostringstream ex;
+            ex << "[lookup engine error] resolution given for <" << _resolution.size()
+                    << "> inputs, but engine <" << _engine->getName() << "> has <" << numberOfInputs << ">";
+            throw fl::Exception(ex.str(), FL_AT);
+        }
+        for (int i = 0; i < numberOfInputs; ++i) {
+            const InputVariable* inputVariable = _engine->getInputVariable(i);
+            const scalar range = inputVariable->getMaximum() - inputVariable->getMinimum();
+            //A range that is empty or reversed would send every lookup to the first point of the grid
+            if (not Op::isFinite(range) or not (range > 0.0)) {
+                std::ostringstream ex;
+                ex << "[lookup engine error] input variable <" << inputVariable->getName()
+                        << "> has the range [" << Op::str(inputVariable->getMinimum()) << ", "
+                        << Op::str(inputVariable->getMaximum()) << "], but a lookup table needs a finite range "
+                        "whose maximum is greater than its minimum";
+                throw fl::Exception(ex.str(), FL_AT);
+            }
+        }
+
+        std::vector<int> resolution(_resolution.begin(), _resolution.begin() + numberOfInputs);
+        int stride = 1;
+        for (int i = 0; i < numberOfInputs; ++i) {
+            const InputVariable* inputVariable = _engine->getInputVariable(i);
+            _minimum.push_back(inputVariable->getMinimum());
+            _step.push_back((inputVariable->getMaximum() - inputVariable->getMinimum()) / (resolution.at(i) - 1));
+            _cells.push_back(resolution.at(i) - 1);
+            _stride.push_back(stride);
+            stride *= resolution.at(i);
+        }
+        std::vector<scalar> points;
+        evaluateGrid(resolution, 0.0, points, _table);
+
+        _inputs.resize(numberOfInputs);
+        _outputs.resize(_engine->numberOfOutputVariables());
+        measureError();
+    }
+
+    void LookupEngine::evaluateGrid(const std::vector<int>& resolution, scalar offset,
+            std::vector<scalar>& inputs, std::vector<scalar>& outputs) {
+        const int numberOfInputs = (int) resolution.size();
+        const int numberOfOutputs = _engine->numberOfOutputVariables();
+        int numberOfPoints = 1;
+        for (int i = 0; i < numberOfInputs; ++i) numberOfPoints *= resolution.at(i);
+
+        std::vector<std::vector<scalar> > inputColumns(numberOfInputs, std::vector<scalar>(numberOfPoints));
+        for (int i = 0; i < numberOfInputs; ++i) {
+            const InputVariable* inputVariable = _engine->getInputVariable(i);
+            const scalar minimum = inputVariable->getMinimum();
+            const scalar step = (inputVariable->getMaximum() - minimum) / (resolution.at(i) - 1 + 2 * offset);
+            int stride = 1;
+            for (int j = 0; j < i; ++j) stride *= resolution.at(j);
+            for (int p = 0; p < numberOfPoints; ++p) {
+                const int index = (p / stride) % resolution.at(i);
+                inputColumns.at(i).at(p) = minimum + (index + offset) * step;
+            }
+        }
+        std::vector<std::vector<scalar> > outputColumns(numberOfOutputs, std::vector<scalar>(numberOfPoints));
+
+        std::vector<const scalar*> arguments;
+        std::vector<scalar> inputValues;
+        for (int i = 0; i < numberOfInputs; ++i) {
+            arguments.push_back(&inputColumns.at(i).at(0));
+            inputValues.push_back(_engine->getInputVariable(i)->getInputValue());
+        }
+        std::vector<scalar*> results;
+        std::vector<scalar> outputValues, previousOutputValues;
+        std::vector<bool> lockPreviousOutputValues;
+        for (int i = 0; i < numberOfOutputs; ++i) {
+            OutputVariable* outputVariable = _engine->getOutputVariable(i);
+            results.push_back(&outputColumns.at(i).at(0));
+            outputValues.push_back(outputVariable->getOutputValue());
+            previousOutputValues.push_back(outputVariable->getPreviousOutputValue());
+            lockPreviousOutputValues.push_back(outputVariable->isLockedPreviousOutputValue());
+            //Every point must be evaluated on its own, not from the point before it
+            outputVariable->setLockPreviousOutputValue(false);
+        }
+
+        CompiledEngine compiled(_engine);
+        compiled.processBatch(arguments, results, numberOfPoints);
+
+        for (int i = 0; i < numberOfInputs; ++i) {
+            _engine->getInputVariable(i)->setInputValue(inputValues.at(i));
+        }
+        for (int i = 0; i < numberOfOutputs; ++i) {
+            _engine->getOutputVariable(i)->setOutputValue(outputValues.at(i));
+            _engine->getOutputVariable(i)->setPreviousOutputValue(previousOutputValues.at(i));
+            _engine->getOutputVariable(i)->setLockPreviousOutputValue(lockPreviousOutputValues.at(i));
+        }
+
+        inputs.resize(numberOfPoints * numberOfInputs);
+        outputs.resize(numberOfPoints * numberOfOutputs);
+        for (int p = 0; p < numberOfPoints; ++p) {
+            for (int i = 0; i < numberOfInputs; ++i) {
+                inputs[p * numberOfInputs + i] = inputColumns[i][p];
+            }
+            for (int o = 0; o < numberOfOutputs; ++o) {
+                outputs[p * numberOfOutputs + o] = outputColumns[o][p];
+            }
+        }
+    }
+
+    bool LookupEngine::isBaked() const {
+        return _engine and not _table.empty();
+    }
+
+    void LookupEngine::lookup(const scalar* inputs, scalar* outputs) const {
+        const int numberOfInputs = (int) _stride.size();
+        const int numberOfOutputs = (int) _outputs.size();
+        int base = 0;
+        scalar fraction[MaximumNumberOfInputs];
+        for (int i = 0; i < numberOfInputs; ++i) {
+            if (inputs[i] != inputs[i]) {
+                for (int o = 0; o < numberOfOutputs; ++o) outputs[o] = fl::nan;
+                return;
+            }
+            const int last = _cells[i];
+            scalar x = _step[i] > 0.0 ? (inputs[i] - _minimum[i]) / _step[i] : 0.0;
+            if (x < 0.0) x = 0.0;
+            else if (x > last) x = last;
+            int index = (int) x;
+            if (index == last) --index;
+            fraction[i] = x - index;
+            base += index * _stride[i];
+        }
+
+        for (int o = 0; o < numberOfOutputs; ++o) outputs[o] = 0.0;
+        const int corners = 1 << numberOfInputs;
+        for (int corner = 0; corner < corners; ++corner) {
+            scalar weight = 1.0;
+            int offset = base;
+            for (int i = 0; i < numberOfInputs; ++i) {
+                if (corner & (1 << i)) {
+                    weight *= fraction[i];
+                    offset += _stride[i];
+                } else {
+                    weight *= 1.0 - fraction[i];
+                }
+            }
+            //Skipped so that a NaN at an unused corner does not spread into the result
+            if (weight == 0.0) continue;
+            const scalar* values = &_table[offset * numberOfOutputs];
+            for (int o = 0; o < numberOfOutputs; ++o) {
+                outputs[o] += weight * values[o];
+            }
+        }
+    }
+
+    void LookupEngine::process() {
+        if (not isBaked()) {
+            throw fl::Exception("[lookup engine error] engine has not been baked", FL_AT);
+        }
+        const std::vector<InputVariable*>& inputVariables = _engine->inputVariables();
+        for (std::size_t i = 0; i < _inputs.size(); ++i) {
+            _inputs[i] = inputVariables[i]->getInputValue();
+        }
+        lookup(&_inputs[0], &_outputs[0]);
+        const std::vector<OutputVariable*>& outputVariables = _engine->outputVariables();
+        for (std::size_t i = 0; i < _outputs.size(); ++i) {
+            outputVariables[i]->setOutputValue(_outputs[i]);
+        }
+    }
+
+    void LookupEngine::measureError() {
+        //The centres of the cells form a grid of one point less per input
+        measureError(_cells);
+    }
+
+    void LookupEngine::measureError(int resolution) {
+        measureError(std::vector<int>(_stride.size(), resolution));
+    }
+
+    void LookupEngine::measureError(const std::vector<int>& resolution) {
+        if (not isBaked()) {
+            throw fl::Exception("[lookup engine error] engine has not been baked", FL_AT);
+        }
+        if (resolution.size() != _stride.size()) {
+            std::ostringstream ex;
+            ex << "[lookup engine error] expected a resolution for <" << _stride.size()
+                    << "> inputs, but got <" << resolution.size() << ">";
+            throw fl::Exception(ex.str(), FL_AT);
+        }
+        std::vector<scalar> inputs, expected;
+        evaluateGrid(resolution, 0.5, inputs, expected);
+
+        const int numberOfInputs = (int) _stride.size();
+        const int numberOfOutputs = (int) _outputs.size();
+        const int numberOfPoints = (int) (expected.size() / numberOfOutputs);
+        _maximumError.assign(numberOfOutputs, 0.0);
+        _meanError.assign(numberOfOutputs, 0.0);
+        std::vector<scalar> obtained(numberOfOutputs);
+        for (int p = 0; p < numberOfPoints; ++p) {
+            lookup(&inputs[p * numberOfInputs], &obtained[0]);
+            for (int o = 0; o < numberOfOutputs; ++o) {
+                const scalar a = obtained[o], b = expected[p * numberOfOutputs + o];
+                scalar error;
+                if (Op::isNaN(a) or Op::isNaN(b)) {
+                    error = (Op::isNaN(a) and Op::isNaN(b)) ? 0.0 : fl::inf;
+                } else {
+                    error = std::fabs(a - b);
+                }
+                if (error > _maximumError[o]) _maximumError[o] = error;
+                _meanError[o] += error;
+            }
+        }
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            if (numberOfPoints > 0) _meanError[o] /= numberOfPoints;
+        }
+    }
+
+    scalar LookupEngine::getMaximumError(int outputIndex) const {
+        return _maximumError.at(outputIndex);
+    }
+
+    scalar LookupEngine::getMeanError(int outputIndex) const {
+        return _meanError.at(outputIndex);
+    }
+
+    Engine* LookupEngine::getEngine() const {
+        return _engine;
+    }
+
+    int LookupEngine::numberOfPoints() const {
+        return _outputs.empty() ? 0 : (int) (_table.size() / _outputs.size());
+    }
+
+    std::string LookupEngine::toString() const {
+        std::ostringstream ss;
+        ss << "LookupEngine: " << (_engine ? _engine->getName() : "") << "\n";
+        ss << "  points: " << numberOfPoints() << " (";
+        for (std::size_t i = 0; i < _cells.size(); ++i) {
+            ss << (i == 0 ? "" : " x ") << _cells.at(i) + 1;
+        }
+        ss << ")\n";
+        for (std::size_t o = 0; o < _maximumError.size(); ++o) {
+            ss << "  " << _engine->getOutputVariable(o)->getName()
+                    << ": maximum error " << Op::str(_maximumError.at(o))
+                    << ", mean error " << Op::str(_meanError.at(o)) << "\n";
+        }
+        return ss.str();
+    }
+
+}
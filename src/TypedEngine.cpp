@@ -0,0 +1,690 @@
+// TypedEngine.cpp
+//
+// Purpose: Implementation of fl::TypedEngine.
+// Detail: The evaluation mirrors CompiledEngine::process() step by step (fuzzify the input slots, evaluate
+// the rules whose required slots are non-zero, activate the conclusions of those above macheps, defuzzify
+// as OutputVariable::defuzzify() does), with the membership functions, norms and sums of the defuzzifiers of
+// TypedKernel<T>, which CompiledEngine uses in scalar, so a DoubleEngine returns what the engine does and a
+// FloatEngine the same up to the rounding of float. Integral outputs sample each activated term only where
+// it is not zero, when its activation and the accumulation leave the samples outside unchanged. The class
+// is instantiated here for float and double.
+
+#include "fl/TypedEngine.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/defuzzifier/Bisector.h"
+#include "fl/defuzzifier/Centroid.h"
+#include "fl/defuzzifier/LargestOfMaximum.h"
+#include "fl/defuzzifier/MeanOfMaximum.h"
+#include "fl/defuzzifier/SmallestOfMaximum.h"
+#include "fl/defuzzifier/WeightedAverage.h"
+#include "fl/defuzzifier/WeightedSum.h"
+#include "fl/hedge/Hedge.h"
+#include "fl/norm/SNorm.h"
+#include "fl/norm/TNorm.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/CompiledFunction.h"
+#include "fl/term/Linear.h"
+#include "fl/term/Term.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+#include "fl/variable/TermIndex.h"
+
+#include <algorithm>
+
+namespace fl {
+
+    template <typename T>
+    TypedEngine<T>::TypedEngine(const CompiledEngine* model) : _engine(fl::null), _macheps(T(fuzzylite::macheps())),
+    _linearColumns(0) {
+        if (model) compile(model);
+    }
+
+    template <typename T>
+    TypedEngine<T>::~TypedEngine() {
+    }
+
+    template <typename T>
+    void TypedEngine<T>::compile(Engine* engine) {
+        CompiledEngine model(engine);
+        compile(&model);
+    }
+
+    template <typename T>
+    void TypedEngine<T>::compile(const CompiledEngine* model) {
+        _engine = fl::null;
+        _terms.clear();
+        _linearCoefficients.clear();
+        _slots.clear();
+        _hedges.clear();
+        _instructions.clear();
+        _conclusions.clear();
+        _rules.clear();
+        _blocks.clear();
+        _requiredSlots.clear();
+        _outputs.clear();
+        _fuzzyOutputs.clear();
+        _functionStack.clear();
+        if (not model or not model->isCompiled()) {
+            throw fl::Exception("[typed engine error] no compiled engine to convert", FL_AT);
+        }
+        const Engine* engine = model->getEngine();
+        _engine = engine;
+        _macheps = T(model->getMacheps());
+        _linearColumns = engine->numberOfInputVariables() + 1;
+        _hedges = model->hedges();
+        _instructions = model->instructions();
+        _requiredSlots = model->requiredSlots();
+
+        const std::vector<CompiledEngine::Slot>& slots = model->slots();
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            const CompiledEngine::Slot& slot = slots.at(i);
+            TypedSlot typed;
+            typed.variable = slot.variable;
+            typed.variableIndex = slot.variableIndex;
+            typed.input = (slot.variableIndex < engine->numberOfInputVariables()
+                    and engine->getInputVariable(slot.variableIndex) == slot.variable);
+            typed.enabled = slot.variable->isEnabled();
+            typed.constant = slot.constant;
+            typed.term = compileTerm(slot.term);
+            typed.firstHedge = slot.firstHedge;
+            typed.numberOfHedges = slot.numberOfHedges;
+            typed.supportStart = T(slot.supportStart);
+            typed.supportEnd = T(slot.supportEnd);
+            typed.outsideSupport = T(slot.outsideSupport);
+            typed.constantValue = T(model->constantSlotValues().at(i));
+            _slots.push_back(typed);
+        }
+
+        const std::vector<CompiledEngine::CompiledRule>& rules = model->rules();
+        for (std::size_t r = 0; r < rules.size(); ++r) {
+            const CompiledEngine::CompiledRule& rule = rules.at(r);
+            TypedRule typed;
+            typed.firstInstruction = rule.firstInstruction;
+            typed.numberOfInstructions = rule.numberOfInstructions;
+            typed.firstConclusion = rule.firstConclusion;
+            typed.numberOfConclusions = rule.numberOfConclusions;
+            typed.firstRequired = rule.firstRequired;
+            typed.numberOfRequired = rule.numberOfRequired;
+            typed.weight = T(rule.weight);
+            _rules.push_back(typed);
+        }
+
+        const std::vector<CompiledEngine::Conclusion>& conclusions = model->conclusions();
+        _conclusions.resize(conclusions.size());
+        const std::vector<CompiledEngine::CompiledBlock>& blocks = model->blocks();
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            const CompiledEngine::CompiledBlock& block = blocks.at(b);
+            TypedBlock typed;
+            typed.conjunctionCode = block.conjunctionCode;
+            typed.disjunctionCode = block.disjunctionCode;
+            typed.activationCode = CompiledEngine::normCode(block.activation);
+            typed.conjunction = block.conjunction;
+            typed.disjunction = block.disjunction;
+            typed.activation = block.activation;
+            typed.firstRule = block.firstRule;
+            typed.numberOfRules = block.numberOfRules;
+            _blocks.push_back(typed);
+            //The conclusions of a rule are activated with the activation of its block
+            for (int r = block.firstRule; r < block.firstRule + block.numberOfRules; ++r) {
+                const TypedRule& rule = _rules.at(r);
+                for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                    const CompiledEngine::Conclusion& conclusion = conclusions.at(c);
+                    TypedConclusion& converted = _conclusions.at(c);
+                    converted.outputIndex = conclusion.outputIndex;
+                    converted.term = compileTerm(conclusion.term);
+                    converted.firstHedge = conclusion.firstHedge;
+                    converted.numberOfHedges = conclusion.numberOfHedges;
+                    converted.block = (int) b;
+                }
+            }
+        }
+
+        const int numberOfOutputs = engine->numberOfOutputVariables();
+        std::vector<std::vector<int> > conclusionTerms(numberOfOutputs);
+        for (std::size_t c = 0; c < _conclusions.size(); ++c) {
+            conclusionTerms.at(_conclusions.at(c).outputIndex).push_back(_conclusions.at(c).term);
+        }
+        int resolution = 0;
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            compileOutput(o, conclusionTerms.at(o));
+            if (_outputs.back().resolution > resolution) resolution = _outputs.back().resolution;
+        }
+
+        _inputValues.assign(engine->numberOfInputVariables(), T(fl::nan));
+        _outputValues.assign(numberOfOutputs, T(fl::nan));
+        _previousOutputValues.assign(numberOfOutputs, T(fl::nan));
+        _fuzzyOutputs.resize(numberOfOutputs);
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            _fuzzyOutputs.at(o).reserve(model->numberOfConclusions(o));
+        }
+        _functionInputs.assign(engine->numberOfInputVariables(), fl::nan);
+        _functionOutputs.assign(numberOfOutputs, fl::nan);
+        if (_functionStack.empty()) _functionStack.assign(1, fl::nan);
+        _slotValues.assign(_slots.size(), T(fl::nan));
+        _stack.assign(model->stackSize() > 0 ? model->stackSize() : 1, T(fl::nan));
+        _x.assign(resolution, T(0));
+        _y.assign(resolution, T(0));
+        _values.assign(resolution, T(0));
+        _degreeValues.assign(resolution, T(0));
+        _groupIndex.assign(_terms.size(), -1);
+        _groupTerms.clear();
+        _groupTerms.reserve(_terms.size());
+        _groupDegrees.clear();
+        _groupDegrees.reserve(_terms.size());
+    }
+
+    template <typename T>
+    int TypedEngine<T>::compileTerm(const Term* term) {
+        for (std::size_t i = 0; i < _terms.size(); ++i) {
+            if (_terms.at(i).term == term) return (int) i;
+        }
+        const MembershipKernel kernel(term);
+        TypedTerm typed;
+        typed.term = term;
+        typed.function = fl::null;
+        typed.shape = kernel.getShape();
+        typed.height = T(kernel.getHeight());
+        for (int i = 0; i < 4; ++i) {
+            typed.parameters[i] = T(kernel.getParameters()[i]);
+        }
+        typed.linearRow = -1;
+        typed.linearInputs = 0;
+        //Only the shapes evaluated here are known to be exactly zero where Op::isLt(x, start) or
+        //Op::isGt(x, end), the comparisons they use themselves
+        scalar start = -fl::inf, end = fl::inf;
+        switch (typed.shape) {
+            case MembershipKernel::TRIANGLE:
+            case MembershipKernel::TRAPEZOID:
+            case MembershipKernel::RECTANGLE:
+            case MembershipKernel::RAMP:
+            case MembershipKernel::SSHAPE:
+            case MembershipKernel::ZSHAPE:
+            case MembershipKernel::PISHAPE:
+            case MembershipKernel::COSINE:
+                TermIndex::support(term, start, end);
+                break;
+            default:
+                break;
+        }
+        typed.supportStart = T(start);
+        typed.supportEnd = T(end);
+        //Linear terms of other engines read their inputs, so only those of this one become rows
+        const Linear* linear = dynamic_cast<const Linear*> (term);
+        if (linear and linear->getEngine() == _engine) {
+            const std::vector<scalar>& coefficients = linear->coefficients();
+            const int numberOfInputs = _linearColumns - 1;
+            typed.linearRow = (int) (_linearCoefficients.size() / _linearColumns);
+            typed.linearInputs = ((int) coefficients.size() < numberOfInputs)
+                    ? (int) coefficients.size() : numberOfInputs;
+            for (int i = 0; i < numberOfInputs; ++i) {
+                _linearCoefficients.push_back(i < typed.linearInputs ? T(coefficients.at(i)) : T(0));
+            }
+            _linearCoefficients.push_back((int) coefficients.size() > numberOfInputs
+                    ? T(coefficients.back()) : T(0));
+        }
+        //Function terms of the engine read its values, which only a CompiledFunction can be given instead
+        const Function* function = dynamic_cast<const Function*> (term);
+        if (function and function->getEngine() == _engine) {
+            const CompiledFunction* compiled = dynamic_cast<const CompiledFunction*> (function);
+            if (not compiled or not compiled->isCompiled()) {
+                throw fl::Exception("[typed engine error] function term <" + term->getName() + "> reads the "
+                        "values of the engine, which a typed engine does not write; use a loaded CompiledFunction "
+                        "instead", FL_AT);
+            }
+            typed.function = compiled;
+            if (compiled->stackSize() > (int) _functionStack.size()) {
+                _functionStack.resize(compiled->stackSize(), fl::nan);
+            }
+        }
+        _terms.push_back(typed);
+        return (int) _terms.size() - 1;
+    }
+
+    template <typename T>
+    void TypedEngine<T>::compileOutput(int outputIndex, const std::vector<int>& conclusionTerms) {
+        const OutputVariable* variable = _engine->getOutputVariable(outputIndex);
+        TypedOutput output;
+        output.variable = variable;
+        output.enabled = variable->isEnabled();
+        output.integral = CompiledEngine::NOT_INTEGRAL;
+        output.weighted = false;
+        output.average = false;
+        output.resolution = 0;
+        output.minimum = T(variable->getMinimum());
+        output.maximum = T(variable->getMaximum());
+        output.defaultValue = T(variable->getDefaultValue());
+        output.lockPreviousValue = variable->isLockedPreviousOutputValue();
+        output.lockValueInRange = variable->isLockedOutputValueInRange();
+        output.accumulation = variable->fuzzyOutput()->getAccumulation();
+        output.accumulationCode = CompiledEngine::normCode(output.accumulation);
+
+        const Defuzzifier* defuzzifier = variable->getDefuzzifier();
+        if (const IntegralDefuzzifier* integral = dynamic_cast<const IntegralDefuzzifier*> (defuzzifier)) {
+            output.resolution = integral->getResolution();
+            if (dynamic_cast<const Centroid*> (integral)) output.integral = CompiledEngine::CENTROID;
+            else if (dynamic_cast<const Bisector*> (integral)) output.integral = CompiledEngine::BISECTOR;
+            else if (dynamic_cast<const MeanOfMaximum*> (integral)) output.integral = CompiledEngine::MEAN_OF_MAXIMUM;
+            else if (dynamic_cast<const SmallestOfMaximum*> (integral)) output.integral = CompiledEngine::SMALLEST_OF_MAXIMUM;
+            else if (dynamic_cast<const LargestOfMaximum*> (integral)) output.integral = CompiledEngine::LARGEST_OF_MAXIMUM;
+        } else if (const WeightedDefuzzifier* weighted = dynamic_cast<const WeightedDefuzzifier*> (defuzzifier)) {
+            output.average = (dynamic_cast<const WeightedAverage*> (weighted) != fl::null);
+            output.weighted = (output.average or dynamic_cast<const WeightedSum*> (weighted))
+                    and weighted->getType() != WeightedDefuzzifier::Tsukamoto;
+            for (std::size_t i = 0; i < conclusionTerms.size() and output.weighted; ++i) {
+                const TypedTerm& term = _terms.at(conclusionTerms.at(i));
+                output.weighted = (term.shape == MembershipKernel::CONSTANT or term.linearRow >= 0
+                        or term.function);
+            }
+        }
+        if (output.integral == CompiledEngine::NOT_INTEGRAL and not output.weighted) {
+            throw fl::Exception("[typed engine error] output variable <" + variable->getName() + "> "
+                    "is defuzzified by <" + (defuzzifier ? defuzzifier->className() : std::string("none"))
+                    + ">, which cannot be evaluated in a typed engine", FL_AT);
+        }
+        _outputs.push_back(output);
+    }
+
+    template <typename T>
+    bool TypedEngine<T>::isCompiled() const {
+        return _engine != fl::null;
+    }
+
+    template <typename T>
+    void TypedEngine<T>::setInputValue(int inputIndex, T value) {
+        _inputValues.at(inputIndex) = value;
+    }
+
+    template <typename T>
+    T TypedEngine<T>::getInputValue(int inputIndex) const {
+        return _inputValues.at(inputIndex);
+    }
+
+    template <typename T>
+    T TypedEngine<T>::getOutputValue(int outputIndex) const {
+        return _outputValues.at(outputIndex);
+    }
+
+    template <typename T>
+    T TypedEngine<T>::getPreviousOutputValue(int outputIndex) const {
+        return _previousOutputValues.at(outputIndex);
+    }
+
+    template <typename T>
+    int TypedEngine<T>::numberOfInputs() const {
+        return (int) _inputValues.size();
+    }
+
+    template <typename T>
+    int TypedEngine<T>::numberOfOutputs() const {
+        return (int) _outputValues.size();
+    }
+
+    template <typename T>
+    int TypedEngine<T>::numberOfTerms() const {
+        return (int) _terms.size();
+    }
+
+    template <typename T>
+    const Engine* TypedEngine<T>::getEngine() const {
+        return _engine;
+    }
+
+    template <typename T>
+    const std::vector<typename TypedEngine<T>::TypedTerm>& TypedEngine<T>::terms() const {
+        return _terms;
+    }
+
+    template <typename T>
+    void TypedEngine<T>::restart() {
+        std::fill(_inputValues.begin(), _inputValues.end(), T(fl::nan));
+        std::fill(_outputValues.begin(), _outputValues.end(), T(fl::nan));
+        std::fill(_previousOutputValues.begin(), _previousOutputValues.end(), T(fl::nan));
+        for (std::size_t o = 0; o < _fuzzyOutputs.size(); ++o) {
+            _fuzzyOutputs[o].clear();
+        }
+    }
+
+    template <typename T>
+    void TypedEngine<T>::process() {
+        if (not isCompiled()) {
+            throw fl::Exception("[typed engine error] engine has not been compiled", FL_AT);
+        }
+        for (std::size_t i = 0; i < _slots.size(); ++i) {
+            const TypedSlot& slot = _slots[i];
+            if (not slot.input) continue;
+            if (not slot.enabled) {
+                _slotValues[i] = T(0);
+            } else if (slot.constant) {
+                _slotValues[i] = slot.constantValue;
+            } else {
+                const T x = _inputValues[slot.variableIndex];
+                _slotValues[i] = (x < slot.supportStart or x > slot.supportEnd) ? slot.outsideSupport
+                        : applyHedges(slot.firstHedge, slot.numberOfHedges, membership(_terms[slot.term], x));
+            }
+        }
+        for (std::size_t o = 0; o < _fuzzyOutputs.size(); ++o) {
+            _fuzzyOutputs[o].clear();
+        }
+
+        for (std::size_t b = 0; b < _blocks.size(); ++b) {
+            const TypedBlock& block = _blocks[b];
+            for (int r = block.firstRule; r < block.firstRule + block.numberOfRules; ++r) {
+                const TypedRule& rule = _rules[r];
+                //NaN is not zero, since Op::min and Op::max ignore it
+                bool active = true;
+                for (int q = rule.firstRequired; q < rule.firstRequired + rule.numberOfRequired and active; ++q) {
+                    active = _slotValues[_requiredSlots[q]] != T(0);
+                }
+                if (not active) continue;
+                const T degree = rule.weight * evaluate(rule, block);
+                //Same as Op::isGt(degree, 0.0), which is false for NaN
+                if (not (degree >= _macheps)) continue;
+                for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                    const TypedConclusion& conclusion = _conclusions[c];
+                    TypedActivation activation;
+                    activation.term = conclusion.term;
+                    activation.degree = applyHedges(conclusion.firstHedge, conclusion.numberOfHedges, degree);
+                    activation.block = conclusion.block;
+                    _fuzzyOutputs[conclusion.outputIndex].push_back(activation);
+                }
+            }
+        }
+
+        for (std::size_t o = 0; o < _outputs.size(); ++o) {
+            _outputValues[o] = defuzzify((int) o);
+        }
+    }
+
+    template <typename T>
+    void TypedEngine<T>::processBatch(const std::vector<const T*>& inputs,
+            const std::vector<T*>& outputs, int size) {
+        if ((int) inputs.size() != numberOfInputs() or (int) outputs.size() != numberOfOutputs()) {
+            throw fl::Exception("[typed engine error] expected one array per input and output variable", FL_AT);
+        }
+        for (int k = 0; k < size; ++k) {
+            for (std::size_t i = 0; i < inputs.size(); ++i) {
+                _inputValues[i] = inputs[i][k];
+            }
+            process();
+            for (std::size_t o = 0; o < outputs.size(); ++o) {
+                if (outputs[o]) outputs[o][k] = _outputValues[o];
+            }
+        }
+    }
+
+    template <typename T>
+    T TypedEngine<T>::evaluate(const TypedRule& rule, const TypedBlock& block) {
+        T* stack = &_stack[0];
+        int top = -1;
+        const CompiledEngine::Instruction* instruction = &_instructions[rule.firstInstruction];
+        const CompiledEngine::Instruction* end = instruction + rule.numberOfInstructions;
+        for (; instruction != end; ++instruction) {
+            switch (instruction->code) {
+                case CompiledEngine::LOAD_SLOT:
+                    stack[++top] = _slotValues[instruction->operand];
+                    break;
+                case CompiledEngine::LOAD_OUTPUT:
+                    stack[++top] = activationDegree(_slots[instruction->operand]);
+                    break;
+                case CompiledEngine::CONJUNCTION:
+                    --top;
+                    stack[top] = Kernel::compute(block.conjunctionCode, block.conjunction,
+                            stack[top], stack[top + 1]);
+                    break;
+                case CompiledEngine::DISJUNCTION:
+                    --top;
+                    stack[top] = Kernel::compute(block.disjunctionCode, block.disjunction,
+                            stack[top], stack[top + 1]);
+                    break;
+            }
+        }
+        return stack[top];
+    }
+
+    template <typename T>
+    T TypedEngine<T>::activationDegree(const TypedSlot& slot) const {
+        if (not slot.enabled) return T(0);
+        //Same as Accumulated::activationDegree() on the activations so far
+        const TypedOutput& output = _outputs[slot.variableIndex];
+        const std::vector<TypedActivation>& activations = _fuzzyOutputs[slot.variableIndex];
+        T result = T(0);
+        for (std::size_t i = 0; i < activations.size(); ++i) {
+            if (activations[i].term != slot.term) continue;
+            if (output.accumulation) {
+                result = Kernel::compute(output.accumulationCode, output.accumulation,
+                        result, activations[i].degree);
+            } else {
+                result += activations[i].degree;
+            }
+        }
+        return applyHedges(slot.firstHedge, slot.numberOfHedges, result);
+    }
+
+    template <typename T>
+    T TypedEngine<T>::applyHedges(int firstHedge, int numberOfHedges, T x) const {
+        const int lastHedge = firstHedge + numberOfHedges;
+        for (int hedge = firstHedge; hedge < lastHedge; ++hedge) {
+            x = T(_hedges[hedge]->hedge(scalar(x)));
+        }
+        return x;
+    }
+
+    template <typename T>
+    T TypedEngine<T>::defuzzify(int outputIndex) {
+        //Same as OutputVariable::defuzzify()
+        const TypedOutput& output = _outputs[outputIndex];
+        const T outputValue = _outputValues[outputIndex];
+        if (Kernel::isFinite(outputValue)) _previousOutputValues[outputIndex] = outputValue;
+        T result;
+        if (output.enabled and not _fuzzyOutputs[outputIndex].empty()) {
+            result = (output.integral != CompiledEngine::NOT_INTEGRAL)
+                    ? defuzzifyIntegral(outputIndex) : defuzzifyWeighted(outputIndex);
+        } else if (output.lockPreviousValue and _previousOutputValues[outputIndex] == _previousOutputValues[outputIndex]) {
+            result = _previousOutputValues[outputIndex];
+        } else {
+            result = output.defaultValue;
+        }
+        if (output.lockValueInRange) {
+            if (result > output.maximum) result = output.maximum;
+            else if (result < output.minimum) result = output.minimum;
+        }
+        return result;
+    }
+
+    template <typename T>
+    T TypedEngine<T>::defuzzifyIntegral(int outputIndex) {
+        const TypedOutput& output = _outputs[outputIndex];
+        const T minimum = output.minimum, maximum = output.maximum;
+        if (not Kernel::isFinite(T(minimum + maximum))) return T(fl::nan);
+        const std::vector<TypedActivation>& activations = _fuzzyOutputs[outputIndex];
+        if (not output.accumulation) {
+            throw fl::Exception("[accumulation error] accumulation operator needed to accumulate "
+                    "the fuzzy output of <" + output.variable->getName() + ">", FL_AT);
+        }
+
+        //Samples the fuzzy output once, at the points of the stock defuzzifiers, term by term
+        const int resolution = output.resolution;
+        const T dx = (maximum - minimum) / resolution;
+        T* x = &_x[0];
+        T* y = &_y[0];
+        T* values = &_values[0];
+        T* degrees = &_degreeValues[0];
+        for (int i = 0; i < resolution; ++i) {
+            x[i] = minimum + (i + T(0.5)) * dx;
+            y[i] = T(0);
+        }
+        for (std::size_t a = 0; a < activations.size(); ++a) {
+            const TypedBlock& block = _blocks[activations[a].block];
+            const TypedTerm& term = _terms[activations[a].term];
+            if (not block.activation) {
+                throw fl::Exception("[activation error] activation operator needed to activate "
+                        + term.term->toString(), FL_AT);
+            }
+            //Outside its support the term is zero, which these norms leave the fuzzy output unchanged by
+            int first = 0, last = resolution;
+            const T degree = activations[a].degree;
+            if (degree >= T(0) and term.height >= T(0)
+                    and (block.activationCode == CompiledEngine::MINIMUM
+                    or block.activationCode == CompiledEngine::ALGEBRAIC_PRODUCT)
+                    and (output.accumulationCode == CompiledEngine::MAXIMUM
+                    or output.accumulationCode == CompiledEngine::ALGEBRAIC_SUM
+                    or output.accumulationCode == CompiledEngine::BOUNDED_SUM)) {
+                supportSamples(term, minimum, dx, resolution, first, last);
+            }
+            const int size = last - first;
+            membership(term, x + first, values, size);
+            std::fill(degrees, degrees + size, degree);
+            Kernel::compute(block.activationCode, block.activation, values, degrees, size);
+            Kernel::compute(output.accumulationCode, output.accumulation, y + first, values, size);
+        }
+
+        switch (output.integral) {
+            case CompiledEngine::CENTROID:
+            {
+                typename Kernel::CentroidSum sum;
+                sum.add(x, y, resolution);
+                return sum.value();
+            }
+            case CompiledEngine::BISECTOR:
+            {
+                //The cells from the right are the same samples, counted from the other end
+                typename Kernel::BisectorWalk walk(minimum, maximum, _macheps);
+                int counter = resolution, left = 0, right = 0;
+                while (counter-- > 0) {
+                    if (walk.fromLeft()) {
+                        walk.addLeft(x[left], y[left]);
+                        ++left;
+                    } else {
+                        walk.addRight(x[resolution - 1 - right], y[resolution - 1 - right]);
+                        ++right;
+                    }
+                }
+                return walk.value();
+            }
+            case CompiledEngine::MEAN_OF_MAXIMUM:
+            {
+                typename Kernel::MaximumSearch search(minimum, maximum, _macheps);
+                search.mean(x, y, resolution);
+                return search.meanValue();
+            }
+            case CompiledEngine::SMALLEST_OF_MAXIMUM:
+            {
+                typename Kernel::MaximumSearch search(minimum, maximum, _macheps);
+                search.smallest(x, y, resolution);
+                return search.xsmallest;
+            }
+            default:
+            {
+                typename Kernel::MaximumSearch search(minimum, maximum, _macheps);
+                search.largest(x, y, resolution);
+                return search.xlargest;
+            }
+        }
+    }
+
+    template <typename T>
+    void TypedEngine<T>::supportSamples(const TypedTerm& term, T minimum, T dx, int resolution,
+            int& first, int& last) const {
+        //The samples are ascending, so the estimates from their spacing only need a few steps to be exact
+        const T* x = &_x[0];
+        first = 0;
+        last = resolution;
+        if (resolution == 0) return;
+        if (term.supportStart > x[0]) {
+            const T position = (term.supportStart - minimum) / dx - T(0.5);
+            first = (position < T(resolution)) ? (int) position : resolution;
+            while (first > 0 and not Kernel::isLt(x[first - 1], term.supportStart, _macheps)) --first;
+            while (first < resolution and Kernel::isLt(x[first], term.supportStart, _macheps)) ++first;
+        }
+        if (term.supportEnd < x[resolution - 1]) {
+            const T position = (term.supportEnd - minimum) / dx - T(0.5);
+            last = (position < T(0)) ? 0 : (position < T(resolution)) ? (int) position + 1 : resolution;
+            while (last < resolution and not Kernel::isGt(x[last], term.supportEnd, _macheps)) ++last;
+            while (last > 0 and Kernel::isGt(x[last - 1], term.supportEnd, _macheps)) --last;
+        }
+        if (last < first) last = first;
+    }
+
+    template <typename T>
+    T TypedEngine<T>::defuzzifyWeighted(int outputIndex) {
+        const TypedOutput& output = _outputs[outputIndex];
+        const std::vector<TypedActivation>& activations = _fuzzyOutputs[outputIndex];
+        T sum = T(0), weights = T(0);
+        if (not output.accumulation) {
+            for (std::size_t a = 0; a < activations.size(); ++a) {
+                const T w = activations[a].degree;
+                const T z = membership(_terms[activations[a].term], w);
+                sum += w * z;
+                weights += w;
+            }
+        } else {
+            //The activations of each term are accumulated into a single degree before weighting
+            _groupTerms.clear();
+            _groupDegrees.clear();
+            for (std::size_t a = 0; a < activations.size(); ++a) {
+                int& group = _groupIndex[activations[a].term];
+                if (group < 0) {
+                    group = (int) _groupTerms.size();
+                    _groupTerms.push_back(activations[a].term);
+                    _groupDegrees.push_back(T(0));
+                }
+                _groupDegrees[group] = Kernel::compute(output.accumulationCode, output.accumulation,
+                        _groupDegrees[group], activations[a].degree);
+            }
+            for (std::size_t g = 0; g < _groupTerms.size(); ++g) {
+                const T w = _groupDegrees[g];
+                const T z = membership(_terms[_groupTerms[g]], w);
+                sum += w * z;
+                weights += w;
+                _groupIndex[_groupTerms[g]] = -1;
+            }
+        }
+        return output.average ? sum / weights : sum;
+    }
+
+    template <typename T>
+    T TypedEngine<T>::membership(const TypedTerm& term, T x) const {
+        if (term.linearRow >= 0) {
+            //Same order of the sums as Linear::membership(), which ignores x
+            const T* coefficients = &_linearCoefficients[term.linearRow * _linearColumns];
+            T result = T(0);
+            for (int i = 0; i < term.linearInputs; ++i) {
+                result += coefficients[i] * _inputValues[i];
+            }
+            return result + coefficients[_linearColumns - 1];
+        }
+        if (term.function) {
+            //The output values are those defuzzified so far, as the engine reads them while it defuzzifies
+            for (std::size_t i = 0; i < _inputValues.size(); ++i) {
+                _functionInputs[i] = scalar(_inputValues[i]);
+            }
+            for (std::size_t i = 0; i < _outputValues.size(); ++i) {
+                _functionOutputs[i] = scalar(_outputValues[i]);
+            }
+            const scalar* inputValues = fl::null;
+            if (not _functionInputs.empty()) inputValues = &_functionInputs[0];
+            const scalar* outputValues = fl::null;
+            if (not _functionOutputs.empty()) outputValues = &_functionOutputs[0];
+            return T(term.function->evaluate(scalar(x), inputValues, outputValues, &_functionStack[0]));
+        }
+        if (term.shape == MembershipKernel::UNKNOWN) return T(term.term->membership(scalar(x)));
+        return Kernel::membership(term.shape, term.parameters, term.height, x, _macheps);
+    }
+
+    template <typename T>
+    void TypedEngine<T>::membership(const TypedTerm& term, const T* x, T* y, int size) const {
+        if (term.linearRow < 0 and not term.function and term.shape != MembershipKernel::UNKNOWN) {
+            Kernel::membership(term.shape, term.parameters, term.height, x, y, size, _macheps);
+            return;
+        }
+        for (int i = 0; i < size; ++i) {
+            y[i] = membership(term, x[i]);
+        }
+    }
+
+    template class TypedEngine<float>;
+    template class TypedEngine<double>;
+
+}
@@ -0,0 +1,305 @@
+// TypedKernel.cpp
+//
+// Purpose: Implementation of fl::TypedKernel.
+// Detail: Each membership function checks NaN first and then the branches of the term in the same order, with
+// the same operations on the same operands, so TypedKernel<scalar> rounds exactly as the term does. The
+// constants are written T(...) so TypedKernel<float> stays in float. The class is instantiated here for float
+// and double.
+
+#include "fl/TypedKernel.h"
+
+#include "fl/norm/Norm.h"
+
+namespace fl {
+
+    template <typename T>
+    T TypedKernel<T>::compute(CompiledEngine::NormCode code, const Norm* norm, T a, T b) {
+        switch (code) {
+            case CompiledEngine::MINIMUM:
+                return minimum(a, b);
+            case CompiledEngine::MAXIMUM:
+                return maximum(a, b);
+            case CompiledEngine::ALGEBRAIC_PRODUCT:
+                return algebraicProduct(a, b);
+            case CompiledEngine::ALGEBRAIC_SUM:
+                return algebraicSum(a, b);
+            case CompiledEngine::BOUNDED_DIFFERENCE:
+                return boundedDifference(a, b);
+            case CompiledEngine::BOUNDED_SUM:
+                return boundedSum(a, b);
+            default:
+                return T(norm->compute(scalar(a), scalar(b)));
+        }
+    }
+
+    template <typename T>
+    void TypedKernel<T>::compute(CompiledEngine::NormCode code, const Norm* norm, T* a, const T* b, int size) {
+        //One loop per norm so that each one is a straight pass over the samples
+        switch (code) {
+            case CompiledEngine::MINIMUM:
+                for (int k = 0; k < size; ++k) {
+                    if (a[k] != a[k] or b[k] < a[k]) a[k] = b[k];
+                }
+                break;
+            case CompiledEngine::MAXIMUM:
+                for (int k = 0; k < size; ++k) {
+                    if (a[k] != a[k] or b[k] > a[k]) a[k] = b[k];
+                }
+                break;
+            case CompiledEngine::ALGEBRAIC_PRODUCT:
+                for (int k = 0; k < size; ++k) {
+                    a[k] = algebraicProduct(a[k], b[k]);
+                }
+                break;
+            case CompiledEngine::ALGEBRAIC_SUM:
+                for (int k = 0; k < size; ++k) {
+                    a[k] = algebraicSum(a[k], b[k]);
+                }
+                break;
+            case CompiledEngine::BOUNDED_DIFFERENCE:
+                for (int k = 0; k < size; ++k) {
+                    a[k] = boundedDifference(a[k], b[k]);
+                }
+                break;
+            case CompiledEngine::BOUNDED_SUM:
+                for (int k = 0; k < size; ++k) {
+                    a[k] = boundedSum(a[k], b[k]);
+                }
+                break;
+            default:
+                for (int k = 0; k < size; ++k) {
+                    a[k] = T(norm->compute(scalar(a[k]), scalar(b[k])));
+                }
+                break;
+        }
+    }
+
+    template <typename T>
+    T TypedKernel<T>::membership(MembershipKernel::Shape shape, const T* p, T h, T x, T macheps) {
+        switch (shape) {
+            case MembershipKernel::TRIANGLE: return triangle(p, h, x, macheps);
+            case MembershipKernel::TRAPEZOID: return trapezoid(p, h, x, macheps);
+            case MembershipKernel::RECTANGLE: return rectangle(p, h, x, macheps);
+            case MembershipKernel::RAMP: return ramp(p, h, x, macheps);
+            case MembershipKernel::SSHAPE: return sShape(p, h, x, macheps);
+            case MembershipKernel::ZSHAPE: return zShape(p, h, x, macheps);
+            case MembershipKernel::PISHAPE: return piShape(p, h, x, macheps);
+            case MembershipKernel::CONCAVE: return concave(p, h, x, macheps);
+            case MembershipKernel::CONSTANT: return constant(p, h, x, macheps);
+            case MembershipKernel::GAUSSIAN: return gaussian(p, h, x, macheps);
+            case MembershipKernel::GAUSSIAN_PRODUCT: return gaussianProduct(p, h, x, macheps);
+            case MembershipKernel::BELL: return bell(p, h, x, macheps);
+            case MembershipKernel::SIGMOID: return sigmoid(p, h, x, macheps);
+            case MembershipKernel::SIGMOID_DIFFERENCE: return sigmoidDifference(p, h, x, macheps);
+            case MembershipKernel::SIGMOID_PRODUCT: return sigmoidProduct(p, h, x, macheps);
+            case MembershipKernel::SPIKE: return spike(p, h, x, macheps);
+            case MembershipKernel::COSINE: return cosine(p, h, x, macheps);
+            default: return T(fl::nan);
+        }
+    }
+
+    template <typename T>
+    void TypedKernel<T>::membership(MembershipKernel::Shape shape, const T* p, T h,
+            const T* x, T* y, int size, T macheps) {
+        switch (shape) {
+            case MembershipKernel::TRIANGLE: loop<&TypedKernel::triangle>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::TRAPEZOID: loop<&TypedKernel::trapezoid>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::RECTANGLE: loop<&TypedKernel::rectangle>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::RAMP: loop<&TypedKernel::ramp>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::SSHAPE: loop<&TypedKernel::sShape>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::ZSHAPE: loop<&TypedKernel::zShape>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::PISHAPE: loop<&TypedKernel::piShape>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::CONCAVE: loop<&TypedKernel::concave>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::CONSTANT: loop<&TypedKernel::constant>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::GAUSSIAN: loop<&TypedKernel::gaussian>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::GAUSSIAN_PRODUCT:
+                loop<&TypedKernel::gaussianProduct>(p, h, x, y, size, macheps);
+                break;
+            case MembershipKernel::BELL: loop<&TypedKernel::bell>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::SIGMOID: loop<&TypedKernel::sigmoid>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::SIGMOID_DIFFERENCE:
+                loop<&TypedKernel::sigmoidDifference>(p, h, x, y, size, macheps);
+                break;
+            case MembershipKernel::SIGMOID_PRODUCT:
+                loop<&TypedKernel::sigmoidProduct>(p, h, x, y, size, macheps);
+                break;
+            case MembershipKernel::SPIKE: loop<&TypedKernel::spike>(p, h, x, y, size, macheps); break;
+            case MembershipKernel::COSINE: loop<&TypedKernel::cosine>(p, h, x, y, size, macheps); break;
+            default:
+                for (int i = 0; i < size; ++i) {
+                    y[i] = T(fl::nan);
+                }
+        }
+    }
+
+    template <typename T>
+    T TypedKernel<T>::triangle(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        if (isLt(x, p[0], macheps) or isGt(x, p[2], macheps)) return h * T(0);
+        if (isEq(x, p[1], macheps)) return h * T(1);
+        if (isLt(x, p[1], macheps)) return h * (x - p[0]) / (p[1] - p[0]);
+        return h * (p[2] - x) / (p[2] - p[1]);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::trapezoid(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        if (isLt(x, p[0], macheps) or isGt(x, p[3], macheps)) return h * T(0);
+        if (isLt(x, p[1], macheps)) {
+            //Same as Op::min(1.0, ...), which ignores NaN
+            const T rising = (x - p[0]) / (p[1] - p[0]);
+            return h * ((rising != rising or T(1) < rising) ? T(1) : rising);
+        }
+        if (isLE(x, p[2], macheps)) return h * T(1);
+        if (isLt(x, p[3], macheps)) return h * (p[3] - x) / (p[3] - p[2]);
+        return h * T(0);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::rectangle(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        if (isLt(x, p[0], macheps) or isGt(x, p[1], macheps)) return h * T(0);
+        return h * T(1);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::ramp(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        if (isEq(p[0], p[1], macheps)) return h * T(0);
+        if (isLt(p[0], p[1], macheps)) {
+            if (isLE(x, p[0], macheps)) return h * T(0);
+            if (isGE(x, p[1], macheps)) return h * T(1);
+            return h * (x - p[0]) / (p[1] - p[0]);
+        }
+        if (isGE(x, p[0], macheps)) return h * T(0);
+        if (isLE(x, p[1], macheps)) return h * T(1);
+        return h * (p[0] - x) / (p[0] - p[1]);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::sShape(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        const T difference = p[1] - p[0];
+        if (isLE(x, p[0], macheps)) return h * T(0);
+        if (isLE(x, (p[0] + p[1]) / T(2), macheps)) {
+            const T rising = (x - p[0]) / difference;
+            return h * T(2) * (rising * rising);
+        }
+        if (isLt(x, p[1], macheps)) {
+            const T falling = (x - p[1]) / difference;
+            return h * (T(1) - T(2) * (falling * falling));
+        }
+        return h * T(1);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::zShape(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        const T difference = p[1] - p[0];
+        if (isLE(x, p[0], macheps)) return h * T(1);
+        if (isLE(x, (p[0] + p[1]) / T(2), macheps)) {
+            const T rising = (x - p[0]) / difference;
+            return h * (T(1) - T(2) * (rising * rising));
+        }
+        if (isLt(x, p[1], macheps)) {
+            const T falling = (x - p[1]) / difference;
+            return h * T(2) * (falling * falling);
+        }
+        return h * T(0);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::piShape(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        T s, z;
+        const T left = p[1] - p[0], right = p[3] - p[2];
+        if (isLE(x, p[0], macheps)) s = T(0);
+        else if (isLE(x, T(0.5) * (p[0] + p[1]), macheps)) s = T(2) * (((x - p[0]) / left) * ((x - p[0]) / left));
+        else if (isLt(x, p[1], macheps)) s = T(1) - T(2) * (((x - p[1]) / left) * ((x - p[1]) / left));
+        else s = T(1);
+        if (isLE(x, p[2], macheps)) z = T(1);
+        else if (isLE(x, T(0.5) * (p[2] + p[3]), macheps)) z = T(1) - T(2) * (((x - p[2]) / right) * ((x - p[2]) / right));
+        else if (isLt(x, p[3], macheps)) z = T(2) * (((x - p[3]) / right) * ((x - p[3]) / right));
+        else z = T(0);
+        return h * s * z;
+    }
+
+    template <typename T>
+    T TypedKernel<T>::concave(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        if (isLE(p[0], p[1], macheps)) {
+            if (isLt(x, p[1], macheps)) return (h * (p[1] - p[0])) / ((T(2) * p[1] - p[0]) - x);
+            return h * T(1);
+        }
+        if (isGt(x, p[1], macheps)) return (h * (p[0] - p[1])) / ((p[0] - T(2) * p[1]) + x);
+        return h * T(1);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::constant(const T* p, T, T, T) {
+        //Constant ignores its input, including NaN, and its height
+        return p[0];
+    }
+
+    template <typename T>
+    T TypedKernel<T>::gaussian(const T* p, T h, T x, T) {
+        if (x != x) return T(fl::nan);
+        return h * std::exp((-(x - p[0]) * (x - p[0])) / (T(2) * p[1] * p[1]));
+    }
+
+    template <typename T>
+    T TypedKernel<T>::gaussianProduct(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        const bool xLEa = isLE(x, p[0], macheps);
+        const T a = std::exp((-(x - p[0]) * (x - p[0])) / (T(2) * p[1] * p[1])) * xLEa + T(1 - xLEa);
+        const bool xGEb = isGE(x, p[2], macheps);
+        const T b = std::exp((-(x - p[2]) * (x - p[2])) / (T(2) * p[3] * p[3])) * xGEb + T(1 - xGEb);
+        return h * a * b;
+    }
+
+    template <typename T>
+    T TypedKernel<T>::bell(const T* p, T h, T x, T) {
+        if (x != x) return T(fl::nan);
+        return h * (T(1) / (T(1) + std::pow(std::fabs((x - p[0]) / p[1]), T(2) * p[2])));
+    }
+
+    template <typename T>
+    T TypedKernel<T>::sigmoid(const T* p, T h, T x, T) {
+        if (x != x) return T(fl::nan);
+        return h * T(1) / (T(1) + std::exp(-p[1] * (x - p[0])));
+    }
+
+    template <typename T>
+    T TypedKernel<T>::sigmoidDifference(const T* p, T h, T x, T) {
+        if (x != x) return T(fl::nan);
+        const T a = T(1) / (T(1) + std::exp(-p[1] * (x - p[0])));
+        const T b = T(1) / (T(1) + std::exp(-p[2] * (x - p[3])));
+        return h * std::fabs(a - b);
+    }
+
+    template <typename T>
+    T TypedKernel<T>::sigmoidProduct(const T* p, T h, T x, T) {
+        if (x != x) return T(fl::nan);
+        const T a = T(1) / (T(1) + std::exp(-p[1] * (x - p[0])));
+        const T b = T(1) / (T(1) + std::exp(-p[2] * (x - p[3])));
+        return h * a * b;
+    }
+
+    template <typename T>
+    T TypedKernel<T>::spike(const T* p, T h, T x, T) {
+        if (x != x) return T(fl::nan);
+        return h * std::exp(-std::fabs(T(10) / p[1] * (x - p[0])));
+    }
+
+    template <typename T>
+    T TypedKernel<T>::cosine(const T* p, T h, T x, T macheps) {
+        if (x != x) return T(fl::nan);
+        if (isLt(x, p[0] - p[1] / T(2), macheps) or isGt(x, p[0] + p[1] / T(2), macheps)) return h * T(0);
+        const T pi = T(4.0 * std::atan(1.0));
+        return h * T(0.5) * (T(1) + std::cos(T(2) / p[1] * pi * (x - p[0])));
+    }
+
+    template class TypedKernel<float>;
+    template class TypedKernel<double>;
+
+}
@@ -0,0 +1,261 @@
+// AdaptiveArea.cpp
+//
+// Purpose: Implementation of fl::AdaptiveArea.
+// Detail: Jumps in the membership function, such as the edges of a Rectangle, keep their deviation as they
+// are split, so cells narrower than the range times fuzzylite::macheps() are not split any further.
+
+#include "fl/defuzzifier/AdaptiveArea.h"
+
+#include "fl/Operation.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/AccumulatedKernel.h"
+#include "fl/term/Activated.h"
+#include "fl/term/Bell.h"
+#include "fl/term/Cosine.h"
+#include "fl/term/Gaussian.h"
+#include "fl/term/PiShape.h"
+#include "fl/term/Ramp.h"
+#include "fl/term/SShape.h"
+#include "fl/term/Sigmoid.h"
+#include "fl/term/Spike.h"
+#include "fl/term/Trapezoid.h"
+#include "fl/term/Triangle.h"
+#include "fl/term/ZShape.h"
+#include "fl/variable/TermIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace fl {
+
+    struct AreaSample {
+        scalar x, y;
+
+        bool operator<(const AreaSample& other) const {
+            return x < other.x;
+        }
+    };
+
+    /**
+     * A cell between two samples with the sample at its midpoint, ordered by its weighted deviation.
+     */
+    struct AreaCell {
+        AreaSample left, middle, right;
+        scalar deviation;
+
+        bool operator<(const AreaCell& other) const {
+            return deviation < other.deviation;
+        }
+    };
+
+    AdaptiveArea::AdaptiveArea() : PiecewiseLinear(), _evaluations(0), _minimum(fl::nan), _maximum(fl::nan) {
+    }
+
+    AdaptiveArea::~AdaptiveArea() {
+    }
+
+    int AdaptiveArea::initialCells() {
+        return 4;
+    }
+
+    void AdaptiveArea::addBreakpoints(const Term* term, scalar minimum, scalar maximum,
+            std::vector<scalar>& breakpoints) const {
+        if (const Accumulated* accumulated = dynamic_cast<const Accumulated*> (term)) {
+            for (int i = 0; i < accumulated->numberOfTerms(); ++i) {
+                addBreakpoints(accumulated->getTerm(i), minimum, maximum, breakpoints);
+            }
+            return;
+        }
+        if (const Activated* activated = dynamic_cast<const Activated*> (term)) {
+            addBreakpoints(activated->getTerm(), minimum, maximum, breakpoints);
+            return;
+        }
+        std::vector<scalar> points;
+        scalar start, end;
+        TermIndex::support(term, start, end);
+        points.push_back(start);
+        points.push_back(end);
+        if (const Triangle* triangle = dynamic_cast<const Triangle*> (term)) {
+            points.push_back(triangle->getVertexB());
+        } else if (const Trapezoid* trapezoid = dynamic_cast<const Trapezoid*> (term)) {
+            points.push_back(trapezoid->getVertexB());
+            points.push_back(trapezoid->getVertexC());
+        } else if (const Ramp* ramp = dynamic_cast<const Ramp*> (term)) {
+            points.push_back(ramp->getStart());
+            points.push_back(ramp->getEnd());
+        } else if (const PiShape* piShape = dynamic_cast<const PiShape*> (term)) {
+            points.push_back(piShape->getTopLeft());
+            points.push_back(piShape->getTopRight());
+        } else if (const SShape* sShape = dynamic_cast<const SShape*> (term)) {
+            points.push_back(sShape->getEnd());
+        } else if (const ZShape* zShape = dynamic_cast<const ZShape*> (term)) {
+            points.push_back(zShape->getStart());
+        } else if (const Gaussian* gaussian = dynamic_cast<const Gaussian*> (term)) {
+            points.push_back(gaussian->getMean());
+        } else if (const Bell* bell = dynamic_cast<const Bell*> (term)) {
+            points.push_back(bell->getCenter());
+        } else if (const Spike* spike = dynamic_cast<const Spike*> (term)) {
+            points.push_back(spike->getCenter());
+        } else if (const Cosine* cosine = dynamic_cast<const Cosine*> (term)) {
+            points.push_back(cosine->getCenter());
+        } else if (const Sigmoid* sigmoid = dynamic_cast<const Sigmoid*> (term)) {
+            points.push_back(sigmoid->getInflection());
+        }
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (points[i] > minimum and points[i] < maximum) breakpoints.push_back(points[i]);
+        }
+    }
+
+    bool AdaptiveArea::build(const Term* term, scalar minimum, scalar maximum,
+            scalar tolerance, int maximumEvaluations) {
+        clear();
+        if (not Op::isFinite(minimum + maximum) or not (maximum > minimum)) return false;
+        const scalar range = maximum - minimum;
+        const scalar narrowest = range * fuzzylite::macheps();
+
+        std::vector<scalar> breakpoints;
+        for (int i = 0; i <= initialCells(); ++i) {
+            breakpoints.push_back(minimum + i * range / initialCells());
+        }
+        addBreakpoints(term, minimum, maximum, breakpoints);
+        std::sort(breakpoints.begin(), breakpoints.end());
+
+        //The breakpoints and the middles of the cells between them are each evaluated in a single call
+        const AccumulatedKernel kernel(term);
+        std::vector<scalar> x, y;
+        for (std::size_t i = 0; i < breakpoints.size(); ++i) {
+            if (not x.empty() and breakpoints[i] - x.back() <= narrowest) continue;
+            x.push_back(breakpoints[i]);
+        }
+        //The breakpoints and their middles take 2n - 1 evaluations, so outputs with too many terms keep an
+        //evenly spread subset of their breakpoints, which always includes both ends of the range
+        const std::size_t mostBreakpoints = (std::size_t) std::max(2, (maximumEvaluations + 1) / 2);
+        if (x.size() > mostBreakpoints) {
+            std::vector<scalar> subset(mostBreakpoints);
+            for (std::size_t i = 0; i < mostBreakpoints; ++i) {
+                subset[i] = x[(i * (x.size() - 1) + (mostBreakpoints - 1) / 2) / (mostBreakpoints - 1)];
+            }
+            x.swap(subset);
+        }
+        y.resize(x.size());
+        kernel.membership(&x[0], &y[0], x.size());
+        std::vector<AreaSample> samples(x.size());
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            samples[i].x = x[i];
+            samples[i].y = y[i];
+        }
+        _evaluations = (int) samples.size();
+
+        const std::size_t numberOfBreakpoints = samples.size();
+        x.resize(numberOfBreakpoints - 1);
+        y.resize(numberOfBreakpoints - 1);
+        for (std::size_t i = 0; i + 1 < numberOfBreakpoints; ++i) {
+            x[i] = 0.5 * (samples[i].x + samples[i + 1].x);
+        }
+        kernel.membership(&x[0], &y[0], x.size());
+
+        std::priority_queue<AreaCell> cells;
+        for (std::size_t i = 0; i + 1 < numberOfBreakpoints; ++i) {
+            AreaCell cell;
+            cell.left = samples[i];
+            cell.right = samples[i + 1];
+            cell.middle.x = x[i];
+            cell.middle.y = y[i];
+            ++_evaluations;
+            samples.push_back(cell.middle);
+            cell.deviation = std::fabs(cell.middle.y - 0.5 * (cell.left.y + cell.right.y))
+                    * (cell.right.x - cell.left.x) / range;
+            if (cell.deviation > tolerance and cell.right.x - cell.left.x > narrowest) cells.push(cell);
+        }
+
+        while (not cells.empty() and _evaluations + 2 <= maximumEvaluations) {
+            const AreaCell cell = cells.top();
+            cells.pop();
+            AreaCell halves[2];
+            halves[0].left = cell.left;
+            halves[0].right = cell.middle;
+            halves[1].left = cell.middle;
+            halves[1].right = cell.right;
+            scalar middles[2], values[2];
+            for (int h = 0; h < 2; ++h) {
+                middles[h] = 0.5 * (halves[h].left.x + halves[h].right.x);
+            }
+            kernel.membership(middles, values, 2);
+            for (int h = 0; h < 2; ++h) {
+                AreaCell& half = halves[h];
+                half.middle.x = middles[h];
+                half.middle.y = values[h];
+                ++_evaluations;
+                samples.push_back(half.middle);
+                half.deviation = std::fabs(half.middle.y - 0.5 * (half.left.y + half.right.y))
+                        * (half.right.x - half.left.x) / range;
+                if (half.deviation > tolerance and half.right.x - half.left.x > narrowest) cells.push(half);
+            }
+        }
+
+        std::sort(samples.begin(), samples.end());
+        _minimum = minimum;
+        _maximum = maximum;
+        _x.resize(samples.size());
+        _y.resize(samples.size());
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            _x[i] = samples[i].x;
+            _y[i] = samples[i].y;
+        }
+        buildPieces();
+        return true;
+    }
+
+    void AdaptiveArea::buildPieces() {
+        _pieces.clear();
+        for (std::size_t i = 0; i + 1 < _x.size(); ++i) {
+            Piece piece;
+            piece.start = _x[i];
+            piece.end = _x[i + 1];
+            piece.value = _y[i];
+            piece.slope = (_y[i + 1] - _y[i]) / (piece.end - piece.start);
+            _pieces.push_back(piece);
+        }
+    }
+
+    void AdaptiveArea::refineMaximum(const Term* term, scalar tolerance, int maximumEvaluations) {
+        if (_x.empty()) return;
+        const scalar narrowest = std::max(tolerance, fuzzylite::macheps()) * (_maximum - _minimum);
+        scalar highest = -fl::inf;
+        for (std::size_t i = 0; i < _y.size(); ++i) highest = Op::max(highest, _y[i]);
+        const AccumulatedKernel kernel(term);
+        bool refined = true;
+        while (refined and _evaluations < maximumEvaluations) {
+            refined = false;
+            for (std::size_t i = 0; i + 1 < _x.size() and _evaluations < maximumEvaluations; ++i) {
+                //Cells where the samples leave the highest value contain the end of a plateau or a peak
+                if (Op::isEq(_y[i], highest) == Op::isEq(_y[i + 1], highest)) continue;
+                if (_x[i + 1] - _x[i] <= narrowest) continue;
+                const scalar x = 0.5 * (_x[i] + _x[i + 1]);
+                const scalar y = kernel.membership(x);
+                ++_evaluations;
+                _x.insert(_x.begin() + i + 1, x);
+                _y.insert(_y.begin() + i + 1, y);
+                if (Op::isGt(y, highest)) highest = y;
+                refined = true;
+                ++i;
+            }
+        }
+        buildPieces();
+    }
+
+    void AdaptiveArea::clear() {
+        PiecewiseLinear::clear();
+        _evaluations = 0;
+        _minimum = fl::nan;
+        _maximum = fl::nan;
+        _x.clear();
+        _y.clear();
+    }
+
+    int AdaptiveArea::evaluations() const {
+        return _evaluations;
+    }
+
+}
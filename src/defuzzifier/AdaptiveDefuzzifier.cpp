@@ -0,0 +1,78 @@
+// AdaptiveDefuzzifier.cpp
+//
+// Purpose: Implementation of fl::AdaptiveDefuzzifier.
+
+#include "fl/defuzzifier/AdaptiveDefuzzifier.h"
+
+#include "fl/defuzzifier/AdaptiveArea.h"
+
+namespace fl {
+
+    AdaptiveDefuzzifier::AdaptiveDefuzzifier(Method method, scalar tolerance, int resolution)
+    : IntegralDefuzzifier(resolution), _method(method), _tolerance(tolerance) {
+    }
+
+    AdaptiveDefuzzifier::~AdaptiveDefuzzifier() {
+    }
+
+    scalar AdaptiveDefuzzifier::defaultTolerance() {
+        return 1e-5;
+    }
+
+    std::string AdaptiveDefuzzifier::className() const {
+        return "AdaptiveDefuzzifier";
+    }
+
+    scalar AdaptiveDefuzzifier::defuzzify(const Term* term, scalar minimum, scalar maximum) const {
+        return defuzzify(term, minimum, maximum, fl::null);
+    }
+
+    scalar AdaptiveDefuzzifier::defuzzify(const Term* term, scalar minimum, scalar maximum,
+            int* evaluations) const {
+        AdaptiveArea area;
+        bool built = area.build(term, minimum, maximum, _tolerance, getResolution());
+        if (built and _method != CENTROID and _method != BISECTOR) {
+            area.refineMaximum(term, _tolerance, getResolution());
+        }
+        if (evaluations) *evaluations = area.evaluations();
+        if (not built) return fl::nan;
+        switch (_method) {
+            case CENTROID:
+                return area.centroid();
+            case BISECTOR:
+                return area.bisector();
+            case MEAN_OF_MAXIMUM:
+                return area.meanOfMaximum();
+            case SMALLEST_OF_MAXIMUM:
+                return area.smallestOfMaximum();
+            case LARGEST_OF_MAXIMUM:
+                return area.largestOfMaximum();
+        }
+        return fl::nan;
+    }
+
+    void AdaptiveDefuzzifier::setMethod(Method method) {
+        _method = method;
+    }
+
+    AdaptiveDefuzzifier::Method AdaptiveDefuzzifier::getMethod() const {
+        return _method;
+    }
+
+    void AdaptiveDefuzzifier::setTolerance(scalar tolerance) {
+        _tolerance = tolerance;
+    }
+
+    scalar AdaptiveDefuzzifier::getTolerance() const {
+        return _tolerance;
+    }
+
+    AdaptiveDefuzzifier* AdaptiveDefuzzifier::clone() const {
+        return new AdaptiveDefuzzifier(*this);
+    }
+
+    Defuzzifier* AdaptiveDefuzzifier::constructor() {
+        return new AdaptiveDefuzzifier;
+    }
+
+}
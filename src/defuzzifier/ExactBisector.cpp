@@ -0,0 +1,44 @@
+// ExactBisector.cpp
+//
+// Purpose: Implementation of fl::ExactBisector.
+
+#include "fl/defuzzifier/ExactBisector.h"
+
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/term/AccumulatedKernel.h"
+
+namespace fl {
+
+    ExactBisector::ExactBisector(int resolution)
+    : Bisector(resolution) {
+    }
+
+    ExactBisector::~ExactBisector() {
+    }
+
+    std::string ExactBisector::className() const {
+        return "ExactBisector";
+    }
+
+    scalar ExactBisector::defuzzify(const Term* term, scalar minimum, scalar maximum) const {
+        PiecewiseLinear piecewiseLinear;
+        return defuzzify(term, minimum, maximum, piecewiseLinear);
+    }
+
+    scalar ExactBisector::defuzzify(const Term* term, scalar minimum, scalar maximum,
+            PiecewiseLinear& piecewiseLinear) const {
+        if (piecewiseLinear.build(term, minimum, maximum)) {
+            return piecewiseLinear.bisector();
+        }
+        return AccumulatedKernel(term).bisector(minimum, maximum, getResolution());
+    }
+
+    ExactBisector* ExactBisector::clone() const {
+        return new ExactBisector(*this);
+    }
+
+    Defuzzifier* ExactBisector::constructor() {
+        return new ExactBisector;
+    }
+
+}
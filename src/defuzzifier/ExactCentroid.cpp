@@ -0,0 +1,44 @@
+// ExactCentroid.cpp
+//
+// Purpose: Implementation of fl::ExactCentroid.
+
+#include "fl/defuzzifier/ExactCentroid.h"
+
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/term/AccumulatedKernel.h"
+
+namespace fl {
+
+    ExactCentroid::ExactCentroid(int resolution)
+    : Centroid(resolution) {
+    }
+
+    ExactCentroid::~ExactCentroid() {
+    }
+
+    std::string ExactCentroid::className() const {
+        return "ExactCentroid";
+    }
+
+    scalar ExactCentroid::defuzzify(const Term* term, scalar minimum, scalar maximum) const {
+        PiecewiseLinear piecewiseLinear;
+        return defuzzify(term, minimum, maximum, piecewiseLinear);
+    }
+
+    scalar ExactCentroid::defuzzify(const Term* term, scalar minimum, scalar maximum,
+            PiecewiseLinear& piecewiseLinear) const {
+        if (piecewiseLinear.build(term, minimum, maximum)) {
+            return piecewiseLinear.centroid();
+        }
+        return AccumulatedKernel(term).centroid(minimum, maximum, getResolution());
+    }
+
+    ExactCentroid* ExactCentroid::clone() const {
+        return new ExactCentroid(*this);
+    }
+
+    Defuzzifier* ExactCentroid::constructor() {
+        return new ExactCentroid;
+    }
+
+}
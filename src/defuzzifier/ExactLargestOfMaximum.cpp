@@ -0,0 +1,44 @@
+// ExactLargestOfMaximum.cpp
+//
+// Purpose: Implementation of fl::ExactLargestOfMaximum.
+
+#include "fl/defuzzifier/ExactLargestOfMaximum.h"
+
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/term/AccumulatedKernel.h"
+
+namespace fl {
+
+    ExactLargestOfMaximum::ExactLargestOfMaximum(int resolution)
+    : LargestOfMaximum(resolution) {
+    }
+
+    ExactLargestOfMaximum::~ExactLargestOfMaximum() {
+    }
+
+    std::string ExactLargestOfMaximum::className() const {
+        return "ExactLargestOfMaximum";
+    }
+
+    scalar ExactLargestOfMaximum::defuzzify(const Term* term, scalar minimum, scalar maximum) const {
+        PiecewiseLinear piecewiseLinear;
+        return defuzzify(term, minimum, maximum, piecewiseLinear);
+    }
+
+    scalar ExactLargestOfMaximum::defuzzify(const Term* term, scalar minimum, scalar maximum,
+            PiecewiseLinear& piecewiseLinear) const {
+        if (piecewiseLinear.build(term, minimum, maximum)) {
+            return piecewiseLinear.largestOfMaximum();
+        }
+        return AccumulatedKernel(term).largestOfMaximum(minimum, maximum, getResolution());
+    }
+
+    ExactLargestOfMaximum* ExactLargestOfMaximum::clone() const {
+        return new ExactLargestOfMaximum(*this);
+    }
+
+    Defuzzifier* ExactLargestOfMaximum::constructor() {
+        return new ExactLargestOfMaximum;
+    }
+
+}
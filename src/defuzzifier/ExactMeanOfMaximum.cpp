@@ -0,0 +1,44 @@
+// ExactMeanOfMaximum.cpp
+//
+// Purpose: Implementation of fl::ExactMeanOfMaximum.
+
+#include "fl/defuzzifier/ExactMeanOfMaximum.h"
+
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/term/AccumulatedKernel.h"
+
+namespace fl {
+
+    ExactMeanOfMaximum::ExactMeanOfMaximum(int resolution)
+    : MeanOfMaximum(resolution) {
+    }
+
+    ExactMeanOfMaximum::~ExactMeanOfMaximum() {
+    }
+
+    std::string ExactMeanOfMaximum::className() const {
+        return "ExactMeanOfMaximum";
+    }
+
+    scalar ExactMeanOfMaximum::defuzzify(const Term* term, scalar minimum, scalar maximum) const {
+        PiecewiseLinear piecewiseLinear;
+        return defuzzify(term, minimum, maximum, piecewiseLinear);
+    }
+
+    scalar ExactMeanOfMaximum::defuzzify(const Term* term, scalar minimum, scalar maximum,
+            PiecewiseLinear& piecewiseLinear) const {
+        if (piecewiseLinear.build(term, minimum, maximum)) {
+            return piecewiseLinear.meanOfMaximum();
+        }
+        return AccumulatedKernel(term).meanOfMaximum(minimum, maximum, getResolution());
+    }
+
+    ExactMeanOfMaximum* ExactMeanOfMaximum::clone() const {
+        return new ExactMeanOfMaximum(*this);
+    }
+
+    Defuzzifier* ExactMeanOfMaximum::constructor() {
+        return new ExactMeanOfMaximum;
+    }
+
+}
@@ -0,0 +1,44 @@
+// ExactSmallestOfMaximum.cpp
+//
+// Purpose: Implementation of fl::ExactSmallestOfMaximum.
+
+#include "fl/defuzzifier/ExactSmallestOfMaximum.h"
+
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/term/AccumulatedKernel.h"
+
+namespace fl {
+
+    ExactSmallestOfMaximum::ExactSmallestOfMaximum(int resolution)
+    : SmallestOfMaximum(resolution) {
+    }
+
+    ExactSmallestOfMaximum::~ExactSmallestOfMaximum() {
+    }
+
+    std::string ExactSmallestOfMaximum::className() const {
+        return "ExactSmallestOfMaximum";
+    }
+
+    scalar ExactSmallestOfMaximum::defuzzify(const Term* term, scalar minimum, scalar maximum) const {
+        PiecewiseLinear piecewiseLinear;
+        return defuzzify(term, minimum, maximum, piecewiseLinear);
+    }
+
+    scalar ExactSmallestOfMaximum::defuzzify(const Term* term, scalar minimum, scalar maximum,
+            PiecewiseLinear& piecewiseLinear) const {
+        if (piecewiseLinear.build(term, minimum, maximum)) {
+            return piecewiseLinear.smallestOfMaximum();
+        }
+        return AccumulatedKernel(term).smallestOfMaximum(minimum, maximum, getResolution());
+    }
+
+    ExactSmallestOfMaximum* ExactSmallestOfMaximum::clone() const {
+        return new ExactSmallestOfMaximum(*this);
+    }
+
+    Defuzzifier* ExactSmallestOfMaximum::constructor() {
+        return new ExactSmallestOfMaximum;
+    }
+
+}
@@ -0,0 +1,360 @@
+// PiecewiseLinear.cpp
+//
+// Purpose: Implementation of fl::PiecewiseLinear.
+// Detail: Each term is read once into the polyline through its vertices, so within an interval between
+// consecutive breakpoints the line of every activated term follows from its vertices and activation degree
+// without calling its membership function. Terms whose support does not overlap an interval are skipped.
+// The polylines, breakpoints and lines are kept in the object, so building again reuses their storage.
+
+#include "fl/defuzzifier/PiecewiseLinear.h"
+
+#include "fl/Operation.h"
+#include "fl/norm/s/Maximum.h"
+#include "fl/norm/t/AlgebraicProduct.h"
+#include "fl/norm/t/Minimum.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Activated.h"
+#include "fl/term/Ramp.h"
+#include "fl/term/Rectangle.h"
+#include "fl/term/Trapezoid.h"
+#include "fl/term/Triangle.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fl {
+
+    PiecewiseLinear::PiecewiseLinear() {
+    }
+
+    PiecewiseLinear::~PiecewiseLinear() {
+    }
+
+    bool PiecewiseLinear::isPiecewiseLinear(const Term* term) {
+        return dynamic_cast<const Triangle*> (term) or dynamic_cast<const Trapezoid*> (term)
+                or dynamic_cast<const Rectangle*> (term) or dynamic_cast<const Ramp*> (term);
+    }
+
+    bool PiecewiseLinear::isApplicable(const Term* term) {
+        const Accumulated* fuzzyOutput = dynamic_cast<const Accumulated*> (term);
+        if (not fuzzyOutput or not dynamic_cast<const Maximum*> (fuzzyOutput->getAccumulation())) {
+            return false;
+        }
+        for (int i = 0; i < fuzzyOutput->numberOfTerms(); ++i) {
+            const Activated* activated = fuzzyOutput->getTerm(i);
+            const TNorm* activation = activated->getActivation();
+            if (not (dynamic_cast<const Minimum*> (activation) or dynamic_cast<const AlgebraicProduct*> (activation))
+                    or Op::isNaN(activated->getDegree()) or not isPiecewiseLinear(activated->getTerm())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PiecewiseLinear::Polyline::set(const Term* term) {
+        size = 0;
+        left = right = 0.0;
+        if (const Triangle* triangle = dynamic_cast<const Triangle*> (term)) {
+            add(triangle->getVertexA(), 0.0);
+            add(triangle->getVertexB(), 1.0);
+            add(triangle->getVertexC(), 0.0);
+        } else if (const Trapezoid* trapezoid = dynamic_cast<const Trapezoid*> (term)) {
+            add(trapezoid->getVertexA(), 0.0);
+            add(trapezoid->getVertexB(), 1.0);
+            add(trapezoid->getVertexC(), 1.0);
+            add(trapezoid->getVertexD(), 0.0);
+        } else if (const Rectangle* rectangle = dynamic_cast<const Rectangle*> (term)) {
+            add(rectangle->getStart(), 1.0);
+            add(rectangle->getEnd(), 1.0);
+        } else if (const Ramp* ramp = dynamic_cast<const Ramp*> (term)) {
+            const scalar start = ramp->getStart(), end = ramp->getEnd();
+            if (start < end) {
+                add(start, 0.0);
+                add(end, 1.0);
+                right = 1.0;
+            } else if (start > end) {
+                add(end, 1.0);
+                add(start, 0.0);
+                left = 1.0;
+            }
+        } else {
+            return false;
+        }
+        const scalar height = term->getHeight();
+        for (int i = 0; i < size; ++i) {
+            y[i] *= height;
+        }
+        left *= height;
+        right *= height;
+        return Op::isFinite(height);
+    }
+
+    void PiecewiseLinear::Polyline::add(scalar vertex, scalar value) {
+        x[size] = vertex;
+        y[size] = value;
+        ++size;
+    }
+
+    scalar PiecewiseLinear::Polyline::supportStart() const {
+        if (size == 0) return fl::inf;
+        return left == 0.0 ? x[0] : -fl::inf;
+    }
+
+    scalar PiecewiseLinear::Polyline::supportEnd() const {
+        if (size == 0) return -fl::inf;
+        return right == 0.0 ? x[size - 1] : fl::inf;
+    }
+
+    void PiecewiseLinear::Polyline::line(scalar point, scalar origin, scalar& value, scalar& slope) const {
+        slope = 0.0;
+        if (size == 0) {
+            value = 0.0;
+            return;
+        }
+        if (point < x[0]) {
+            value = left;
+            return;
+        }
+        for (int i = 0; i + 1 < size; ++i) {
+            if (point <= x[i + 1]) {
+                slope = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+                value = y[i] + slope * (origin - x[i]);
+                return;
+            }
+        }
+        value = right;
+    }
+
+    bool PiecewiseLinear::build(const Term* term, scalar minimum, scalar maximum) {
+        clear();
+        const Accumulated* fuzzyOutput = dynamic_cast<const Accumulated*> (term);
+        if (not Op::isFinite(minimum + maximum) or not (minimum < maximum)
+                or not fuzzyOutput or not dynamic_cast<const Maximum*> (fuzzyOutput->getAccumulation())) {
+            return false;
+        }
+        const int numberOfTerms = fuzzyOutput->numberOfTerms();
+        std::vector<Polyline>& polylines = _polylines;
+        std::vector<scalar>& degrees = _degrees;
+        std::vector<bool>& clipped = _clipped;
+        polylines.resize(numberOfTerms);
+        degrees.resize(numberOfTerms);
+        clipped.resize(numberOfTerms);
+
+        std::vector<scalar>& breakpoints = _breakpoints;
+        breakpoints.clear();
+        breakpoints.reserve(7 * numberOfTerms + 2);
+        breakpoints.push_back(minimum);
+        breakpoints.push_back(maximum);
+        for (int i = 0; i < numberOfTerms; ++i) {
+            const Activated* activated = fuzzyOutput->getTerm(i);
+            const TNorm* activation = activated->getActivation();
+            degrees[i] = activated->getDegree();
+            clipped[i] = dynamic_cast<const Minimum*> (activation) != fl::null;
+            if (not (clipped[i] or dynamic_cast<const AlgebraicProduct*> (activation))
+                    or Op::isNaN(degrees[i]) or not polylines[i].set(activated->getTerm())) {
+                return false;
+            }
+            const Polyline& polyline = polylines[i];
+            for (int v = 0; v < polyline.size; ++v) {
+                breakpoints.push_back(polyline.x[v]);
+            }
+            //Clipping adds a vertex wherever a segment crosses the activation degree
+            for (int v = 0; clipped[i] and v + 1 < polyline.size; ++v) {
+                const scalar y1 = polyline.y[v], y2 = polyline.y[v + 1], degree = degrees[i];
+                if ((y1 < degree and degree < y2) or (y2 < degree and degree < y1)) {
+                    breakpoints.push_back(polyline.x[v]
+                            + (degree - y1) / (y2 - y1) * (polyline.x[v + 1] - polyline.x[v]));
+                }
+            }
+        }
+        std::sort(breakpoints.begin(), breakpoints.end());
+        breakpoints.erase(std::unique(breakpoints.begin(), breakpoints.end()), breakpoints.end());
+
+        std::vector<scalar>& values = _values;
+        std::vector<scalar>& slopes = _slopes;
+        values.reserve(numberOfTerms + 1);
+        slopes.reserve(numberOfTerms + 1);
+        for (std::size_t b = 0; b + 1 < breakpoints.size(); ++b) {
+            const scalar start = breakpoints[b], end = breakpoints[b + 1];
+            if (end <= minimum or start >= maximum) continue;
+
+            //Accumulated::membership() starts from zero before accumulating the activated terms
+            values.assign(1, 0.0);
+            slopes.assign(1, 0.0);
+            const scalar middle = 0.5 * (start + end);
+            for (int i = 0; i < numberOfTerms; ++i) {
+                const Polyline& polyline = polylines[i];
+                if (polyline.supportEnd() <= start or polyline.supportStart() >= end) continue;
+                scalar value, slope;
+                polyline.line(middle, start, value, slope);
+                if (not clipped[i]) {
+                    value *= degrees[i];
+                    slope *= degrees[i];
+                } else if (value + slope * (middle - start) > degrees[i]) {
+                    value = degrees[i];
+                    slope = 0.0;
+                }
+                values.push_back(value);
+                slopes.push_back(slope);
+            }
+            addEnvelope(start, end, values, slopes);
+        }
+        return true;
+    }
+
+    void PiecewiseLinear::addEnvelope(scalar start, scalar end,
+            const std::vector<scalar>& values, const std::vector<scalar>& slopes) {
+        //The line on top at the start, preferring the steepest one on ties since it stays on top
+        std::size_t current = 0;
+        for (std::size_t i = 1; i < values.size(); ++i) {
+            if (values[i] > values[current] or (values[i] == values[current] and slopes[i] > slopes[current])) {
+                current = i;
+            }
+        }
+        //Walk the upper envelope: the next line on top is the first steeper one to cross the current one
+        scalar offset = 0.0;
+        const scalar length = end - start;
+        while (true) {
+            std::size_t next = current;
+            scalar crossing = length;
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                if (slopes[i] <= slopes[current]) continue;
+                const scalar t = (values[current] - values[i]) / (slopes[i] - slopes[current]);
+                if (t > offset and (t < crossing or (t == crossing and slopes[i] > slopes[next]))) {
+                    crossing = t;
+                    next = i;
+                }
+            }
+            Piece piece;
+            piece.start = start + offset;
+            piece.end = (next == current) ? end : start + crossing;
+            piece.slope = slopes[current];
+            piece.value = values[current] + slopes[current] * offset;
+            if (piece.end > piece.start) _pieces.push_back(piece);
+            if (next == current) break;
+            offset = crossing;
+            current = next;
+        }
+    }
+
+    void PiecewiseLinear::clear() {
+        _pieces.clear();
+    }
+
+    const std::vector<PiecewiseLinear::Piece>& PiecewiseLinear::pieces() const {
+        return _pieces;
+    }
+
+    bool PiecewiseLinear::isEmpty() const {
+        return _pieces.empty();
+    }
+
+    scalar PiecewiseLinear::area(const Piece& piece) {
+        const scalar length = piece.end - piece.start;
+        return length * (piece.value + 0.5 * piece.slope * length);
+    }
+
+    scalar PiecewiseLinear::moment(const Piece& piece) {
+        const scalar length = piece.end - piece.start;
+        return piece.start * area(piece)
+                + length * length * (0.5 * piece.value + piece.slope * length / 3.0);
+    }
+
+    scalar PiecewiseLinear::area() const {
+        scalar result = 0.0;
+        for (std::size_t i = 0; i < _pieces.size(); ++i) {
+            result += area(_pieces[i]);
+        }
+        return result;
+    }
+
+    scalar PiecewiseLinear::centroid() const {
+        scalar totalArea = 0.0, totalMoment = 0.0;
+        for (std::size_t i = 0; i < _pieces.size(); ++i) {
+            totalArea += area(_pieces[i]);
+            totalMoment += moment(_pieces[i]);
+        }
+        return totalMoment / totalArea;
+    }
+
+    scalar PiecewiseLinear::bisector() const {
+        const scalar half = 0.5 * area();
+        if (not (half > 0.0)) return fl::nan;
+        scalar accumulated = 0.0;
+        for (std::size_t i = 0; i < _pieces.size(); ++i) {
+            const Piece& piece = _pieces[i];
+            const scalar pieceArea = area(piece);
+            if (accumulated + pieceArea >= half and pieceArea > 0.0) {
+                //Solve value * t + slope * t^2 / 2 = remaining for t in the stable form of the quadratic
+                const scalar remaining = half - accumulated;
+                const scalar discriminant = piece.value * piece.value + 2.0 * piece.slope * remaining;
+                const scalar denominator = piece.value + std::sqrt(discriminant > 0.0 ? discriminant : 0.0);
+                const scalar t = denominator > 0.0 ? 2.0 * remaining / denominator : 0.0;
+                return std::min(piece.start + t, piece.end);
+            }
+            accumulated += pieceArea;
+        }
+        return _pieces.back().end;
+    }
+
+    scalar PiecewiseLinear::highestValue() const {
+        if (_pieces.empty()) return fl::nan;
+        scalar result = -fl::inf;
+        for (std::size_t i = 0; i < _pieces.size(); ++i) {
+            const Piece& piece = _pieces[i];
+            result = Op::max(result, Op::max(piece.value, piece.value + piece.slope * (piece.end - piece.start)));
+        }
+        return result;
+    }
+
+    scalar PiecewiseLinear::smallestOfMaximum() const {
+        const scalar highest = highestValue();
+        for (std::size_t i = 0; i < _pieces.size(); ++i) {
+            const Piece& piece = _pieces[i];
+            if (Op::isEq(piece.value, highest)) return piece.start;
+            if (Op::isEq(piece.value + piece.slope * (piece.end - piece.start), highest)) return piece.end;
+        }
+        return fl::nan;
+    }
+
+    scalar PiecewiseLinear::largestOfMaximum() const {
+        const scalar highest = highestValue();
+        for (std::size_t i = _pieces.size(); i-- > 0;) {
+            const Piece& piece = _pieces[i];
+            if (Op::isEq(piece.value + piece.slope * (piece.end - piece.start), highest)) return piece.end;
+            if (Op::isEq(piece.value, highest)) return piece.start;
+        }
+        return fl::nan;
+    }
+
+    scalar PiecewiseLinear::meanOfMaximum() const {
+        const scalar highest = highestValue();
+        std::size_t i = 0;
+        scalar smallest = fl::nan;
+        for (; i < _pieces.size(); ++i) {
+            const Piece& piece = _pieces[i];
+            if (Op::isEq(piece.value, highest)) {
+                smallest = piece.start;
+                break;
+            }
+            if (Op::isEq(piece.value + piece.slope * (piece.end - piece.start), highest)) {
+                smallest = piece.end;
+                ++i;
+                break;
+            }
+        }
+        if (Op::isNaN(smallest)) return fl::nan;
+        //The plateau continues through the contiguous pieces that stay at the highest value
+        scalar largest = smallest;
+        for (; i < _pieces.size(); ++i) {
+            const Piece& piece = _pieces[i];
+            if (piece.start != largest or not Op::isEq(piece.value, highest)
+                    or not Op::isEq(piece.value + piece.slope * (piece.end - piece.start), highest)) {
+                break;
+            }
+            largest = piece.end;
+        }
+        return 0.5 * (smallest + largest);
+    }
+
+}
@@ -0,0 +1,40 @@
+// PrefixSumBisector.cpp
+//
+// Purpose: Implementation of fl::PrefixSumBisector.
+
+#include "fl/defuzzifier/PrefixSumBisector.h"
+
+#include "fl/defuzzifier/SampledArea.h"
+
+namespace fl {
+
+    PrefixSumBisector::PrefixSumBisector(int resolution)
+    : Bisector(resolution) {
+    }
+
+    PrefixSumBisector::~PrefixSumBisector() {
+    }
+
+    std::string PrefixSumBisector::className() const {
+        return "PrefixSumBisector";
+    }
+
+    scalar PrefixSumBisector::defuzzify(const Term* term, scalar minimum, scalar maximum) const {
+        SampledArea samples;
+        if (not samples.build(term, minimum, maximum, getResolution())) return fl::nan;
+        return defuzzify(samples);
+    }
+
+    scalar PrefixSumBisector::defuzzify(const SampledArea& samples) const {
+        return samples.bisector();
+    }
+
+    PrefixSumBisector* PrefixSumBisector::clone() const {
+        return new PrefixSumBisector(*this);
+    }
+
+    Defuzzifier* PrefixSumBisector::constructor() {
+        return new PrefixSumBisector;
+    }
+
+}
@@ -0,0 +1,99 @@
+// SampledArea.cpp
+//
+// Purpose: Implementation of fl::SampledArea.
+
+#include "fl/defuzzifier/SampledArea.h"
+
+#include "fl/Operation.h"
+#include "fl/term/AccumulatedKernel.h"
+#include "fl/term/Term.h"
+
+#include <algorithm>
+
+namespace fl {
+
+    SampledArea::SampledArea() : _minimum(fl::nan), _maximum(fl::nan), _step(fl::nan) {
+    }
+
+    SampledArea::~SampledArea() {
+    }
+
+    bool SampledArea::build(const Term* term, scalar minimum, scalar maximum, int resolution) {
+        return build(AccumulatedKernel(term), minimum, maximum, resolution);
+    }
+
+    bool SampledArea::build(const AccumulatedKernel& term, scalar minimum, scalar maximum, int resolution) {
+        clear();
+        if (not Op::isFinite(minimum + maximum) or resolution <= 0) return false;
+        _minimum = minimum;
+        _maximum = maximum;
+        _step = (maximum - minimum) / resolution;
+        _samples.resize(resolution);
+        _cumulative.resize(resolution + 1);
+        //The points are laid out in the cumulative sums first, which overwrite them once sampled
+        for (int i = 0; i < resolution; ++i) {
+            _cumulative[i] = minimum + (i + 0.5) * _step;
+        }
+        term.membership(&_cumulative[0], &_samples[0], resolution);
+        scalar sum = 0.0;
+        for (int i = 0; i < resolution; ++i) {
+            _cumulative[i] = sum;
+            sum += _samples[i];
+        }
+        _cumulative[resolution] = sum;
+        return true;
+    }
+
+    void SampledArea::clear() {
+        _samples.clear();
+        _cumulative.clear();
+        _minimum = fl::nan;
+        _maximum = fl::nan;
+        _step = fl::nan;
+    }
+
+    const std::vector<scalar>& SampledArea::samples() const {
+        return _samples;
+    }
+
+    const std::vector<scalar>& SampledArea::cumulative() const {
+        return _cumulative;
+    }
+
+    scalar SampledArea::step() const {
+        return _step;
+    }
+
+    bool SampledArea::isEmpty() const {
+        return _samples.empty();
+    }
+
+    scalar SampledArea::area() const {
+        if (_samples.empty()) return fl::nan;
+        return _cumulative.back() * _step;
+    }
+
+    scalar SampledArea::centroid() const {
+        if (_samples.empty()) return fl::nan;
+        //Same sums in the same order as Centroid::defuzzify()
+        scalar area = 0.0, xcentroid = 0.0;
+        for (std::size_t i = 0; i < _samples.size(); ++i) {
+            const scalar x = _minimum + (i + 0.5) * _step;
+            xcentroid += _samples[i] * x;
+            area += _samples[i];
+        }
+        return xcentroid / area;
+    }
+
+    scalar SampledArea::bisector() const {
+        if (_samples.empty()) return fl::nan;
+        const scalar half = 0.5 * _cumulative.back();
+        if (not (half > 0.0) or Op::isInf(half)) return fl::nan;
+        //The first cell whose right edge reaches half of the area, whose sample is therefore positive
+        std::size_t cell = std::lower_bound(_cumulative.begin() + 1, _cumulative.end(), half)
+                - _cumulative.begin() - 1;
+        const scalar fraction = (half - _cumulative[cell]) / _samples[cell];
+        return std::min(_minimum + (cell + fraction) * _step, _maximum);
+    }
+
+}
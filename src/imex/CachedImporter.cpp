@@ -0,0 +1,89 @@
+// CachedImporter.cpp
+//
+// Purpose: Implementation of fl::CachedImporter.
+
+#include "fl/imex/CachedImporter.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+
+namespace fl {
+
+    CachedImporter::CachedImporter(Importer* importer, const EngineCache& cache)
+    : Importer(), _importer(importer), _cache(cache) {
+    }
+
+    CachedImporter::CachedImporter(const CachedImporter& other)
+    : Importer(other), _importer(fl::null), _cache(other._cache) {
+        if (other._importer) _importer = other._importer->clone();
+    }
+
+    CachedImporter& CachedImporter::operator=(const CachedImporter& other) {
+        if (this != &other) {
+            Importer::operator=(other);
+            if (_importer) delete _importer;
+            _importer = fl::null;
+            if (other._importer) _importer = other._importer->clone();
+            _cache = other._cache;
+        }
+        return *this;
+    }
+
+    CachedImporter::~CachedImporter() {
+        if (_importer) delete _importer;
+    }
+
+    std::string CachedImporter::name() const {
+        return "CachedImporter";
+    }
+
+    void CachedImporter::setImporter(Importer* importer) {
+        if (this->_importer) delete this->_importer;
+        this->_importer = importer;
+    }
+
+    Importer* CachedImporter::getImporter() const {
+        return this->_importer;
+    }
+
+    void CachedImporter::setCache(const EngineCache& cache) {
+        this->_cache = cache;
+    }
+
+    const EngineCache& CachedImporter::getCache() const {
+        return this->_cache;
+    }
+
+    Engine* CachedImporter::fromString(const std::string& text) const {
+        if (not _importer) {
+            throw fl::Exception("[import error] cached importer has no importer", FL_AT);
+        }
+        const std::string key = sourceKey(text);
+        try {
+            std::string fingerprint;
+            if (_cache.load(key, fingerprint)) {
+                if (Engine* engine = _cache.loadEngine(fingerprint)) return engine;
+            }
+        } catch (fl::Exception& ex) {
+            //The cache is only a shortcut
+            FL_LOG("engine not imported from the cache: " << ex.getWhat());
+        }
+
+        Engine* engine = _importer->fromString(text);
+        try {
+            _cache.storeEngine(engine, key);
+        } catch (fl::Exception& ex) {
+            FL_LOG("engine not stored in the cache: " << ex.getWhat());
+        }
+        return engine;
+    }
+
+    std::string CachedImporter::sourceKey(const std::string& text) const {
+        return EngineCache::hash((_importer ? _importer->name() : std::string()) + "\n" + text) + ".source";
+    }
+
+    CachedImporter* CachedImporter::clone() const {
+        return new CachedImporter(*this);
+    }
+
+}
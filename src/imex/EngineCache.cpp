@@ -0,0 +1,519 @@
+// EngineCache.cpp
+//
+// Purpose: Implementation of fl::EngineCache.
+// Detail: The fingerprint hashes every value with a fixed encoding, whatever the platform: integers and
+// scalars as 64-bit little-endian words, scalars as the bits of their double value with every NaN and zero
+// written alike, and strings preceded by their length. Terms are hashed as FlbExporter stores them, with the
+// exact parameters of the stock terms and the text of the parameters of any other. The index holds one line
+// per artifact with its key, its size and the tick of its last use, which grows by one on every use.
+
+#include "fl/imex/EngineCache.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/defuzzifier/AdaptiveDefuzzifier.h"
+#include "fl/defuzzifier/Defuzzifier.h"
+#include "fl/defuzzifier/IntegralDefuzzifier.h"
+#include "fl/defuzzifier/WeightedDefuzzifier.h"
+#include "fl/imex/FlbExporter.h"
+#include "fl/imex/FlbImage.h"
+#include "fl/imex/FlbImporter.h"
+#include "fl/norm/SNorm.h"
+#include "fl/norm/TNorm.h"
+#include "fl/rule/Rule.h"
+#include "fl/rule/RuleBlock.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Discrete.h"
+#include "fl/term/Function.h"
+#include "fl/term/Linear.h"
+#include "fl/term/MembershipKernel.h"
+#include "fl/term/Term.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#if defined(FL_UNIX) || defined(FL_APPLE)
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#elif defined(FL_WINDOWS)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace fl {
+
+    /**
+     * The 64-bit FNV-1a hash of the values of an engine.
+     */
+    class FingerprintHash {
+    public:
+        unsigned long long value;
+
+        FingerprintHash() : value(14695981039346656037ull) {
+        }
+
+        void addBytes(const char* bytes, std::size_t size) {
+            for (std::size_t i = 0; i < size; ++i) {
+                value ^= (unsigned char) bytes[i];
+                value *= 1099511628211ull;
+            }
+        }
+
+        void addWord(unsigned long long word) {
+            char bytes[8];
+            for (int i = 0; i < 8; ++i) {
+                bytes[i] = (char) ((word >> (8 * i)) & 0xFF);
+            }
+            addBytes(bytes, 8);
+        }
+
+        void addInteger(int integer) {
+            addWord((unsigned long long) (long long) integer);
+        }
+
+        void addScalar(scalar x) {
+            double value = (double) x;
+            //NaN and zero compare equal to themselves whatever their sign and payload
+            if (value != value) value = std::numeric_limits<double>::quiet_NaN();
+            else if (value == 0.0) value = 0.0;
+            unsigned long long word = 0;
+            std::memcpy(&word, &value, sizeof(value));
+            addWord(word);
+        }
+
+        void addString(const std::string& text) {
+            addWord((unsigned long long) text.size());
+            addBytes(text.data(), text.size());
+        }
+
+        void addVariable(const Variable* variable) {
+            addString(variable->getName());
+            addScalar(variable->getMinimum());
+            addScalar(variable->getMaximum());
+            addInteger(variable->isEnabled());
+            if (const OutputVariable* outputVariable = dynamic_cast<const OutputVariable*> (variable)) {
+                addScalar(outputVariable->getDefaultValue());
+                addInteger(outputVariable->isLockedPreviousOutputValue());
+                addInteger(outputVariable->isLockedOutputValueInRange());
+                const Defuzzifier* defuzzifier = outputVariable->getDefuzzifier();
+                addString(defuzzifier ? defuzzifier->className() : "");
+                const IntegralDefuzzifier* integral = dynamic_cast<const IntegralDefuzzifier*> (defuzzifier);
+                addInteger(integral ? integral->getResolution() : -1);
+                const WeightedDefuzzifier* weighted = dynamic_cast<const WeightedDefuzzifier*> (defuzzifier);
+                addInteger(weighted ? (int) weighted->getType() : -1);
+                const AdaptiveDefuzzifier* adaptive = dynamic_cast<const AdaptiveDefuzzifier*> (defuzzifier);
+                addInteger(adaptive ? (int) adaptive->getMethod() : -1);
+                addScalar(adaptive ? adaptive->getTolerance() : fl::nan);
+                const SNorm* accumulation = outputVariable->fuzzyOutput()->getAccumulation();
+                addString(accumulation ? accumulation->className() : "");
+            }
+            addInteger(variable->numberOfTerms());
+            for (int i = 0; i < variable->numberOfTerms(); ++i) {
+                addTerm(variable->getTerm(i));
+            }
+        }
+
+        void addTerm(const Term* term) {
+            const std::string className = term->className();
+            addString(className);
+            addString(term->getName());
+            addScalar(term->getHeight());
+            const MembershipKernel kernel(term);
+            const Discrete* discrete = dynamic_cast<const Discrete*> (term);
+            const Linear* linear = dynamic_cast<const Linear*> (term);
+            const Function* function = dynamic_cast<const Function*> (term);
+            if (kernel.getShape() != MembershipKernel::UNKNOWN
+                    and FlbImage::shapeClassName(kernel.getShape()) == className) {
+                const int numberOfParameters = FlbImage::shapeParameters(kernel.getShape());
+                for (int i = 0; i < numberOfParameters; ++i) {
+                    addScalar(kernel.getParameters()[i]);
+                }
+            } else if (discrete and (className == "Discrete" or className == "SortedDiscrete")) {
+                const std::vector<Discrete::Pair>& xy = discrete->xy();
+                addInteger((int) xy.size());
+                for (std::size_t i = 0; i < xy.size(); ++i) {
+                    addScalar(xy.at(i).first);
+                    addScalar(xy.at(i).second);
+                }
+            } else if (linear and className == "Linear") {
+                const std::vector<scalar>& coefficients = linear->coefficients();
+                addInteger((int) coefficients.size());
+                for (std::size_t i = 0; i < coefficients.size(); ++i) {
+                    addScalar(coefficients.at(i));
+                }
+            } else if (function and (className == "Function" or className == "CompiledFunction")) {
+                addString(function->getFormula());
+            } else {
+                addString(term->parameters());
+            }
+        }
+
+        void addRuleBlock(const RuleBlock* ruleBlock) {
+            addString(ruleBlock->getName());
+            addInteger(ruleBlock->isEnabled());
+            addString(ruleBlock->getConjunction() ? ruleBlock->getConjunction()->className() : "");
+            addString(ruleBlock->getDisjunction() ? ruleBlock->getDisjunction()->className() : "");
+            addString(ruleBlock->getActivation() ? ruleBlock->getActivation()->className() : "");
+            addInteger(ruleBlock->numberOfRules());
+            for (int i = 0; i < ruleBlock->numberOfRules(); ++i) {
+                const Rule* rule = ruleBlock->getRule(i);
+                addString(rule->getText());
+                addScalar(rule->getWeight());
+            }
+        }
+
+        std::string str() const {
+            std::ostringstream ss;
+            ss << std::hex;
+            ss.fill('0');
+            ss.width(16);
+            ss << value;
+            return ss.str();
+        }
+    };
+
+    /**
+     * An artifact listed in the index of the cache.
+     */
+    struct CacheEntry {
+        std::string key;
+        std::size_t size;
+        unsigned long long tick;
+
+        static bool lessRecentlyUsed(const CacheEntry& a, const CacheEntry& b) {
+            return a.tick < b.tick;
+        }
+    };
+
+    /**
+     * The index of the cache, read from and written to the file "index" of its directory.
+     */
+    class CacheIndex {
+    public:
+        std::vector<CacheEntry> entries;
+        unsigned long long lastTick;
+
+        CacheIndex() : lastTick(0) {
+        }
+
+        void read(const std::string& path) {
+            entries.clear();
+            lastTick = 0;
+            std::ifstream reader(path.c_str());
+            std::string line;
+            while (std::getline(reader, line)) {
+                std::istringstream tokens(line);
+                CacheEntry entry;
+                if (not (tokens >> entry.key >> entry.size >> entry.tick)) continue;
+                lastTick = std::max(lastTick, entry.tick);
+                entries.push_back(entry);
+            }
+        }
+
+        std::string str() const {
+            std::ostringstream ss;
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                ss << entries.at(i).key << " " << entries.at(i).size << " " << entries.at(i).tick << "\n";
+            }
+            return ss.str();
+        }
+
+        CacheEntry* find(const std::string& key) {
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (entries.at(i).key == key) return &entries.at(i);
+            }
+            return fl::null;
+        }
+
+        void erase(const std::string& key) {
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (entries.at(i).key == key) {
+                    entries.erase(entries.begin() + i);
+                    return;
+                }
+            }
+        }
+
+        std::size_t size() const {
+            std::size_t result = 0;
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                result += entries.at(i).size;
+            }
+            return result;
+        }
+    };
+
+    /**
+     * The size of the file at the path, or -1 if it cannot be read.
+     */
+    static long fileSize(const std::string& path) {
+        std::ifstream reader(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+        if (not reader.is_open()) return -1;
+        return (long) reader.tellg();
+    }
+
+    static void checkKey(const std::string& key) {
+        bool valid = not key.empty() and key != "index" and key.at(0) != '.';
+        for (std::size_t i = 0; i < key.size() and valid; ++i) {
+            const char c = key.at(i);
+            valid = (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9')
+                    or c == '.' or c == '-' or c == '_';
+        }
+        if (not valid) {
+            throw fl::Exception("[cache error] key <" + key + "> is not a valid name of an artifact", FL_AT);
+        }
+    }
+
+    const std::size_t EngineCache::DefaultCapacity = 64 * 1024 * 1024;
+
+    EngineCache::EngineCache(const std::string& directory, std::size_t capacity)
+    : _directory(directory), _capacity(capacity) {
+    }
+
+    EngineCache::~EngineCache() {
+    }
+
+    void EngineCache::setDirectory(const std::string& directory) {
+        this->_directory = directory;
+    }
+
+    std::string EngineCache::getDirectory() const {
+        return this->_directory;
+    }
+
+    void EngineCache::setCapacity(std::size_t capacity) {
+        this->_capacity = capacity;
+    }
+
+    std::size_t EngineCache::getCapacity() const {
+        return this->_capacity;
+    }
+
+    std::string EngineCache::fingerprint(const Engine* engine) {
+        FingerprintHash hash;
+        hash.addString(engine->getName());
+        hash.addInteger(engine->numberOfInputVariables());
+        for (int i = 0; i < engine->numberOfInputVariables(); ++i) {
+            hash.addVariable(engine->getInputVariable(i));
+        }
+        hash.addInteger(engine->numberOfOutputVariables());
+        for (int i = 0; i < engine->numberOfOutputVariables(); ++i) {
+            hash.addVariable(engine->getOutputVariable(i));
+        }
+        hash.addInteger(engine->numberOfRuleBlocks());
+        for (int i = 0; i < engine->numberOfRuleBlocks(); ++i) {
+            hash.addRuleBlock(engine->getRuleBlock(i));
+        }
+        return hash.str();
+    }
+
+    std::string EngineCache::hash(const std::string& bytes) {
+        FingerprintHash hash;
+        hash.addBytes(bytes.data(), bytes.size());
+        return hash.str();
+    }
+
+    std::string EngineCache::storeEngine(const Engine* engine, const std::string& key) const {
+        const std::string result = fingerprint(engine);
+        const std::string imageKey = result + ".flb";
+        if (not touch(imageKey)) {
+            const std::string image = FlbExporter().toString(engine);
+            //An image that does not import back to the same engine would be imported in vain on every load
+            std::string reason;
+            try {
+                FL_unique_ptr<Engine> imported(FlbImporter().fromString(image));
+                if (fingerprint(imported.get()) != result) reason = "it imports back as a different engine";
+            } catch (fl::Exception& ex) {
+                reason = ex.getWhat();
+            }
+            if (not reason.empty()) {
+                throw fl::Exception("[cache error] engine <" + engine->getName()
+                        + "> cannot be cached as a binary image: " + reason, FL_AT);
+            }
+            if (not store(imageKey, image)) return result;
+        }
+        if (not key.empty()) {
+            //Storing the key evicts the image it names only if both do not fit in the cache
+            const long size = fileSize(path(imageKey));
+            if (size >= 0 and (std::size_t) size + result.size() <= _capacity) {
+                store(key, result);
+            }
+        }
+        return result;
+    }
+
+    Engine* EngineCache::loadEngine(const std::string& fingerprint) const {
+        const std::string key = fingerprint + ".flb";
+        if (not touch(key)) return fl::null;
+        FlbImage image;
+        try {
+            image.map(path(key));
+            image.check();
+        } catch (fl::Exception&) {
+            //Written by another version of the format, or damaged
+            remove(key);
+            return fl::null;
+        }
+        return FlbImporter().fromImage(image);
+    }
+
+    bool EngineCache::store(const std::string& key, const std::string& artifact) const {
+        checkKey(key);
+        if (artifact.size() > _capacity) return false;
+        if (not _directory.empty()) {
+#if defined(FL_UNIX) || defined(FL_APPLE)
+            ::mkdir(_directory.c_str(), 0777);
+#elif defined(FL_WINDOWS)
+            ::CreateDirectoryA(_directory.c_str(), fl::null);
+#endif
+        }
+        write(path(key), artifact);
+
+        CacheIndex index;
+        index.read(path("index"));
+        CacheEntry* entry = index.find(key);
+        if (not entry) {
+            CacheEntry added;
+            added.key = key;
+            index.entries.push_back(added);
+            entry = &index.entries.back();
+        }
+        entry->size = artifact.size();
+        entry->tick = ++index.lastTick;
+
+        std::sort(index.entries.begin(), index.entries.end(), CacheEntry::lessRecentlyUsed);
+        std::size_t size = index.size();
+        std::vector<CacheEntry>::iterator it = index.entries.begin();
+        while (size > _capacity and it->key != key) {
+            std::remove(path(it->key).c_str());
+            size -= it->size;
+            ++it;
+        }
+        index.entries.erase(index.entries.begin(), it);
+        write(path("index"), index.str());
+        return true;
+    }
+
+    bool EngineCache::load(const std::string& key, std::string& artifact) const {
+        if (not touch(key)) return false;
+        std::ifstream reader(path(key).c_str(), std::ios::in | std::ios::binary);
+        if (not reader.is_open()) return false;
+        artifact.assign(std::istreambuf_iterator<char>(reader), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool EngineCache::touch(const std::string& key) const {
+        checkKey(key);
+        CacheIndex index;
+        index.read(path("index"));
+        CacheEntry* entry = index.find(key);
+        const long size = fileSize(path(key));
+        if (size < 0) {
+            //Removed by another process, or never stored
+            if (entry) {
+                index.erase(key);
+                write(path("index"), index.str());
+            }
+            return false;
+        }
+        if (not entry) {
+            //Stored by a process whose update of the index was lost
+            CacheEntry added;
+            added.key = key;
+            index.entries.push_back(added);
+            entry = &index.entries.back();
+        }
+        entry->size = (std::size_t) size;
+        entry->tick = ++index.lastTick;
+        write(path("index"), index.str());
+        return true;
+    }
+
+    void EngineCache::remove(const std::string& key) const {
+        checkKey(key);
+        std::remove(path(key).c_str());
+        CacheIndex index;
+        index.read(path("index"));
+        if (index.find(key)) {
+            index.erase(key);
+            write(path("index"), index.str());
+        }
+    }
+
+    void EngineCache::clear() const {
+        CacheIndex index;
+        index.read(path("index"));
+        for (std::size_t i = 0; i < index.entries.size(); ++i) {
+            std::remove(path(index.entries.at(i).key).c_str());
+        }
+        std::remove(path("index").c_str());
+    }
+
+    int EngineCache::numberOfArtifacts() const {
+        CacheIndex index;
+        index.read(path("index"));
+        return (int) index.entries.size();
+    }
+
+    std::size_t EngineCache::size() const {
+        CacheIndex index;
+        index.read(path("index"));
+        return index.size();
+    }
+
+    std::string EngineCache::path(const std::string& key) const {
+        if (_directory.empty()) return key;
+        const char last = _directory.at(_directory.size() - 1);
+        if (last == '/' or last == '\\') return _directory + key;
+        return _directory + "/" + key;
+    }
+
+    void EngineCache::write(const std::string& path, const std::string& bytes) const {
+        //Unique to the process, and to the thread by the address of its stack
+        std::ostringstream temporary;
+#if defined(FL_UNIX) || defined(FL_APPLE)
+        temporary << path << "." << ::getpid();
+#elif defined(FL_WINDOWS)
+        temporary << path << "." << ::GetCurrentProcessId();
+#else
+        temporary << path;
+#endif
+        temporary << "." << std::hex << reinterpret_cast<std::size_t> (&temporary) << ".tmp";
+        {
+            std::ofstream writer(temporary.str().c_str(), std::ios::out | std::ios::binary);
+            if (not writer.is_open()) {
+                throw fl::Exception("[file error] file <" + temporary.str() + "> could not be created", FL_AT);
+            }
+            writer.write(bytes.data(), bytes.size());
+            if (not writer) {
+                writer.close();
+                std::remove(temporary.str().c_str());
+                throw fl::Exception("[file error] file <" + temporary.str() + "> could not be written", FL_AT);
+            }
+        }
+#if defined(FL_WINDOWS)
+        const bool renamed = ::MoveFileExA(temporary.str().c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        const bool renamed = std::rename(temporary.str().c_str(), path.c_str()) == 0;
+#endif
+        if (not renamed) {
+            std::remove(temporary.str().c_str());
+            throw fl::Exception("[file error] file <" + path + "> could not be replaced", FL_AT);
+        }
+    }
+
+}
@@ -0,0 +1,322 @@
+// FlbExporter.cpp
+//
+// Purpose: Implementation of fl::FlbExporter.
+// Detail: The records are gathered first and then written section by section, each padded to 8 bytes. Rules
+// whose propositions cannot be resolved to the variables and terms of the engine are stored as text only,
+// as rules that were not loaded are.
+
+#include "fl/imex/FlbExporter.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/defuzzifier/AdaptiveDefuzzifier.h"
+#include "fl/defuzzifier/Defuzzifier.h"
+#include "fl/defuzzifier/IntegralDefuzzifier.h"
+#include "fl/defuzzifier/WeightedDefuzzifier.h"
+#include "fl/hedge/Hedge.h"
+#include "fl/imex/FlbImage.h"
+#include "fl/norm/SNorm.h"
+#include "fl/norm/TNorm.h"
+#include "fl/rule/Antecedent.h"
+#include "fl/rule/Consequent.h"
+#include "fl/rule/Expression.h"
+#include "fl/rule/Rule.h"
+#include "fl/rule/RuleBlock.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Discrete.h"
+#include "fl/term/Function.h"
+#include "fl/term/Linear.h"
+#include "fl/term/MembershipKernel.h"
+#include "fl/term/Term.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace fl {
+
+    /**
+     * Records of the image being exported.
+     */
+    class FlbWriter {
+    public:
+        typedef FlbImage::Index Index;
+
+        std::map<std::string, Index> stringIndices;
+        std::vector<FlbImage::StringRecord> strings;
+        std::string characters;
+        std::vector<FlbImage::VariableRecord> variables;
+        std::vector<FlbImage::TermRecord> terms;
+        std::vector<scalar> scalars;
+        std::vector<FlbImage::RuleBlockRecord> ruleBlocks;
+        std::vector<FlbImage::RuleRecord> rules;
+        std::vector<FlbImage::NodeRecord> nodes;
+        std::vector<Index> hedges;
+        std::vector<const Variable*> engineVariables;
+        std::map<const Variable*, Index> variableIndices;
+
+        Index intern(const std::string& text) {
+            std::map<std::string, Index>::const_iterator it = stringIndices.find(text);
+            if (it != stringIndices.end()) return it->second;
+            FlbImage::StringRecord record;
+            record.offset = (Index) characters.size();
+            record.length = (Index) text.size();
+            characters.append(text);
+            characters.push_back('\0');
+            strings.push_back(record);
+            stringIndices[text] = (Index) strings.size() - 1;
+            return (Index) strings.size() - 1;
+        }
+
+        void writeVariable(const Variable* variable) {
+            FlbImage::VariableRecord record;
+            std::memset(&record, 0, sizeof(record));
+            record.minimum = variable->getMinimum();
+            record.maximum = variable->getMaximum();
+            record.defaultValue = fl::nan;
+            record.tolerance = fl::nan;
+            record.name = intern(variable->getName());
+            record.flags = variable->isEnabled() ? FlbImage::ENABLED : 0;
+            record.defuzzifier = FlbImage::None;
+            record.resolution = FlbImage::None;
+            record.type = FlbImage::None;
+            record.accumulation = FlbImage::None;
+            if (const OutputVariable* outputVariable = dynamic_cast<const OutputVariable*> (variable)) {
+                record.defaultValue = outputVariable->getDefaultValue();
+                if (outputVariable->isLockedPreviousOutputValue()) record.flags |= FlbImage::LOCK_PREVIOUS_VALUE;
+                if (outputVariable->isLockedOutputValueInRange()) record.flags |= FlbImage::LOCK_VALUE_IN_RANGE;
+                if (const Defuzzifier* defuzzifier = outputVariable->getDefuzzifier()) {
+                    record.defuzzifier = intern(defuzzifier->className());
+                    if (const IntegralDefuzzifier* integral = dynamic_cast<const IntegralDefuzzifier*> (defuzzifier)) {
+                        record.resolution = (Index) integral->getResolution();
+                    }
+                    if (const WeightedDefuzzifier* weighted = dynamic_cast<const WeightedDefuzzifier*> (defuzzifier)) {
+                        record.type = (Index) weighted->getType();
+                    }
+                    if (const AdaptiveDefuzzifier* adaptive = dynamic_cast<const AdaptiveDefuzzifier*> (defuzzifier)) {
+                        record.type = (Index) adaptive->getMethod();
+                        record.tolerance = adaptive->getTolerance();
+                    }
+                }
+                if (const SNorm* accumulation = outputVariable->fuzzyOutput()->getAccumulation()) {
+                    record.accumulation = intern(accumulation->className());
+                }
+            }
+            record.firstTerm = (Index) terms.size();
+            record.numberOfTerms = (Index) variable->numberOfTerms();
+            for (int i = 0; i < variable->numberOfTerms(); ++i) {
+                writeTerm(variable->getTerm(i));
+            }
+            variables.push_back(record);
+            variableIndices[variable] = (Index) engineVariables.size();
+            engineVariables.push_back(variable);
+        }
+
+        void writeTerm(const Term* term) {
+            FlbImage::TermRecord record;
+            std::memset(&record, 0, sizeof(record));
+            const std::string className = term->className();
+            record.height = term->getHeight();
+            record.name = intern(term->getName());
+            record.className = intern(className);
+            record.shape = MembershipKernel::UNKNOWN;
+            record.text = FlbImage::None;
+            record.firstScalar = (Index) scalars.size();
+            //Subclasses of the stock terms keep their class and parameters as text
+            const MembershipKernel kernel(term);
+            const Discrete* discrete = dynamic_cast<const Discrete*> (term);
+            const Linear* linear = dynamic_cast<const Linear*> (term);
+            const Function* function = dynamic_cast<const Function*> (term);
+            if (kernel.getShape() != MembershipKernel::UNKNOWN
+                    and FlbImage::shapeClassName(kernel.getShape()) == className) {
+                record.kind = FlbImage::SHAPE;
+                record.shape = kernel.getShape();
+                const int numberOfParameters = FlbImage::shapeParameters(kernel.getShape());
+                scalars.insert(scalars.end(), kernel.getParameters(), kernel.getParameters() + numberOfParameters);
+            } else if (discrete and (className == "Discrete" or className == "SortedDiscrete")) {
+                record.kind = FlbImage::DISCRETE;
+                const std::vector<Discrete::Pair>& xy = discrete->xy();
+                for (std::size_t i = 0; i < xy.size(); ++i) {
+                    scalars.push_back(xy.at(i).first);
+                    scalars.push_back(xy.at(i).second);
+                }
+            } else if (linear and className == "Linear") {
+                record.kind = FlbImage::LINEAR;
+                scalars.insert(scalars.end(), linear->coefficients().begin(), linear->coefficients().end());
+            } else if (function and (className == "Function" or className == "CompiledFunction")) {
+                record.kind = FlbImage::FUNCTION;
+                record.text = intern(function->getFormula());
+                if (function->isLoaded()) record.flags = FlbImage::LOADED;
+            } else {
+                record.kind = FlbImage::TEXT;
+                record.text = intern(term->parameters());
+            }
+            record.numberOfScalars = (Index) scalars.size() - record.firstScalar;
+            terms.push_back(record);
+        }
+
+        void writeRuleBlock(const RuleBlock* ruleBlock) {
+            FlbImage::RuleBlockRecord record;
+            std::memset(&record, 0, sizeof(record));
+            record.name = intern(ruleBlock->getName());
+            record.flags = ruleBlock->isEnabled() ? FlbImage::ENABLED : 0;
+            record.conjunction = ruleBlock->getConjunction()
+                    ? intern(ruleBlock->getConjunction()->className()) : FlbImage::None;
+            record.disjunction = ruleBlock->getDisjunction()
+                    ? intern(ruleBlock->getDisjunction()->className()) : FlbImage::None;
+            record.activation = ruleBlock->getActivation()
+                    ? intern(ruleBlock->getActivation()->className()) : FlbImage::None;
+            record.firstRule = (Index) rules.size();
+            record.numberOfRules = (Index) ruleBlock->numberOfRules();
+            for (int i = 0; i < ruleBlock->numberOfRules(); ++i) {
+                writeRule(ruleBlock->getRule(i));
+            }
+            ruleBlocks.push_back(record);
+        }
+
+        void writeRule(const Rule* rule) {
+            FlbImage::RuleRecord record;
+            std::memset(&record, 0, sizeof(record));
+            record.weight = rule->getWeight();
+            record.text = intern(rule->getText());
+            record.antecedent = FlbImage::None;
+            record.consequent = FlbImage::None;
+            record.firstNode = (Index) nodes.size();
+            const std::size_t numberOfHedges = hedges.size();
+            bool resolved = rule->isLoaded() and writeExpression(rule->getAntecedent()->getExpression());
+            record.numberOfNodes = (Index) nodes.size() - record.firstNode;
+            if (resolved) {
+                const std::vector<Proposition*>& conclusions = rule->getConsequent()->conclusions();
+                for (std::size_t i = 0; resolved and i < conclusions.size(); ++i) {
+                    resolved = conclusions.at(i)->term and writeExpression(conclusions.at(i));
+                }
+            }
+            if (resolved) {
+                record.flags = FlbImage::LOADED;
+                record.antecedent = intern(rule->getAntecedent()->getText());
+                record.consequent = intern(rule->getConsequent()->getText());
+                record.numberOfConclusions = (Index) nodes.size() - record.firstNode - record.numberOfNodes;
+            } else {
+                nodes.resize(record.firstNode);
+                hedges.resize(numberOfHedges);
+                record.numberOfNodes = 0;
+            }
+            rules.push_back(record);
+        }
+
+        bool writeExpression(const Expression* expression) {
+            FlbImage::NodeRecord record;
+            std::memset(&record, 0, sizeof(record));
+            if (const Operator* fuzzyOperator = dynamic_cast<const Operator*> (expression)) {
+                if (fuzzyOperator->name == Rule::andKeyword()) record.code = FlbImage::CONJUNCTION;
+                else if (fuzzyOperator->name == Rule::orKeyword()) record.code = FlbImage::DISJUNCTION;
+                else return false;
+                if (not (writeExpression(fuzzyOperator->left) and writeExpression(fuzzyOperator->right))) {
+                    return false;
+                }
+                nodes.push_back(record);
+                return true;
+            }
+            const Proposition* proposition = dynamic_cast<const Proposition*> (expression);
+            if (not proposition) return false;
+            record.code = FlbImage::PROPOSITION;
+            std::map<const Variable*, Index>::const_iterator it = variableIndices.find(proposition->variable);
+            if (it == variableIndices.end()) return false;
+            record.variable = it->second;
+            record.term = FlbImage::None;
+            if (proposition->term) {
+                const Variable* variable = engineVariables.at(record.variable);
+                for (int i = 0; i < variable->numberOfTerms(); ++i) {
+                    if (variable->getTerm(i) == proposition->term) record.term = (Index) i;
+                }
+                if (record.term == FlbImage::None) return false;
+            }
+            record.firstHedge = (Index) hedges.size();
+            record.numberOfHedges = (Index) proposition->hedges.size();
+            for (std::size_t i = 0; i < proposition->hedges.size(); ++i) {
+                hedges.push_back(intern(proposition->hedges.at(i)->name()));
+            }
+            nodes.push_back(record);
+            return true;
+        }
+
+        template <typename T>
+        void writeSection(std::string& image, FlbImage::Section& section, const std::vector<T>& records) {
+            image.append((8 - image.size() % 8) % 8, '\0');
+            section.offset = (Index) image.size();
+            section.count = (Index) records.size();
+            if (not records.empty()) {
+                image.append(reinterpret_cast<const char*> (&records[0]), records.size() * sizeof(T));
+            }
+        }
+    };
+
+    FlbExporter::FlbExporter() : Exporter() {
+    }
+
+    FlbExporter::~FlbExporter() {
+    }
+
+    std::string FlbExporter::name() const {
+        return "FlbExporter";
+    }
+
+    std::string FlbExporter::toString(const Engine* engine) const {
+        FlbWriter writer;
+        FlbImage::Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "FLB", 4);
+        header.version = FlbImage::Version;
+        header.byteOrder = FlbImage::ByteOrder;
+        header.scalarSize = sizeof(scalar);
+        header.name = writer.intern(engine->getName());
+
+        for (int i = 0; i < engine->numberOfInputVariables(); ++i) {
+            writer.writeVariable(engine->getInputVariable(i));
+        }
+        header.numberOfInputs = (FlbImage::Index) engine->numberOfInputVariables();
+        for (int i = 0; i < engine->numberOfOutputVariables(); ++i) {
+            writer.writeVariable(engine->getOutputVariable(i));
+        }
+        for (int i = 0; i < engine->numberOfRuleBlocks(); ++i) {
+            writer.writeRuleBlock(engine->getRuleBlock(i));
+        }
+
+        std::string image(sizeof(header), '\0');
+        writer.writeSection(image, header.strings, writer.strings);
+        std::vector<char> characters(writer.characters.begin(), writer.characters.end());
+        writer.writeSection(image, header.characters, characters);
+        writer.writeSection(image, header.variables, writer.variables);
+        writer.writeSection(image, header.terms, writer.terms);
+        writer.writeSection(image, header.scalars, writer.scalars);
+        writer.writeSection(image, header.ruleBlocks, writer.ruleBlocks);
+        writer.writeSection(image, header.rules, writer.rules);
+        writer.writeSection(image, header.nodes, writer.nodes);
+        writer.writeSection(image, header.hedges, writer.hedges);
+        if (image.size() >= (std::size_t) FlbImage::None) {
+            throw fl::Exception("[export error] engine <" + engine->getName()
+                    + "> is too large for a binary image", FL_AT);
+        }
+        header.size = (FlbImage::Index) image.size();
+        std::memcpy(&image[0], &header, sizeof(header));
+        return image;
+    }
+
+    void FlbExporter::toFile(const std::string& path, const Engine* engine) const {
+        std::ofstream writer(path.c_str(), std::ios::out | std::ios::binary);
+        if (not writer.is_open()) {
+            throw fl::Exception("[file error] file <" + path + "> could not be created", FL_AT);
+        }
+        const std::string image = toString(engine);
+        writer.write(image.data(), image.size());
+        writer.close();
+    }
+
+    FlbExporter* FlbExporter::clone() const {
+        return new FlbExporter(*this);
+    }
+
+}
@@ -0,0 +1,381 @@
+// FlbImage.cpp
+//
+// Purpose: Implementation of fl::FlbImage.
+// Detail: Files are mapped with mmap() on Unix and with a file mapping on Windows; elsewhere they are read
+// into the aligned copy. Offsets and counts are checked by division rather than by adding them up, so a
+// corrupt image cannot overflow them past the checks.
+
+#include "fl/imex/FlbImage.h"
+
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/term/MembershipKernel.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(FL_UNIX) || defined(FL_APPLE)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(FL_WINDOWS)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace fl {
+
+    const FlbImage::Index FlbImage::None = 0xFFFFFFFFu;
+    const FlbImage::Index FlbImage::Version = 2;
+    const FlbImage::Index FlbImage::ByteOrder = 0x01020304u;
+
+    FlbImage::FlbImage() : _data(fl::null), _size(0), _mapped(false) {
+    }
+
+    FlbImage::~FlbImage() {
+        close();
+    }
+
+    void FlbImage::map(const std::string& path) {
+        close();
+#if defined(FL_UNIX) || defined(FL_APPLE)
+        const int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            throw fl::Exception("[file error] file <" + path + "> could not be opened", FL_AT);
+        }
+        struct stat status;
+        if (::fstat(file, &status) != 0 or status.st_size <= 0) {
+            ::close(file);
+            throw fl::Exception("[file error] file <" + path + "> is empty or could not be read", FL_AT);
+        }
+        void* view = ::mmap(fl::null, (std::size_t) status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        //The mapping keeps the file open
+        ::close(file);
+        if (view == MAP_FAILED) {
+            throw fl::Exception("[file error] file <" + path + "> could not be mapped", FL_AT);
+        }
+        _data = static_cast<const char*> (view);
+        _size = (std::size_t) status.st_size;
+        _mapped = true;
+#elif defined(FL_WINDOWS)
+        HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, fl::null,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, fl::null);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw fl::Exception("[file error] file <" + path + "> could not be opened", FL_AT);
+        }
+        LARGE_INTEGER fileSize;
+        if (not ::GetFileSizeEx(file, &fileSize) or fileSize.QuadPart <= 0) {
+            ::CloseHandle(file);
+            throw fl::Exception("[file error] file <" + path + "> is empty or could not be read", FL_AT);
+        }
+        HANDLE mapping = ::CreateFileMappingA(file, fl::null, PAGE_READONLY, 0, 0, fl::null);
+        const void* view = mapping ? ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : fl::null;
+        //The view keeps the file and its mapping open
+        if (mapping) ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        if (not view) {
+            throw fl::Exception("[file error] file <" + path + "> could not be mapped", FL_AT);
+        }
+        _data = static_cast<const char*> (view);
+        _size = (std::size_t) fileSize.QuadPart;
+        _mapped = true;
+#else
+        std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+        if (not file.is_open()) {
+            throw fl::Exception("[file error] file <" + path + "> could not be opened", FL_AT);
+        }
+        std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        _copy.assign((bytes.size() + sizeof(double) - 1) / sizeof(double), 0.0);
+        if (not bytes.empty()) std::memcpy(&_copy[0], bytes.data(), bytes.size());
+        _data = _copy.empty() ? "" : reinterpret_cast<const char*> (&_copy[0]);
+        _size = bytes.size();
+#endif
+    }
+
+    void FlbImage::view(const char* data, std::size_t size) {
+        close();
+        if ((reinterpret_cast<std::size_t> (data) % sizeof(double)) == 0) {
+            _data = data;
+            _size = size;
+            return;
+        }
+        _copy.assign((size + sizeof(double) - 1) / sizeof(double), 0.0);
+        if (size > 0) std::memcpy(&_copy[0], data, size);
+        _data = _copy.empty() ? "" : reinterpret_cast<const char*> (&_copy[0]);
+        _size = size;
+    }
+
+    void FlbImage::close() {
+        if (_mapped) {
+#if defined(FL_UNIX) || defined(FL_APPLE)
+            ::munmap(const_cast<char*> (_data), _size);
+#elif defined(FL_WINDOWS)
+            ::UnmapViewOfFile(_data);
+#endif
+        }
+        _mapped = false;
+        _data = fl::null;
+        _size = 0;
+        std::vector<double>().swap(_copy);
+    }
+
+    bool FlbImage::isMapped() const {
+        return this->_mapped;
+    }
+
+    const char* FlbImage::data() const {
+        return this->_data;
+    }
+
+    std::size_t FlbImage::size() const {
+        return this->_size;
+    }
+
+    static void checkSection(const FlbImage::Section& section, std::size_t recordSize, std::size_t size,
+            const std::string& name) {
+        if (section.offset % 8 != 0 or section.offset < sizeof(FlbImage::Header) or section.offset > size
+                or section.count > (size - section.offset) / recordSize) {
+            throw fl::Exception("[import error] section of " + name + " is out of the image", FL_AT);
+        }
+    }
+
+    static void checkRange(FlbImage::Index first, FlbImage::Index count, FlbImage::Index total,
+            const std::string& name) {
+        if (first > total or count > total - first) {
+            throw fl::Exception("[import error] " + name + " out of range", FL_AT);
+        }
+    }
+
+    static void checkIndex(FlbImage::Index index, FlbImage::Index total, bool optional, const std::string& name) {
+        if (index >= total and not (optional and index == FlbImage::None)) {
+            throw fl::Exception("[import error] " + name + " out of range", FL_AT);
+        }
+    }
+
+    void FlbImage::check() const {
+        if (not _data or _size < sizeof(Header)) {
+            throw fl::Exception("[import error] image is too small to hold a header", FL_AT);
+        }
+        const Header& h = header();
+        if (std::memcmp(h.magic, "FLB", 4) != 0) {
+            throw fl::Exception("[import error] image is not a binary engine", FL_AT);
+        }
+        if (h.byteOrder != ByteOrder) {
+            throw fl::Exception("[import error] image was written in a different byte order", FL_AT);
+        }
+        if (h.version != Version) {
+            throw fl::Exception("[import error] image version <" + Op::str((int) h.version)
+                    + "> is not supported, expected <" + Op::str((int) Version) + ">", FL_AT);
+        }
+        if (h.scalarSize != sizeof(scalar)) {
+            throw fl::Exception("[import error] image was written with scalars of <" + Op::str((int) h.scalarSize)
+                    + "> bytes, expected <" + Op::str((int) sizeof(scalar)) + ">", FL_AT);
+        }
+        if (h.size > _size) {
+            throw fl::Exception("[import error] image is truncated to <" + Op::str((int) _size)
+                    + "> of its <" + Op::str((int) h.size) + "> bytes", FL_AT);
+        }
+        const std::size_t size = h.size;
+        checkSection(h.strings, sizeof(StringRecord), size, "strings");
+        checkSection(h.characters, 1, size, "characters");
+        checkSection(h.variables, sizeof(VariableRecord), size, "variables");
+        checkSection(h.terms, sizeof(TermRecord), size, "terms");
+        checkSection(h.scalars, sizeof(scalar), size, "scalars");
+        checkSection(h.ruleBlocks, sizeof(RuleBlockRecord), size, "rule blocks");
+        checkSection(h.rules, sizeof(RuleRecord), size, "rules");
+        checkSection(h.nodes, sizeof(NodeRecord), size, "nodes");
+        checkSection(h.hedges, sizeof(Index), size, "hedges");
+
+        const StringRecord* strings = reinterpret_cast<const StringRecord*> (_data + h.strings.offset);
+        const char* characters = _data + h.characters.offset;
+        for (Index i = 0; i < h.strings.count; ++i) {
+            if (strings[i].offset >= h.characters.count
+                    or strings[i].length >= h.characters.count - strings[i].offset
+                    or characters[strings[i].offset + strings[i].length] != '\0') {
+                throw fl::Exception("[import error] string <" + Op::str((int) i) + "> out of range", FL_AT);
+            }
+        }
+        const Index numberOfStrings = h.strings.count;
+        checkIndex(h.name, numberOfStrings, false, "name of the engine");
+        if (h.numberOfInputs > h.variables.count) {
+            throw fl::Exception("[import error] number of input variables out of range", FL_AT);
+        }
+
+        const VariableRecord* variables = this->variables();
+        for (Index i = 0; i < h.variables.count; ++i) {
+            const VariableRecord& variable = variables[i];
+            checkIndex(variable.name, numberOfStrings, false, "name of variable");
+            checkRange(variable.firstTerm, variable.numberOfTerms, h.terms.count, "terms of variable");
+            checkIndex(variable.defuzzifier, numberOfStrings, true, "defuzzifier of variable");
+            checkIndex(variable.accumulation, numberOfStrings, true, "accumulation of variable");
+        }
+
+        const TermRecord* terms = this->terms();
+        for (Index i = 0; i < h.terms.count; ++i) {
+            const TermRecord& term = terms[i];
+            checkIndex(term.name, numberOfStrings, false, "name of term");
+            checkIndex(term.className, numberOfStrings, false, "class of term");
+            checkIndex(term.text, numberOfStrings, true, "text of term");
+            checkRange(term.firstScalar, term.numberOfScalars, h.scalars.count, "parameters of term");
+            const bool valid = (term.kind == SHAPE
+                    and (int) term.numberOfScalars == shapeParameters((int) term.shape)
+                    and term.numberOfScalars > 0)
+                    or (term.kind == DISCRETE and term.numberOfScalars % 2 == 0)
+                    or term.kind == LINEAR
+                    or ((term.kind == FUNCTION or term.kind == TEXT) and term.text != None);
+            if (not valid) {
+                throw fl::Exception("[import error] term <" + std::string(string(term.name))
+                        + "> is not valid", FL_AT);
+            }
+        }
+
+        const RuleBlockRecord* ruleBlocks = this->ruleBlocks();
+        for (Index i = 0; i < h.ruleBlocks.count; ++i) {
+            const RuleBlockRecord& ruleBlock = ruleBlocks[i];
+            checkIndex(ruleBlock.name, numberOfStrings, false, "name of rule block");
+            checkIndex(ruleBlock.conjunction, numberOfStrings, true, "conjunction of rule block");
+            checkIndex(ruleBlock.disjunction, numberOfStrings, true, "disjunction of rule block");
+            checkIndex(ruleBlock.activation, numberOfStrings, true, "activation of rule block");
+            checkRange(ruleBlock.firstRule, ruleBlock.numberOfRules, h.rules.count, "rules of rule block");
+        }
+
+        const RuleRecord* rules = this->rules();
+        const NodeRecord* nodes = this->nodes();
+        const Index* hedges = this->hedges();
+        for (Index i = 0; i < h.rules.count; ++i) {
+            const RuleRecord& rule = rules[i];
+            checkIndex(rule.text, numberOfStrings, false, "text of rule");
+            if (not (rule.flags & LOADED)) continue;
+            checkIndex(rule.antecedent, numberOfStrings, false, "antecedent of rule");
+            checkIndex(rule.consequent, numberOfStrings, false, "consequent of rule");
+            checkRange(rule.firstNode, rule.numberOfNodes, h.nodes.count, "antecedent of rule");
+            checkRange(rule.firstNode + rule.numberOfNodes, rule.numberOfConclusions, h.nodes.count,
+                    "consequent of rule");
+            //The postfix antecedent must leave exactly one expression, and conclusions are on outputs
+            Index depth = 0;
+            for (Index n = 0; n < rule.numberOfNodes + rule.numberOfConclusions; ++n) {
+                const NodeRecord& node = nodes[rule.firstNode + n];
+                const bool conclusion = n >= rule.numberOfNodes;
+                if (node.code == PROPOSITION) {
+                    checkIndex(node.variable, h.variables.count, false, "variable of proposition");
+                    checkIndex(node.term, variables[node.variable].numberOfTerms, not conclusion,
+                            "term of proposition");
+                    checkRange(node.firstHedge, node.numberOfHedges, h.hedges.count, "hedges of proposition");
+                    for (Index k = 0; k < node.numberOfHedges; ++k) {
+                        checkIndex(hedges[node.firstHedge + k], numberOfStrings, false, "hedge of proposition");
+                    }
+                    if (conclusion and node.variable < h.numberOfInputs) {
+                        throw fl::Exception("[import error] conclusion on an input variable", FL_AT);
+                    }
+                    if (not conclusion) ++depth;
+                } else if ((node.code == CONJUNCTION or node.code == DISJUNCTION) and not conclusion
+                        and depth >= 2) {
+                    --depth;
+                } else {
+                    throw fl::Exception("[import error] rule <" + std::string(string(rule.text))
+                            + "> is not valid", FL_AT);
+                }
+            }
+            if (depth != 1 or rule.numberOfConclusions == 0) {
+                throw fl::Exception("[import error] rule <" + std::string(string(rule.text))
+                        + "> is not valid", FL_AT);
+            }
+        }
+    }
+
+    const FlbImage::Header& FlbImage::header() const {
+        return *reinterpret_cast<const Header*> (_data);
+    }
+
+    const char* FlbImage::string(Index index) const {
+        const StringRecord& record = reinterpret_cast<const StringRecord*> (_data + header().strings.offset)[index];
+        return _data + header().characters.offset + record.offset;
+    }
+
+    const FlbImage::VariableRecord* FlbImage::variables() const {
+        return reinterpret_cast<const VariableRecord*> (_data + header().variables.offset);
+    }
+
+    const FlbImage::TermRecord* FlbImage::terms() const {
+        return reinterpret_cast<const TermRecord*> (_data + header().terms.offset);
+    }
+
+    const scalar* FlbImage::scalars() const {
+        return reinterpret_cast<const scalar*> (_data + header().scalars.offset);
+    }
+
+    const FlbImage::RuleBlockRecord* FlbImage::ruleBlocks() const {
+        return reinterpret_cast<const RuleBlockRecord*> (_data + header().ruleBlocks.offset);
+    }
+
+    const FlbImage::RuleRecord* FlbImage::rules() const {
+        return reinterpret_cast<const RuleRecord*> (_data + header().rules.offset);
+    }
+
+    const FlbImage::NodeRecord* FlbImage::nodes() const {
+        return reinterpret_cast<const NodeRecord*> (_data + header().nodes.offset);
+    }
+
+    const FlbImage::Index* FlbImage::hedges() const {
+        return reinterpret_cast<const Index*> (_data + header().hedges.offset);
+    }
+
+    std::string FlbImage::shapeClassName(int shape) {
+        switch (shape) {
+            case MembershipKernel::TRIANGLE: return "Triangle";
+            case MembershipKernel::TRAPEZOID: return "Trapezoid";
+            case MembershipKernel::RECTANGLE: return "Rectangle";
+            case MembershipKernel::RAMP: return "Ramp";
+            case MembershipKernel::SSHAPE: return "SShape";
+            case MembershipKernel::ZSHAPE: return "ZShape";
+            case MembershipKernel::PISHAPE: return "PiShape";
+            case MembershipKernel::CONCAVE: return "Concave";
+            case MembershipKernel::CONSTANT: return "Constant";
+            case MembershipKernel::GAUSSIAN: return "Gaussian";
+            case MembershipKernel::GAUSSIAN_PRODUCT: return "GaussianProduct";
+            case MembershipKernel::BELL: return "Bell";
+            case MembershipKernel::SIGMOID: return "Sigmoid";
+            case MembershipKernel::SIGMOID_DIFFERENCE: return "SigmoidDifference";
+            case MembershipKernel::SIGMOID_PRODUCT: return "SigmoidProduct";
+            case MembershipKernel::SPIKE: return "Spike";
+            case MembershipKernel::COSINE: return "Cosine";
+            default: return "";
+        }
+    }
+
+    int FlbImage::shapeParameters(int shape) {
+        switch (shape) {
+            case MembershipKernel::CONSTANT:
+                return 1;
+            case MembershipKernel::RECTANGLE:
+            case MembershipKernel::RAMP:
+            case MembershipKernel::SSHAPE:
+            case MembershipKernel::ZSHAPE:
+            case MembershipKernel::CONCAVE:
+            case MembershipKernel::GAUSSIAN:
+            case MembershipKernel::SIGMOID:
+            case MembershipKernel::SPIKE:
+            case MembershipKernel::COSINE:
+                return 2;
+            case MembershipKernel::TRIANGLE:
+            case MembershipKernel::BELL:
+                return 3;
+            case MembershipKernel::TRAPEZOID:
+            case MembershipKernel::PISHAPE:
+            case MembershipKernel::GAUSSIAN_PRODUCT:
+            case MembershipKernel::SIGMOID_DIFFERENCE:
+            case MembershipKernel::SIGMOID_PRODUCT:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+}
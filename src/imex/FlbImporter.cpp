@@ -0,0 +1,360 @@
+// FlbImporter.cpp
+//
+// Purpose: Implementation of fl::FlbImporter.
+// Detail: Variables are created before any rule block, and Function terms are loaded only once every
+// variable exists, as their formulas may refer to any of them. Each rule owns the hedges of its propositions,
+// created once per rule as Rule::load() does.
+
+#include "fl/imex/FlbImporter.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/defuzzifier/AdaptiveDefuzzifier.h"
+#include "fl/defuzzifier/Defuzzifier.h"
+#include "fl/defuzzifier/ExactBisector.h"
+#include "fl/defuzzifier/ExactCentroid.h"
+#include "fl/defuzzifier/ExactLargestOfMaximum.h"
+#include "fl/defuzzifier/ExactMeanOfMaximum.h"
+#include "fl/defuzzifier/ExactSmallestOfMaximum.h"
+#include "fl/defuzzifier/IntegralDefuzzifier.h"
+#include "fl/defuzzifier/PrefixSumBisector.h"
+#include "fl/defuzzifier/WeightedDefuzzifier.h"
+#include "fl/factory/DefuzzifierFactory.h"
+#include "fl/factory/FactoryManager.h"
+#include "fl/factory/HedgeFactory.h"
+#include "fl/factory/SNormFactory.h"
+#include "fl/factory/TNormFactory.h"
+#include "fl/factory/TermFactory.h"
+#include "fl/hedge/Hedge.h"
+#include "fl/norm/SNorm.h"
+#include "fl/norm/TNorm.h"
+#include "fl/rule/Antecedent.h"
+#include "fl/rule/Consequent.h"
+#include "fl/rule/Expression.h"
+#include "fl/rule/Rule.h"
+#include "fl/rule/RuleBlock.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Bell.h"
+#include "fl/term/CompiledFunction.h"
+#include "fl/term/Concave.h"
+#include "fl/term/Constant.h"
+#include "fl/term/Cosine.h"
+#include "fl/term/Discrete.h"
+#include "fl/term/Function.h"
+#include "fl/term/Gaussian.h"
+#include "fl/term/GaussianProduct.h"
+#include "fl/term/Linear.h"
+#include "fl/term/MembershipKernel.h"
+#include "fl/term/PiShape.h"
+#include "fl/term/Ramp.h"
+#include "fl/term/Rectangle.h"
+#include "fl/term/SShape.h"
+#include "fl/term/Sigmoid.h"
+#include "fl/term/SigmoidDifference.h"
+#include "fl/term/SigmoidProduct.h"
+#include "fl/term/SortedDiscrete.h"
+#include "fl/term/Spike.h"
+#include "fl/term/Trapezoid.h"
+#include "fl/term/Triangle.h"
+#include "fl/term/ZShape.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+namespace fl {
+
+    /**
+     * Antecedent whose expression was read from a binary image.
+     */
+    class ImageAntecedent : public Antecedent {
+    public:
+
+        ImageAntecedent(const std::string& text, Expression* expression) : Antecedent() {
+            this->_text = text;
+            this->_expression = expression;
+        }
+    };
+
+    /**
+     * Consequent whose conclusions were read from a binary image.
+     */
+    class ImageConsequent : public Consequent {
+    public:
+
+        ImageConsequent(const std::string& text, const std::vector<Proposition*>& conclusions) : Consequent() {
+            this->_text = text;
+            this->_conclusions = conclusions;
+        }
+    };
+
+    FlbImporter::FlbImporter() : Importer() {
+    }
+
+    FlbImporter::~FlbImporter() {
+    }
+
+    std::string FlbImporter::name() const {
+        return "FlbImporter";
+    }
+
+    Engine* FlbImporter::fromString(const std::string& image) const {
+        FlbImage flb;
+        flb.view(image.data(), image.size());
+        return fromImage(flb);
+    }
+
+    Engine* FlbImporter::fromFile(const std::string& path) const {
+        FlbImage flb;
+        flb.map(path);
+        return fromImage(flb);
+    }
+
+    Engine* FlbImporter::fromImage(const FlbImage& image) const {
+        image.check();
+        const FlbImage::Header& header = image.header();
+        FL_unique_ptr<Engine> engine(new Engine(image.string(header.name)));
+
+        std::vector<Variable*> variables;
+        std::vector<Function*> functions;
+        for (FlbImage::Index i = 0; i < header.variables.count; ++i) {
+            const FlbImage::VariableRecord& record = image.variables()[i];
+            Variable* variable = fl::null;
+            if (i < header.numberOfInputs) {
+                InputVariable* inputVariable = new InputVariable(image.string(record.name),
+                        record.minimum, record.maximum);
+                engine->addInputVariable(inputVariable);
+                variable = inputVariable;
+            } else {
+                OutputVariable* outputVariable = new OutputVariable(image.string(record.name),
+                        record.minimum, record.maximum);
+                engine->addOutputVariable(outputVariable);
+                outputVariable->setDefaultValue(record.defaultValue);
+                outputVariable->setLockPreviousOutputValue(record.flags & FlbImage::LOCK_PREVIOUS_VALUE);
+                outputVariable->setLockOutputValueInRange(record.flags & FlbImage::LOCK_VALUE_IN_RANGE);
+                if (record.defuzzifier != FlbImage::None) {
+                    outputVariable->setDefuzzifier(buildDefuzzifier(image, record));
+                }
+                if (record.accumulation != FlbImage::None) {
+                    outputVariable->fuzzyOutput()->setAccumulation(
+                            FactoryManager::instance()->snorm()->constructObject(image.string(record.accumulation)));
+                }
+                variable = outputVariable;
+            }
+            variable->setEnabled(record.flags & FlbImage::ENABLED);
+            for (FlbImage::Index t = 0; t < record.numberOfTerms; ++t) {
+                const FlbImage::TermRecord& termRecord = image.terms()[record.firstTerm + t];
+                Term* term = buildTerm(image, termRecord, engine.get());
+                variable->addTerm(term);
+                if (termRecord.kind == FlbImage::FUNCTION and (termRecord.flags & FlbImage::LOADED)) {
+                    functions.push_back(dynamic_cast<Function*> (term));
+                }
+            }
+            variables.push_back(variable);
+        }
+        for (std::size_t i = 0; i < functions.size(); ++i) {
+            functions.at(i)->load(functions.at(i)->getFormula(), engine.get());
+        }
+
+        for (FlbImage::Index i = 0; i < header.ruleBlocks.count; ++i) {
+            const FlbImage::RuleBlockRecord& record = image.ruleBlocks()[i];
+            RuleBlock* ruleBlock = new RuleBlock(image.string(record.name));
+            engine->addRuleBlock(ruleBlock);
+            ruleBlock->setEnabled(record.flags & FlbImage::ENABLED);
+            if (record.conjunction != FlbImage::None) {
+                ruleBlock->setConjunction(FactoryManager::instance()->tnorm()->constructObject(
+                        image.string(record.conjunction)));
+            }
+            if (record.disjunction != FlbImage::None) {
+                ruleBlock->setDisjunction(FactoryManager::instance()->snorm()->constructObject(
+                        image.string(record.disjunction)));
+            }
+            if (record.activation != FlbImage::None) {
+                ruleBlock->setActivation(FactoryManager::instance()->tnorm()->constructObject(
+                        image.string(record.activation)));
+            }
+            for (FlbImage::Index r = 0; r < record.numberOfRules; ++r) {
+                ruleBlock->addRule(buildRule(image, image.rules()[record.firstRule + r], variables));
+            }
+        }
+        return engine.release();
+    }
+
+    Term* FlbImporter::buildTerm(const FlbImage& image, const FlbImage::TermRecord& record,
+            const Engine* engine) const {
+        const std::string name = image.string(record.name);
+        const std::string className = image.string(record.className);
+        const scalar* p = image.scalars() + record.firstScalar;
+        Term* result = fl::null;
+        if (record.kind == FlbImage::SHAPE) {
+            switch (record.shape) {
+                case MembershipKernel::TRIANGLE: result = new Triangle(name, p[0], p[1], p[2]);
+                    break;
+                case MembershipKernel::TRAPEZOID: result = new Trapezoid(name, p[0], p[1], p[2], p[3]);
+                    break;
+                case MembershipKernel::RECTANGLE: result = new Rectangle(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::RAMP: result = new Ramp(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::SSHAPE: result = new SShape(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::ZSHAPE: result = new ZShape(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::PISHAPE: result = new PiShape(name, p[0], p[1], p[2], p[3]);
+                    break;
+                case MembershipKernel::CONCAVE: result = new Concave(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::CONSTANT: result = new Constant(name, p[0]);
+                    break;
+                case MembershipKernel::GAUSSIAN: result = new Gaussian(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::GAUSSIAN_PRODUCT: result = new GaussianProduct(name, p[0], p[1], p[2], p[3]);
+                    break;
+                case MembershipKernel::BELL: result = new Bell(name, p[0], p[1], p[2]);
+                    break;
+                case MembershipKernel::SIGMOID: result = new Sigmoid(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::SIGMOID_DIFFERENCE: result = new SigmoidDifference(name, p[0], p[1], p[2], p[3]);
+                    break;
+                case MembershipKernel::SIGMOID_PRODUCT: result = new SigmoidProduct(name, p[0], p[1], p[2], p[3]);
+                    break;
+                case MembershipKernel::SPIKE: result = new Spike(name, p[0], p[1]);
+                    break;
+                case MembershipKernel::COSINE: result = new Cosine(name, p[0], p[1]);
+                    break;
+                default:
+                    throw fl::Exception("[import error] term <" + name + "> has an unknown shape", FL_AT);
+            }
+        } else if (record.kind == FlbImage::DISCRETE) {
+            std::vector<Discrete::Pair> xy(record.numberOfScalars / 2);
+            for (std::size_t i = 0; i < xy.size(); ++i) {
+                xy.at(i) = Discrete::Pair(p[2 * i], p[2 * i + 1]);
+            }
+            if (className == "SortedDiscrete") result = new SortedDiscrete(name, xy);
+            else result = new Discrete(name, xy);
+        } else if (record.kind == FlbImage::LINEAR) {
+            result = new Linear(name, std::vector<scalar>(p, p + record.numberOfScalars), engine);
+        } else if (record.kind == FlbImage::FUNCTION) {
+            //Loaded by fromImage() once every variable of the engine exists
+            if (className == "CompiledFunction") result = new CompiledFunction(name, image.string(record.text), engine);
+            else result = new Function(name, image.string(record.text), engine);
+        } else {
+            FL_unique_ptr<Term> term(constructTerm(className));
+            if (not term.get()) {
+                throw fl::Exception("[import error] term <" + className + "> not registered", FL_AT);
+            }
+            term->setName(name);
+            term->configure(image.string(record.text));
+            result = term.release();
+        }
+        result->setHeight(record.height);
+        return result;
+    }
+
+    Defuzzifier* FlbImporter::buildDefuzzifier(const FlbImage& image,
+            const FlbImage::VariableRecord& record) const {
+        const std::string className = image.string(record.defuzzifier);
+        Defuzzifier* result = constructDefuzzifier(className);
+        if (not result) {
+            throw fl::Exception("[import error] defuzzifier <" + className + "> not registered", FL_AT);
+        }
+        IntegralDefuzzifier* integral = dynamic_cast<IntegralDefuzzifier*> (result);
+        if (integral and record.resolution != FlbImage::None) {
+            integral->setResolution((int) record.resolution);
+        }
+        WeightedDefuzzifier* weighted = dynamic_cast<WeightedDefuzzifier*> (result);
+        if (weighted and record.type != FlbImage::None) {
+            weighted->setType((WeightedDefuzzifier::Type) record.type);
+        }
+        AdaptiveDefuzzifier* adaptive = dynamic_cast<AdaptiveDefuzzifier*> (result);
+        if (adaptive) {
+            if (record.type != FlbImage::None) adaptive->setMethod((AdaptiveDefuzzifier::Method) record.type);
+            if (not Op::isNaN(record.tolerance)) adaptive->setTolerance(record.tolerance);
+        }
+        return result;
+    }
+
+    Defuzzifier* FlbImporter::constructDefuzzifier(const std::string& className) const {
+        if (className == "ExactCentroid") return new ExactCentroid;
+        if (className == "ExactBisector") return new ExactBisector;
+        if (className == "ExactMeanOfMaximum") return new ExactMeanOfMaximum;
+        if (className == "ExactSmallestOfMaximum") return new ExactSmallestOfMaximum;
+        if (className == "ExactLargestOfMaximum") return new ExactLargestOfMaximum;
+        if (className == "PrefixSumBisector") return new PrefixSumBisector;
+        if (className == "AdaptiveDefuzzifier") return new AdaptiveDefuzzifier;
+        return FactoryManager::instance()->defuzzifier()->constructObject(className);
+    }
+
+    Term* FlbImporter::constructTerm(const std::string& className) const {
+        if (className == "SortedDiscrete") return new SortedDiscrete;
+        if (className == "CompiledFunction") return new CompiledFunction;
+        return FactoryManager::instance()->term()->constructObject(className);
+    }
+
+    Rule* FlbImporter::buildRule(const FlbImage& image, const FlbImage::RuleRecord& record,
+            const std::vector<Variable*>& variables) const {
+        FL_unique_ptr<Rule> rule(new Rule(image.string(record.text), record.weight));
+        if (not (record.flags & FlbImage::LOADED)) return rule.release();
+
+        //FlbImage::check() guarantees the postfix antecedent leaves exactly one expression
+        std::vector<Expression*> expressions;
+        std::vector<Proposition*> conclusions;
+        try {
+            for (FlbImage::Index n = 0; n < record.numberOfNodes; ++n) {
+                const FlbImage::NodeRecord& node = image.nodes()[record.firstNode + n];
+                if (node.code == FlbImage::PROPOSITION) {
+                    expressions.push_back(buildProposition(image, node, variables, rule.get()));
+                    continue;
+                }
+                Operator* fuzzyOperator = new Operator;
+                fuzzyOperator->name = (node.code == FlbImage::CONJUNCTION) ? Rule::andKeyword() : Rule::orKeyword();
+                fuzzyOperator->right = expressions.back();
+                expressions.pop_back();
+                fuzzyOperator->left = expressions.back();
+                expressions.back() = fuzzyOperator;
+            }
+            for (FlbImage::Index n = 0; n < record.numberOfConclusions; ++n) {
+                const FlbImage::NodeRecord& node = image.nodes()[record.firstNode + record.numberOfNodes + n];
+                conclusions.push_back(buildProposition(image, node, variables, rule.get()));
+            }
+        } catch (...) {
+            for (std::size_t i = 0; i < expressions.size(); ++i) {
+                delete expressions.at(i);
+            }
+            for (std::size_t i = 0; i < conclusions.size(); ++i) {
+                delete conclusions.at(i);
+            }
+            throw;
+        }
+        rule->setAntecedent(new ImageAntecedent(image.string(record.antecedent), expressions.front()));
+        rule->setConsequent(new ImageConsequent(image.string(record.consequent), conclusions));
+        return rule.release();
+    }
+
+    Proposition* FlbImporter::buildProposition(const FlbImage& image, const FlbImage::NodeRecord& record,
+            const std::vector<Variable*>& variables, Rule* rule) const {
+        FL_unique_ptr<Proposition> proposition(new Proposition);
+        proposition->variable = variables.at(record.variable);
+        if (record.term != FlbImage::None) {
+            proposition->term = proposition->variable->getTerm((int) record.term);
+        }
+        for (FlbImage::Index i = 0; i < record.numberOfHedges; ++i) {
+            const std::string name = image.string(image.hedges()[record.firstHedge + i]);
+            //Every rule owns its hedges, so each hedge is created once per rule that uses it
+            Hedge* hedge = fl::null;
+            if (rule->hasHedge(name)) hedge = rule->getHedge(name);
+            if (not hedge) {
+                hedge = FactoryManager::instance()->hedge()->constructObject(name);
+                if (not hedge) {
+                    throw fl::Exception("[import error] hedge <" + name + "> not registered", FL_AT);
+                }
+                rule->addHedge(hedge);
+            }
+            proposition->hedges.push_back(hedge);
+        }
+        return proposition.release();
+    }
+
+    FlbImporter* FlbImporter::clone() const {
+        return new FlbImporter(*this);
+    }
+
+}
@@ -0,0 +1,1282 @@
+// KernelExporter.cpp
+//
+// Purpose: Implementation of fl::KernelExporter.
+// Detail: The helper functions of the exported code are the scalar forms of the membership functions of
+// MembershipKernel, the norms of CompiledEngine and the sampling loops of AccumulatedKernel, and every
+// helper is written only if the engine calls it. The fuzzy output of a Mamdani output keeps the degree of
+// every conclusion on it in rule order, zero for the ones that did not fire, which leaves the accumulation
+// unchanged; with Maximum accumulation of Minimum or AlgebraicProduct activations, the conclusions on the
+// same term are merged into their maximum degree beforehand, which gives the same membership with fewer terms.
+// The Exact* defuzzifiers are integrated in closed form, by walking the upper envelope of the activated terms
+// between their vertices as PiecewiseLinear does, on arrays whose size is fixed by the number of terms; they
+// are sampled like the stock ones where PiecewiseLinear does not apply, as they fall back to sampling there.
+// PrefixSumBisector sums the samples of the fuzzy output twice, to find half of the area and then the cell
+// that reaches it, instead of keeping them all as SampledArea does.
+
+#include "fl/imex/KernelExporter.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/defuzzifier/Defuzzifier.h"
+#include "fl/defuzzifier/IntegralDefuzzifier.h"
+#include "fl/defuzzifier/PiecewiseLinear.h"
+#include "fl/defuzzifier/WeightedDefuzzifier.h"
+#include "fl/hedge/Hedge.h"
+#include "fl/norm/SNorm.h"
+#include "fl/norm/TNorm.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Constant.h"
+#include "fl/term/Linear.h"
+#include "fl/term/MembershipKernel.h"
+#include "fl/term/Term.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace fl {
+
+    /**
+     * The source of a helper function of the exported code, in the order the helpers are written.
+     */
+    struct KernelHelper {
+        const char* name;
+        const char* source;
+    };
+
+    static const KernelHelper kernelHelpers[] = {
+        {"fl_algebraicSum",
+            "    inline double fl_algebraicSum(double a, double b) {\n"
+            "        return a + b - (a * b);\n"
+            "    }\n"},
+        {"fl_boundedDifference",
+            "    inline double fl_boundedDifference(double a, double b) {\n"
+            "        const double x = a + b - 1.0;\n"
+            "        return x > 0.0 ? x : 0.0;\n"
+            "    }\n"},
+        {"fl_boundedSum",
+            "    inline double fl_boundedSum(double a, double b) {\n"
+            "        const double x = a + b;\n"
+            "        return x < 1.0 ? x : 1.0;\n"
+            "    }\n"},
+        {"fl_bound",
+            "    inline double fl_bound(double x, double minimum, double maximum) {\n"
+            "        if (fl_isGt(x, maximum)) return maximum;\n"
+            "        if (fl_isLt(x, minimum)) return minimum;\n"
+            "        return x;\n"
+            "    }\n"},
+        {"fl_not",
+            "    inline double fl_not(double x) {\n"
+            "        return 1.0 - x;\n"
+            "    }\n"},
+        {"fl_seldom",
+            "    inline double fl_seldom(double x) {\n"
+            "        return fl_isLE(x, 0.5) ? std::sqrt(x / 2.0) : 1.0 - std::sqrt((1.0 - x) / 2.0);\n"
+            "    }\n"},
+        {"fl_somewhat",
+            "    inline double fl_somewhat(double x) {\n"
+            "        return std::sqrt(x);\n"
+            "    }\n"},
+        {"fl_very",
+            "    inline double fl_very(double x) {\n"
+            "        return x * x;\n"
+            "    }\n"},
+        {"fl_extremely",
+            "    inline double fl_extremely(double x) {\n"
+            "        return fl_isLE(x, 0.5) ? 2.0 * x * x : 1.0 - 2.0 * (1.0 - x) * (1.0 - x);\n"
+            "    }\n"},
+        {"fl_triangle",
+            "    inline double fl_triangle(double x, double a, double b, double c, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        if (fl_isLt(x, a) || fl_isGt(x, c)) return h * 0.0;\n"
+            "        if (fl_isEq(x, b)) return h * 1.0;\n"
+            "        if (fl_isLt(x, b)) return h * (x - a) / (b - a);\n"
+            "        return h * (c - x) / (c - b);\n"
+            "    }\n"},
+        {"fl_trapezoid",
+            "    inline double fl_trapezoid(double x, double a, double b, double c, double d, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        if (fl_isLt(x, a) || fl_isGt(x, d)) return h * 0.0;\n"
+            "        if (fl_isLt(x, b)) return h * fl_min((x - a) / (b - a), 1.0);\n"
+            "        if (fl_isLE(x, c)) return h * 1.0;\n"
+            "        if (fl_isLt(x, d)) return h * (d - x) / (d - c);\n"
+            "        return h * 0.0;\n"
+            "    }\n"},
+        {"fl_rectangle",
+            "    inline double fl_rectangle(double x, double a, double b, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        return (fl_isLt(x, a) || fl_isGt(x, b)) ? h * 0.0 : h * 1.0;\n"
+            "    }\n"},
+        {"fl_ramp",
+            "    inline double fl_ramp(double x, double a, double b, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        if (fl_isEq(a, b)) return h * 0.0;\n"
+            "        if (fl_isLt(a, b)) {\n"
+            "            if (fl_isLE(x, a)) return h * 0.0;\n"
+            "            if (fl_isGE(x, b)) return h * 1.0;\n"
+            "            return h * (x - a) / (b - a);\n"
+            "        }\n"
+            "        if (fl_isGE(x, a)) return h * 0.0;\n"
+            "        if (fl_isLE(x, b)) return h * 1.0;\n"
+            "        return h * (a - x) / (a - b);\n"
+            "    }\n"},
+        {"fl_sShape",
+            "    inline double fl_sShape(double x, double a, double b, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        if (fl_isLE(x, a)) return h * 0.0;\n"
+            "        if (fl_isLE(x, (a + b) / 2.0)) {\n"
+            "            const double r = (x - a) / (b - a);\n"
+            "            return (h * 2.0) * (r * r);\n"
+            "        }\n"
+            "        if (fl_isLt(x, b)) {\n"
+            "            const double f = (x - b) / (b - a);\n"
+            "            return h * (1.0 - 2.0 * (f * f));\n"
+            "        }\n"
+            "        return h * 1.0;\n"
+            "    }\n"},
+        {"fl_zShape",
+            "    inline double fl_zShape(double x, double a, double b, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        if (fl_isLE(x, a)) return h * 1.0;\n"
+            "        if (fl_isLE(x, (a + b) / 2.0)) {\n"
+            "            const double r = (x - a) / (b - a);\n"
+            "            return h * (1.0 - 2.0 * (r * r));\n"
+            "        }\n"
+            "        if (fl_isLt(x, b)) {\n"
+            "            const double f = (x - b) / (b - a);\n"
+            "            return (h * 2.0) * (f * f);\n"
+            "        }\n"
+            "        return h * 0.0;\n"
+            "    }\n"},
+        {"fl_piShape",
+            "    inline double fl_piShape(double x, double a, double b, double c, double d, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        double s = 1.0, z = 0.0;\n"
+            "        if (fl_isLE(x, a)) {\n"
+            "            s = 0.0;\n"
+            "        } else if (fl_isLE(x, 0.5 * (a + b))) {\n"
+            "            const double t = (x - a) / (b - a);\n"
+            "            s = 2.0 * (t * t);\n"
+            "        } else if (fl_isLt(x, b)) {\n"
+            "            const double u = (x - b) / (b - a);\n"
+            "            s = 1.0 - 2.0 * (u * u);\n"
+            "        }\n"
+            "        if (fl_isLE(x, c)) {\n"
+            "            z = 1.0;\n"
+            "        } else if (fl_isLE(x, 0.5 * (c + d))) {\n"
+            "            const double t = (x - c) / (d - c);\n"
+            "            z = 1.0 - 2.0 * (t * t);\n"
+            "        } else if (fl_isLt(x, d)) {\n"
+            "            const double u = (x - d) / (d - c);\n"
+            "            z = 2.0 * (u * u);\n"
+            "        }\n"
+            "        return (h * s) * z;\n"
+            "    }\n"},
+        {"fl_concave",
+            "    inline double fl_concave(double x, double a, double b, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        if (fl_isLE(a, b)) return fl_isLt(x, b) ? (h * (b - a)) / ((2.0 * b - a) - x) : h * 1.0;\n"
+            "        return fl_isGt(x, b) ? (h * (a - b)) / ((a - 2.0 * b) + x) : h * 1.0;\n"
+            "    }\n"},
+        {"fl_gaussian",
+            "    inline double fl_gaussian(double x, double mean, double deviation, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        return h * std::exp((-(x - mean) * (x - mean)) / (2 * deviation * deviation));\n"
+            "    }\n"},
+        {"fl_gaussianProduct",
+            "    inline double fl_gaussianProduct(double x, double meanA, double deviationA,\n"
+            "            double meanB, double deviationB, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        const bool xLEa = fl_isLE(x, meanA);\n"
+            "        const double a = std::exp((-(x - meanA) * (x - meanA)) / (2 * deviationA * deviationA))\n"
+            "                * xLEa + (1 - xLEa);\n"
+            "        const bool xGEb = fl_isGE(x, meanB);\n"
+            "        const double b = std::exp((-(x - meanB) * (x - meanB)) / (2 * deviationB * deviationB))\n"
+            "                * xGEb + (1 - xGEb);\n"
+            "        return h * a * b;\n"
+            "    }\n"},
+        {"fl_bell",
+            "    inline double fl_bell(double x, double center, double width, double slope, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        return h * (1.0 / (1.0 + std::pow(std::fabs((x - center) / width), 2 * slope)));\n"
+            "    }\n"},
+        {"fl_sigmoid",
+            "    inline double fl_sigmoid(double x, double inflection, double slope, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        return h * 1.0 / (1.0 + std::exp(-slope * (x - inflection)));\n"
+            "    }\n"},
+        {"fl_sigmoidDifference",
+            "    inline double fl_sigmoidDifference(double x, double left, double rising,\n"
+            "            double falling, double right, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        const double a = 1.0 / (1 + std::exp(-rising * (x - left)));\n"
+            "        const double b = 1.0 / (1 + std::exp(-falling * (x - right)));\n"
+            "        return h * std::fabs(a - b);\n"
+            "    }\n"},
+        {"fl_sigmoidProduct",
+            "    inline double fl_sigmoidProduct(double x, double left, double rising,\n"
+            "            double falling, double right, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        const double a = 1.0 / (1 + std::exp(-rising * (x - left)));\n"
+            "        const double b = 1.0 / (1 + std::exp(-falling * (x - right)));\n"
+            "        return h * a * b;\n"
+            "    }\n"},
+        {"fl_spike",
+            "    inline double fl_spike(double x, double center, double width, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        return h * std::exp(-std::fabs((10.0 / width) * (x - center)));\n"
+            "    }\n"},
+        {"fl_cosine",
+            "    inline double fl_cosine(double x, double center, double width, double h) {\n"
+            "        if (x != x) return fl_nan;\n"
+            "        if (fl_isLt(x, center - width / 2.0) || fl_isGt(x, center + width / 2.0)) return h * 0.0;\n"
+            "        const double frequency = 2.0 / width * (4.0 * std::atan(1.0));\n"
+            "        return h * 0.5 * (1.0 + std::cos(frequency * (x - center)));\n"
+            "    }\n"},
+        {"fl_centroid",
+            "    template <typename FuzzyOutput>\n"
+            "    double fl_centroid(const FuzzyOutput& mu, double minimum, double maximum, int resolution) {\n"
+            "        const double dx = (maximum - minimum) / resolution;\n"
+            "        double area = 0.0, xcentroid = 0.0;\n"
+            "        for (int i = 0; i < resolution; ++i) {\n"
+            "            const double x = minimum + (i + 0.5) * dx;\n"
+            "            const double y = mu(x);\n"
+            "            xcentroid += y * x;\n"
+            "            area += y;\n"
+            "        }\n"
+            "        return xcentroid / area;\n"
+            "    }\n"},
+        {"fl_bisector",
+            "    template <typename FuzzyOutput>\n"
+            "    double fl_bisector(const FuzzyOutput& mu, double minimum, double maximum, int resolution) {\n"
+            "        const double dx = (maximum - minimum) / resolution;\n"
+            "        int counter = resolution, left = 0, right = 0;\n"
+            "        double leftArea = 0.0, rightArea = 0.0;\n"
+            "        double xLeft = minimum, xRight = maximum;\n"
+            "        while (counter-- > 0) {\n"
+            "            if (fl_isLE(leftArea, rightArea)) {\n"
+            "                xLeft = minimum + (left + 0.5) * dx;\n"
+            "                leftArea += mu(xLeft);\n"
+            "                ++left;\n"
+            "            } else {\n"
+            "                xRight = maximum - (right + 0.5) * dx;\n"
+            "                rightArea += mu(xRight);\n"
+            "                ++right;\n"
+            "            }\n"
+            "        }\n"
+            "        return (leftArea * xRight + rightArea * xLeft) / (leftArea + rightArea);\n"
+            "    }\n"},
+        {"fl_meanOfMaximum",
+            "    template <typename FuzzyOutput>\n"
+            "    double fl_meanOfMaximum(const FuzzyOutput& mu, double minimum, double maximum, int resolution) {\n"
+            "        const double dx = (maximum - minimum) / resolution;\n"
+            "        double ymax = -1.0, xsmallest = minimum, xlargest = maximum;\n"
+            "        bool samePlateau = false;\n"
+            "        for (int i = 0; i < resolution; ++i) {\n"
+            "            const double x = minimum + (i + 0.5) * dx;\n"
+            "            const double y = mu(x);\n"
+            "            if (fl_isGt(y, ymax)) {\n"
+            "                ymax = y;\n"
+            "                xsmallest = x;\n"
+            "                xlargest = x;\n"
+            "                samePlateau = true;\n"
+            "            } else if (fl_isEq(y, ymax) && samePlateau) {\n"
+            "                xlargest = x;\n"
+            "            } else if (fl_isLt(y, ymax)) {\n"
+            "                samePlateau = false;\n"
+            "            }\n"
+            "        }\n"
+            "        return (xlargest + xsmallest) / 2.0;\n"
+            "    }\n"},
+        {"fl_smallestOfMaximum",
+            "    template <typename FuzzyOutput>\n"
+            "    double fl_smallestOfMaximum(const FuzzyOutput& mu, double minimum, double maximum, int resolution) {\n"
+            "        const double dx = (maximum - minimum) / resolution;\n"
+            "        double ymax = -1.0, xsmallest = minimum;\n"
+            "        for (int i = 0; i < resolution; ++i) {\n"
+            "            const double x = minimum + (i + 0.5) * dx;\n"
+            "            const double y = mu(x);\n"
+            "            if (fl_isGt(y, ymax)) {\n"
+            "                xsmallest = x;\n"
+            "                ymax = y;\n"
+            "            }\n"
+            "        }\n"
+            "        return xsmallest;\n"
+            "    }\n"},
+        {"fl_largestOfMaximum",
+            "    template <typename FuzzyOutput>\n"
+            "    double fl_largestOfMaximum(const FuzzyOutput& mu, double minimum, double maximum, int resolution) {\n"
+            "        const double dx = (maximum - minimum) / resolution;\n"
+            "        double ymax = -1.0, xlargest = maximum;\n"
+            "        for (int i = 0; i < resolution; ++i) {\n"
+            "            const double x = minimum + (i + 0.5) * dx;\n"
+            "            const double y = mu(x);\n"
+            "            if (fl_isGE(y, ymax)) {\n"
+            "                ymax = y;\n"
+            "                xlargest = x;\n"
+            "            }\n"
+            "        }\n"
+            "        return xlargest;\n"
+            "    }\n"},
+        {"fl_pieces",
+            "    //A piecewise-linear term as fl::PiecewiseLinear::Polyline reads it, clipped or scaled by its degree\n"
+            "    struct fl_Polyline {\n"
+            "        double x[4], y[4];\n"
+            "        int size;\n"
+            "        double left, right;\n"
+            "        bool clipped;\n"
+            "    };\n"
+            "\n"
+            "    inline void fl_line(const fl_Polyline& polyline, double point, double origin,\n"
+            "            double& value, double& slope) {\n"
+            "        slope = 0.0;\n"
+            "        if (polyline.size == 0) {\n"
+            "            value = 0.0;\n"
+            "            return;\n"
+            "        }\n"
+            "        if (point < polyline.x[0]) {\n"
+            "            value = polyline.left;\n"
+            "            return;\n"
+            "        }\n"
+            "        for (int i = 0; i + 1 < polyline.size; ++i) {\n"
+            "            if (point <= polyline.x[i + 1]) {\n"
+            "                slope = (polyline.y[i + 1] - polyline.y[i]) / (polyline.x[i + 1] - polyline.x[i]);\n"
+            "                value = polyline.y[i] + slope * (origin - polyline.x[i]);\n"
+            "                return;\n"
+            "            }\n"
+            "        }\n"
+            "        value = polyline.right;\n"
+            "    }\n"
+            "\n"
+            "    //Visits the pieces of the Maximum of the activated polylines in order, as fl::PiecewiseLinear::build()\n"
+            "    template <int N, typename Visitor>\n"
+            "    void fl_pieces(const fl_Polyline (&polylines)[N], const double* degrees,\n"
+            "            double minimum, double maximum, Visitor& visit) {\n"
+            "        double breakpoints[7 * N + 2];\n"
+            "        int size = 0;\n"
+            "        breakpoints[size++] = minimum;\n"
+            "        breakpoints[size++] = maximum;\n"
+            "        for (int i = 0; i < N; ++i) {\n"
+            "            const fl_Polyline& polyline = polylines[i];\n"
+            "            for (int v = 0; v < polyline.size; ++v) {\n"
+            "                breakpoints[size++] = polyline.x[v];\n"
+            "            }\n"
+            "            for (int v = 0; polyline.clipped && v + 1 < polyline.size; ++v) {\n"
+            "                const double y1 = polyline.y[v], y2 = polyline.y[v + 1], degree = degrees[i];\n"
+            "                if ((y1 < degree && degree < y2) || (y2 < degree && degree < y1)) {\n"
+            "                    breakpoints[size++] = polyline.x[v]\n"
+            "                            + (degree - y1) / (y2 - y1) * (polyline.x[v + 1] - polyline.x[v]);\n"
+            "                }\n"
+            "            }\n"
+            "        }\n"
+            "        for (int i = 1; i < size; ++i) {\n"
+            "            const double breakpoint = breakpoints[i];\n"
+            "            int j = i;\n"
+            "            for (; j > 0 && breakpoint < breakpoints[j - 1]; --j) {\n"
+            "                breakpoints[j] = breakpoints[j - 1];\n"
+            "            }\n"
+            "            breakpoints[j] = breakpoint;\n"
+            "        }\n"
+            "        int unique = 0;\n"
+            "        for (int i = 0; i < size; ++i) {\n"
+            "            if (unique == 0 || breakpoints[i] != breakpoints[unique - 1]) {\n"
+            "                breakpoints[unique++] = breakpoints[i];\n"
+            "            }\n"
+            "        }\n"
+            "\n"
+            "        double values[N + 1], slopes[N + 1];\n"
+            "        for (int b = 0; b + 1 < unique; ++b) {\n"
+            "            const double start = breakpoints[b], end = breakpoints[b + 1];\n"
+            "            if (end <= minimum || start >= maximum) continue;\n"
+            "            int lines = 1;\n"
+            "            values[0] = 0.0;\n"
+            "            slopes[0] = 0.0;\n"
+            "            const double middle = 0.5 * (start + end);\n"
+            "            for (int i = 0; i < N; ++i) {\n"
+            "                const fl_Polyline& polyline = polylines[i];\n"
+            "                const double supportStart = polyline.size == 0 ? fl_inf\n"
+            "                        : (polyline.left == 0.0 ? polyline.x[0] : -fl_inf);\n"
+            "                const double supportEnd = polyline.size == 0 ? -fl_inf\n"
+            "                        : (polyline.right == 0.0 ? polyline.x[polyline.size - 1] : fl_inf);\n"
+            "                if (supportEnd <= start || supportStart >= end) continue;\n"
+            "                double value, slope;\n"
+            "                fl_line(polyline, middle, start, value, slope);\n"
+            "                if (!polyline.clipped) {\n"
+            "                    value *= degrees[i];\n"
+            "                    slope *= degrees[i];\n"
+            "                } else if (value + slope * (middle - start) > degrees[i]) {\n"
+            "                    value = degrees[i];\n"
+            "                    slope = 0.0;\n"
+            "                }\n"
+            "                values[lines] = value;\n"
+            "                slopes[lines] = slope;\n"
+            "                ++lines;\n"
+            "            }\n"
+            "            //Upper envelope: the next line on top is the first steeper one to cross the current one\n"
+            "            int current = 0;\n"
+            "            for (int i = 1; i < lines; ++i) {\n"
+            "                if (values[i] > values[current]\n"
+            "                        || (values[i] == values[current] && slopes[i] > slopes[current])) {\n"
+            "                    current = i;\n"
+            "                }\n"
+            "            }\n"
+            "            double offset = 0.0;\n"
+            "            const double length = end - start;\n"
+            "            while (true) {\n"
+            "                int next = current;\n"
+            "                double crossing = length;\n"
+            "                for (int i = 0; i < lines; ++i) {\n"
+            "                    if (slopes[i] <= slopes[current]) continue;\n"
+            "                    const double t = (values[current] - values[i]) / (slopes[i] - slopes[current]);\n"
+            "                    if (t > offset && (t < crossing || (t == crossing && slopes[i] > slopes[next]))) {\n"
+            "                        crossing = t;\n"
+            "                        next = i;\n"
+            "                    }\n"
+            "                }\n"
+            "                const double pieceStart = start + offset;\n"
+            "                const double pieceEnd = (next == current) ? end : start + crossing;\n"
+            "                if (pieceEnd > pieceStart) {\n"
+            "                    visit(pieceStart, pieceEnd, values[current] + slopes[current] * offset, slopes[current]);\n"
+            "                }\n"
+            "                if (next == current) break;\n"
+            "                offset = crossing;\n"
+            "                current = next;\n"
+            "            }\n"
+            "        }\n"
+            "    }\n"
+            "\n"
+            "    struct fl_PieceArea {\n"
+            "        double area, moment;\n"
+            "\n"
+            "        void operator()(double start, double end, double value, double slope) {\n"
+            "            const double length = end - start;\n"
+            "            const double pieceArea = length * (value + 0.5 * slope * length);\n"
+            "            area += pieceArea;\n"
+            "            moment += start * pieceArea + length * length * (0.5 * value + slope * length / 3.0);\n"
+            "        }\n"
+            "    };\n"
+            "\n"
+            "    struct fl_PieceBisector {\n"
+            "        double half, accumulated, x;\n"
+            "        bool found;\n"
+            "\n"
+            "        void operator()(double start, double end, double value, double slope) {\n"
+            "            if (found) return;\n"
+            "            const double length = end - start;\n"
+            "            const double pieceArea = length * (value + 0.5 * slope * length);\n"
+            "            x = end;\n"
+            "            if (accumulated + pieceArea >= half && pieceArea > 0.0) {\n"
+            "                //Solve value * t + slope * t^2 / 2 = remaining for t in the stable form of the quadratic\n"
+            "                const double remaining = half - accumulated;\n"
+            "                const double discriminant = value * value + 2.0 * slope * remaining;\n"
+            "                const double denominator = value + std::sqrt(discriminant > 0.0 ? discriminant : 0.0);\n"
+            "                const double t = denominator > 0.0 ? 2.0 * remaining / denominator : 0.0;\n"
+            "                x = (end < start + t) ? end : start + t;\n"
+            "                found = true;\n"
+            "            }\n"
+            "            accumulated += pieceArea;\n"
+            "        }\n"
+            "    };\n"
+            "\n"
+            "    struct fl_PieceHighest {\n"
+            "        double highest;\n"
+            "        int pieces;\n"
+            "\n"
+            "        void operator()(double start, double end, double value, double slope) {\n"
+            "            highest = fl_max(highest, fl_max(value, value + slope * (end - start)));\n"
+            "            ++pieces;\n"
+            "        }\n"
+            "    };\n"
+            "\n"
+            "    //The first and last points at the highest value, and the first plateau at it\n"
+            "    struct fl_PieceMaximum {\n"
+            "        double highest, smallest, largest, plateauStart, plateauEnd;\n"
+            "        int plateau;\n"
+            "\n"
+            "        void operator()(double start, double end, double value, double slope) {\n"
+            "            const bool first = fl_isEq(value, highest);\n"
+            "            const bool last = fl_isEq(value + slope * (end - start), highest);\n"
+            "            if (smallest != smallest && (first || last)) smallest = first ? start : end;\n"
+            "            if (first || last) largest = last ? end : start;\n"
+            "            if (plateau == 0 && (first || last)) {\n"
+            "                plateauStart = plateauEnd = first ? start : end;\n"
+            "                plateau = 1;\n"
+            "                if (!first) return;\n"
+            "            }\n"
+            "            if (plateau == 1) {\n"
+            "                if (start != plateauEnd || !first || !last) plateau = 2;\n"
+            "                else plateauEnd = end;\n"
+            "            }\n"
+            "        }\n"
+            "    };\n"},
+        {"fl_exactCentroid",
+            "    template <int N>\n"
+            "    double fl_exactCentroid(const fl_Polyline (&polylines)[N], const double* degrees,\n"
+            "            double minimum, double maximum) {\n"
+            "        fl_PieceArea area = {0.0, 0.0};\n"
+            "        fl_pieces(polylines, degrees, minimum, maximum, area);\n"
+            "        return area.moment / area.area;\n"
+            "    }\n"},
+        {"fl_exactBisector",
+            "    template <int N>\n"
+            "    double fl_exactBisector(const fl_Polyline (&polylines)[N], const double* degrees,\n"
+            "            double minimum, double maximum) {\n"
+            "        fl_PieceArea area = {0.0, 0.0};\n"
+            "        fl_pieces(polylines, degrees, minimum, maximum, area);\n"
+            "        fl_PieceBisector bisector = {0.5 * area.area, 0.0, fl_nan, false};\n"
+            "        if (!(bisector.half > 0.0)) return fl_nan;\n"
+            "        fl_pieces(polylines, degrees, minimum, maximum, bisector);\n"
+            "        return bisector.x;\n"
+            "    }\n"},
+        {"fl_exactMaximum",
+            "    template <int N>\n"
+            "    fl_PieceMaximum fl_exactMaximum(const fl_Polyline (&polylines)[N], const double* degrees,\n"
+            "            double minimum, double maximum) {\n"
+            "        fl_PieceHighest highest = {-fl_inf, 0};\n"
+            "        fl_pieces(polylines, degrees, minimum, maximum, highest);\n"
+            "        fl_PieceMaximum result = {highest.pieces == 0 ? fl_nan : highest.highest,\n"
+            "            fl_nan, fl_nan, fl_nan, fl_nan, 0};\n"
+            "        if (highest.pieces > 0) fl_pieces(polylines, degrees, minimum, maximum, result);\n"
+            "        return result;\n"
+            "    }\n"},
+        {"fl_exactMeanOfMaximum",
+            "    template <int N>\n"
+            "    double fl_exactMeanOfMaximum(const fl_Polyline (&polylines)[N], const double* degrees,\n"
+            "            double minimum, double maximum) {\n"
+            "        const fl_PieceMaximum maximumPieces = fl_exactMaximum(polylines, degrees, minimum, maximum);\n"
+            "        return 0.5 * (maximumPieces.plateauStart + maximumPieces.plateauEnd);\n"
+            "    }\n"},
+        {"fl_exactSmallestOfMaximum",
+            "    template <int N>\n"
+            "    double fl_exactSmallestOfMaximum(const fl_Polyline (&polylines)[N], const double* degrees,\n"
+            "            double minimum, double maximum) {\n"
+            "        return fl_exactMaximum(polylines, degrees, minimum, maximum).smallest;\n"
+            "    }\n"},
+        {"fl_exactLargestOfMaximum",
+            "    template <int N>\n"
+            "    double fl_exactLargestOfMaximum(const fl_Polyline (&polylines)[N], const double* degrees,\n"
+            "            double minimum, double maximum) {\n"
+            "        return fl_exactMaximum(polylines, degrees, minimum, maximum).largest;\n"
+            "    }\n"},
+        {"fl_prefixSumBisector",
+            "    template <typename FuzzyOutput>\n"
+            "    double fl_prefixSumBisector(const FuzzyOutput& mu, double minimum, double maximum, int resolution) {\n"
+            "        const double dx = (maximum - minimum) / resolution;\n"
+            "        double area = 0.0;\n"
+            "        for (int i = 0; i < resolution; ++i) {\n"
+            "            area += mu(minimum + (i + 0.5) * dx);\n"
+            "        }\n"
+            "        const double half = 0.5 * area;\n"
+            "        if (!(half > 0.0) || half == fl_inf) return fl_nan;\n"
+            "        //The first cell whose right edge reaches half of the area, summed again in the same order\n"
+            "        double cumulative = 0.0;\n"
+            "        for (int i = 0; i < resolution; ++i) {\n"
+            "            const double y = mu(minimum + (i + 0.5) * dx);\n"
+            "            if (cumulative + y >= half) {\n"
+            "                const double x = minimum + (i + (half - cumulative) / y) * dx;\n"
+            "                return (maximum < x) ? maximum : x;\n"
+            "            }\n"
+            "            cumulative += y;\n"
+            "        }\n"
+            "        return maximum;\n"
+            "    }\n"}
+    };
+
+    /**
+     * An activated term in the fuzzy output of a Mamdani output variable of the exported engine.
+     */
+    struct KernelActivation {
+        const Term* term;
+        CompiledEngine::NormCode activation;
+    };
+
+    KernelExporter::KernelExporter() : Exporter(), _checkSamples(100) {
+
+    }
+
+    KernelExporter::~KernelExporter() {
+
+    }
+
+    std::string KernelExporter::name() const {
+        return "KernelExporter";
+    }
+
+    void KernelExporter::setCheckSamples(int checkSamples) {
+        this->_checkSamples = checkSamples;
+    }
+
+    int KernelExporter::getCheckSamples() const {
+        return this->_checkSamples;
+    }
+
+    std::string KernelExporter::identifier(const std::string& name) const {
+        std::string result;
+        for (std::size_t i = 0; i < name.size(); ++i) {
+            const char c = name.at(i);
+            const bool valid = (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9');
+            result.push_back(valid ? c : '_');
+        }
+        if (result.empty() or (result.at(0) >= '0' and result.at(0) <= '9')) {
+            result = "fl_" + result;
+        }
+        return result;
+    }
+
+    std::string KernelExporter::literal(scalar value) const {
+        if (Op::isNaN(value)) return "fl_nan";
+        if (Op::isInf(value)) return value < 0.0 ? "-fl_inf" : "fl_inf";
+        std::ostringstream ss;
+        ss << std::setprecision(17) << (double) value;
+        std::string result = ss.str();
+        if (result.find_first_of(".e") == std::string::npos) result += ".0";
+        return result;
+    }
+
+    std::string KernelExporter::membership(const MembershipKernel& kernel, const std::string& x,
+            std::set<std::string>& functions) const {
+        const scalar* p = kernel.getParameters();
+        std::string function;
+        int numberOfParameters = 0;
+        switch (kernel.getShape()) {
+            case MembershipKernel::TRIANGLE:
+                function = "fl_triangle";
+                numberOfParameters = 3;
+                break;
+            case MembershipKernel::TRAPEZOID:
+                function = "fl_trapezoid";
+                numberOfParameters = 4;
+                break;
+            case MembershipKernel::RECTANGLE:
+                function = "fl_rectangle";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::RAMP:
+                function = "fl_ramp";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::SSHAPE:
+                function = "fl_sShape";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::ZSHAPE:
+                function = "fl_zShape";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::PISHAPE:
+                function = "fl_piShape";
+                numberOfParameters = 4;
+                break;
+            case MembershipKernel::CONCAVE:
+                function = "fl_concave";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::CONSTANT:
+                //Constant ignores its input and its height
+                return literal(p[0]);
+            case MembershipKernel::GAUSSIAN:
+                function = "fl_gaussian";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::GAUSSIAN_PRODUCT:
+                function = "fl_gaussianProduct";
+                numberOfParameters = 4;
+                break;
+            case MembershipKernel::BELL:
+                function = "fl_bell";
+                numberOfParameters = 3;
+                break;
+            case MembershipKernel::SIGMOID:
+                function = "fl_sigmoid";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::SIGMOID_DIFFERENCE:
+                function = "fl_sigmoidDifference";
+                numberOfParameters = 4;
+                break;
+            case MembershipKernel::SIGMOID_PRODUCT:
+                function = "fl_sigmoidProduct";
+                numberOfParameters = 4;
+                break;
+            case MembershipKernel::SPIKE:
+                function = "fl_spike";
+                numberOfParameters = 2;
+                break;
+            case MembershipKernel::COSINE:
+                function = "fl_cosine";
+                numberOfParameters = 2;
+                break;
+            default:
+            {
+                const Term* term = kernel.getTerm();
+                throw fl::Exception("[export error] term <" + (term ? term->getName() : std::string("null"))
+                        + "> of class <" + (term ? term->className() : std::string("null"))
+                        + "> has no kernel", FL_AT);
+            }
+        }
+        functions.insert(function);
+        std::ostringstream ss;
+        ss << function << "(" << x;
+        for (int i = 0; i < numberOfParameters; ++i) {
+            ss << ", " << literal(p[i]);
+        }
+        ss << ", " << literal(kernel.getHeight()) << ")";
+        return ss.str();
+    }
+
+    std::string KernelExporter::hedge(const Hedge* hedge, const std::string& x, std::set<std::string>& functions) const {
+        const std::string name = hedge->name();
+        if (name == "any") return literal(1.0);
+        if (name == "not" or name == "seldom" or name == "somewhat" or name == "very" or name == "extremely") {
+            functions.insert("fl_" + name);
+            return "fl_" + name + "(" + x + ")";
+        }
+        throw fl::Exception("[export error] hedge <" + name + "> has no kernel", FL_AT);
+    }
+
+    std::string KernelExporter::norm(CompiledEngine::NormCode code, const std::string& a, const std::string& b,
+            std::set<std::string>& functions) const {
+        std::string function;
+        switch (code) {
+            case CompiledEngine::MINIMUM:
+                return "fl_min(" + a + ", " + b + ")";
+            case CompiledEngine::MAXIMUM:
+                return "fl_max(" + a + ", " + b + ")";
+            case CompiledEngine::ALGEBRAIC_PRODUCT:
+                return "(" + a + " * " + b + ")";
+            case CompiledEngine::ALGEBRAIC_SUM:
+                function = "fl_algebraicSum";
+                break;
+            case CompiledEngine::BOUNDED_DIFFERENCE:
+                function = "fl_boundedDifference";
+                break;
+            case CompiledEngine::BOUNDED_SUM:
+                function = "fl_boundedSum";
+                break;
+            default:
+                throw fl::Exception("[export error] norm has no kernel", FL_AT);
+        }
+        functions.insert(function);
+        return function + "(" + a + ", " + b + ")";
+    }
+
+    std::string KernelExporter::toString(const Engine* constEngine) const {
+        Engine* engine = const_cast<Engine*> (constEngine);
+        CompiledEngine model(engine);
+        const int numberOfInputs = engine->numberOfInputVariables();
+        const int numberOfOutputs = engine->numberOfOutputVariables();
+        const std::string function = identifier(engine->getName().empty() ? "engine" : engine->getName());
+        std::set<std::string> functions;
+        std::ostringstream body;
+
+        //Output variables
+        std::vector<bool> mamdani(numberOfOutputs, false), merged(numberOfOutputs, false);
+        std::vector<bool> average(numberOfOutputs, false);
+        std::vector<CompiledEngine::IntegralCode> integrals(numberOfOutputs, CompiledEngine::NOT_INTEGRAL);
+        std::vector<CompiledEngine::IntegralForm> forms(numberOfOutputs, CompiledEngine::SAMPLED);
+        std::vector<CompiledEngine::NormCode> accumulations(numberOfOutputs, CompiledEngine::CUSTOM);
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            const OutputVariable* outputVariable = engine->getOutputVariable(o);
+            if (outputVariable->isLockedPreviousOutputValue()) {
+                throw fl::Exception("[export error] output variable <" + outputVariable->getName()
+                        + "> locks its previous value, which has no kernel", FL_AT);
+            }
+            if (not outputVariable->isEnabled()) continue;
+            const Defuzzifier* defuzzifier = outputVariable->getDefuzzifier();
+            if (not defuzzifier) {
+                throw fl::Exception("[export error] output variable <" + outputVariable->getName()
+                        + "> has no defuzzifier", FL_AT);
+            }
+            const SNorm* accumulation = outputVariable->fuzzyOutput()->getAccumulation();
+            accumulations.at(o) = CompiledEngine::normCode(accumulation);
+            CompiledEngine::IntegralForm form;
+            integrals.at(o) = CompiledEngine::integralCode(defuzzifier, form);
+            forms.at(o) = form;
+            if (integrals.at(o) != CompiledEngine::NOT_INTEGRAL) {
+                mamdani.at(o) = true;
+                if (accumulations.at(o) == CompiledEngine::CUSTOM) {
+                    throw fl::Exception("[export error] output variable <" + outputVariable->getName()
+                            + "> has no accumulation with a kernel", FL_AT);
+                }
+                if (not Op::isFinite(outputVariable->getMinimum() + outputVariable->getMaximum())) {
+                    throw fl::Exception("[export error] output variable <" + outputVariable->getName()
+                            + "> has an infinite range", FL_AT);
+                }
+                continue;
+            }
+            const WeightedDefuzzifier* weighted = dynamic_cast<const WeightedDefuzzifier*> (defuzzifier);
+            const std::string className = defuzzifier->className();
+            if (not weighted or weighted->getType() == WeightedDefuzzifier::Tsukamoto
+                    or not (className == "WeightedAverage" or className == "WeightedSum")) {
+                throw fl::Exception("[export error] defuzzifier <" + className + "> of output variable <"
+                        + outputVariable->getName() + "> has no kernel", FL_AT);
+            }
+            if (accumulation and accumulations.at(o) == CompiledEngine::CUSTOM) {
+                throw fl::Exception("[export error] output variable <" + outputVariable->getName()
+                        + "> has no accumulation with a kernel", FL_AT);
+            }
+            average.at(o) = (className == "WeightedAverage");
+        }
+
+        //Conclusions of the output variables, and the activated terms of the Mamdani ones
+        const std::vector<CompiledEngine::Conclusion>& conclusions = model.conclusions();
+        const std::vector<CompiledEngine::CompiledRule>& rules = model.rules();
+        const std::vector<CompiledEngine::CompiledBlock>& blocks = model.blocks();
+        std::vector<int> conclusionBlocks(conclusions.size(), -1);
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            for (int r = blocks.at(b).firstRule; r < blocks.at(b).firstRule + blocks.at(b).numberOfRules; ++r) {
+                const CompiledEngine::CompiledRule& rule = rules.at(r);
+                for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                    conclusionBlocks.at(c) = (int) b;
+                }
+            }
+        }
+        std::vector<std::vector<KernelActivation> > activations(numberOfOutputs);
+        std::vector<int> degreeIndices(conclusions.size(), -1);
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            if (not mamdani.at(o)) continue;
+            CompiledEngine::NormCode activation = CompiledEngine::CUSTOM;
+            bool sameActivation = true;
+            for (std::size_t c = 0; c < conclusions.size(); ++c) {
+                if (conclusions.at(c).outputIndex != o) continue;
+                const TNorm* norm = blocks.at(conclusionBlocks.at(c)).activation;
+                const CompiledEngine::NormCode code = CompiledEngine::normCode(norm);
+                if (code == CompiledEngine::CUSTOM) {
+                    throw fl::Exception("[export error] rule block of a conclusion on output variable <"
+                            + engine->getOutputVariable(o)->getName() + "> has no activation with a kernel", FL_AT);
+                }
+                if (activation != CompiledEngine::CUSTOM and code != activation) sameActivation = false;
+                activation = code;
+            }
+            merged.at(o) = sameActivation and accumulations.at(o) == CompiledEngine::MAXIMUM
+                    and (activation == CompiledEngine::MINIMUM or activation == CompiledEngine::ALGEBRAIC_PRODUCT);
+            for (std::size_t c = 0; c < conclusions.size(); ++c) {
+                if (conclusions.at(c).outputIndex != o) continue;
+                KernelActivation activated;
+                activated.term = conclusions.at(c).term;
+                activated.activation = CompiledEngine::normCode(blocks.at(conclusionBlocks.at(c)).activation);
+                int index = -1;
+                for (std::size_t k = 0; k < activations.at(o).size() and merged.at(o); ++k) {
+                    if (activations.at(o).at(k).term == activated.term) index = (int) k;
+                }
+                if (index < 0) {
+                    index = (int) activations.at(o).size();
+                    activations.at(o).push_back(activated);
+                }
+                degreeIndices.at(c) = index;
+            }
+        }
+
+        //Values of the Takagi-Sugeno terms, and their rows when the output accumulates them
+        std::vector<std::vector<const Term*> > weightedTerms(numberOfOutputs);
+        std::vector<std::string> termValues(conclusions.size());
+        for (std::size_t c = 0; c < conclusions.size(); ++c) {
+            const CompiledEngine::Conclusion& conclusion = conclusions.at(c);
+            const int o = conclusion.outputIndex;
+            if (mamdani.at(o) or not engine->getOutputVariable(o)->isEnabled()) continue;
+            if (const Constant* constant = dynamic_cast<const Constant*> (conclusion.term)) {
+                termValues.at(c) = literal(constant->getValue());
+            } else if (const Linear* linear = dynamic_cast<const Linear*> (conclusion.term)) {
+                const std::vector<scalar>& coefficients = linear->coefficients();
+                if ((int) coefficients.size() != numberOfInputs + 1) {
+                    throw fl::Exception("[export error] linear term <" + linear->getName() + "> has <"
+                            + Op::str((int) coefficients.size()) + "> coefficients, expected <"
+                            + Op::str(numberOfInputs + 1) + ">", FL_AT);
+                }
+                //Same order of the sums as Linear::membership()
+                std::string value = "0.0";
+                for (int i = 0; i < numberOfInputs; ++i) {
+                    value = "(" + value + " + " + literal(coefficients.at(i)) + " * x" + Op::str(i) + ")";
+                }
+                termValues.at(c) = "(" + value + " + " + literal(coefficients.back()) + ")";
+            } else {
+                throw fl::Exception("[export error] term <" + conclusion.term->getName() + "> of class <"
+                        + conclusion.term->className() + "> of output variable <"
+                        + engine->getOutputVariable(o)->getName() + "> has no kernel", FL_AT);
+            }
+            if (accumulations.at(o) != CompiledEngine::CUSTOM) {
+                std::vector<const Term*>& terms = weightedTerms.at(o);
+                std::vector<const Term*>::iterator it = std::find(terms.begin(), terms.end(), conclusion.term);
+                degreeIndices.at(c) = (int) (it - terms.begin());
+                if (it == terms.end()) terms.push_back(conclusion.term);
+            }
+        }
+
+        //Inputs and propositions
+        for (int i = 0; i < numberOfInputs; ++i) {
+            body << "    const double x" << i << " = inputs[" << i << "];\n";
+        }
+        const std::vector<CompiledEngine::Slot>& slots = model.slots();
+        const std::vector<const Hedge*>& hedges = model.hedges();
+        for (std::size_t s = 0; s < slots.size(); ++s) {
+            const CompiledEngine::Slot& slot = slots.at(s);
+            if (not dynamic_cast<const InputVariable*> (slot.variable)) continue;
+            std::string value;
+            int firstHedge = slot.firstHedge;
+            if (not slot.variable->isEnabled()) {
+                value = "0.0";
+                firstHedge = slot.firstHedge + slot.numberOfHedges;
+            } else if (slot.constant) {
+                //"any" is the first hedge to be applied
+                value = literal(1.0);
+                ++firstHedge;
+            } else {
+                value = membership(MembershipKernel(slot.term), "x" + Op::str(slot.variableIndex), functions);
+            }
+            for (int h = firstHedge; h < slot.firstHedge + slot.numberOfHedges; ++h) {
+                value = hedge(hedges.at(h), value, functions);
+            }
+            body << "    const double s" << s << " = " << value << ";\n";
+        }
+
+        //State of the fuzzy outputs
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            if (not engine->getOutputVariable(o)->isEnabled()) continue;
+            body << "    bool fired" << o << " = false;\n";
+            if (mamdani.at(o)) {
+                body << "    double degrees" << o << "[" << std::max((int) activations.at(o).size(), 1)
+                        << "] = {0.0};\n";
+            } else {
+                body << "    double sum" << o << " = 0.0, weights" << o << " = 0.0;\n";
+                if (not weightedTerms.at(o).empty()) {
+                    body << "    double degrees" << o << "[" << weightedTerms.at(o).size() << "] = {";
+                    for (std::size_t k = 0; k < weightedTerms.at(o).size(); ++k) {
+                        body << (k == 0 ? "" : ", ") << "-1.0";
+                    }
+                    body << "};\n";
+                }
+            }
+        }
+
+        //Rules
+        const std::vector<CompiledEngine::Instruction>& instructions = model.instructions();
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            const CompiledEngine::CompiledBlock& block = blocks.at(b);
+            body << "\n    //Rule block " << b << "\n";
+            for (int r = block.firstRule; r < block.firstRule + block.numberOfRules; ++r) {
+                const CompiledEngine::CompiledRule& rule = rules.at(r);
+                std::vector<std::string> stack;
+                for (int i = rule.firstInstruction; i < rule.firstInstruction + rule.numberOfInstructions; ++i) {
+                    const CompiledEngine::Instruction& instruction = instructions.at(i);
+                    if (instruction.code == CompiledEngine::LOAD_SLOT) {
+                        stack.push_back("s" + Op::str(instruction.operand));
+                    } else if (instruction.code == CompiledEngine::LOAD_OUTPUT) {
+                        throw fl::Exception("[export error] rules on output variables have no kernel", FL_AT);
+                    } else {
+                        const std::string right = stack.back();
+                        stack.pop_back();
+                        const std::string left = stack.back();
+                        stack.pop_back();
+                        const bool conjunction = (instruction.code == CompiledEngine::CONJUNCTION);
+                        const CompiledEngine::NormCode code = conjunction ? block.conjunctionCode : block.disjunctionCode;
+                        if (code == CompiledEngine::CUSTOM) {
+                            throw fl::Exception(std::string("[export error] rule block has no ")
+                                    + (conjunction ? "conjunction" : "disjunction") + " with a kernel", FL_AT);
+                        }
+                        stack.push_back(norm(code, left, right, functions));
+                    }
+                }
+                body << "    {\n";
+                body << "        const double degree = " << literal(rule.weight) << " * " << stack.back() << ";\n";
+                body << "        if (degree >= fl_macheps) {\n";
+                for (int c = rule.firstConclusion; c < rule.firstConclusion + rule.numberOfConclusions; ++c) {
+                    const CompiledEngine::Conclusion& conclusion = conclusions.at(c);
+                    const int o = conclusion.outputIndex;
+                    if (not engine->getOutputVariable(o)->isEnabled()) continue;
+                    std::string w = "degree";
+                    for (int h = conclusion.firstHedge; h < conclusion.firstHedge + conclusion.numberOfHedges; ++h) {
+                        w = hedge(hedges.at(h), w, functions);
+                    }
+                    const std::string degree = "degrees" + Op::str(o) + "[" + Op::str(degreeIndices.at(c)) + "]";
+                    body << "            fired" << o << " = true;\n";
+                    if (mamdani.at(o)) {
+                        if (merged.at(o)) {
+                            body << "            " << degree << " = fl_max(" << degree << ", " << w << ");\n";
+                        } else {
+                            body << "            " << degree << " = " << w << ";\n";
+                        }
+                    } else if (accumulations.at(o) != CompiledEngine::CUSTOM) {
+                        body << "            " << degree << " = " << norm(accumulations.at(o),
+                                "(" + degree + " < 0.0 ? 0.0 : " + degree + ")", w, functions) << ";\n";
+                    } else {
+                        body << "            {\n";
+                        body << "                const double w = " << w << ";\n";
+                        body << "                sum" << o << " += w * " << termValues.at(c) << ";\n";
+                        body << "                weights" << o << " += w;\n";
+                        body << "            }\n";
+                    }
+                }
+                body << "        }\n";
+                body << "    }\n";
+            }
+        }
+
+        //Defuzzification
+        std::ostringstream fuzzyOutputs;
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            const OutputVariable* outputVariable = engine->getOutputVariable(o);
+            body << "\n    //" << outputVariable->getName() << "\n";
+            body << "    double y" << o << " = " << literal(outputVariable->getDefaultValue()) << ";\n";
+            if (mamdani.at(o)) {
+                //The Exact* defuzzifiers sample the fuzzy outputs that are not piecewise linear, as the stock ones
+                std::vector<PiecewiseLinear::Polyline> polylines(activations.at(o).size());
+                bool piecewiseLinear = forms.at(o) == CompiledEngine::PIECEWISE_LINEAR and not polylines.empty()
+                        and accumulations.at(o) == CompiledEngine::MAXIMUM
+                        and outputVariable->getMinimum() < outputVariable->getMaximum();
+                for (std::size_t k = 0; k < polylines.size() and piecewiseLinear; ++k) {
+                    const KernelActivation& activated = activations.at(o).at(k);
+                    piecewiseLinear = polylines.at(k).set(activated.term)
+                            and (activated.activation == CompiledEngine::MINIMUM
+                            or activated.activation == CompiledEngine::ALGEBRAIC_PRODUCT);
+                }
+                const int resolution = static_cast<const IntegralDefuzzifier*> (
+                        outputVariable->getDefuzzifier())->getResolution();
+                const std::string range = literal(outputVariable->getMinimum()) + ", "
+                        + literal(outputVariable->getMaximum());
+                std::string defuzzify;
+                if (piecewiseLinear) {
+                    fuzzyOutputs << "\n    const fl_Polyline polylines" << o << "[" << polylines.size() << "] = {\n";
+                    for (std::size_t k = 0; k < polylines.size(); ++k) {
+                        const PiecewiseLinear::Polyline& polyline = polylines.at(k);
+                        std::string x, y;
+                        for (int v = 0; v < 4; ++v) {
+                            x += (v == 0 ? "" : ", ") + literal(v < polyline.size ? polyline.x[v] : 0.0);
+                            y += (v == 0 ? "" : ", ") + literal(v < polyline.size ? polyline.y[v] : 0.0);
+                        }
+                        fuzzyOutputs << "        {{" << x << "}, {" << y << "}, " << polyline.size << ", "
+                                << literal(polyline.left) << ", " << literal(polyline.right) << ", "
+                                << (activations.at(o).at(k).activation == CompiledEngine::MINIMUM ? "true" : "false")
+                                << "}" << (k + 1 < polylines.size() ? "," : "") << "\n";
+                    }
+                    fuzzyOutputs << "    };\n";
+                    switch (integrals.at(o)) {
+                        case CompiledEngine::CENTROID: defuzzify = "fl_exactCentroid";
+                            break;
+                        case CompiledEngine::BISECTOR: defuzzify = "fl_exactBisector";
+                            break;
+                        case CompiledEngine::MEAN_OF_MAXIMUM: defuzzify = "fl_exactMeanOfMaximum";
+                            break;
+                        case CompiledEngine::SMALLEST_OF_MAXIMUM: defuzzify = "fl_exactSmallestOfMaximum";
+                            break;
+                        default: defuzzify = "fl_exactLargestOfMaximum";
+                            break;
+                    }
+                    functions.insert("fl_pieces");
+                    functions.insert("fl_exactMaximum");
+                    functions.insert(defuzzify);
+                    body << "    if (fired" << o << ") {\n";
+                    body << "        y" << o << " = " << defuzzify << "(polylines" << o << ", degrees" << o << ", "
+                            << range << ");\n";
+                    body << "    }\n";
+                } else {
+                    fuzzyOutputs << "\n    struct FuzzyOutput" << o << " {\n";
+                    fuzzyOutputs << "        const double* degrees;\n\n";
+                    fuzzyOutputs << "        double operator()(double x) const {\n";
+                    fuzzyOutputs << "            double mu = 0.0;\n";
+                    for (std::size_t k = 0; k < activations.at(o).size(); ++k) {
+                        const KernelActivation& activated = activations.at(o).at(k);
+                        const std::string y = norm(activated.activation,
+                                membership(MembershipKernel(activated.term), "x", functions),
+                                "degrees[" + Op::str((int) k) + "]", functions);
+                        fuzzyOutputs << "            mu = " << norm(accumulations.at(o), "mu", y, functions) << ";\n";
+                    }
+                    fuzzyOutputs << "            return mu;\n";
+                    fuzzyOutputs << "        }\n";
+                    fuzzyOutputs << "    };\n";
+                    switch (integrals.at(o)) {
+                        case CompiledEngine::CENTROID: defuzzify = "fl_centroid";
+                            break;
+                        case CompiledEngine::BISECTOR:
+                            defuzzify = forms.at(o) == CompiledEngine::PREFIX_SUM ? "fl_prefixSumBisector" : "fl_bisector";
+                            break;
+                        case CompiledEngine::MEAN_OF_MAXIMUM: defuzzify = "fl_meanOfMaximum";
+                            break;
+                        case CompiledEngine::SMALLEST_OF_MAXIMUM: defuzzify = "fl_smallestOfMaximum";
+                            break;
+                        default: defuzzify = "fl_largestOfMaximum";
+                            break;
+                    }
+                    functions.insert(defuzzify);
+                    body << "    if (fired" << o << ") {\n";
+                    body << "        const FuzzyOutput" << o << " fuzzyOutput = {degrees" << o << "};\n";
+                    body << "        y" << o << " = " << defuzzify << "(fuzzyOutput, " << range << ", "
+                            << resolution << ");\n";
+                    body << "    }\n";
+                }
+            } else if (outputVariable->isEnabled()) {
+                body << "    if (fired" << o << ") {\n";
+                const std::vector<const Term*>& terms = weightedTerms.at(o);
+                for (std::size_t k = 0; k < terms.size(); ++k) {
+                    std::size_t c = 0;
+                    while (conclusions.at(c).outputIndex != o or conclusions.at(c).term != terms.at(k)) ++c;
+                    body << "        if (degrees" << o << "[" << k << "] >= 0.0) {\n";
+                    body << "            sum" << o << " += degrees" << o << "[" << k << "] * "
+                            << termValues.at(c) << ";\n";
+                    body << "            weights" << o << " += degrees" << o << "[" << k << "];\n";
+                    body << "        }\n";
+                }
+                body << "        y" << o << " = " << (average.at(o) ? "sum" + Op::str(o) + " / weights" + Op::str(o)
+                        : "sum" + Op::str(o)) << ";\n";
+                body << "    }\n";
+            }
+            if (outputVariable->isLockedOutputValueInRange()) {
+                functions.insert("fl_bound");
+                body << "    y" << o << " = fl_bound(y" << o << ", " << literal(outputVariable->getMinimum()) << ", "
+                        << literal(outputVariable->getMaximum()) << ");\n";
+            }
+            body << "    outputs[" << o << "] = y" << o << ";\n";
+        }
+
+        //Signatures of the functions of each output
+        std::ostringstream parameters;
+        for (int i = 0; i < numberOfInputs; ++i) {
+            parameters << (i == 0 ? "" : ", ") << "double " << identifier(engine->getInputVariable(i)->getName());
+        }
+
+        //Test harness
+        std::ostringstream check;
+        if (_checkSamples > 0) {
+            //The grid of FldExporter::toString(engine, checkSamples), with the last input changing fastest
+            int resolution = 0;
+            int numberOfSamples = 1;
+            if (numberOfInputs > 0) {
+                resolution = -1 + (int) std::max(1.0, std::pow((double) _checkSamples, 1.0 / numberOfInputs));
+                for (int i = 0; i < numberOfInputs; ++i) numberOfSamples *= resolution + 1;
+            }
+            const int columns = numberOfInputs + numberOfOutputs;
+            engine->restart();
+            check << "\nint " << function << "_check(double tolerance) {\n";
+            check << "    static const double samples[" << numberOfSamples << "][" << columns << "] = {\n";
+            for (int k = 0; k < numberOfSamples; ++k) {
+                int sample = k;
+                std::vector<scalar> inputValues(numberOfInputs);
+                for (int i = numberOfInputs - 1; i >= 0; --i) {
+                    const InputVariable* inputVariable = engine->getInputVariable(i);
+                    inputValues.at(i) = inputVariable->getMinimum()
+                            + (sample % (resolution + 1)) * (inputVariable->getMaximum() - inputVariable->getMinimum())
+                            / std::max(1, resolution);
+                    sample /= resolution + 1;
+                }
+                for (int i = 0; i < numberOfInputs; ++i) {
+                    engine->getInputVariable(i)->setInputValue(inputValues.at(i));
+                }
+                engine->process();
+                check << "        {";
+                for (int i = 0; i < numberOfInputs; ++i) {
+                    check << (i == 0 ? "" : ", ") << literal(inputValues.at(i));
+                }
+                for (int o = 0; o < numberOfOutputs; ++o) {
+                    check << (o + numberOfInputs == 0 ? "" : ", ")
+                            << literal(engine->getOutputVariable(o)->getOutputValue());
+                }
+                check << "}" << (k + 1 < numberOfSamples ? "," : "") << "\n";
+            }
+            check << "    };\n";
+            check << "    int failures = 0;\n";
+            check << "    for (int k = 0; k < " << numberOfSamples << "; ++k) {\n";
+            check << "        double outputs[" << numberOfOutputs << "];\n";
+            check << "        " << function << "(samples[k], outputs);\n";
+            check << "        for (int o = 0; o < " << numberOfOutputs << "; ++o) {\n";
+            check << "            const double expected = samples[k][" << numberOfInputs << " + o];\n";
+            check << "            const bool same = (expected != expected) ? (outputs[o] != outputs[o])\n";
+            check << "                    : (expected == outputs[o] || std::fabs(outputs[o] - expected) <= tolerance);\n";
+            check << "            if (!same) ++failures;\n";
+            check << "        }\n";
+            check << "    }\n";
+            check << "    return failures;\n";
+            check << "}\n";
+        }
+
+        std::ostringstream result;
+        result << "// " << function << ".cpp\n";
+        result << "//\n";
+        result << "// Purpose: Engine <" << engine->getName() << "> as a standalone function, exported by "
+                "fl::KernelExporter.\n";
+        result << "// Detail: void " << function << "(const double* inputs, double* outputs) evaluates the "
+                << numberOfInputs << " input values\n";
+        result << "// into the " << numberOfOutputs << " output values, in the order of the variables of the engine.\n";
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            result << "// double " << identifier(engine->getOutputVariable(o)->getName())
+                    << "(" << parameters.str() << ");\n";
+        }
+        if (_checkSamples > 0) {
+            result << "// int " << function << "_check(double tolerance) returns the number of outputs that differ "
+                    "from Engine::process()\n";
+            result << "// by more than the tolerance.\n";
+        }
+        result << "\n#include <cmath>\n";
+        result << "#include <limits>\n\n";
+        result << "namespace {\n";
+        result << "    const double fl_nan = std::numeric_limits<double>::quiet_NaN();\n";
+        result << "    const double fl_inf = std::numeric_limits<double>::infinity();\n";
+        result << "    const double fl_macheps = " << literal(fuzzylite::macheps()) << ";\n\n";
+        result << "    inline bool fl_isEq(double a, double b) {\n";
+        result << "        return a == b || std::fabs(a - b) < fl_macheps || (a != a && b != b);\n";
+        result << "    }\n\n";
+        result << "    inline bool fl_isLt(double a, double b) {\n";
+        result << "        return !fl_isEq(a, b) && a < b;\n";
+        result << "    }\n\n";
+        result << "    inline bool fl_isLE(double a, double b) {\n";
+        result << "        return fl_isEq(a, b) || a < b;\n";
+        result << "    }\n\n";
+        result << "    inline bool fl_isGt(double a, double b) {\n";
+        result << "        return !fl_isEq(a, b) && a > b;\n";
+        result << "    }\n\n";
+        result << "    inline bool fl_isGE(double a, double b) {\n";
+        result << "        return fl_isEq(a, b) || a > b;\n";
+        result << "    }\n\n";
+        result << "    inline double fl_min(double a, double b) {\n";
+        result << "        if (a != a) return b;\n";
+        result << "        if (b != b) return a;\n";
+        result << "        return a < b ? a : b;\n";
+        result << "    }\n\n";
+        result << "    inline double fl_max(double a, double b) {\n";
+        result << "        if (a != a) return b;\n";
+        result << "        if (b != b) return a;\n";
+        result << "        return a > b ? a : b;\n";
+        result << "    }\n";
+        for (std::size_t h = 0; h < sizeof(kernelHelpers) / sizeof(kernelHelpers[0]); ++h) {
+            if (functions.find(kernelHelpers[h].name) != functions.end()) {
+                result << "\n" << kernelHelpers[h].source;
+            }
+        }
+        result << fuzzyOutputs.str();
+        result << "}\n\n";
+
+        result << "void " << function << "(const double* inputs, double* outputs) {\n";
+        if (numberOfInputs == 0) result << "    (void) inputs;\n";
+        result << body.str();
+        result << "}\n";
+
+        for (int o = 0; o < numberOfOutputs; ++o) {
+            result << "\ndouble " << identifier(engine->getOutputVariable(o)->getName())
+                    << "(" << parameters.str() << ") {\n";
+            if (numberOfInputs == 0) {
+                result << "    const double* inputs = 0;\n";
+            } else {
+                result << "    const double inputs[" << numberOfInputs << "] = {";
+                for (int i = 0; i < numberOfInputs; ++i) {
+                    result << (i == 0 ? "" : ", ") << identifier(engine->getInputVariable(i)->getName());
+                }
+                result << "};\n";
+            }
+            result << "    double outputs[" << numberOfOutputs << "];\n";
+            result << "    " << function << "(inputs, outputs);\n";
+            result << "    return outputs[" << o << "];\n";
+            result << "}\n";
+        }
+
+        result << check.str();
+        return result.str();
+    }
+
+    KernelExporter* KernelExporter::clone() const {
+        return new KernelExporter(*this);
+    }
+
+}
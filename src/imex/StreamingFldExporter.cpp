@@ -0,0 +1,466 @@
+// StreamingFldExporter.cpp
+//
+// Purpose: Implementation of fl::StreamingFldExporter.
+// Detail: Chunks end after their last line break, and the partial line after it is carried to the front of
+// the next chunk, so no line is ever split; the buffer doubles only when a single line does not fit. Blocks
+// that fail keep the rows before the failing line and the message of its exception, and once all blocks of
+// the chunk are done the rows are written up to that line before the exception is thrown, as FldExporter
+// writes the rows before the line it fails on. Grids are swept in chunks of 64 blocks per thread, so their
+// rows are written as they are evaluated, whatever the number of points.
+
+#include "fl/imex/StreamingFldExporter.h"
+
+#include "fl/CompiledEngine.h"
+#include "fl/Engine.h"
+#include "fl/EvaluationContext.h"
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace fl {
+
+    /**
+     * The compiled engine and one context per thread of a dataset being evaluated.
+     */
+    class FldContexts {
+    public:
+        CompiledEngine model;
+        std::vector<EvaluationContext*> contexts;
+
+        FldContexts(Engine* engine, int numberOfThreads) : model(engine) {
+            bool ordered = false;
+            for (int i = 0; i < engine->numberOfOutputVariables(); ++i) {
+                if (engine->getOutputVariable(i)->isLockedPreviousOutputValue()) ordered = true;
+            }
+#ifdef _OPENMP
+            if (numberOfThreads <= 0) numberOfThreads = omp_get_max_threads();
+#else
+            numberOfThreads = 1;
+#endif
+            if (ordered or numberOfThreads < 1) numberOfThreads = 1;
+            for (int i = 0; i < numberOfThreads; ++i) {
+                contexts.push_back(new EvaluationContext(&model));
+            }
+        }
+
+        ~FldContexts() {
+            for (std::size_t i = 0; i < contexts.size(); ++i) {
+                delete contexts.at(i);
+            }
+        }
+
+    private:
+        FL_DISABLE_COPY(FldContexts)
+    };
+
+    static bool isBlank(char c) {
+        return c == ' ' or c == '\t' or c == '\r' or c == '\v' or c == '\f' or c == '\n';
+    }
+
+    /**
+     * Writes the rows of the blocks in order, up to the first block that failed, and throws its error.
+     */
+    static void writeBlocks(const std::vector<std::string>& blocks, const std::vector<std::string>& errors,
+            std::ostream& writer) {
+        for (std::size_t block = 0; block < errors.size(); ++block) {
+            writer.write(blocks.at(block).data(), blocks.at(block).size());
+            if (not errors.at(block).empty()) {
+                throw fl::Exception(errors.at(block), FL_AT);
+            }
+        }
+    }
+
+    const std::size_t StreamingFldExporter::DefaultChunkSize = 4 * 1024 * 1024;
+
+    StreamingFldExporter::StreamingFldExporter(const std::string& separator) : FldExporter(separator),
+    _chunkSize(DefaultChunkSize), _linesPerBlock(512), _numberOfThreads(0),
+    _exportBinary(false) {
+
+    }
+
+    StreamingFldExporter::~StreamingFldExporter() {
+
+    }
+
+    std::string StreamingFldExporter::name() const {
+        return "StreamingFldExporter";
+    }
+
+    void StreamingFldExporter::setChunkSize(std::size_t chunkSize) {
+        if (chunkSize < 1) {
+            throw fl::Exception("[export error] chunk size must be positive", FL_AT);
+        }
+        this->_chunkSize = chunkSize;
+    }
+
+    std::size_t StreamingFldExporter::getChunkSize() const {
+        return this->_chunkSize;
+    }
+
+    void StreamingFldExporter::setLinesPerBlock(int linesPerBlock) {
+        if (linesPerBlock < 1) {
+            throw fl::Exception("[export error] lines per block must be positive", FL_AT);
+        }
+        this->_linesPerBlock = linesPerBlock;
+    }
+
+    int StreamingFldExporter::getLinesPerBlock() const {
+        return this->_linesPerBlock;
+    }
+
+    void StreamingFldExporter::setNumberOfThreads(int numberOfThreads) {
+        this->_numberOfThreads = numberOfThreads;
+    }
+
+    int StreamingFldExporter::getNumberOfThreads() const {
+        return this->_numberOfThreads;
+    }
+
+    void StreamingFldExporter::setExportBinary(bool exportBinary) {
+        this->_exportBinary = exportBinary;
+    }
+
+    bool StreamingFldExporter::exportsBinary() const {
+        return this->_exportBinary;
+    }
+
+    std::string StreamingFldExporter::toString(Engine* engine, int maximumNumberOfResults) const {
+        std::ostringstream writer;
+        sweep(engine, maximumNumberOfResults, writer);
+        return writer.str();
+    }
+
+    std::string StreamingFldExporter::toString(Engine* engine, const std::string& inputData) const {
+        std::ostringstream writer;
+        stream(engine, inputData.c_str(), inputData.size(), writer);
+        return writer.str();
+    }
+
+    void StreamingFldExporter::toFile(const std::string& path, Engine* engine, int maximumNumberOfResults) const {
+        std::ofstream writer(path.c_str(), _exportBinary
+                ? std::ios_base::out | std::ios_base::binary : std::ios_base::out);
+        if (not writer.is_open()) {
+            throw fl::Exception("[file error] file <" + path + "> could not be created", FL_AT);
+        }
+        sweep(engine, maximumNumberOfResults, writer);
+        writer.close();
+    }
+
+    void StreamingFldExporter::toFile(const std::string& path, Engine* engine, const std::string& inputData) const {
+        std::ofstream writer(path.c_str(), _exportBinary
+                ? std::ios_base::out | std::ios_base::binary : std::ios_base::out);
+        if (not writer.is_open()) {
+            throw fl::Exception("[file error] file <" + path + "> could not be created", FL_AT);
+        }
+        stream(engine, inputData.c_str(), inputData.size(), writer);
+        writer.close();
+    }
+
+    void StreamingFldExporter::toFile(const std::string& path, Engine* engine, std::istream& reader) const {
+        std::ofstream writer(path.c_str(), _exportBinary
+                ? std::ios_base::out | std::ios_base::binary : std::ios_base::out);
+        if (not writer.is_open()) {
+            throw fl::Exception("[file error] file <" + path + "> could not be created", FL_AT);
+        }
+        stream(engine, reader, writer);
+        writer.close();
+    }
+
+    long StreamingFldExporter::stream(Engine* engine, std::istream& reader, std::ostream& writer) const {
+        FldContexts contexts(engine, _numberOfThreads);
+        if (_exportHeaders and not _exportBinary) writer << header(engine) << "\n";
+
+        std::vector<std::string> blocks;
+        std::vector<char> buffer(_chunkSize + 1);
+        std::size_t carried = 0;
+        long lines = 0;
+        while (true) {
+            std::size_t capacity = buffer.size() - 1;
+            if (carried == capacity) {
+                //A line longer than the buffer
+                buffer.resize(2 * capacity + 1);
+                capacity *= 2;
+            }
+            reader.read(&buffer.at(carried), capacity - carried);
+            std::size_t size = carried + (std::size_t) reader.gcount();
+            bool finished = not reader;
+            buffer.at(size) = '\0';
+
+            const char* data = &buffer.at(0);
+            std::size_t complete = size;
+            if (not finished) {
+                complete = 0;
+                for (std::size_t i = size; i > 0; --i) {
+                    if (data[i - 1] == '\n') {
+                        complete = i;
+                        break;
+                    }
+                }
+            }
+            lines += writeLines(contexts.contexts, data, data + complete, lines, blocks, writer);
+            carried = size - complete;
+            if (carried > 0) std::memmove(&buffer.at(0), &buffer.at(complete), carried);
+            if (finished) break;
+        }
+        return lines;
+    }
+
+    long StreamingFldExporter::stream(Engine* engine, const char* data, std::size_t size, std::ostream& writer) const {
+        FldContexts contexts(engine, _numberOfThreads);
+        if (_exportHeaders and not _exportBinary) writer << header(engine) << "\n";
+        std::vector<std::string> blocks;
+        return writeLines(contexts.contexts, data, data + size, 0, blocks, writer);
+    }
+
+    long StreamingFldExporter::writeLines(const std::vector<EvaluationContext*>& contexts, const char* start,
+            const char* end, long firstLine, std::vector<std::string>& blocks, std::ostream& writer) const {
+        std::vector<const char*> lines;
+        const char* line = start;
+        for (const char* it = start; it != end; ++it) {
+            if (*it == '\n') {
+                lines.push_back(line);
+                line = it + 1;
+            }
+        }
+        if (line != end) {
+            //The last line, without a line break
+            lines.push_back(line);
+            line = end + 1;
+        }
+        const int numberOfLines = (int) lines.size();
+        lines.push_back(line);
+        if (numberOfLines == 0) return 0;
+
+        const int numberOfBlocks = (numberOfLines + _linesPerBlock - 1) / _linesPerBlock;
+        if ((int) blocks.size() < numberOfBlocks) blocks.resize(numberOfBlocks);
+        std::vector<std::string> errors(numberOfBlocks);
+        const int numberOfThreads = (int) contexts.size();
+        (void) numberOfThreads;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(numberOfThreads)
+#endif
+        for (int block = 0; block < numberOfBlocks; ++block) {
+#ifdef _OPENMP
+            EvaluationContext* context = contexts.at(omp_get_thread_num());
+#else
+            EvaluationContext* context = contexts.front();
+#endif
+            std::string& rows = blocks.at(block);
+            rows.clear();
+            const int first = block * _linesPerBlock;
+            const int last = std::min(first + _linesPerBlock, numberOfLines);
+            for (int i = first; i < last; ++i) {
+                try {
+                    writeLine(context, lines.at(i), lines.at(i + 1) - 1, rows);
+                } catch (fl::Exception& ex) {
+                    ex.append(" writing line <" + Op::str((int) (firstLine + i + 1)) + ">");
+                    errors.at(block) = ex.getWhat();
+                    break;
+                } catch (std::exception& ex) {
+                    errors.at(block) = ex.what();
+                    break;
+                }
+            }
+        }
+
+        writeBlocks(blocks, errors, writer);
+        return numberOfLines;
+    }
+
+    long StreamingFldExporter::sweep(Engine* engine, int maximumNumberOfResults, std::ostream& writer) const {
+        FldContexts contexts(engine, _numberOfThreads);
+        if (_exportHeaders and not _exportBinary) writer << header(engine) << "\n";
+
+        const int numberOfInputs = engine->numberOfInputVariables();
+        int resolution = 0;
+        long numberOfPoints = 1;
+        if (numberOfInputs > 0) {
+            resolution = -1 + (int) std::max(1.0, std::pow((double) maximumNumberOfResults, 1.0 / numberOfInputs));
+            for (int i = 0; i < numberOfInputs; ++i) {
+                numberOfPoints *= resolution + 1;
+            }
+        }
+
+        std::vector<std::string> blocks;
+        const long pointsPerChunk = 64L * _linesPerBlock * (long) contexts.contexts.size();
+        for (long point = 0; point < numberOfPoints; point += pointsPerChunk) {
+            writePoints(contexts.contexts, point, std::min(pointsPerChunk, numberOfPoints - point),
+                    resolution, blocks, writer);
+        }
+        return numberOfPoints;
+    }
+
+    void StreamingFldExporter::writePoints(const std::vector<EvaluationContext*>& contexts, long firstPoint,
+            long numberOfPoints, int resolution, std::vector<std::string>& blocks, std::ostream& writer) const {
+        const Engine* engine = contexts.front()->getModel()->getEngine();
+        const int numberOfInputs = engine->numberOfInputVariables();
+        std::vector<scalar> minimums(numberOfInputs), ranges(numberOfInputs);
+        std::vector<bool> enabled(numberOfInputs);
+        for (int i = 0; i < numberOfInputs; ++i) {
+            const InputVariable* inputVariable = engine->getInputVariable(i);
+            minimums.at(i) = inputVariable->getMinimum();
+            ranges.at(i) = inputVariable->getMaximum() - inputVariable->getMinimum();
+            enabled.at(i) = inputVariable->isEnabled();
+        }
+
+        const int numberOfBlocks = (int) ((numberOfPoints + _linesPerBlock - 1) / _linesPerBlock);
+        if ((int) blocks.size() < numberOfBlocks) blocks.resize(numberOfBlocks);
+        std::vector<std::string> errors(numberOfBlocks);
+        const int numberOfThreads = (int) contexts.size();
+        (void) numberOfThreads;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(numberOfThreads)
+#endif
+        for (int block = 0; block < numberOfBlocks; ++block) {
+#ifdef _OPENMP
+            EvaluationContext* context = contexts.at(omp_get_thread_num());
+#else
+            EvaluationContext* context = contexts.front();
+#endif
+            std::string& rows = blocks.at(block);
+            rows.clear();
+            const long first = firstPoint + (long) block * _linesPerBlock;
+            const long last = std::min(first + _linesPerBlock, firstPoint + numberOfPoints);
+            for (long point = first; point < last; ++point) {
+                try {
+                    //The last input changes fastest, as with Op::increment()
+                    long sample = point;
+                    for (int i = numberOfInputs - 1; i >= 0; --i) {
+                        scalar value = minimums.at(i)
+                                + (sample % (resolution + 1)) * ranges.at(i) / std::max(1, resolution);
+                        sample /= resolution + 1;
+                        context->setInputValue(i, enabled.at(i) ? value : fl::nan);
+                    }
+                    writeRow(context, rows);
+                } catch (fl::Exception& ex) {
+                    errors.at(block) = ex.getWhat();
+                    break;
+                } catch (std::exception& ex) {
+                    errors.at(block) = ex.what();
+                    break;
+                }
+            }
+        }
+
+        writeBlocks(blocks, errors, writer);
+    }
+
+    void StreamingFldExporter::writeLine(EvaluationContext* context, const char* start, const char* end,
+            std::string& output) const {
+        while (start != end and isBlank(*start)) ++start;
+        while (end != start and isBlank(*(end - 1))) --end;
+        if (start == end or *start == '#') {
+            if (not _exportBinary) output.push_back('\n');
+            return;
+        }
+
+        const Engine* engine = context->getModel()->getEngine();
+        const int numberOfInputs = context->numberOfInputs();
+        int numberOfValues = 0;
+        const char* token = start;
+        while (token != end) {
+            const char* tokenEnd = token;
+            while (tokenEnd != end and not isBlank(*tokenEnd)) ++tokenEnd;
+            char* parsed = fl::null;
+            scalar value = (scalar) std::strtod(token, &parsed);
+            if (parsed != tokenEnd) {
+                throw fl::Exception("[conversion error] from <" + std::string(token, tokenEnd)
+                        + "> to scalar", FL_AT);
+            }
+            if (numberOfValues < numberOfInputs) {
+                if (not engine->getInputVariable(numberOfValues)->isEnabled()) value = fl::nan;
+                context->setInputValue(numberOfValues, value);
+            }
+            ++numberOfValues;
+            token = tokenEnd;
+            while (token != end and isBlank(*token)) ++token;
+        }
+        if (numberOfValues < numberOfInputs) {
+            std::ostringstream ex;
+            ex << "[export error] engine has <" << numberOfInputs << "> input variables, "
+                    "but input data provides <" << numberOfValues << "> values";
+            throw fl::Exception(ex.str(), FL_AT);
+        }
+
+        writeRow(context, output);
+    }
+
+    void StreamingFldExporter::writeRow(EvaluationContext* context, std::string& output) const {
+        context->process();
+
+        if (_exportBinary) {
+            if (_exportInputValues) {
+                for (int i = 0; i < context->numberOfInputs(); ++i) {
+                    scalar value = context->getInputValue(i);
+                    output.append(reinterpret_cast<const char*> (&value), sizeof(scalar));
+                }
+            }
+            if (_exportOutputValues) {
+                for (int i = 0; i < context->numberOfOutputs(); ++i) {
+                    scalar value = context->getOutputValue(i);
+                    output.append(reinterpret_cast<const char*> (&value), sizeof(scalar));
+                }
+            }
+            return;
+        }
+
+        bool separate = false;
+        if (_exportInputValues) {
+            for (int i = 0; i < context->numberOfInputs(); ++i) {
+                if (separate) output.append(_separator);
+                appendValue(context->getInputValue(i), output);
+                separate = true;
+            }
+        }
+        if (_exportOutputValues) {
+            for (int i = 0; i < context->numberOfOutputs(); ++i) {
+                if (separate) output.append(_separator);
+                appendValue(context->getOutputValue(i), output);
+                separate = true;
+            }
+        }
+        output.push_back('\n');
+    }
+
+    void StreamingFldExporter::appendValue(scalar value, std::string& output) {
+        if (Op::isNaN(value)) {
+            output.append("nan");
+            return;
+        }
+        if (Op::isInf(value)) {
+            output.append(value < 0.0 ? "-inf" : "inf");
+            return;
+        }
+        if (Op::isEq(value, 0.0)) value = 0.0;
+        char buffer[64];
+        int length = std::snprintf(buffer, sizeof(buffer), "%.*f", fuzzylite::decimals(), (double) value);
+        if (length >= 0 and length < (int) sizeof(buffer)) {
+            output.append(buffer, length);
+        } else {
+            //Values too large for the buffer
+            output.append(Op::str(value));
+        }
+    }
+
+    StreamingFldExporter* StreamingFldExporter::clone() const {
+        return new StreamingFldExporter(*this);
+    }
+
+}
@@ -0,0 +1,475 @@
+// RuleLoader.cpp
+//
+// Purpose: Implementation of fl::RuleLoader.
+// Detail: The grammar follows Rule::load() of fuzzylite 5.0: "if antecedent then consequent [with weight]",
+// where "and" binds tighter than "or", hedges are looked up before terms, "any" needs no term, and the
+// consequent is a conjunction of propositions on output variables.
+
+#include "fl/rule/RuleLoader.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/factory/FactoryManager.h"
+#include "fl/factory/HedgeFactory.h"
+#include "fl/hedge/Any.h"
+#include "fl/hedge/Hedge.h"
+#include "fl/rule/Antecedent.h"
+#include "fl/rule/Consequent.h"
+#include "fl/rule/Expression.h"
+#include "fl/rule/Rule.h"
+#include "fl/rule/RuleBlock.h"
+#include "fl/term/Term.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <cstring>
+
+namespace fl {
+
+    /**
+     * Antecedent whose expression was parsed by the RuleLoader.
+     */
+    class LoadedAntecedent : public Antecedent {
+    public:
+
+        LoadedAntecedent(const std::string& text, Expression* expression) : Antecedent() {
+            this->_text = text;
+            this->_expression = expression;
+        }
+    };
+
+    /**
+     * Consequent whose conclusions were parsed by the RuleLoader.
+     */
+    class LoadedConsequent : public Consequent {
+    public:
+
+        LoadedConsequent(const std::string& text, const std::vector<Proposition*>& conclusions) : Consequent() {
+            this->_text = text;
+            this->_conclusions = conclusions;
+        }
+    };
+
+    RuleLoader::NameTable::NameTable() {
+    }
+
+    RuleLoader::NameTable::~NameTable() {
+    }
+
+    std::size_t RuleLoader::NameTable::hash(const char* name, std::size_t length) {
+        //FNV-1a
+        std::size_t result = 2166136261u;
+        for (std::size_t i = 0; i < length; ++i) {
+            result = (result ^ (unsigned char) name[i]) * 16777619u;
+        }
+        return result;
+    }
+
+    void RuleLoader::NameTable::rehash(std::size_t numberOfSlots) {
+        _slots.assign(numberOfSlots, -1);
+        const std::size_t mask = numberOfSlots - 1;
+        for (std::size_t i = 0; i < _names.size(); ++i) {
+            std::size_t slot = hash(_names.at(i).c_str(), _names.at(i).size()) & mask;
+            while (_slots.at(slot) >= 0) slot = (slot + 1) & mask;
+            _slots.at(slot) = (int) i;
+        }
+    }
+
+    void RuleLoader::NameTable::add(const std::string& name, int value) {
+        if (find(name.c_str(), name.size()) >= 0) return;
+        _names.push_back(name);
+        _values.push_back(value);
+        //Keeps the table at most half full, with a power of two slots for masking
+        if (2 * _names.size() > _slots.size()) {
+            std::size_t numberOfSlots = 16;
+            while (numberOfSlots < 2 * _names.size()) numberOfSlots *= 2;
+            rehash(2 * numberOfSlots);
+        } else {
+            const std::size_t mask = _slots.size() - 1;
+            std::size_t slot = hash(name.c_str(), name.size()) & mask;
+            while (_slots.at(slot) >= 0) slot = (slot + 1) & mask;
+            _slots.at(slot) = (int) _names.size() - 1;
+        }
+    }
+
+    int RuleLoader::NameTable::find(const char* name, std::size_t length) const {
+        if (_slots.empty()) return -1;
+        const std::size_t mask = _slots.size() - 1;
+        for (std::size_t slot = hash(name, length) & mask; _slots[slot] >= 0; slot = (slot + 1) & mask) {
+            const std::string& candidate = _names[_slots[slot]];
+            if (candidate.size() == length and std::memcmp(candidate.data(), name, length) == 0) {
+                return _values[_slots[slot]];
+            }
+        }
+        return -1;
+    }
+
+    int RuleLoader::NameTable::size() const {
+        return (int) _names.size();
+    }
+
+    void RuleLoader::NameTable::clear() {
+        _names.clear();
+        _values.clear();
+        _slots.clear();
+    }
+
+    RuleLoader::RuleLoader(const Engine* engine) : _engine(fl::null), _text(fl::null), _position(0) {
+        if (engine) build(engine);
+    }
+
+    RuleLoader::~RuleLoader() {
+    }
+
+    void RuleLoader::build(const Engine* engine) {
+        _engine = engine;
+        build();
+    }
+
+    void RuleLoader::build() {
+        _variables.clear();
+        _inputVariables.clear();
+        _outputVariables.clear();
+        _terms.clear();
+        _hedgeNames.clear();
+        _hedges.clear();
+        _ruleHedges.clear();
+        _usedHedges.clear();
+        if (not _engine) return;
+
+        for (int i = 0; i < _engine->numberOfInputVariables(); ++i) {
+            InputVariable* inputVariable = _engine->getInputVariable(i);
+            _inputVariables.add(inputVariable->getName(), (int) _variables.size());
+            _variables.push_back(inputVariable);
+        }
+        for (int i = 0; i < _engine->numberOfOutputVariables(); ++i) {
+            OutputVariable* outputVariable = _engine->getOutputVariable(i);
+            _outputVariables.add(outputVariable->getName(), (int) _variables.size());
+            _variables.push_back(outputVariable);
+        }
+        _terms.resize(_variables.size());
+        for (std::size_t i = 0; i < _variables.size(); ++i) {
+            for (int t = 0; t < _variables.at(i)->numberOfTerms(); ++t) {
+                _terms.at(i).add(_variables.at(i)->getTerm(t)->getName(), t);
+            }
+        }
+
+        HedgeFactory* factory = FactoryManager::instance()->hedge();
+        std::vector<std::string> available = factory->available();
+        for (std::size_t i = 0; i < available.size(); ++i) {
+            if (factory->getConstructor(available.at(i))) {
+                _hedges.add(available.at(i), (int) _hedgeNames.size());
+                _hedgeNames.push_back(available.at(i));
+            }
+        }
+        _ruleHedges.assign(_hedgeNames.size(), (Hedge*) fl::null);
+    }
+
+    const Engine* RuleLoader::getEngine() const {
+        return this->_engine;
+    }
+
+    void RuleLoader::tokenize(const std::string& text, std::size_t start, std::size_t end) {
+        _tokens.clear();
+        Token token;
+        std::size_t i = start;
+        while (i < end) {
+            const char c = text[i];
+            if (c == ' ' or c == '\t' or c == '\r' or c == '\n') {
+                ++i;
+            } else if (c == '(' or c == ')') {
+                token.start = i;
+                token.end = ++i;
+                _tokens.push_back(token);
+            } else {
+                token.start = i;
+                while (i < end and text[i] != ' ' and text[i] != '\t' and text[i] != '\r' and text[i] != '\n'
+                        and text[i] != '(' and text[i] != ')') {
+                    ++i;
+                }
+                token.end = i;
+                _tokens.push_back(token);
+            }
+        }
+    }
+
+    bool RuleLoader::accept(const char* keyword) {
+        if (_position >= _tokens.size()) return false;
+        const Token& token = _tokens[_position];
+        const std::size_t length = token.end - token.start;
+        if (std::strlen(keyword) == length and _text->compare(token.start, length, keyword) == 0) {
+            ++_position;
+            return true;
+        }
+        return false;
+    }
+
+    std::string RuleLoader::current() const {
+        if (_position >= _tokens.size()) return "the end of the rule";
+        const Token& token = _tokens[_position];
+        return "<" + _text->substr(token.start, token.end - token.start) + ">";
+    }
+
+    bool RuleLoader::fail(const std::string& message) {
+        _message = message;
+        return false;
+    }
+
+    Expression* RuleLoader::parseDisjunction(Rule* rule) {
+        Expression* left = parseConjunction(rule);
+        while (left and accept("or")) {
+            Expression* right = parseConjunction(rule);
+            if (not right) {
+                delete left;
+                return fl::null;
+            }
+            Operator* disjunction = new Operator;
+            disjunction->name = Rule::orKeyword();
+            disjunction->left = left;
+            disjunction->right = right;
+            left = disjunction;
+        }
+        return left;
+    }
+
+    Expression* RuleLoader::parseConjunction(Rule* rule) {
+        Expression* left = parsePrimary(rule);
+        while (left and accept("and")) {
+            Expression* right = parsePrimary(rule);
+            if (not right) {
+                delete left;
+                return fl::null;
+            }
+            Operator* conjunction = new Operator;
+            conjunction->name = Rule::andKeyword();
+            conjunction->left = left;
+            conjunction->right = right;
+            left = conjunction;
+        }
+        return left;
+    }
+
+    Expression* RuleLoader::parsePrimary(Rule* rule) {
+        if (not accept("(")) return parseProposition(rule, false);
+        Expression* expression = parseDisjunction(rule);
+        if (expression and not accept(")")) {
+            fail("[syntax error] expected <)>, but found " + current());
+            delete expression;
+            return fl::null;
+        }
+        return expression;
+    }
+
+    Proposition* RuleLoader::parseProposition(Rule* rule, bool conclusion) {
+        if (_position >= _tokens.size()) {
+            fail("[syntax error] expected variable, but found the end of the rule");
+            return fl::null;
+        }
+        const Token& name = _tokens[_position];
+        const char* characters = _text->data();
+        int variable = _outputVariables.find(characters + name.start, name.end - name.start);
+        if (not conclusion) {
+            //Input variables take precedence in antecedents, as in Antecedent::load()
+            const int inputVariable = _inputVariables.find(characters + name.start, name.end - name.start);
+            if (inputVariable >= 0) variable = inputVariable;
+        }
+        if (variable < 0) {
+            fail(std::string("[syntax error] expected ") + (conclusion ? "output" : "input or output")
+                    + " variable, but found " + current());
+            return fl::null;
+        }
+        ++_position;
+        if (not accept("is")) {
+            fail("[syntax error] expected keyword <" + Rule::isKeyword() + ">, but found " + current());
+            return fl::null;
+        }
+
+        Proposition* proposition = new Proposition;
+        proposition->variable = _variables.at(variable);
+        while (_position < _tokens.size()) {
+            const Token& token = _tokens[_position];
+            const int hedgeIndex = _hedges.find(characters + token.start, token.end - token.start);
+            if (hedgeIndex >= 0) {
+                Hedge* hedge = this->hedge(rule, hedgeIndex);
+                proposition->hedges.push_back(hedge);
+                ++_position;
+                if (not conclusion and dynamic_cast<Any*> (hedge)) return proposition;
+                continue;
+            }
+            const int term = _terms.at(variable).find(characters + token.start, token.end - token.start);
+            if (term >= 0) {
+                proposition->term = proposition->variable->getTerm(term);
+                ++_position;
+                return proposition;
+            }
+            break;
+        }
+        fail("[syntax error] expected hedge or term of variable <" + proposition->variable->getName()
+                + ">, but found " + current());
+        delete proposition;
+        return fl::null;
+    }
+
+    Hedge* RuleLoader::hedge(Rule* rule, int hedgeIndex) {
+        //Every rule owns its hedges, so each hedge is created once per rule that uses it
+        Hedge* result = _ruleHedges.at(hedgeIndex);
+        if (not result) {
+            result = FactoryManager::instance()->hedge()->constructObject(_hedgeNames.at(hedgeIndex));
+            rule->addHedge(result);
+            _ruleHedges.at(hedgeIndex) = result;
+            _usedHedges.push_back(hedgeIndex);
+        }
+        return result;
+    }
+
+    Rule* RuleLoader::parse(const std::string& text, int line) {
+        if (not _engine) {
+            throw fl::Exception("[loader error] no engine was given to the rule loader", FL_AT);
+        }
+        _text = &text;
+        _position = 0;
+        _message.clear();
+        tokenize(text, 0, text.size());
+        for (std::size_t i = 0; i < _usedHedges.size(); ++i) {
+            _ruleHedges.at(_usedHedges.at(i)) = fl::null;
+        }
+        _usedHedges.clear();
+
+        Rule* rule = new Rule(text);
+        Expression* expression = fl::null;
+        std::vector<Proposition*> conclusions;
+        std::size_t antecedentStart = 0, antecedentEnd = 0, consequentStart = 0, consequentEnd = 0;
+        scalar weight = 1.0;
+        bool valid = accept("if")
+                or fail("[syntax error] expected keyword <" + Rule::ifKeyword() + ">, but found " + current());
+        if (valid) {
+            antecedentStart = _position;
+            expression = parseDisjunction(rule);
+            antecedentEnd = _position;
+            valid = expression and (accept("then")
+                    or fail("[syntax error] expected keyword <" + Rule::thenKeyword() + ">, but found " + current()));
+        }
+        if (valid) {
+            consequentStart = _position;
+            do {
+                Proposition* conclusion = parseProposition(rule, true);
+                valid = conclusion != fl::null;
+                if (valid) conclusions.push_back(conclusion);
+            } while (valid and accept("and"));
+            consequentEnd = _position;
+        }
+        if (valid and accept("with")) {
+            valid = _position < _tokens.size()
+                    or fail("[syntax error] expected weight, but found the end of the rule");
+            if (valid) {
+                const std::string token = text.substr(_tokens[_position].start,
+                        _tokens[_position].end - _tokens[_position].start);
+                weight = Op::toScalar(token, fl::nan);
+                valid = not (Op::isNaN(weight) and token != "nan")
+                        or fail("[syntax error] expected weight, but found <" + token + ">");
+                ++_position;
+            }
+        }
+        if (valid and _position < _tokens.size()) {
+            valid = fail("[syntax error] unexpected " + current() + " at the end of the rule");
+        }
+
+        if (not valid) {
+            delete expression;
+            for (std::size_t i = 0; i < conclusions.size(); ++i) {
+                delete conclusions.at(i);
+            }
+            delete rule;
+            Error error;
+            error.line = line;
+            error.rule = text;
+            error.message = _message;
+            _errors.push_back(error);
+            _text = fl::null;
+            return fl::null;
+        }
+
+        rule->setWeight(weight);
+        rule->setAntecedent(new LoadedAntecedent(text.substr(_tokens[antecedentStart].start,
+                _tokens[antecedentEnd - 1].end - _tokens[antecedentStart].start), expression));
+        rule->setConsequent(new LoadedConsequent(text.substr(_tokens[consequentStart].start,
+                _tokens[consequentEnd - 1].end - _tokens[consequentStart].start), conclusions));
+        _text = fl::null;
+        return rule;
+    }
+
+    static bool isBlank(char c) {
+        return c == ' ' or c == '\t' or c == '\r';
+    }
+
+    /**
+     * Narrows [start, end) of the line to the text of its rule, returning false if it holds none.
+     */
+    static bool ruleText(const std::string& line, std::size_t start, std::size_t& ruleStart, std::size_t& ruleEnd) {
+        const std::size_t comment = line.find('#', start);
+        if (comment < ruleEnd) ruleEnd = comment;
+        ruleStart = start;
+        while (ruleStart < ruleEnd and isBlank(line[ruleStart])) ++ruleStart;
+        if (ruleEnd - ruleStart >= 5 and line.compare(ruleStart, 5, "rule:") == 0) {
+            ruleStart += 5;
+            while (ruleStart < ruleEnd and isBlank(line[ruleStart])) ++ruleStart;
+        }
+        while (ruleEnd > ruleStart and isBlank(line[ruleEnd - 1])) --ruleEnd;
+        return ruleEnd > ruleStart;
+    }
+
+    int RuleLoader::load(RuleBlock* ruleBlock, const std::string& rules) {
+        int result = 0;
+        int line = 0;
+        std::size_t start = 0;
+        while (start < rules.size()) {
+            std::size_t end = rules.find('\n', start);
+            if (end == std::string::npos) end = rules.size();
+            ++line;
+            std::size_t ruleStart, ruleEnd = end;
+            if (ruleText(rules, start, ruleStart, ruleEnd)) {
+                if (Rule* rule = parse(rules.substr(ruleStart, ruleEnd - ruleStart), line)) {
+                    ruleBlock->addRule(rule);
+                    ++result;
+                }
+            }
+            start = end + 1;
+        }
+        return result;
+    }
+
+    int RuleLoader::load(RuleBlock* ruleBlock, const std::vector<std::string>& rules) {
+        ruleBlock->rules().reserve(ruleBlock->rules().size() + rules.size());
+        int result = 0;
+        for (std::size_t i = 0; i < rules.size(); ++i) {
+            std::size_t ruleStart, ruleEnd = rules.at(i).size();
+            if (ruleText(rules.at(i), 0, ruleStart, ruleEnd)) {
+                Rule* rule;
+                if (ruleStart == 0 and ruleEnd == rules.at(i).size()) {
+                    rule = parse(rules.at(i), (int) i + 1);
+                } else {
+                    rule = parse(rules.at(i).substr(ruleStart, ruleEnd - ruleStart), (int) i + 1);
+                }
+                if (rule) {
+                    ruleBlock->addRule(rule);
+                    ++result;
+                }
+            }
+        }
+        return result;
+    }
+
+    const std::vector<RuleLoader::Error>& RuleLoader::errors() const {
+        return this->_errors;
+    }
+
+    int RuleLoader::numberOfErrors() const {
+        return (int) _errors.size();
+    }
+
+    void RuleLoader::clearErrors() {
+        _errors.clear();
+    }
+
+}
@@ -0,0 +1,222 @@
+// AccumulatedKernel.cpp
+//
+// Purpose: Implementation of fl::AccumulatedKernel.
+// Detail: Accumulated::membership() folds the activated terms into zero in the order they were added, and
+// each block of values is folded in the same order, so every value sees the same operations on the same
+// operands. Values that are NaN are NaN in the fuzzy output whatever its terms and norms are. Snapshots
+// without an accumulation or with a term without an activation evaluate value by value, so they throw
+// exactly where Accumulated::membership() and Activated::membership() do.
+
+#include "fl/term/AccumulatedKernel.h"
+
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/TypedKernel.h"
+#include "fl/norm/SNorm.h"
+#include "fl/norm/TNorm.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Activated.h"
+#include "fl/term/Term.h"
+
+#include <algorithm>
+
+namespace fl {
+
+    AccumulatedKernel::AccumulatedKernel(const Term* term)
+    : _term(fl::null), _accumulated(false), _complete(true), _accumulation(fl::null),
+    _accumulationCode(CompiledEngine::CUSTOM),
+    _values(BlockSize), _degreeValues(BlockSize), _x(BlockSize), _y(BlockSize),
+    _rightX(BlockSize), _rightY(BlockSize) {
+        set(term);
+    }
+
+    AccumulatedKernel::~AccumulatedKernel() {
+    }
+
+    void AccumulatedKernel::set(const Term* term) {
+        _term = term;
+        const Accumulated* accumulated = dynamic_cast<const Accumulated*> (term);
+        _accumulated = (accumulated != fl::null);
+        if (not accumulated) {
+            _accumulation = fl::null;
+            _accumulationCode = CompiledEngine::CUSTOM;
+            _kernels.resize(1);
+            _kernels.front().set(term);
+            _degrees.clear();
+            _activations.clear();
+            _activationCodes.clear();
+            _complete = true;
+            return;
+        }
+
+        const int numberOfTerms = accumulated->numberOfTerms();
+        _accumulation = accumulated->getAccumulation();
+        _accumulationCode = CompiledEngine::normCode(_accumulation);
+        _kernels.resize(numberOfTerms);
+        _degrees.resize(numberOfTerms);
+        _activations.resize(numberOfTerms);
+        _activationCodes.resize(numberOfTerms);
+        _complete = (numberOfTerms == 0 or _accumulation);
+        for (int i = 0; i < numberOfTerms; ++i) {
+            const Activated* activated = accumulated->getTerm(i);
+            _kernels[i].set(activated->getTerm());
+            _degrees[i] = activated->getDegree();
+            _activations[i] = activated->getActivation();
+            _activationCodes[i] = CompiledEngine::normCode(_activations[i]);
+            _complete = _complete and _activations[i];
+        }
+    }
+
+    const Term* AccumulatedKernel::getTerm() const {
+        return _term;
+    }
+
+    bool AccumulatedKernel::isAccumulated() const {
+        return _accumulated;
+    }
+
+    int AccumulatedKernel::numberOfTerms() const {
+        return _accumulated ? (int) _kernels.size() : 0;
+    }
+
+    scalar AccumulatedKernel::membership(scalar x) const {
+        scalar y = fl::nan;
+        if (not _accumulated) {
+            _kernels.front().membership(&x, &y, 1);
+            return y;
+        }
+        if (Op::isNaN(x)) return fl::nan;
+        if (not (_kernels.empty() or _accumulation)) {
+            throw fl::Exception("[accumulation error] "
+                    "accumulation operator needed to accumulate " + _term->toString(), FL_AT);
+        }
+        scalar mu = 0.0;
+        for (std::size_t i = 0; i < _kernels.size(); ++i) {
+            if (not _activations[i]) {
+                throw fl::Exception("[activation error] "
+                        "activation operator needed to activate " + _kernels[i].getTerm()->toString(), FL_AT);
+            }
+            _kernels[i].membership(&x, &y, 1);
+            y = CompiledEngine::compute(_activationCodes[i], _activations[i], y, _degrees[i]);
+            mu = CompiledEngine::compute(_accumulationCode, _accumulation, mu, y);
+        }
+        return mu;
+    }
+
+    void AccumulatedKernel::membership(const scalar* x, scalar* y, std::size_t size) const {
+        if (not _accumulated) {
+            std::fill(y, y + size, fl::nan);
+            _kernels.front().membership(x, y, size);
+            return;
+        }
+        if (not _complete) {
+            for (std::size_t i = 0; i < size; ++i) y[i] = membership(x[i]);
+            return;
+        }
+        scalar* values = &_values[0];
+        scalar* degrees = &_degreeValues[0];
+        for (std::size_t start = 0; start < size; start += BlockSize) {
+            const int block = (size - start < (std::size_t) BlockSize) ? (int) (size - start) : BlockSize;
+            scalar* mu = y + start;
+            std::fill(mu, mu + block, 0.0);
+            for (std::size_t i = 0; i < _kernels.size(); ++i) {
+                _kernels[i].membership(x + start, values, block);
+                std::fill(degrees, degrees + block, _degrees[i]);
+                CompiledEngine::compute(_activationCodes[i], _activations[i], values, degrees, block);
+                CompiledEngine::compute(_accumulationCode, _accumulation, mu, values, block);
+            }
+            for (int k = 0; k < block; ++k) {
+                if (x[start + k] != x[start + k]) mu[k] = fl::nan;
+            }
+        }
+    }
+
+    void AccumulatedKernel::sample(scalar origin, scalar step, bool fromRight, int first, int size,
+            scalar* x, scalar* y) const {
+        for (int k = 0; k < size; ++k) {
+            const int i = first + k;
+            x[k] = fromRight ? origin - (i + 0.5) * step : origin + (i + 0.5) * step;
+        }
+        membership(x, y, size);
+    }
+
+    scalar AccumulatedKernel::centroid(scalar minimum, scalar maximum, int resolution) const {
+        if (not Op::isFinite(minimum + maximum)) return fl::nan;
+        const scalar dx = (maximum - minimum) / resolution;
+        TypedKernel<scalar>::CentroidSum sum;
+        for (int start = 0; start < resolution; start += BlockSize) {
+            const int block = (resolution - start < BlockSize) ? resolution - start : BlockSize;
+            sample(minimum, dx, false, start, block, &_x[0], &_y[0]);
+            sum.add(&_x[0], &_y[0], block);
+        }
+        return sum.value();
+    }
+
+    scalar AccumulatedKernel::bisector(scalar minimum, scalar maximum, int resolution) const {
+        if (not Op::isFinite(minimum + maximum)) return fl::nan;
+        const scalar dx = (maximum - minimum) / resolution;
+        int counter = resolution, left = 0, right = 0;
+        TypedKernel<scalar>::BisectorWalk walk(minimum, maximum, fuzzylite::macheps());
+        //The sides meet wherever the areas balance, so each one is sampled only a short block ahead, never
+        //past the cells that are left to visit
+        const int lookahead = BlockSize / 8;
+        int leftStart = 0, leftEnd = 0, rightStart = 0, rightEnd = 0;
+        while (counter-- > 0) {
+            if (walk.fromLeft()) {
+                if (left == leftEnd) {
+                    leftStart = left;
+                    leftEnd = left + ((counter < lookahead) ? counter + 1 : lookahead);
+                    sample(minimum, dx, false, leftStart, leftEnd - leftStart, &_x[0], &_y[0]);
+                }
+                walk.addLeft(_x[left - leftStart], _y[left - leftStart]);
+                ++left;
+            } else {
+                if (right == rightEnd) {
+                    rightStart = right;
+                    rightEnd = right + ((counter < lookahead) ? counter + 1 : lookahead);
+                    sample(maximum, dx, true, rightStart, rightEnd - rightStart, &_rightX[0], &_rightY[0]);
+                }
+                walk.addRight(_rightX[right - rightStart], _rightY[right - rightStart]);
+                ++right;
+            }
+        }
+        return walk.value();
+    }
+
+    scalar AccumulatedKernel::meanOfMaximum(scalar minimum, scalar maximum, int resolution) const {
+        if (not Op::isFinite(minimum + maximum)) return fl::nan;
+        const scalar dx = (maximum - minimum) / resolution;
+        TypedKernel<scalar>::MaximumSearch search(minimum, maximum, fuzzylite::macheps());
+        for (int start = 0; start < resolution; start += BlockSize) {
+            const int block = (resolution - start < BlockSize) ? resolution - start : BlockSize;
+            sample(minimum, dx, false, start, block, &_x[0], &_y[0]);
+            search.mean(&_x[0], &_y[0], block);
+        }
+        return search.meanValue();
+    }
+
+    scalar AccumulatedKernel::smallestOfMaximum(scalar minimum, scalar maximum, int resolution) const {
+        if (not Op::isFinite(minimum + maximum)) return fl::nan;
+        const scalar dx = (maximum - minimum) / resolution;
+        TypedKernel<scalar>::MaximumSearch search(minimum, maximum, fuzzylite::macheps());
+        for (int start = 0; start < resolution; start += BlockSize) {
+            const int block = (resolution - start < BlockSize) ? resolution - start : BlockSize;
+            sample(minimum, dx, false, start, block, &_x[0], &_y[0]);
+            search.smallest(&_x[0], &_y[0], block);
+        }
+        return search.xsmallest;
+    }
+
+    scalar AccumulatedKernel::largestOfMaximum(scalar minimum, scalar maximum, int resolution) const {
+        if (not Op::isFinite(minimum + maximum)) return fl::nan;
+        const scalar dx = (maximum - minimum) / resolution;
+        TypedKernel<scalar>::MaximumSearch search(minimum, maximum, fuzzylite::macheps());
+        for (int start = 0; start < resolution; start += BlockSize) {
+            const int block = (resolution - start < BlockSize) ? resolution - start : BlockSize;
+            sample(minimum, dx, false, start, block, &_x[0], &_y[0]);
+            search.largest(&_x[0], &_y[0], block);
+        }
+        return search.xlargest;
+    }
+
+}
@@ -0,0 +1,258 @@
+// CompiledFunction.cpp
+//
+// Purpose: Implementation of fl::CompiledFunction.
+// Detail: The instructions compute the same operations in the same order as Node::evaluate(), including
+// its order of operands for binary elements, so they return exactly what Function::evaluate() does. The
+// elements of the FunctionFactory for the arithmetic operators are recognized by their function pointers.
+
+#include "fl/term/CompiledFunction.h"
+
+#include "fl/Engine.h"
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+#include "fl/variable/InputVariable.h"
+#include "fl/variable/OutputVariable.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace fl {
+
+    CompiledFunction::CompiledFunction(const std::string& name,
+            const std::string& formula, const Engine* engine)
+    : Function(name, formula, engine), _stackSize(0) {
+    }
+
+    CompiledFunction::~CompiledFunction() {
+    }
+
+    CompiledFunction* CompiledFunction::create(const std::string& name,
+            const std::string& formula, const Engine* engine) {
+        FL_unique_ptr<CompiledFunction> result(new CompiledFunction(name));
+        result->load(formula, engine);
+        return result.release();
+    }
+
+    std::string CompiledFunction::className() const {
+        return "CompiledFunction";
+    }
+
+    void CompiledFunction::setEngine(const Engine* engine) {
+        Function::setEngine(engine);
+        if (isLoaded()) compile();
+    }
+
+    void CompiledFunction::unload() {
+        Function::unload();
+        _instructions.clear();
+        _variableNames.clear();
+        _inputs.clear();
+        _outputs.clear();
+        _stackSize = 0;
+    }
+
+    void CompiledFunction::load(const std::string& formula, const Engine* engine) {
+        //Function::load() evaluates the tree once, which checks its variables before compiling it
+        Function::load(formula, engine);
+        compile();
+    }
+
+    void CompiledFunction::compile() {
+        if (not isLoaded()) {
+            throw fl::Exception("[function error] function <" + _formula + "> not loaded.", FL_AT);
+        }
+        _instructions.clear();
+        _variableNames.clear();
+        _inputs.clear();
+        _outputs.clear();
+        _stackSize = 0;
+        int depth = 0;
+        compile(_root.get(), depth);
+
+        _inputValues.assign(_engine ? _engine->numberOfInputVariables() : 0, fl::nan);
+        _outputValues.assign(_engine ? _engine->numberOfOutputVariables() : 0, fl::nan);
+        _stack.assign(_stackSize, fl::nan);
+    }
+
+    void CompiledFunction::emit(OpCode code, int operand, scalar value, Unary unary, Binary binary) {
+        Instruction instruction;
+        instruction.code = code;
+        instruction.operand = operand;
+        instruction.value = value;
+        instruction.unary = unary;
+        instruction.binary = binary;
+        _instructions.push_back(instruction);
+    }
+
+    bool CompiledFunction::compile(const Node* node, int& depth) {
+        if (const Element* element = node->element.get()) {
+            if (element->unary) {
+                if (compile(node->left.get(), depth)) {
+                    Instruction& operand = _instructions.back();
+                    operand.value = element->unary(operand.value);
+                    return true;
+                }
+                if (element->unary == &Op::negate) emit(NEGATE);
+                else emit(UNARY, 0, 0.0, element->unary);
+                return false;
+            }
+            if (element->binary) {
+                bool constant = compile(node->right.get(), depth);
+                constant = compile(node->left.get(), depth) and constant;
+                --depth;
+                if (constant) {
+                    scalar b = _instructions.back().value;
+                    _instructions.pop_back();
+                    Instruction& a = _instructions.back();
+                    a.value = element->binary(a.value, b);
+                    return true;
+                }
+                if (element->binary == &Op::add) emit(ADD);
+                else if (element->binary == &Op::subtract) emit(SUBTRACT);
+                else if (element->binary == &Op::multiply) emit(MULTIPLY);
+                else if (element->binary == &Op::divide) emit(DIVIDE);
+                else emit(BINARY, 0, 0.0, fl::null, element->binary);
+                return false;
+            }
+            std::ostringstream ex;
+            ex << "[function error] arity <" << element->arity << "> of "
+                    << (element->isOperator() ? "operator" : "function")
+                    << " <" << element->name << "> is fl::nan or not supported";
+            throw fl::Exception(ex.str(), FL_AT);
+        }
+
+        _stackSize = std::max(_stackSize, ++depth);
+        if (node->variable.empty()) {
+            emit(CONSTANT, 0, node->value);
+            return true;
+        }
+        //Function::membership() sets the inputs, then the outputs and then x, so the last one set wins
+        if (node->variable == "x") {
+            emit(LOAD_X);
+            return false;
+        }
+        int input = -1, output = -1;
+        if (_engine) {
+            for (int i = 0; i < _engine->numberOfInputVariables(); ++i) {
+                if (_engine->getInputVariable(i)->getName() == node->variable) input = i;
+            }
+            for (int i = 0; i < _engine->numberOfOutputVariables(); ++i) {
+                if (_engine->getOutputVariable(i)->getName() == node->variable) output = i;
+            }
+        }
+        if (output >= 0) {
+            if (std::find(_outputs.begin(), _outputs.end(), output) == _outputs.end()) {
+                _outputs.push_back(output);
+            }
+            emit(LOAD_OUTPUT, output);
+        } else if (input >= 0) {
+            if (std::find(_inputs.begin(), _inputs.end(), input) == _inputs.end()) {
+                _inputs.push_back(input);
+            }
+            emit(LOAD_INPUT, input);
+        } else {
+            emit(LOAD_VARIABLE, (int) _variableNames.size());
+            _variableNames.push_back(node->variable);
+        }
+        return false;
+    }
+
+    scalar CompiledFunction::membership(scalar x) const {
+        //Function::load() calls membership() before the instructions are compiled
+        if (_instructions.empty()) return Function::membership(x);
+
+        for (std::size_t i = 0; i < _inputs.size(); ++i) {
+            _inputValues[_inputs[i]] = _engine->getInputVariable(_inputs[i])->getInputValue();
+        }
+        for (std::size_t i = 0; i < _outputs.size(); ++i) {
+            _outputValues[_outputs[i]] = _engine->getOutputVariable(_outputs[i])->getOutputValue();
+        }
+        const scalar* inputValues = fl::null;
+        if (not _inputValues.empty()) inputValues = &_inputValues[0];
+        const scalar* outputValues = fl::null;
+        if (not _outputValues.empty()) outputValues = &_outputValues[0];
+        return evaluate(x, inputValues, outputValues, &_stack[0]);
+    }
+
+    scalar CompiledFunction::evaluate(scalar x, const scalar* inputValues, const scalar* outputValues,
+            scalar* stack) const {
+        int top = -1;
+        const Instruction* instruction = &_instructions[0];
+        const Instruction* end = instruction + _instructions.size();
+        for (; instruction != end; ++instruction) {
+            switch (instruction->code) {
+                case CONSTANT:
+                    stack[++top] = instruction->value;
+                    break;
+                case LOAD_X:
+                    stack[++top] = x;
+                    break;
+                case LOAD_INPUT:
+                    stack[++top] = inputValues[instruction->operand];
+                    break;
+                case LOAD_OUTPUT:
+                    stack[++top] = outputValues[instruction->operand];
+                    break;
+                case LOAD_VARIABLE:
+                {
+                    const std::string& name = _variableNames[instruction->operand];
+                    std::map<std::string, scalar>::const_iterator it = variables.find(name);
+                    if (it == variables.end()) {
+                        throw fl::Exception("[function error] unknown variable <" + name + ">", FL_AT);
+                    }
+                    stack[++top] = it->second;
+                    break;
+                }
+                case NEGATE:
+                    stack[top] = -stack[top];
+                    break;
+                case ADD:
+                    --top;
+                    stack[top] = stack[top] + stack[top + 1];
+                    break;
+                case SUBTRACT:
+                    --top;
+                    stack[top] = stack[top] - stack[top + 1];
+                    break;
+                case MULTIPLY:
+                    --top;
+                    stack[top] = stack[top] * stack[top + 1];
+                    break;
+                case DIVIDE:
+                    --top;
+                    stack[top] = stack[top] / stack[top + 1];
+                    break;
+                case UNARY:
+                    stack[top] = instruction->unary(stack[top]);
+                    break;
+                case BINARY:
+                    --top;
+                    stack[top] = instruction->binary(stack[top], stack[top + 1]);
+                    break;
+            }
+        }
+        return stack[top];
+    }
+
+    bool CompiledFunction::isCompiled() const {
+        return not _instructions.empty();
+    }
+
+    const std::vector<CompiledFunction::Instruction>& CompiledFunction::instructions() const {
+        return _instructions;
+    }
+
+    int CompiledFunction::stackSize() const {
+        return _stackSize;
+    }
+
+    CompiledFunction* CompiledFunction::clone() const {
+        return new CompiledFunction(*this);
+    }
+
+    Term* CompiledFunction::constructor() {
+        return new CompiledFunction;
+    }
+
+}
@@ -0,0 +1,515 @@
+// MembershipKernel.cpp
+//
+// Purpose: Implementation of fl::MembershipKernel.
+// Detail: Each SIMD kernel computes the value of every branch of the membership function of fuzzylite 5.0
+// and selects them with the comparisons of fl::Operation, including their macheps tolerance, from the last
+// branch to the first, so the first branch that holds wins as in the scalar code. Fused multiply-add is not
+// used, since it would round differently from the terms.
+
+#include "fl/term/MembershipKernel.h"
+
+#include "fl/Operation.h"
+#include "fl/TypedKernel.h"
+#include "fl/term/Bell.h"
+#include "fl/term/Concave.h"
+#include "fl/term/Constant.h"
+#include "fl/term/Cosine.h"
+#include "fl/term/Gaussian.h"
+#include "fl/term/GaussianProduct.h"
+#include "fl/term/PiShape.h"
+#include "fl/term/Ramp.h"
+#include "fl/term/Rectangle.h"
+#include "fl/term/SShape.h"
+#include "fl/term/Sigmoid.h"
+#include "fl/term/SigmoidDifference.h"
+#include "fl/term/SigmoidProduct.h"
+#include "fl/term/Spike.h"
+#include "fl/term/Term.h"
+#include "fl/term/Trapezoid.h"
+#include "fl/term/Triangle.h"
+#include "fl/term/ZShape.h"
+
+#include <algorithm>
+
+#ifndef FL_USE_FLOAT
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FL_KERNEL_WIDTH 4
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FL_KERNEL_WIDTH 2
+#endif
+#endif
+
+namespace fl {
+
+#if defined(FL_KERNEL_WIDTH) && FL_KERNEL_WIDTH == 4
+    typedef __m256d Pack;
+
+    static inline Pack broadcast(scalar a) {
+        return _mm256_set1_pd(a);
+    }
+
+    static inline Pack load(const scalar* x) {
+        return _mm256_loadu_pd(x);
+    }
+
+    static inline void store(scalar* y, Pack a) {
+        _mm256_storeu_pd(y, a);
+    }
+
+    static inline Pack add(Pack a, Pack b) {
+        return _mm256_add_pd(a, b);
+    }
+
+    static inline Pack sub(Pack a, Pack b) {
+        return _mm256_sub_pd(a, b);
+    }
+
+    static inline Pack mul(Pack a, Pack b) {
+        return _mm256_mul_pd(a, b);
+    }
+
+    static inline Pack div(Pack a, Pack b) {
+        return _mm256_div_pd(a, b);
+    }
+
+    //Returns b where a or b is NaN, as Op::min(b, a)
+    static inline Pack min(Pack a, Pack b) {
+        return _mm256_min_pd(a, b);
+    }
+
+    static inline Pack equal(Pack a, Pack b) {
+        return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+    }
+
+    static inline Pack less(Pack a, Pack b) {
+        return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+    }
+
+    static inline Pack greater(Pack a, Pack b) {
+        return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+    }
+
+    static inline Pack unordered(Pack a, Pack b) {
+        return _mm256_cmp_pd(a, b, _CMP_UNORD_Q);
+    }
+
+    static inline Pack either(Pack a, Pack b) {
+        return _mm256_or_pd(a, b);
+    }
+
+    //(not a) and b
+    static inline Pack butNot(Pack a, Pack b) {
+        return _mm256_andnot_pd(a, b);
+    }
+
+    static inline Pack select(Pack mask, Pack a, Pack b) {
+        return _mm256_blendv_pd(b, a, mask);
+    }
+
+#elif defined(FL_KERNEL_WIDTH) && FL_KERNEL_WIDTH == 2
+    typedef __m128d Pack;
+
+    static inline Pack broadcast(scalar a) {
+        return _mm_set1_pd(a);
+    }
+
+    static inline Pack load(const scalar* x) {
+        return _mm_loadu_pd(x);
+    }
+
+    static inline void store(scalar* y, Pack a) {
+        _mm_storeu_pd(y, a);
+    }
+
+    static inline Pack add(Pack a, Pack b) {
+        return _mm_add_pd(a, b);
+    }
+
+    static inline Pack sub(Pack a, Pack b) {
+        return _mm_sub_pd(a, b);
+    }
+
+    static inline Pack mul(Pack a, Pack b) {
+        return _mm_mul_pd(a, b);
+    }
+
+    static inline Pack div(Pack a, Pack b) {
+        return _mm_div_pd(a, b);
+    }
+
+    //Returns b where a or b is NaN, as Op::min(b, a)
+    static inline Pack min(Pack a, Pack b) {
+        return _mm_min_pd(a, b);
+    }
+
+    static inline Pack equal(Pack a, Pack b) {
+        return _mm_cmpeq_pd(a, b);
+    }
+
+    static inline Pack less(Pack a, Pack b) {
+        return _mm_cmplt_pd(a, b);
+    }
+
+    static inline Pack greater(Pack a, Pack b) {
+        return _mm_cmpgt_pd(a, b);
+    }
+
+    static inline Pack unordered(Pack a, Pack b) {
+        return _mm_cmpunord_pd(a, b);
+    }
+
+    static inline Pack either(Pack a, Pack b) {
+        return _mm_or_pd(a, b);
+    }
+
+    //(not a) and b
+    static inline Pack butNot(Pack a, Pack b) {
+        return _mm_andnot_pd(a, b);
+    }
+
+    static inline Pack select(Pack mask, Pack a, Pack b) {
+        return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+    }
+#endif
+
+#ifdef FL_KERNEL_WIDTH
+
+    /**
+     * The comparisons of fl::Operation on packs, where a and b are equal within macheps.
+     */
+    struct Comparison {
+        Pack macheps, sign;
+
+        Comparison() : macheps(broadcast(fuzzylite::macheps())), sign(broadcast(-0.0)) {
+        }
+
+        Pack isEq(Pack a, Pack b) const {
+            //NaN inputs are replaced afterwards, so the case of a and b both NaN is not needed
+            return either(equal(a, b), less(butNot(sign, sub(a, b)), macheps));
+        }
+
+        Pack isLt(Pack a, Pack b) const {
+            return butNot(isEq(a, b), less(a, b));
+        }
+
+        Pack isLE(Pack a, Pack b) const {
+            return either(isEq(a, b), less(a, b));
+        }
+
+        Pack isGt(Pack a, Pack b) const {
+            return butNot(isEq(a, b), greater(a, b));
+        }
+
+        Pack isGE(Pack a, Pack b) const {
+            return either(isEq(a, b), greater(a, b));
+        }
+
+        Pack isNaN(Pack x) const {
+            return unordered(x, x);
+        }
+    };
+#endif
+
+    MembershipKernel::MembershipKernel(const Term* term) : _term(fl::null), _shape(UNKNOWN), _height(1.0) {
+        std::fill(_parameters, _parameters + 4, scalar(0.0));
+        if (term) set(term);
+    }
+
+    MembershipKernel::~MembershipKernel() {
+    }
+
+    void MembershipKernel::set(const Term* term) {
+        _term = term;
+        _shape = UNKNOWN;
+        _height = term ? term->getHeight() : 1.0;
+        std::fill(_parameters, _parameters + 4, scalar(0.0));
+        scalar* p = _parameters;
+        if (const Triangle* triangle = dynamic_cast<const Triangle*> (term)) {
+            _shape = TRIANGLE;
+            p[0] = triangle->getVertexA();
+            p[1] = triangle->getVertexB();
+            p[2] = triangle->getVertexC();
+        } else if (const Trapezoid* trapezoid = dynamic_cast<const Trapezoid*> (term)) {
+            _shape = TRAPEZOID;
+            p[0] = trapezoid->getVertexA();
+            p[1] = trapezoid->getVertexB();
+            p[2] = trapezoid->getVertexC();
+            p[3] = trapezoid->getVertexD();
+        } else if (const Rectangle* rectangle = dynamic_cast<const Rectangle*> (term)) {
+            _shape = RECTANGLE;
+            p[0] = rectangle->getStart();
+            p[1] = rectangle->getEnd();
+        } else if (const Ramp* ramp = dynamic_cast<const Ramp*> (term)) {
+            _shape = RAMP;
+            p[0] = ramp->getStart();
+            p[1] = ramp->getEnd();
+        } else if (const SShape* sShape = dynamic_cast<const SShape*> (term)) {
+            _shape = SSHAPE;
+            p[0] = sShape->getStart();
+            p[1] = sShape->getEnd();
+        } else if (const ZShape* zShape = dynamic_cast<const ZShape*> (term)) {
+            _shape = ZSHAPE;
+            p[0] = zShape->getStart();
+            p[1] = zShape->getEnd();
+        } else if (const PiShape* piShape = dynamic_cast<const PiShape*> (term)) {
+            _shape = PISHAPE;
+            p[0] = piShape->getBottomLeft();
+            p[1] = piShape->getTopLeft();
+            p[2] = piShape->getTopRight();
+            p[3] = piShape->getBottomRight();
+        } else if (const Concave* concave = dynamic_cast<const Concave*> (term)) {
+            _shape = CONCAVE;
+            p[0] = concave->getInflection();
+            p[1] = concave->getEnd();
+        } else if (const Constant* constant = dynamic_cast<const Constant*> (term)) {
+            _shape = CONSTANT;
+            p[0] = constant->getValue();
+        } else if (const Gaussian* gaussian = dynamic_cast<const Gaussian*> (term)) {
+            _shape = GAUSSIAN;
+            p[0] = gaussian->getMean();
+            p[1] = gaussian->getStandardDeviation();
+        } else if (const GaussianProduct* gaussianProduct = dynamic_cast<const GaussianProduct*> (term)) {
+            _shape = GAUSSIAN_PRODUCT;
+            p[0] = gaussianProduct->getMeanA();
+            p[1] = gaussianProduct->getStandardDeviationA();
+            p[2] = gaussianProduct->getMeanB();
+            p[3] = gaussianProduct->getStandardDeviationB();
+        } else if (const Bell* bell = dynamic_cast<const Bell*> (term)) {
+            _shape = BELL;
+            p[0] = bell->getCenter();
+            p[1] = bell->getWidth();
+            p[2] = bell->getSlope();
+        } else if (const Sigmoid* sigmoid = dynamic_cast<const Sigmoid*> (term)) {
+            _shape = SIGMOID;
+            p[0] = sigmoid->getInflection();
+            p[1] = sigmoid->getSlope();
+        } else if (const SigmoidDifference* difference = dynamic_cast<const SigmoidDifference*> (term)) {
+            _shape = SIGMOID_DIFFERENCE;
+            p[0] = difference->getLeft();
+            p[1] = difference->getRising();
+            p[2] = difference->getFalling();
+            p[3] = difference->getRight();
+        } else if (const SigmoidProduct* product = dynamic_cast<const SigmoidProduct*> (term)) {
+            _shape = SIGMOID_PRODUCT;
+            p[0] = product->getLeft();
+            p[1] = product->getRising();
+            p[2] = product->getFalling();
+            p[3] = product->getRight();
+        } else if (const Spike* spike = dynamic_cast<const Spike*> (term)) {
+            _shape = SPIKE;
+            p[0] = spike->getCenter();
+            p[1] = spike->getWidth();
+        } else if (const Cosine* cosine = dynamic_cast<const Cosine*> (term)) {
+            _shape = COSINE;
+            p[0] = cosine->getCenter();
+            p[1] = cosine->getWidth();
+        }
+    }
+
+    const Term* MembershipKernel::getTerm() const {
+        return this->_term;
+    }
+
+    MembershipKernel::Shape MembershipKernel::getShape() const {
+        return this->_shape;
+    }
+
+    scalar MembershipKernel::getHeight() const {
+        return this->_height;
+    }
+
+    const scalar* MembershipKernel::getParameters() const {
+        return this->_parameters;
+    }
+
+    bool MembershipKernel::isVectorized() const {
+#ifdef FL_KERNEL_WIDTH
+        return _shape >= TRIANGLE and _shape <= CONSTANT;
+#else
+        return false;
+#endif
+    }
+
+    int MembershipKernel::vectorWidth() {
+#ifdef FL_KERNEL_WIDTH
+        return FL_KERNEL_WIDTH;
+#else
+        return 1;
+#endif
+    }
+
+    void MembershipKernel::membership(const Term* term, const scalar* x, scalar* y, std::size_t size) {
+        MembershipKernel(term).membership(x, y, size);
+    }
+
+    void MembershipKernel::membership(const scalar* x, scalar* y, std::size_t size) const {
+        if (not _term) return;
+        std::size_t done = 0;
+        if (isVectorized()) {
+            done = vectorized(x, y, size);
+        }
+        sequential(x + done, y + done, size - done);
+    }
+
+    std::size_t MembershipKernel::vectorized(const scalar* x, scalar* y, std::size_t size) const {
+#ifdef FL_KERNEL_WIDTH
+        const Comparison op;
+        const Pack nan = broadcast(fl::nan), zero = broadcast(_height * 0.0), one = broadcast(_height * 1.0);
+        const Pack height = broadcast(_height), two = broadcast(2.0), unit = broadcast(1.0);
+        const Pack a = broadcast(_parameters[0]), b = broadcast(_parameters[1]);
+        const Pack c = broadcast(_parameters[2]), d = broadcast(_parameters[3]);
+        std::size_t i = 0;
+        switch (_shape) {
+            case TRIANGLE:
+                for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                    const Pack v = load(x + i);
+                    Pack r = div(mul(height, sub(c, v)), sub(c, b));
+                    r = select(op.isLt(v, b), div(mul(height, sub(v, a)), sub(b, a)), r);
+                    r = select(op.isEq(v, b), one, r);
+                    r = select(either(op.isLt(v, a), op.isGt(v, c)), zero, r);
+                    store(y + i, select(op.isNaN(v), nan, r));
+                }
+                break;
+            case TRAPEZOID:
+                for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                    const Pack v = load(x + i);
+                    Pack r = zero;
+                    r = select(op.isLt(v, d), div(mul(height, sub(d, v)), sub(d, c)), r);
+                    r = select(op.isLE(v, c), one, r);
+                    r = select(op.isLt(v, b), mul(height, min(div(sub(v, a), sub(b, a)), unit)), r);
+                    r = select(either(op.isLt(v, a), op.isGt(v, d)), zero, r);
+                    store(y + i, select(op.isNaN(v), nan, r));
+                }
+                break;
+            case RECTANGLE:
+                for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                    const Pack v = load(x + i);
+                    const Pack r = select(either(op.isLt(v, a), op.isGt(v, b)), zero, one);
+                    store(y + i, select(op.isNaN(v), nan, r));
+                }
+                break;
+            case RAMP:
+                if (Op::isEq(_parameters[0], _parameters[1])) {
+                    for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                        store(y + i, select(op.isNaN(load(x + i)), nan, zero));
+                    }
+                } else if (Op::isLt(_parameters[0], _parameters[1])) {
+                    for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                        const Pack v = load(x + i);
+                        Pack r = div(mul(height, sub(v, a)), sub(b, a));
+                        r = select(op.isGE(v, b), one, r);
+                        r = select(op.isLE(v, a), zero, r);
+                        store(y + i, select(op.isNaN(v), nan, r));
+                    }
+                } else {
+                    for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                        const Pack v = load(x + i);
+                        Pack r = div(mul(height, sub(a, v)), sub(a, b));
+                        r = select(op.isLE(v, b), one, r);
+                        r = select(op.isGE(v, a), zero, r);
+                        store(y + i, select(op.isNaN(v), nan, r));
+                    }
+                }
+                break;
+            case SSHAPE:
+            {
+                const Pack average = broadcast((_parameters[0] + _parameters[1]) / 2.0);
+                const Pack difference = broadcast(_parameters[1] - _parameters[0]);
+                const Pack twiceHeight = mul(height, two);
+                for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                    const Pack v = load(x + i);
+                    const Pack rising = div(sub(v, a), difference), falling = div(sub(v, b), difference);
+                    Pack r = one;
+                    r = select(op.isLt(v, b), mul(height, sub(unit, mul(two, mul(falling, falling)))), r);
+                    r = select(op.isLE(v, average), mul(twiceHeight, mul(rising, rising)), r);
+                    r = select(op.isLE(v, a), zero, r);
+                    store(y + i, select(op.isNaN(v), nan, r));
+                }
+                break;
+            }
+            case ZSHAPE:
+            {
+                const Pack average = broadcast((_parameters[0] + _parameters[1]) / 2.0);
+                const Pack difference = broadcast(_parameters[1] - _parameters[0]);
+                const Pack twiceHeight = mul(height, two);
+                for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                    const Pack v = load(x + i);
+                    const Pack rising = div(sub(v, a), difference), falling = div(sub(v, b), difference);
+                    Pack r = zero;
+                    r = select(op.isLt(v, b), mul(twiceHeight, mul(falling, falling)), r);
+                    r = select(op.isLE(v, average), mul(height, sub(unit, mul(two, mul(rising, rising)))), r);
+                    r = select(op.isLE(v, a), one, r);
+                    store(y + i, select(op.isNaN(v), nan, r));
+                }
+                break;
+            }
+            case PISHAPE:
+            {
+                const Pack leftAverage = broadcast(0.5 * (_parameters[0] + _parameters[1]));
+                const Pack rightAverage = broadcast(0.5 * (_parameters[2] + _parameters[3]));
+                const Pack left = sub(b, a), right = sub(d, c), zeroes = broadcast(0.0);
+                for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                    const Pack v = load(x + i);
+                    Pack t = div(sub(v, a), left), u = div(sub(v, b), left);
+                    Pack sShape = unit;
+                    sShape = select(op.isLt(v, b), sub(unit, mul(two, mul(u, u))), sShape);
+                    sShape = select(op.isLE(v, leftAverage), mul(two, mul(t, t)), sShape);
+                    sShape = select(op.isLE(v, a), zeroes, sShape);
+                    t = div(sub(v, c), right);
+                    u = div(sub(v, d), right);
+                    Pack zShape = zeroes;
+                    zShape = select(op.isLt(v, d), mul(two, mul(u, u)), zShape);
+                    zShape = select(op.isLE(v, rightAverage), sub(unit, mul(two, mul(t, t))), zShape);
+                    zShape = select(op.isLE(v, c), unit, zShape);
+                    store(y + i, select(op.isNaN(v), nan, mul(mul(height, sShape), zShape)));
+                }
+                break;
+            }
+            case CONCAVE:
+                if (Op::isLE(_parameters[0], _parameters[1])) {
+                    const Pack numerator = mul(height, sub(b, a)), offset = sub(mul(two, b), a);
+                    for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                        const Pack v = load(x + i);
+                        const Pack r = select(op.isLt(v, b), div(numerator, sub(offset, v)), one);
+                        store(y + i, select(op.isNaN(v), nan, r));
+                    }
+                } else {
+                    const Pack numerator = mul(height, sub(a, b)), offset = sub(a, mul(two, b));
+                    for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                        const Pack v = load(x + i);
+                        const Pack r = select(op.isGt(v, b), div(numerator, add(offset, v)), one);
+                        store(y + i, select(op.isNaN(v), nan, r));
+                    }
+                }
+                break;
+            case CONSTANT:
+                //Constant ignores its input, including NaN
+                for (; i + FL_KERNEL_WIDTH <= size; i += FL_KERNEL_WIDTH) {
+                    store(y + i, a);
+                }
+                break;
+            default:
+                break;
+        }
+        return i;
+#else
+        (void) x;
+        (void) y;
+        (void) size;
+        return 0;
+#endif
+    }
+
+    void MembershipKernel::sequential(const scalar* x, scalar* y, std::size_t size) const {
+        if (_shape == UNKNOWN) {
+            for (std::size_t i = 0; i < size; ++i) {
+                y[i] = _term->membership(x[i]);
+            }
+            return;
+        }
+        TypedKernel<scalar>::membership(_shape, _parameters, _height, x, y, (int) size, fuzzylite::macheps());
+    }
+
+}
@@ -0,0 +1,126 @@
+// SortedDiscrete.cpp
+//
+// Purpose: Implementation of fl::SortedDiscrete.
+// Detail: On points sorted by x, the comparisons of Discrete::membership() against the value are true for
+// every point before some index and false from it on, so the first point it finds equal to the value, or
+// the pair of points it interpolates between, is determined by that index alone. Both the binary search
+// and the uniform guess find it with the same comparisons, including their macheps tolerance.
+
+#include "fl/term/SortedDiscrete.h"
+
+#include "fl/Exception.h"
+#include "fl/Operation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace fl {
+
+    static bool lessByX(const Discrete::Pair& a, const Discrete::Pair& b) {
+        return a.first < b.first;
+    }
+
+    SortedDiscrete::SortedDiscrete(const std::string& name, const std::vector<Pair>& xy, scalar height)
+    : Discrete(name, xy, height), _uniform(false), _start(0.0), _inverseStep(0.0) {
+        sort();
+    }
+
+    SortedDiscrete::~SortedDiscrete() {
+    }
+
+    std::string SortedDiscrete::className() const {
+        return "SortedDiscrete";
+    }
+
+    void SortedDiscrete::configure(const std::string& parameters) {
+        Discrete::configure(parameters);
+        sort();
+    }
+
+    std::size_t SortedDiscrete::locate(scalar x) const {
+        //Op::isLt(_xy[i].first, x) holds for the first point and not for the last one
+        if (_uniform) {
+            //The guess is within a point of the index, as every point is within a quarter step of the grid
+            scalar position = (x - _start) * _inverseStep;
+            std::size_t index = 0;
+            if (position > 0.0) {
+                index = std::min(static_cast<std::size_t> (position), _xy.size() - 1);
+            }
+            while (index > 0 and not Op::isLt(_xy[index - 1].first, x)) --index;
+            while (Op::isLt(_xy[index].first, x)) ++index;
+            return index;
+        }
+        std::size_t lower = 0, upper = _xy.size() - 1;
+        while (upper - lower > 1) {
+            std::size_t middle = lower + (upper - lower) / 2;
+            if (Op::isLt(_xy[middle].first, x)) lower = middle;
+            else upper = middle;
+        }
+        return upper;
+    }
+
+    scalar SortedDiscrete::membership(scalar x) const {
+        if (Op::isNaN(x)) return fl::nan;
+        if (_xy.empty()) {
+            throw fl::Exception("[discrete error] term is empty", FL_AT);
+        }
+        if (Op::isLE(x, _xy.front().first)) return _height * _xy.front().second;
+        if (Op::isGE(x, _xy.back().first)) return _height * _xy.back().second;
+
+        std::size_t upper = locate(x);
+        const Pair& right = _xy[upper];
+        if (Op::isEq(right.first, x)) return _height * right.second;
+        const Pair& left = _xy[upper - 1];
+        return _height * Op::scale(x, left.first, right.first, left.second, right.second);
+    }
+
+    void SortedDiscrete::setXY(const std::vector<Pair>& pairs) {
+        Discrete::setXY(pairs);
+        sort();
+    }
+
+    void SortedDiscrete::setGrid(scalar start, scalar step, const std::vector<scalar>& y) {
+        if (not (step > 0.0)) {
+            std::ostringstream ex;
+            ex << "[discrete error] expected a positive step, but found <" << step << ">";
+            throw fl::Exception(ex.str(), FL_AT);
+        }
+        _xy.resize(y.size());
+        for (std::size_t i = 0; i < y.size(); ++i) {
+            _xy[i] = Pair(start + i * step, y[i]);
+        }
+        _uniform = _xy.size() >= 2;
+        _start = start;
+        _inverseStep = 1.0 / step;
+    }
+
+    void SortedDiscrete::sort() {
+        std::stable_sort(_xy.begin(), _xy.end(), lessByX);
+        _uniform = false;
+        if (_xy.size() < 2) return;
+
+        scalar start = _xy.front().first;
+        scalar step = (_xy.back().first - start) / (_xy.size() - 1);
+        if (not (step > 0.0) or Op::isInf(step)) return;
+        for (std::size_t i = 0; i < _xy.size(); ++i) {
+            if (std::fabs(_xy[i].first - (start + i * step)) > 0.25 * step) return;
+        }
+        _uniform = true;
+        _start = start;
+        _inverseStep = 1.0 / step;
+    }
+
+    bool SortedDiscrete::isUniform() const {
+        return _uniform;
+    }
+
+    SortedDiscrete* SortedDiscrete::clone() const {
+        return new SortedDiscrete(*this);
+    }
+
+    Term* SortedDiscrete::constructor() {
+        return new SortedDiscrete;
+    }
+
+}
@@ -0,0 +1,140 @@
+// TermIndex.cpp
+//
+// Purpose: Implementation of fl::TermIndex.
+// Detail: The supports follow the membership functions of fuzzylite 5.0, where a term returns
+// height * 0.0 beyond the vertices at which it reaches zero.
+
+#include "fl/variable/TermIndex.h"
+
+#include "fl/Operation.h"
+#include "fl/norm/s/AlgebraicSum.h"
+#include "fl/norm/s/BoundedSum.h"
+#include "fl/norm/s/Maximum.h"
+#include "fl/norm/t/AlgebraicProduct.h"
+#include "fl/norm/t/Minimum.h"
+#include "fl/term/Accumulated.h"
+#include "fl/term/Activated.h"
+#include "fl/term/Constant.h"
+#include "fl/term/Cosine.h"
+#include "fl/term/Discrete.h"
+#include "fl/term/PiShape.h"
+#include "fl/term/Ramp.h"
+#include "fl/term/Rectangle.h"
+#include "fl/term/SShape.h"
+#include "fl/term/Trapezoid.h"
+#include "fl/term/Triangle.h"
+#include "fl/term/ZShape.h"
+
+#include <algorithm>
+
+namespace fl {
+
+    /**
+     * Support of a Discrete term, which extends its first and last values beyond its first and last
+     * points, or false if its points are not sorted.
+     */
+    static bool discreteSupport(const Discrete* discrete, scalar& start, scalar& end) {
+        const std::vector<Discrete::Pair>& xy = discrete->xy();
+        int first = -1, last = -1;
+        for (std::size_t i = 0; i < xy.size(); ++i) {
+            if (i > 0 and xy.at(i).first < xy.at(i - 1).first) return false;
+            if (xy.at(i).second != 0.0) {
+                if (first < 0) first = (int) i;
+                last = (int) i;
+            }
+        }
+        if (first < 0) {
+            start = fl::inf;
+            end = -fl::inf;
+            return true;
+        }
+        start = (first == 0) ? -fl::inf : xy.at(first - 1).first;
+        end = (last == (int) xy.size() - 1) ? fl::inf : xy.at(last + 1).first;
+        return true;
+    }
+
+    void TermIndex::support(const Term* term, scalar& start, scalar& end) {
+        start = -fl::inf;
+        end = fl::inf;
+        if (not term) return;
+        const Discrete* discrete = dynamic_cast<const Discrete*> (term);
+        if (discrete and discrete->xy().empty()) return;
+        if (term->getHeight() == 0.0) {
+            start = fl::inf;
+            end = -fl::inf;
+            return;
+        }
+        if (const Triangle* triangle = dynamic_cast<const Triangle*> (term)) {
+            start = triangle->getVertexA();
+            end = triangle->getVertexC();
+        } else if (const Trapezoid* trapezoid = dynamic_cast<const Trapezoid*> (term)) {
+            start = trapezoid->getVertexA();
+            end = trapezoid->getVertexD();
+        } else if (const Rectangle* rectangle = dynamic_cast<const Rectangle*> (term)) {
+            start = rectangle->getStart();
+            end = rectangle->getEnd();
+        } else if (const Cosine* cosine = dynamic_cast<const Cosine*> (term)) {
+            start = cosine->getCenter() - 0.5 * cosine->getWidth();
+            end = cosine->getCenter() + 0.5 * cosine->getWidth();
+        } else if (const PiShape* piShape = dynamic_cast<const PiShape*> (term)) {
+            start = piShape->getBottomLeft();
+            end = piShape->getBottomRight();
+        } else if (const SShape* sShape = dynamic_cast<const SShape*> (term)) {
+            start = sShape->getStart();
+        } else if (const ZShape* zShape = dynamic_cast<const ZShape*> (term)) {
+            end = zShape->getEnd();
+        } else if (const Ramp* ramp = dynamic_cast<const Ramp*> (term)) {
+            if (Op::isEq(ramp->getStart(), ramp->getEnd())) {
+                start = fl::inf;
+                end = -fl::inf;
+                return;
+            }
+            if (ramp->getStart() < ramp->getEnd()) start = ramp->getStart();
+            else end = ramp->getStart();
+        } else if (discrete) {
+            if (not discreteSupport(discrete, start, end)) {
+                start = -fl::inf;
+                end = fl::inf;
+            }
+        } else if (const Constant* constant = dynamic_cast<const Constant*> (term)) {
+            if (constant->getValue() == 0.0) {
+                start = fl::inf;
+                end = -fl::inf;
+            }
+            return;
+        } else if (const Activated* activated = dynamic_cast<const Activated*> (term)) {
+            //T(0, degree) = 0 for these activations, so the activated term is zero where its term is
+            const TNorm* activation = activated->getActivation();
+            if (dynamic_cast<const Minimum*> (activation) or dynamic_cast<const AlgebraicProduct*> (activation)) {
+                support(activated->getTerm(), start, end);
+            }
+            return;
+        } else if (const Accumulated* accumulated = dynamic_cast<const Accumulated*> (term)) {
+            //S(0, 0) = 0 for these accumulations, so the fuzzy output is zero outside the union of supports
+            const SNorm* accumulation = accumulated->getAccumulation();
+            if (not (dynamic_cast<const Maximum*> (accumulation) or dynamic_cast<const AlgebraicSum*> (accumulation)
+                    or dynamic_cast<const BoundedSum*> (accumulation))) {
+                return;
+            }
+            start = fl::inf;
+            end = -fl::inf;
+            for (int i = 0; i < accumulated->numberOfTerms(); ++i) {
+                scalar termStart, termEnd;
+                support(accumulated->getTerm(i), termStart, termEnd);
+                start = std::min(start, termStart);
+                end = std::max(end, termEnd);
+            }
+            return;
+        } else {
+            return;
+        }
+        if (Op::isNaN(start) or Op::isNaN(end)) {
+            start = -fl::inf;
+            end = fl::inf;
+            return;
+        }
+        start -= fuzzylite::macheps();
+        end += fuzzylite::macheps();
+    }
+
+}
@@ -0,0 +1,75 @@
+// FlbImporterTest.cpp
+//
+// Purpose: Test of fl::FlbImporter against the images fl::FlbExporter writes of the FuzzyCar engine.
+// Detail: FuzzyCar is exported and imported back under each defuzzifier of the library, and the engine imported
+// must have the fingerprint of the original and give outputs with the same bits over a walk of the inputs.
+
+#include "Tests.h"
+
+#include "fl/Headers.h"
+
+#include <cstring>
+#include <iostream>
+
+using namespace fl;
+
+static int compareImportedEngine(const Engine* engine) {
+    FL_unique_ptr<Engine> imported;
+    try {
+        imported.reset(FlbImporter().fromString(FlbExporter().toString(engine)));
+    } catch (fl::Exception& ex) {
+        std::cout << "engine <" << engine->getName() << "> does not import back from its image: "
+                << ex.getWhat() << std::endl;
+        return 1;
+    }
+    int differences = 0;
+    if (EngineCache::fingerprint(imported.get()) != EngineCache::fingerprint(engine)) {
+        std::cout << "engine <" << engine->getName() << "> imports back with a different fingerprint" << std::endl;
+        ++differences;
+    }
+
+    Engine original(*engine);
+    const int numberOfPoints = 101;
+    for (int point = 0; point < numberOfPoints; ++point) {
+        for (int i = 0; i < original.numberOfInputVariables(); ++i) {
+            const InputVariable* input = original.getInputVariable(i);
+            //Every input walks its range at a different stride, so the points do not lie on a diagonal
+            const scalar fraction = scalar((point * (i + 1)) % numberOfPoints) / (numberOfPoints - 1);
+            scalar x = input->getMinimum() + fraction * (input->getMaximum() - input->getMinimum());
+            if (not Op::isFinite(x)) x = fraction;
+            original.getInputVariable(i)->setInputValue(x);
+            imported->getInputVariable(i)->setInputValue(x);
+        }
+        original.process();
+        imported->process();
+        for (int i = 0; i < original.numberOfOutputVariables(); ++i) {
+            const scalar expected = original.getOutputVariable(i)->getOutputValue();
+            const scalar obtained = imported->getOutputVariable(i)->getOutputValue();
+            if (std::memcmp(&expected, &obtained, sizeof(scalar)) != 0
+                    and not (Op::isNaN(expected) and Op::isNaN(obtained))) {
+                std::cout << "output <" << original.getOutputVariable(i)->getName() << "> of <"
+                        << engine->getName() << "> is " << Op::str(obtained) << " instead of "
+                        << Op::str(expected) << " at point " << point << std::endl;
+                ++differences;
+            }
+        }
+    }
+    return differences;
+}
+
+int testFlbImporter() {
+    Defuzzifier* defuzzifiers[] = {
+        new ExactCentroid, new ExactBisector, new ExactMeanOfMaximum,
+        new ExactSmallestOfMaximum, new ExactLargestOfMaximum, new PrefixSumBisector(250),
+        new AdaptiveDefuzzifier(AdaptiveDefuzzifier::BISECTOR, 1e-4, 500),
+        new Centroid(300), new Bisector, new MeanOfMaximum
+    };
+    int differences = 0;
+    for (std::size_t i = 0; i < sizeof(defuzzifiers) / sizeof(defuzzifiers[0]); ++i) {
+        FL_unique_ptr<Engine> engine(makeFuzzyCar());
+        engine->setName("FuzzyCar with " + defuzzifiers[i]->className());
+        engine->getOutputVariable(0)->setDefuzzifier(defuzzifiers[i]);
+        differences += compareImportedEngine(engine.get());
+    }
+    return differences;
+}
@@ -0,0 +1,64 @@
+// FuzzyCar.cpp
+//
+// Purpose: The FuzzyCar engine of main.cpp, as a fixture of the tests.
+// Detail: The same variables, terms and rules as SetupFuzzyInferenceSystem(), with the steering
+// defuzzified by ExactCentroid, built without the globals of the game.
+
+#include "Tests.h"
+
+#include "fl/Headers.h"
+
+fl::Engine* makeFuzzyCar() {
+    fl::Engine* engine = new fl::Engine("FuzzyCar");
+
+    fl::InputVariable* carPosition = new fl::InputVariable("CarPosition", -1.0, 1.0);
+    carPosition->addTerm(new fl::Triangle("FarLeft", -2.000, -1.000, -0.400));
+    carPosition->addTerm(new fl::Triangle("NearLeft", -0.800, -0.400, 0.000));
+    carPosition->addTerm(new fl::Triangle("Neutral", -0.400, 0.000, 0.400));
+    carPosition->addTerm(new fl::Triangle("NearRight", 0.000, 0.400, 0.800));
+    carPosition->addTerm(new fl::Triangle("FarRight", 0.400, 1.000, 2.00));
+    engine->addInputVariable(carPosition);
+
+    fl::InputVariable* carVelocity = new fl::InputVariable("CarVelocity", -1.0, 1.0);
+    carVelocity->addTerm(new fl::Triangle("MovingFastLeft", -2.000, -1.000, -0.400));
+    carVelocity->addTerm(new fl::Triangle("MovingSlowLeft", -0.800, -0.400, 0.000));
+    carVelocity->addTerm(new fl::Triangle("Neutral", -0.400, 0.000, 0.400));
+    carVelocity->addTerm(new fl::Triangle("MovingSlowRight", 0.000, 0.400, 0.800));
+    carVelocity->addTerm(new fl::Triangle("MovingFastRight", 0.400, 1.000, 2.00));
+    engine->addInputVariable(carVelocity);
+
+    fl::OutputVariable* carSteering = new fl::OutputVariable("CarSteering", -1.0, 1.0);
+    carSteering->setDefaultValue(0);
+    carSteering->setLockOutputValueInRange(true);
+    carSteering->addTerm(new fl::Triangle("SteerFarLeft", -2.000, -1.000, -0.600));
+    carSteering->addTerm(new fl::Triangle("SteerMediumLeft", -0.750, -0.500, -0.250));
+    carSteering->addTerm(new fl::Triangle("SteerNearLeft", -0.400, -0.200, 0.000));
+    carSteering->addTerm(new fl::Triangle("Neutral", -0.200, 0.000, 0.200));
+    carSteering->addTerm(new fl::Triangle("SteerNearRight", 0.000, 0.200, 0.400));
+    carSteering->addTerm(new fl::Triangle("SteerMediumRight", 0.250, 0.500, 0.750));
+    carSteering->addTerm(new fl::Triangle("SteerFarRight", 0.600, 1.000, 1.200));
+    engine->addOutputVariable(carSteering);
+
+    //The Fuzzy Associative Map of Fuzzy_Grid.pdf, one row per velocity
+    const char* positions[] = {"FarLeft", "NearLeft", "Neutral", "NearRight", "FarRight"};
+    const char* velocities[] = {"MovingFastLeft", "MovingSlowLeft", "Neutral", "MovingSlowRight", "MovingFastRight"};
+    const char* steerings[5][5] = {
+        {"SteerFarRight", "SteerMediumRight", "SteerMediumRight", "SteerNearRight", "Neutral"},
+        {"SteerMediumRight", "SteerNearRight", "SteerNearRight", "Neutral", "SteerNearLeft"},
+        {"SteerMediumRight", "SteerNearRight", "Neutral", "SteerNearLeft", "SteerMediumLeft"},
+        {"SteerNearRight", "Neutral", "SteerNearLeft", "SteerNearLeft", "SteerMediumLeft"},
+        {"Neutral", "SteerNearLeft", "SteerMediumLeft", "SteerMediumLeft", "SteerFarLeft"}
+    };
+    fl::RuleBlock* ruleBlock = new fl::RuleBlock();
+    for (int v = 0; v < 5; ++v) {
+        for (int p = 0; p < 5; ++p) {
+            ruleBlock->addRule(fl::Rule::parse(std::string("if CarPosition is ") + positions[p]
+                    + " and CarVelocity is " + velocities[v] + " then CarSteering is " + steerings[v][p], engine));
+        }
+    }
+    engine->addRuleBlock(ruleBlock);
+
+    engine->configure("Minimum", "Maximum", "Minimum", "Maximum", "Centroid");
+    carSteering->setDefuzzifier(new fl::ExactCentroid());
+    return engine;
+}
@@ -0,0 +1,100 @@
+// MembershipKernelTest.cpp
+//
+// Purpose: Test of fl::MembershipKernel against the membership functions of the terms it evaluates.
+// Detail: Terms of every shape, with heights 1, 0.5 and 0, are evaluated at their parameters and just either
+// side of them, between them, far outside them, at the infinities and at NaN, over arrays of every alignment
+// and length up to a few vectors, so the head, the SIMD body and the tail of the kernel are all exercised.
+// Every value must have the same bits as Term::membership(), or both must be NaN.
+
+#include "Tests.h"
+
+#include "fl/Headers.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace fl;
+
+int testMembershipKernel() {
+    std::vector<Term*> terms;
+    terms.push_back(new Triangle("triangle", -0.5, 0.25, 1.0));
+    terms.push_back(new Triangle("leftTriangle", 0.0, 0.0, 1.0));
+    terms.push_back(new Triangle("rightTriangle", 0.0, 1.0, 1.0));
+    terms.push_back(new Trapezoid("trapezoid", -0.5, 0.0, 0.5, 1.0));
+    terms.push_back(new Trapezoid("shoulder", 0.0, 0.0, 0.5, 1.0));
+    terms.push_back(new Rectangle("rectangle", 0.25, 0.75));
+    terms.push_back(new Ramp("rising", 0.0, 1.0));
+    terms.push_back(new Ramp("falling", 1.0, 0.0));
+    terms.push_back(new Ramp("flat", 0.5, 0.5));
+    terms.push_back(new SShape("sShape", 0.0, 1.0));
+    terms.push_back(new ZShape("zShape", 0.0, 1.0));
+    terms.push_back(new PiShape("piShape", 0.0, 0.25, 0.5, 1.0));
+    terms.push_back(new Concave("rightConcave", 0.25, 0.75));
+    terms.push_back(new Concave("leftConcave", 0.75, 0.25));
+    terms.push_back(new Constant("constant", 0.7));
+    terms.push_back(new Gaussian("gaussian", 0.5, 0.2));
+    terms.push_back(new GaussianProduct("gaussianProduct", 0.25, 0.1, 0.75, 0.2));
+    terms.push_back(new Bell("bell", 0.5, 0.25, 3.0));
+    terms.push_back(new Sigmoid("sigmoid", 0.5, 10.0));
+    terms.push_back(new SigmoidDifference("sigmoidDifference", 0.25, 20.0, 10.0, 0.75));
+    terms.push_back(new SigmoidProduct("sigmoidProduct", 0.25, 20.0, -10.0, 0.75));
+    terms.push_back(new Spike("spike", 0.5, 1.0));
+    terms.push_back(new Cosine("cosine", 0.5, 1.0));
+
+    const scalar heights[] = {1.0, 0.5, 0.0};
+    const scalar epsilon = 1e-12;
+    int failures = 0;
+    for (std::size_t t = 0; t < terms.size(); ++t) {
+        Term* term = terms.at(t);
+        for (std::size_t h = 0; h < sizeof(heights) / sizeof(heights[0]); ++h) {
+            term->setHeight(heights[h]);
+            const MembershipKernel kernel(term);
+
+            //The edges of the shape, just either side of them and between them
+            std::vector<scalar> x;
+            const scalar* p = kernel.getParameters();
+            for (int i = 0; i < 4; ++i) {
+                x.push_back(p[i]);
+                x.push_back(p[i] - epsilon);
+                x.push_back(p[i] + epsilon);
+                x.push_back(p[i] * (1.0 - epsilon));
+                x.push_back(p[i] * (1.0 + epsilon));
+                if (i < 3) x.push_back(0.5 * (p[i] + p[i + 1]));
+            }
+            for (int i = 0; i <= 8; ++i) x.push_back(-1.0 + i * 0.375);
+            x.push_back(-1e9);
+            x.push_back(1e9);
+            x.push_back(-std::numeric_limits<scalar>::infinity());
+            x.push_back(std::numeric_limits<scalar>::infinity());
+            x.push_back(std::numeric_limits<scalar>::quiet_NaN());
+
+            //Every offset and length over the first few vectors, then the whole array
+            std::vector<scalar> y(x.size());
+            const std::size_t span = std::min(x.size(), (std::size_t) (4 * MembershipKernel::vectorWidth() + 3));
+            for (std::size_t start = 0; start < x.size(); ++start) {
+                const std::size_t longest = (start < span) ? std::min(span, x.size() - start) : 1;
+                for (std::size_t size = 1; size <= longest; ++size) {
+                    kernel.membership(&x[start], &y[start], size);
+                    for (std::size_t i = start; i < start + size; ++i) {
+                        const scalar expected = term->membership(x[i]);
+                        const bool same = (Op::isNaN(expected) and Op::isNaN(y[i]))
+                                or std::memcmp(&expected, &y[i], sizeof(scalar)) == 0;
+                        if (not same) {
+                            ++failures;
+                            std::cout << term->className() << " <" << term->getName() << "> with height "
+                                    << heights[h] << " at " << x[i] << ": kernel " << y[i] << ", term "
+                                    << expected << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    for (std::size_t t = 0; t < terms.size(); ++t) {
+        delete terms.at(t);
+    }
+    return failures;
+}
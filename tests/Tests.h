@@ -0,0 +1,35 @@
+// Tests.h
+//
+// Purpose: The tests of the project, run one after another by the Tests console project.
+// Detail: Every test builds its own fixtures, prints each value that differs from what it expects to
+// std::cout, and returns the number of values that differ, so a test passes when it returns zero.
+
+#ifndef FL_TESTS_H
+#define FL_TESTS_H
+
+namespace fl {
+    class Engine;
+}
+
+/**
+ * Builds the FuzzyCar engine of the game, whose steering is defuzzified by ExactCentroid.
+ */
+fl::Engine* makeFuzzyCar();
+
+/**
+ * Compares the kernel of every shape of MembershipKernel against Term::membership().
+ */
+int testMembershipKernel();
+
+/**
+ * Exports FuzzyCar under each defuzzifier to FLB and compares the engine imported back against it.
+ */
+int testFlbImporter();
+
+/**
+ * Compares DoubleEngine and FloatEngine against the engine on CompiledFunction terms, and checks that a plain
+ * Function term of the engine does not compile.
+ */
+int testTypedEngine();
+
+#endif /* FL_TESTS_H */
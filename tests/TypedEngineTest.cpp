@@ -0,0 +1,91 @@
+// TypedEngineTest.cpp
+//
+// Purpose: Test of fl::TypedEngine on Function terms, against Engine::process().
+// Detail: A Takagi-Sugeno engine with a CompiledFunction on an input and another one as a consequent reading
+// both inputs is evaluated over a grid of its inputs by the engine, a DoubleEngine and a FloatEngine. The
+// typed engines are given their inputs without writing them to the engine, so a function that read the
+// engine instead would see the values of the previous point. The same engine with a plain Function must not
+// compile.
+
+#include "Tests.h"
+
+#include "fl/Headers.h"
+
+#include <cmath>
+#include <iostream>
+
+using namespace fl;
+
+static Engine* makeFunctions(bool compiled) {
+    Engine* engine = new Engine("Functions");
+    InputVariable* a = new InputVariable("A", 0.0, 1.0);
+    a->addTerm(new Triangle("low", -0.5, 0.0, 0.6));
+    a->addTerm(new Triangle("high", 0.4, 1.0, 1.5));
+    engine->addInputVariable(a);
+    InputVariable* b = new InputVariable("B", 0.0, 1.0);
+    b->addTerm(new Ramp("up", 0.0, 1.0));
+    b->addTerm(CompiledFunction::create("wave", "0.5 + 0.5 * sin(6 * x)", engine));
+    engine->addInputVariable(b);
+
+    OutputVariable* o = new OutputVariable("O", -2.0, 3.0);
+    o->setDefaultValue(fl::nan);
+    o->addTerm(new Constant("c", 0.7));
+    if (compiled) o->addTerm(CompiledFunction::create("f", "A * B + 0.1", engine));
+    else o->addTerm(Function::create("f", "A * B + 0.1", engine));
+    engine->addOutputVariable(o);
+
+    RuleBlock* ruleBlock = new RuleBlock();
+    ruleBlock->addRule(Rule::parse("if A is low and B is up then O is c", engine));
+    ruleBlock->addRule(Rule::parse("if B is wave then O is f", engine));
+    ruleBlock->addRule(Rule::parse("if A is high and B is very wave then O is f with 0.5", engine));
+    engine->addRuleBlock(ruleBlock);
+    engine->configure("Minimum", "Maximum", "Minimum", "", "WeightedAverage");
+    return engine;
+}
+
+int testTypedEngine() {
+    int failures = 0;
+    FL_unique_ptr<Engine> engine(makeFunctions(true));
+    DoubleEngine doubleEngine;
+    FloatEngine floatEngine;
+    doubleEngine.compile(engine.get());
+    floatEngine.compile(engine.get());
+    const int points = 21;
+    for (int i = 0; i < points; ++i) {
+        for (int j = 0; j < points; ++j) {
+            const scalar a = scalar(i) / (points - 1), b = scalar(j) / (points - 1);
+            doubleEngine.setInputValue(0, a);
+            doubleEngine.setInputValue(1, b);
+            doubleEngine.process();
+            floatEngine.setInputValue(0, float(a));
+            floatEngine.setInputValue(1, float(b));
+            floatEngine.process();
+            engine->setInputValue("A", a);
+            engine->setInputValue("B", b);
+            engine->process();
+            const scalar expected = engine->getOutputValue("O");
+            const scalar obtained[] = {doubleEngine.getOutputValue(0), floatEngine.getOutputValue(0)};
+            const scalar tolerances[] = {1e-12, 1e-4};
+            for (int t = 0; t < 2; ++t) {
+                const bool same = Op::isNaN(expected) ? Op::isNaN(obtained[t])
+                        : std::fabs(obtained[t] - expected) <= tolerances[t];
+                if (not same) {
+                    std::cout << (t == 0 ? "DoubleEngine" : "FloatEngine") << " gives " << Op::str(obtained[t])
+                            << " instead of " << Op::str(expected) << " at A=" << Op::str(a)
+                            << ", B=" << Op::str(b) << std::endl;
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    FL_unique_ptr<Engine> plain(makeFunctions(false));
+    try {
+        DoubleEngine typed;
+        typed.compile(plain.get());
+        std::cout << "DoubleEngine compiles a plain Function term of the engine" << std::endl;
+        ++failures;
+    } catch (fl::Exception&) {
+    }
+    return failures;
+}
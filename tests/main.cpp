@@ -0,0 +1,33 @@
+// main.cpp
+//
+// Purpose: Entry point of the Tests console project.
+// Detail: Runs every test of Tests.h and exits with a status other than zero if any of them fails, so the
+// build, which runs the tests once they are linked, fails with them.
+
+#include "Tests.h"
+
+#include <cstddef>
+#include <iostream>
+
+struct Test {
+    const char* name;
+    int (*run)();
+};
+
+static const Test tests[] = {
+    {"MembershipKernel", &testMembershipKernel},
+    {"FlbImporter", &testFlbImporter},
+    {"TypedEngine", &testTypedEngine}
+};
+
+int main() {
+    int failed = 0;
+    for (std::size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        const int failures = tests[i].run();
+        std::cout << (failures == 0 ? "[passed] " : "[FAILED] ") << tests[i].name;
+        if (failures != 0) std::cout << ": " << failures << " failures";
+        std::cout << std::endl;
+        if (failures != 0) ++failed;
+    }
+    return failed == 0 ? 0 : 1;
+}